@@ -12,23 +12,20 @@ PciInitContext(PciCtrlCtx** __OutCtx__)
         return -1;
     }
 
-    PciCtrlCtx* Ctx = (PciCtrlCtx*)KMalloc(sizeof(PciCtrlCtx));
+    PciCtrlCtx* Ctx = (PciCtrlCtx*)KZalloc(sizeof(PciCtrlCtx));
     if (!Ctx)
     {
         return -1;
     }
-    memset(Ctx, 0, sizeof(PciCtrlCtx));
 
     uint32_t InitCap = 128u;
-    size_t   InitSz  = sizeof(PciDevice) * InitCap;
 
-    Ctx->Devices = (PciDevice*)KMalloc(InitSz);
+    Ctx->Devices = (PciDevice*)KCalloc(InitCap, sizeof(PciDevice));
     if (!Ctx->Devices)
     {
         KFree(Ctx);
         return -1;
     }
-    memset(Ctx->Devices, 0, InitSz);
     Ctx->DevCap         = InitCap;
     Ctx->DevCount       = 0;
     Ctx->UseEcam        = 0;
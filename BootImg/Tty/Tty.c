@@ -131,12 +131,11 @@ static int TtyIoctl(void* __DevCtx__, unsigned long __Cmd__, void* __Arg__);
 static int
 TtyRegister(long __Index__)
 {
-    TtyCtx* Ctx = KMalloc(sizeof(TtyCtx));
+    TtyCtx* Ctx = KZalloc(sizeof(TtyCtx));
     if (!Ctx)
     {
         return -1;
     }
-    memset(Ctx, 0, sizeof(TtyCtx));
     TtyMakeName(Ctx->Name, sizeof(Ctx->Name), __Index__);
 
     CharDevOps Ops = {
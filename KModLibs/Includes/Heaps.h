@@ -9,6 +9,8 @@
 #define FreeObjectMagic 0xFEEDFACE
 
 void* KMalloc(size_t __Size__);
+void* KZalloc(size_t __Size__);
+void* KCalloc(size_t __Count__, size_t __Size__);
 void  KFree(void* __Ptr__);
 
 /*Module*/
@@ -5,4 +5,20 @@
 #define IdtTypeInterruptGate 0x8E
 #define IdtTypeTrapGate      0x8F
 
-void SetIdtEntry(int __Index__, uint64_t __Handler__, uint16_t __Selector__, uint8_t __Flags__);
\ No newline at end of file
+void SetIdtEntry(int __Index__, uint64_t __Handler__, uint16_t __Selector__, uint8_t __Flags__);
+
+/*Softirqs, deferred out of hard IRQ context*/
+#define SoftirqTimer   0
+#define SoftirqBlock   1
+#define SoftirqNet     2
+#define SoftirqTasklet 3
+#define SoftirqRcu     4
+#define SoftirqCount   8
+
+typedef void (*SoftirqHandler)(uint32_t __CpuId__);
+
+int  RegisterSoftirq(uint32_t __Nr__, SoftirqHandler __Handler__, const char* __Name__);
+void RaiseSoftirq(uint32_t __Nr__);
+void RaiseSoftirqOn(uint32_t __CpuId__, uint32_t __Nr__);
+void LocalBhDisable(void);
+void LocalBhEnable(void);
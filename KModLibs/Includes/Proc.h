@@ -24,7 +24,7 @@ typedef struct PosixFdTable
     long     StdinFd;
     long     StdoutFd;
     long     StderrFd;
-    SpinLock Lock;
+    Mutex    Lock;
 } PosixFdTable;
 
 int  PosixFdInit(PosixFdTable* __Tab__, long __Cap__);
@@ -101,7 +101,7 @@ typedef struct PosixProcTable
     PosixProc** Items;
     long        Count;
     long        Cap;
-    SpinLock    Lock;
+    RwLock      Lock;
 } PosixProcTable;
 
 extern PosixProcTable PosixProcs;
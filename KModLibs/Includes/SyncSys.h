@@ -4,10 +4,20 @@
 
 typedef struct
 {
-    volatile uint32_t Lock;
+    union
+    {
+        volatile uint32_t Lock;
+        struct
+        {
+            volatile uint16_t Owner;
+            volatile uint16_t Next;
+        };
+    };
     uint32_t          CpuId;
     const char*       Name;
     uint64_t          Flags;
+    struct LockClass* Class;
+    uint64_t          AcquiredTsc;
 
 } SpinLock;
 
@@ -15,13 +25,92 @@ void InitializeSpinLock(SpinLock* __Lock__, const char* __Name__);
 void AcquireSpinLock(SpinLock* __Lock__);
 void ReleaseSpinLock(SpinLock* __Lock__);
 bool TryAcquireSpinLock(SpinLock* __Lock__);
+void AcquireSpinLockBh(SpinLock* __Lock__);
+void ReleaseSpinLockBh(SpinLock* __Lock__);
+void AcquireSpinLockPlain(SpinLock* __Lock__);
+void ReleaseSpinLockPlain(SpinLock* __Lock__);
+
+typedef struct WaitQueueEntry
+{
+    struct Thread*         Thread;
+    struct WaitQueueEntry* Next;
+    uint32_t               Queued;
+
+} WaitQueueEntry;
+
+typedef struct
+{
+    WaitQueueEntry* volatile Head;
+    WaitQueueEntry*          Tail;
+    SpinLock                 Lock;
+    uint32_t                 Reason;
+
+} WaitQueue;
+
+typedef bool (*WaitCondition)(void* __Arg__);
+
+void InitializeWaitQueue(WaitQueue* __Queue__, const char* __Name__);
+void WaitEvent(WaitQueue* __Queue__, WaitCondition __Cond__, void* __Arg__);
+int  WakeUp(WaitQueue* __Queue__);
+int  WakeUpAll(WaitQueue* __Queue__);
+
+#define McsMaxNesting 4
+
+typedef struct __attribute__((aligned(64))) McsNode
+{
+    struct McsNode* volatile Next;
+    volatile uint32_t        Locked;
+    uint64_t                 Flags;
+
+} McsNode;
+
+typedef struct
+{
+    McsNode* volatile Tail;
+    McsNode*          Holder;
+    uint32_t          CpuId;
+    const char*       Name;
+
+} McsLock;
+
+void InitializeMcsLock(McsLock* __Lock__, const char* __Name__);
+void AcquireMcsLock(McsLock* __Lock__);
+void ReleaseMcsLock(McsLock* __Lock__);
+bool TryAcquireMcsLock(McsLock* __Lock__);
+
+#define RwLockWriterLocked  0x0FFU
+#define RwLockWriterWaiting 0x100U
+#define RwLockWriterMask    0x1FFU
+#define RwLockReaderBias    0x200U
+
+typedef struct
+{
+    volatile uint32_t Count;
+    SpinLock          Wait;
+    const char*       Name;
+
+} RwLock;
+
+void InitializeRwLock(RwLock* __Lock__, const char* __Name__);
+void AcquireRwLockRead(RwLock* __Lock__);
+void ReleaseRwLockRead(RwLock* __Lock__);
+void AcquireRwLockWrite(RwLock* __Lock__);
+void ReleaseRwLockWrite(RwLock* __Lock__);
+
+#define MutexUnlocked  0
+#define MutexLocked    1
+#define MutexContended 2
+#define MutexSpinLimit 2048
 
 typedef struct
 {
     volatile uint32_t Lock;
-    uint32_t          Owner;
     uint32_t          RecursionCount;
+    uintptr_t         Owner;
     const char*       Name;
+    WaitQueue         Waiters;
+    struct LockClass* Class;
+    uint64_t          AcquiredTsc;
 } Mutex;
 
 void InitializeMutex(Mutex* __Mutex__, const char* __Name__);
@@ -31,13 +120,74 @@ bool TryAcquireMutex(Mutex* __Mutex__);
 
 typedef struct
 {
-    volatile int32_t  Count;
-    volatile uint32_t WaitQueue;
-    SpinLock          QueueLock;
-    const char*       Name;
+    volatile int32_t Count;
+    WaitQueue        Waiters;
+    const char*      Name;
 } Semaphore;
 
 void InitializeSemaphore(Semaphore* __Semaphore__, int32_t __InitialCount__, const char* __Name__);
 void AcquireSemaphore(Semaphore* __Semaphore__);
 void ReleaseSemaphore(Semaphore* __Semaphore__);
-bool TryAcquireSemaphore(Semaphore* __Semaphore__);
\ No newline at end of file
+bool TryAcquireSemaphore(Semaphore* __Semaphore__);
+
+#define RwSemaphoreWriter (-1)
+
+typedef struct
+{
+    volatile int32_t  Count;
+    volatile uint32_t Writers;
+    WaitQueue         Waiters;
+    const char*       Name;
+
+} RwSemaphore;
+
+void InitializeRwSemaphore(RwSemaphore* __Sem__, const char* __Name__);
+void AcquireRwSemaphoreRead(RwSemaphore* __Sem__);
+void ReleaseRwSemaphoreRead(RwSemaphore* __Sem__);
+void AcquireRwSemaphoreWrite(RwSemaphore* __Sem__);
+void ReleaseRwSemaphoreWrite(RwSemaphore* __Sem__);
+
+typedef struct
+{
+    volatile uint32_t Sequence;
+    SpinLock          Lock;
+
+} SeqLock;
+
+void InitializeSeqLock(SeqLock* __Seq__, const char* __Name__);
+void AcquireSeqLockWrite(SeqLock* __Seq__);
+void ReleaseSeqLockWrite(SeqLock* __Seq__);
+
+static inline uint32_t
+ReadSeqLockBegin(const SeqLock* __Seq__)
+{
+    uint32_t Sequence;
+    while ((Sequence = __atomic_load_n(&__Seq__->Sequence, __ATOMIC_ACQUIRE)) & 1)
+    {
+        __asm__ volatile("pause");
+    }
+    return Sequence;
+}
+
+static inline bool
+ReadSeqLockRetry(const SeqLock* __Seq__, uint32_t __Start__)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&__Seq__->Sequence, __ATOMIC_RELAXED) != __Start__;
+}
+
+typedef struct RcuHead
+{
+    struct RcuHead* Next;
+    void (*Func)(struct RcuHead* __Head__);
+    uint64_t Gp;
+
+} RcuHead;
+
+#define RcuAssignPointer(__Ptr__, __Val__) __atomic_store_n(&(__Ptr__), (__Val__), __ATOMIC_RELEASE)
+#define RcuDereference(__Ptr__)            __atomic_load_n(&(__Ptr__), __ATOMIC_ACQUIRE)
+
+void RcuReadLock(void);
+void RcuReadUnlock(void);
+void CallRcu(RcuHead* __Head__, void (*__Func__)(RcuHead* __Head__));
+int  SynchronizeRcu(void);
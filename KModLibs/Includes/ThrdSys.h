@@ -35,6 +35,15 @@ typedef enum
 
 } ThreadPriority;
 
+typedef enum
+{
+
+    SchedPolicyNormal, /*SCHED_OTHER, priority stride*/
+    SchedPolicyFifo,   /*SCHED_FIFO, runs until it blocks or yields*/
+    SchedPolicyRr      /*SCHED_RR, FIFO with a quantum*/
+
+} SchedPolicy;
+
 typedef struct
 {
     /*GPR*/
@@ -53,67 +62,93 @@ typedef struct
 
 } ThreadContext;
 
-typedef struct Thread
+#define AcctUser  0
+#define AcctSys   1
+#define AcctIrq   2
+#define AcctWait  3 /*Runnable but still queued*/
+#define AcctModes 4
+
+/*Rarely used per-thread state, allocated on first use by GetThreadCold*/
+typedef struct ThreadCold
 {
     /*Core ID*/
-    uint32_t ThreadId;
-    uint32_t ProcessId; /*Parent*/
-    char     Name[64];
+    char Name[64];
+
+    /*File descr*/
+    void*    FileTable[64];
+    uint32_t FileCount;
+
+    /*Signals*/
+    uint64_t SignalMask;
+    void*    SignalHandlers[32];
+
+    /*Debugging*/
+    void* DebugInfo;
+
+} ThreadCold;
 
-    /*State mgr*/
+typedef struct __attribute__((aligned(64))) Thread
+{
+    /*Hot: queue walks and Schedule only touch this cache line*/
+    struct Thread* Next;
+    struct Thread* Prev;
     ThreadState    State;
     ThreadType     Type;
     ThreadPriority Priority;
+    SchedPolicy    Policy;
+    uint32_t       RtPriority;  /*1..99 under FIFO/RR*/
+    uint32_t       RtSliceLeft; /*Ticks left of the RR quantum*/
+    uint32_t       Cooldown;
+    uint32_t       LastCpu;
+    uint64_t       WakeupTime;
+    uint64_t       PageDirectory;
+
+    /*Warm: accounting updated on every switch*/
+    uint64_t       CpuTime;
+    uint64_t       StartTime;
+    uint64_t       ContextSwitches;
+    uint64_t       TimeSlice;
+    uint32_t       ThreadId;
+    uint32_t       ProcessId; /*Parent*/
+    uint32_t       CpuAffinity;
+    uint32_t       WaitReason;
+    uint32_t       Flags;
     ThreadPriority BasePriority;
-
-    /*CPU snap*/
-    ThreadContext Context;
-    uint64_t      KernelStack;
-    uint64_t      UserStack;
-    uint32_t      StackSize;
-
-    /*MM*/
-    uint64_t PageDirectory;
+    uint32_t       ExitCode;
+    uint32_t       MemoryUsage;
+
+    /*CPU time per Acct* mode in TSC cycles*/
+    uint64_t AcctCycles[AcctModes];
+    uint64_t AcctStamp;  /*TSC at the last mode change*/
+    uint64_t ReadyStamp; /*TSC when queued, 0 while not runnable*/
+    uint32_t AcctMode;
+    uint32_t GroupId; /*SchedGroup, 0 is the root group*/
+
+    /*Stacks & MM*/
+    uint64_t KernelStack;
+    uint64_t UserStack;
+    uint32_t StackSize;
     uint64_t VirtualBase;
-    uint32_t MemoryUsage;
-
-    /*Scheduling*/
-    uint32_t CpuAffinity;
-    uint32_t LastCpu;
-    uint64_t TimeSlice;
-    uint64_t CpuTime;
-    uint64_t StartTime;
-    uint64_t WakeupTime;
 
     /*Sync*/
-    void*    WaitingOn;
-    uint32_t WaitReason;
-    uint32_t ExitCode;
-    uint32_t Cooldown;
+    void* WaitingOn;
 
     /*Linked lists*/
-    struct Thread* Next;
-    struct Thread* Prev;
     struct Thread* Parent;
     struct Thread* Children;
-
-    /*File descr*/
-    void*    FileTable[64];
-    uint32_t FileCount;
-
-    /*Signals*/
-    uint64_t SignalMask;
-    void*    SignalHandlers[32];
+    struct Thread* ReapNext; /*Zombie queue and reaper list, never the run queues*/
 
     /*Statistics*/
-    uint64_t ContextSwitches;
     uint64_t PageFaults;
     uint64_t SystemCalls;
-
-    /*Debugging*/
     uint64_t CreationTick;
-    uint32_t Flags;
-    void*    DebugInfo;
+
+    /*Cold*/
+    ThreadCold* Cold;  /*NULL until something needs it*/
+    void*       Alloc; /*Unaligned block the TCB was carved from*/
+
+    /*CPU snap, only read and written at switch time*/
+    ThreadContext Context;
 
 } Thread;
 
@@ -123,6 +158,8 @@ typedef struct Thread
 #define ThreadFlagTraced    (1 << 3)
 #define ThreadFlagSuspended (1 << 4)
 #define ThreadFlagCritical  (1 << 5)
+#define ThreadFlagIdle      (1 << 6) /*Per-CPU idle thread, never queued*/
+#define ThreadFlagWakeup    (1 << 7) /*Woken before it reached the waiting queue*/
 
 #define WaitReasonNone      0
 #define WaitReasonMutex     1
@@ -132,26 +169,70 @@ typedef struct Thread
 #define WaitReasonSignal    5
 #define WaitReasonChild     6
 
+#define RtPriorityMin 1
+#define RtPriorityMax 99
+
 #define UserVirtualBase 0x0000000000400000ULL
 #define KStackSize      8192
 
-void     InitializeThreadManager(void);
-Thread*  GetCurrentThread(uint32_t __CpuId__);
-Thread*  CreateThread(ThreadType     __Type__,
-                      void*          __EntryPoint__,
-                      void*          __Argument__,
-                      ThreadPriority __Priority__);
-void     DestroyThread(Thread* __ThreadPtr__);
-void     SuspendThread(Thread* __ThreadPtr__);
-void     ResumeThread(Thread* __ThreadPtr__);
-void     SetThreadPriority(Thread* __ThreadPtr__, ThreadPriority __Priority__);
-void     SetThreadAffinity(Thread* __ThreadPtr__, uint32_t __CpuMask__);
-void     ThreadYield(void);
-void     ThreadSleep(uint64_t __Milliseconds__);
-void     ThreadExit(uint32_t __ExitCode__);
-Thread*  FindThreadById(uint32_t __ThreadId__);
-uint32_t GetThreadCount(void);
-void     ThreadExecute(Thread* __ThreadPtr__);
-void     ThreadExecuteMultiple(Thread** __ThreadArray__, uint32_t __ThreadCount__);
+void        InitializeThreadManager(void);
+Thread*     GetCurrentThread(uint32_t __CpuId__);
+Thread*     CreateThread(ThreadType     __Type__,
+                         void*          __EntryPoint__,
+                         void*          __Argument__,
+                         ThreadPriority __Priority__);
+void        DestroyThread(Thread* __ThreadPtr__);
+void        SuspendThread(Thread* __ThreadPtr__);
+void        ResumeThread(Thread* __ThreadPtr__);
+void        SetThreadPriority(Thread* __ThreadPtr__, ThreadPriority __Priority__);
+void        SetThreadAffinity(Thread* __ThreadPtr__, uint32_t __CpuMask__);
+int         SetThreadScheduler(Thread*     __ThreadPtr__,
+                               SchedPolicy __Policy__,
+                               uint32_t    __RtPriority__);
+ThreadCold* GetThreadCold(Thread* __ThreadPtr__);
+uint64_t    ThreadAcctNs(Thread* __ThreadPtr__, uint32_t __Mode__);
+const char* GetThreadName(Thread* __ThreadPtr__);
+int         SetThreadName(Thread* __ThreadPtr__, const char* __Name__);
+void        ThreadYield(void);
+void        ThreadSleep(uint64_t __Milliseconds__);
+void        ThreadExit(uint32_t __ExitCode__);
+Thread*     FindThreadById(uint32_t __ThreadId__);
+uint32_t    GetThreadCount(void);
+void        ThreadExecute(Thread* __ThreadPtr__);
+void        ThreadExecuteMultiple(Thread** __ThreadArray__, uint32_t __ThreadCount__);
 /*SMP*/
-uint32_t GetCurrentCpuId(void);
\ No newline at end of file
+uint32_t GetCurrentCpuId(void);
+/*Deferred work*/
+#define WorkPending  (1 << 0)
+#define WorkDelayed  (1 << 1)
+#define WorkInactive (1 << 2)
+
+struct WorkItem;
+typedef struct WorkQueue WorkQueue; /*Opaque to modules*/
+typedef void (*WorkFunc)(struct WorkItem* __Work__);
+
+typedef struct WorkItem
+{
+    struct WorkItem*  Next;
+    WorkFunc          Func;
+    struct WorkQueue* Queue;
+    uint32_t          Flags;
+    uint32_t          Cpu;
+    uint64_t          Deadline;
+
+} WorkItem;
+
+WorkQueue* CreateWorkQueue(const char* __Name__, uint32_t __MaxActive__);
+void       DestroyWorkQueue(WorkQueue* __Queue__);
+void       InitWork(WorkItem* __Work__, WorkFunc __Func__);
+int        QueueWork(WorkItem* __Work__);
+int        QueueWorkOn(uint32_t __CpuId__, WorkQueue* __Queue__, WorkItem* __Work__);
+int        QueueDelayedWork(WorkItem* __Work__, uint64_t __DelayMs__);
+int        QueueDelayedWorkOn(uint32_t   __CpuId__,
+                              WorkQueue* __Queue__,
+                              WorkItem*  __Work__,
+                              uint64_t   __DelayMs__);
+int        CancelWork(WorkItem* __Work__);
+int        CancelWorkSync(WorkItem* __Work__);
+void       FlushWork(WorkItem* __Work__);
+void       FlushWorkQueue(WorkQueue* __Queue__);
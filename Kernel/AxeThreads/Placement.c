@@ -0,0 +1,281 @@
+#include <AxeSchd.h>
+#include <AxeThreads.h>
+#include <PerCPUData.h>
+#include <SMP.h>
+#include <Sync.h>
+#include <SymAP.h>
+#include <Topology.h>
+
+/*
+ * CPU placement and load balancing. Kept apart from thread lifetime code so the
+ * policy builds on its own, both in the kernel and in the host SchedSim.
+ */
+
+
+uint32_t
+GetCpuLoad(uint32_t __CpuId__)
+{
+    if (__CpuId__ >= MaxCPUs)
+    {
+        return 0xFFFFFFFF; /* Invalid CPU indicator */
+    }
+
+    return GetCpuReadyCount(__CpuId__);
+}
+
+/*Ready threads plus the one on the CPU, so a busy CPU with an empty queue is not "idle"*/
+static uint32_t
+__CpuBusy__(uint32_t __CpuId__)
+{
+    Thread* Running = __atomic_load_n(&CpuSchedulers[__CpuId__].CurrentThread, __ATOMIC_SEQ_CST);
+    return GetCpuLoad(__CpuId__) + (Running && !(Running->Flags & ThreadFlagIdle));
+}
+
+static int
+__CpuAllowed__(Thread* __ThreadPtr__, uint32_t __CpuId__)
+{
+    if (Smp.Cpus[__CpuId__].Status != CPU_STATUS_ONLINE)
+    {
+        return 0;
+    }
+    return !__ThreadPtr__ || __ThreadPtr__->CpuAffinity == 0xFFFFFFFF ||
+           (__CpuId__ < 32 && (__ThreadPtr__->CpuAffinity & (1U << __CpuId__)));
+}
+
+/*
+ * Lowest score wins, compared level by level: load first, then whether the
+ * SMT siblings are busy (an idle core beats an idle sibling), then whether
+ * the CPU shares the last level cache with __Near__, then staying put.
+ */
+static uint32_t
+__BestCpu__(Thread* __ThreadPtr__, uint32_t __Near__, int __LlcOnly__, uint32_t* __OutLoad__)
+{
+    uint32_t BestCpu   = __Near__;
+    uint64_t BestScore = ~0ULL;
+    uint32_t BestLoad  = 0xFFFFFFFF;
+
+    for (uint32_t CpuIndex = 0; CpuIndex < Smp.CpuCount; CpuIndex++)
+    {
+        if (!__CpuAllowed__(__ThreadPtr__, CpuIndex))
+        {
+            continue;
+        }
+
+        int SameLlc = CpusShareLlc(CpuIndex, __Near__);
+        if (__LlcOnly__ && !SameLlc)
+        {
+            continue;
+        }
+
+        CpuTopology* Topo        = &GetPerCpuData(CpuIndex)->Topo;
+        uint32_t     Load        = __CpuBusy__(CpuIndex);
+        uint32_t     SiblingLoad = 0;
+        for (uint32_t Index = 0; Index < Topo->SiblingCount; Index++)
+        {
+            SiblingLoad += __CpuBusy__(Topo->Siblings[Index]);
+        }
+
+        if (SiblingLoad > 0xFFFF)
+        {
+            SiblingLoad = 0xFFFF;
+        }
+
+        uint64_t Score = ((uint64_t)Load << 32) | ((uint64_t)SiblingLoad << 8) |
+                         ((uint64_t)!SameLlc << 1) | (uint64_t)(CpuIndex != __Near__);
+        if (Score < BestScore)
+        {
+            BestScore = Score;
+            BestCpu   = CpuIndex;
+            BestLoad  = Load;
+        }
+    }
+
+    if (__OutLoad__)
+    {
+        *__OutLoad__ = BestLoad;
+    }
+    return BestCpu;
+}
+
+uint32_t
+FindLeastLoadedCpu(void)
+{
+    return __BestCpu__(NULL, GetCurrentCpuId(), 0, NULL);
+}
+
+uint32_t
+CalculateOptimalCpu(Thread* __ThreadPtr__)
+{
+    if (!__ThreadPtr__)
+    {
+        return 0;
+    }
+
+    /* Start from where the thread last ran so its cache stays warm */
+    uint32_t Near = __ThreadPtr__->LastCpu < Smp.CpuCount ? __ThreadPtr__->LastCpu : 0;
+    uint32_t Load = 0xFFFFFFFF;
+    uint32_t Best = __BestCpu__(__ThreadPtr__, Near, 0, &Load);
+
+    return Load == 0xFFFFFFFF ? 0 : Best;
+}
+
+void
+ThreadExecute(Thread* __ThreadPtr__)
+{
+    if (!__ThreadPtr__)
+    {
+        return;
+    }
+
+    /* Determine best CPU for this thread */
+    uint32_t TargetCpu = CalculateOptimalCpu(__ThreadPtr__);
+
+    /* Update thread's last CPU assignment */
+    AcquireSpinLock(&ThreadListLock);
+    __ThreadPtr__->LastCpu = TargetCpu;
+    __ThreadPtr__->State   = ThreadStateReady;
+    ReleaseSpinLock(&ThreadListLock);
+
+    /* Enqueue thread in target CPU’s ready queue */
+    AddThreadToReadyQueue(TargetCpu, __ThreadPtr__);
+
+    PDebug("ThreadExecute: Thread %u assigned to CPU %u (Load: %u)\n",
+           __ThreadPtr__->ThreadId,
+           TargetCpu,
+           GetCpuLoad(TargetCpu));
+}
+
+void
+ThreadExecuteMultiple(Thread** __ThreadArray__, uint32_t __ThreadCount__)
+{
+    if (!__ThreadArray__ || __ThreadCount__ == 0)
+    {
+        return;
+    }
+
+    for (uint32_t ThreadIndex = 0; ThreadIndex < __ThreadCount__; ThreadIndex++)
+    {
+        Thread* ThreadPtr = __ThreadArray__[ThreadIndex];
+        if (!ThreadPtr)
+        {
+            continue;
+        }
+
+        uint32_t TargetCpu = CalculateOptimalCpu(ThreadPtr);
+        AcquireSpinLock(&ThreadListLock);
+        ThreadPtr->LastCpu = TargetCpu;
+        ThreadPtr->State   = ThreadStateReady;
+        ReleaseSpinLock(&ThreadListLock);
+        AddThreadToReadyQueue(TargetCpu, ThreadPtr);
+
+        PDebug("ThreadExecuteMultiple: Thread %u \u2192 CPU %u (Load: %u)\n",
+               ThreadPtr->ThreadId,
+               TargetCpu,
+               GetCpuLoad(TargetCpu));
+    }
+}
+
+void
+LoadBalanceThreads(void)
+{
+    uint32_t MaxLoad = 0;
+    uint32_t MaxCpu  = 0;
+
+    /* Gather load information */
+    for (uint32_t CpuIndex = 0; CpuIndex < Smp.CpuCount; CpuIndex++)
+    {
+        uint32_t Load = GetCpuLoad(CpuIndex);
+        if (Load > MaxLoad)
+        {
+            MaxLoad = Load;
+            MaxCpu  = CpuIndex;
+        }
+    }
+
+    if (MaxLoad == 0)
+    {
+        return;
+    }
+
+    Thread* ThreadToMigrate = GetNextThread(MaxCpu);
+    if (!ThreadToMigrate)
+    {
+        return;
+    }
+
+    /* Settle imbalance inside the last level cache first, and leave it only for a larger one */
+    uint32_t DestLoad = 0;
+    uint32_t DestCpu  = __BestCpu__(ThreadToMigrate, MaxCpu, 1, &DestLoad);
+    if (DestCpu == MaxCpu || DestLoad + TopoLlcMigrate >= MaxLoad)
+    {
+        DestCpu = __BestCpu__(ThreadToMigrate, MaxCpu, 0, &DestLoad);
+        if (DestCpu != MaxCpu && DestLoad + TopoFarMigrate >= MaxLoad)
+        {
+            DestCpu = MaxCpu;
+        }
+    }
+
+    if (DestCpu == MaxCpu)
+    {
+        /* Put thread back into original CPU’s ready queue if migration is not worth it */
+        AddThreadToReadyQueue(MaxCpu, ThreadToMigrate);
+        return;
+    }
+
+    ThreadToMigrate->LastCpu = DestCpu;
+    AddThreadToReadyQueue(DestCpu, ThreadToMigrate);
+
+    PDebug("LoadBalance: Migrated Thread %u from CPU %u to CPU %u (%s)\n",
+           ThreadToMigrate->ThreadId,
+           MaxCpu,
+           DestCpu,
+           CpusShareLlc(MaxCpu, DestCpu) ? "same LLC" : "remote");
+}
+
+void
+GetSystemLoadStats(uint32_t* __TotalThreads__,
+                   uint32_t* __AverageLoad__,
+                   uint32_t* __MaxLoad__,
+                   uint32_t* __MinLoad__)
+{
+    uint32_t TotalLoad = 0;
+    uint32_t MaxLoad   = 0;
+    uint32_t MinLoad   = 0xFFFFFFFF;
+
+    for (uint32_t CpuIndex = 0; CpuIndex < Smp.CpuCount; CpuIndex++)
+    {
+        uint32_t Load = GetCpuLoad(CpuIndex);
+        TotalLoad += Load;
+
+        if (Load > MaxLoad)
+        {
+            MaxLoad = Load;
+        }
+        if (Load < MinLoad)
+        {
+            MinLoad = Load;
+        }
+    }
+
+    if (MinLoad == 0xFFFFFFFF)
+    {
+        MinLoad = 0;
+    }
+
+    if (__TotalThreads__)
+    {
+        *__TotalThreads__ = TotalLoad;
+    }
+    if (__AverageLoad__)
+    {
+        *__AverageLoad__ = (Smp.CpuCount > 0) ? TotalLoad / Smp.CpuCount : 0;
+    }
+    if (__MaxLoad__)
+    {
+        *__MaxLoad__ = MaxLoad;
+    }
+    if (__MinLoad__)
+    {
+        *__MinLoad__ = MinLoad;
+    }
+}
@@ -0,0 +1,99 @@
+#include <AxeSchd.h>
+#include <AxeThreads.h>
+#include <Sync.h>
+
+/*
+ * Dead threads are freed here rather than on the tick path. Schedule hands a
+ * thread over only once its CPU has switched away from it, so nothing is
+ * still running on the stack being released.
+ */
+
+static Thread*  ReapList;
+static Thread*  Reaper;
+static uint32_t ReaperParked;
+static SpinLock ReapLock;
+
+void
+ReapThreads(Thread* __Chain__)
+{
+    if (!__Chain__)
+    {
+        return;
+    }
+
+    Thread* Tail = __Chain__;
+    while (Tail->ReapNext)
+    {
+        Tail = Tail->ReapNext;
+    }
+
+    AcquireSpinLock(&ReapLock);
+    Tail->ReapNext = ReapList;
+    ReapList       = __Chain__;
+    Thread* Wake   = ReaperParked ? Reaper : NULL;
+    ReaperParked   = 0;
+    ReleaseSpinLock(&ReapLock);
+
+    if (Wake)
+    {
+        WakeupThread(Wake);
+    }
+}
+
+static void
+__ReaperLoop__(void* __Arg__)
+{
+    (void)__Arg__;
+
+    for (;;)
+    {
+        AcquireSpinLock(&ReapLock);
+        Thread* Batch = ReapList;
+        ReapList      = NULL;
+        if (!Batch)
+        {
+            /*Park; the next handoff sees the flag under this lock and wakes us*/
+            ReaperParked       = 1;
+            Reaper->WaitReason = WaitReasonIo;
+            Reaper->State      = ThreadStateBlocked;
+            ReleaseSpinLock(&ReapLock);
+            ThreadYield();
+            continue;
+        }
+        ReleaseSpinLock(&ReapLock);
+
+        /*Frees run with interrupts on; yield now and then so a mass exit stays fair*/
+        uint32_t Count = 0;
+        while (Batch)
+        {
+            Thread* Next = Batch->ReapNext;
+            DestroyThread(Batch);
+            Batch = Next;
+
+            if (++Count % ReaperBatch == 0)
+            {
+                ThreadYield();
+            }
+        }
+    }
+}
+
+void
+InitializeReaper(void)
+{
+    InitializeSpinLock(&ReapLock, "Reaper");
+
+    Thread* Th = CreateThread(ThreadTypeKernel, (void*)__ReaperLoop__, NULL, ThreadPriorityNormal);
+    if (!Th)
+    {
+        PError("Reaper: thread create failed\n");
+        return;
+    }
+
+    Th->Flags |= ThreadFlagSystem;
+    SetThreadName(Th, "kreaper");
+    Reaper = Th;
+    ThreadExecute(Th);
+
+    PSuccess("Reaper: dead threads are freed by thread %u\n", Th->ThreadId);
+}
@@ -0,0 +1,392 @@
+#include <AxeSchd.h>
+#include <String.h>
+#include <Timer.h>
+
+SchedGroup SchedGroups[MaxSchedGroups];
+
+static SpinLock SchedGroupsLock; /*Create, destroy and attach*/
+static Thread*  GroupIdle[MaxCPUs];
+
+static void
+__GroupIdleLoop__(void* __Arg__)
+{
+    (void)__Arg__;
+    for (;;)
+    {
+        __asm__ volatile("sti; hlt");
+    }
+}
+
+void
+InitializeSchedGroups(void)
+{
+    InitializeSpinLock(&SchedGroupsLock, "SchedGroups");
+
+    for (uint32_t Index = 0; Index < MaxSchedGroups; Index++)
+    {
+        memset(&SchedGroups[Index], 0, sizeof(SchedGroup));
+        InitializeSpinLock(&SchedGroups[Index].Lock, "SchedGroup");
+    }
+
+    SchedGroup* Root = &SchedGroups[SchedGroupRoot];
+    StringCopy(Root->Name, "root", SchedGroupNameLen);
+    Root->InUse  = 1;
+    Root->Shares = SchedGroupDefaultShares;
+
+    /*
+     * Where a CPU parks when its thread blocks or everything runnable on it
+     * is over quota. Schedule halts a CPU that has none, so do it here.
+     */
+    for (uint32_t CpuIndex = 0; CpuIndex < Smp.CpuCount; CpuIndex++)
+    {
+        Thread* Idle =
+            CreateThread(ThreadTypeKernel, (void*)__GroupIdleLoop__, NULL, ThreadPriorityIdle);
+        if (!Idle)
+        {
+            PError("SchedGroup: No idle thread for CPU %u, it could not park blocked threads\n",
+                   CpuIndex);
+            for (;;)
+            {
+                __asm__ volatile("cli; hlt");
+            }
+        }
+        Idle->Flags |= ThreadFlagIdle | ThreadFlagSystem | ThreadFlagPinned;
+        Idle->CpuAffinity   = 1U << (CpuIndex & 31);
+        Idle->State         = ThreadStateBlocked;
+        GroupIdle[CpuIndex] = Idle;
+    }
+
+    PSuccess("SchedGroup: CPU groups initialized\n");
+}
+
+Thread*
+SchedGroupIdleThread(uint32_t __CpuId__)
+{
+    return __CpuId__ < MaxCPUs ? GroupIdle[__CpuId__] : NULL;
+}
+
+static inline SchedGroup*
+__GroupOf__(uint32_t __GroupId__)
+{
+    if (__GroupId__ >= MaxSchedGroups || !SchedGroups[__GroupId__].InUse)
+    {
+        return NULL;
+    }
+    return &SchedGroups[__GroupId__];
+}
+
+int
+SchedGroupCreate(const char* __Name__, uint32_t __Parent__)
+{
+    if (!__Name__ || !__Name__[0])
+    {
+        return -1;
+    }
+
+    AcquireSpinLock(&SchedGroupsLock);
+
+    SchedGroup* Parent = __GroupOf__(__Parent__);
+    if (!Parent)
+    {
+        ReleaseSpinLock(&SchedGroupsLock);
+        return -1;
+    }
+
+    for (uint32_t Index = 1; Index < MaxSchedGroups; Index++)
+    {
+        SchedGroup* Group = &SchedGroups[Index];
+        if (Group->InUse)
+        {
+            continue;
+        }
+
+        memset(Group->Cpu, 0, sizeof(Group->Cpu));
+        StringCopy(Group->Name, __Name__, SchedGroupNameLen);
+        Group->Parent         = __Parent__;
+        Group->Shares         = SchedGroupDefaultShares;
+        Group->Members        = 0;
+        Group->Queued         = 0;
+        Group->Children       = 0;
+        Group->Generation     = 1;
+        Group->ThrottledGen   = 0;
+        Group->QuotaTicks     = 0;
+        Group->PeriodTicks    = 0;
+        Group->PeriodStart    = GetSystemTicks();
+        Group->PoolLeft       = 0;
+        Group->Usage          = 0;
+        Group->Throttled      = 0;
+        Group->ThrottledPicks = 0;
+        Parent->Children++;
+        __atomic_store_n(&Group->InUse, 1, __ATOMIC_SEQ_CST);
+
+        ReleaseSpinLock(&SchedGroupsLock);
+        PDebug("SchedGroup: Created %s (%u) under %u\n", Group->Name, Index, __Parent__);
+        return (int)Index;
+    }
+
+    ReleaseSpinLock(&SchedGroupsLock);
+    PError("SchedGroup: No free group for %s\n", __Name__);
+    return -1;
+}
+
+int
+SchedGroupDestroy(uint32_t __GroupId__)
+{
+    if (__GroupId__ == SchedGroupRoot)
+    {
+        return -1;
+    }
+
+    AcquireSpinLock(&SchedGroupsLock);
+
+    SchedGroup* Group = __GroupOf__(__GroupId__);
+    if (!Group || Group->Members || Group->Children)
+    {
+        ReleaseSpinLock(&SchedGroupsLock);
+        return -1;
+    }
+
+    SchedGroups[Group->Parent].Children--;
+    __atomic_store_n(&Group->InUse, 0, __ATOMIC_SEQ_CST);
+
+    ReleaseSpinLock(&SchedGroupsLock);
+    return 0;
+}
+
+int
+SchedGroupSetShares(uint32_t __GroupId__, uint32_t __Shares__)
+{
+    SchedGroup* Group = __GroupOf__(__GroupId__);
+    if (!Group || __Shares__ < SchedGroupMinShares || __Shares__ > SchedGroupMaxShares)
+    {
+        return -1;
+    }
+
+    __atomic_store_n(&Group->Shares, __Shares__, __ATOMIC_SEQ_CST);
+    return 0;
+}
+
+int
+SchedGroupSetQuota(uint32_t __GroupId__, uint64_t __QuotaTicks__, uint64_t __PeriodTicks__)
+{
+    SchedGroup* Group = __GroupOf__(__GroupId__);
+    if (!Group || __GroupId__ == SchedGroupRoot)
+    {
+        return -1;
+    }
+    if (__QuotaTicks__ && (!__PeriodTicks__ || __QuotaTicks__ > __PeriodTicks__ * Smp.CpuCount))
+    {
+        return -1;
+    }
+
+    AcquireSpinLock(&Group->Lock);
+    Group->QuotaTicks  = __QuotaTicks__;
+    Group->PeriodTicks = __PeriodTicks__;
+    Group->PeriodStart = GetSystemTicks();
+    Group->PoolLeft    = __QuotaTicks__;
+    Group->Generation++;
+    ReleaseSpinLock(&Group->Lock);
+
+    PDebug("SchedGroup: %s limited to %lu/%lu ticks\n",
+           Group->Name,
+           __QuotaTicks__,
+           __PeriodTicks__);
+    return 0;
+}
+
+int
+SchedGroupAttach(Thread* __ThreadPtr__, uint32_t __GroupId__)
+{
+    if (!__ThreadPtr__ || (__ThreadPtr__->Flags & ThreadFlagIdle))
+    {
+        return -1;
+    }
+
+    AcquireSpinLock(&SchedGroupsLock);
+
+    SchedGroup* To = __GroupOf__(__GroupId__);
+    if (!To)
+    {
+        ReleaseSpinLock(&SchedGroupsLock);
+        return -1;
+    }
+
+    /*A queued thread carries its Queued count over to the new group*/
+    int         Queued = __ThreadPtr__->State == ThreadStateReady;
+    SchedGroup* From   = &SchedGroups[__ThreadPtr__->GroupId];
+    __atomic_fetch_sub(&From->Members, 1, __ATOMIC_SEQ_CST);
+    __atomic_fetch_add(&To->Members, 1, __ATOMIC_SEQ_CST);
+    if (Queued)
+    {
+        __atomic_fetch_sub(&From->Queued, 1, __ATOMIC_SEQ_CST);
+        __atomic_fetch_add(&To->Queued, 1, __ATOMIC_SEQ_CST);
+    }
+    __atomic_store_n(&__ThreadPtr__->GroupId, __GroupId__, __ATOMIC_SEQ_CST);
+
+    ReleaseSpinLock(&SchedGroupsLock);
+    return 0;
+}
+
+/*New threads land in the group of whoever created them*/
+void
+SchedGroupInherit(Thread* __ThreadPtr__)
+{
+    uint32_t CpuId   = GetCurrentCpuId();
+    Thread*  Creator = CpuId < MaxCPUs ? CpuSchedulers[CpuId].CurrentThread : NULL;
+    uint32_t GroupId = (Creator && !(Creator->Flags & ThreadFlagIdle)) ? Creator->GroupId
+                                                                       : SchedGroupRoot;
+
+    __ThreadPtr__->GroupId = GroupId;
+    __atomic_fetch_add(&SchedGroups[GroupId].Members, 1, __ATOMIC_SEQ_CST);
+}
+
+void
+SchedGroupLeave(Thread* __ThreadPtr__)
+{
+    __atomic_fetch_sub(&SchedGroups[__ThreadPtr__->GroupId].Members, 1, __ATOMIC_SEQ_CST);
+}
+
+void
+SchedGroupQueued(Thread* __ThreadPtr__, int __Delta__)
+{
+    if (__ThreadPtr__->GroupId == SchedGroupRoot)
+    {
+        return;
+    }
+    __atomic_fetch_add(&SchedGroups[__ThreadPtr__->GroupId].Queued, __Delta__, __ATOMIC_SEQ_CST);
+}
+
+/*Caller holds nothing; refills the global pool once a period has elapsed*/
+static void
+__GroupRefill__(SchedGroup* __Group__, uint64_t __Now__)
+{
+    if (__Now__ - __Group__->PeriodStart < __Group__->PeriodTicks)
+    {
+        return;
+    }
+
+    AcquireSpinLock(&__Group__->Lock);
+    if (__Now__ - __Group__->PeriodStart >= __Group__->PeriodTicks)
+    {
+        __Group__->PeriodStart = __Now__;
+        __Group__->PoolLeft    = __Group__->QuotaTicks;
+        __Group__->Generation++;
+    }
+    ReleaseSpinLock(&__Group__->Lock);
+}
+
+/*Returns the runtime this CPU holds for the group, topping it up from the pool if empty*/
+static uint32_t
+__GroupRuntime__(SchedGroup* __Group__, uint32_t __CpuId__)
+{
+    SchedGroupCpu* Local = &__Group__->Cpu[__CpuId__];
+
+    /*Leftovers from an earlier period expire*/
+    uint32_t Generation = __atomic_load_n(&__Group__->Generation, __ATOMIC_SEQ_CST);
+    if (Local->Generation != Generation)
+    {
+        Local->Generation  = Generation;
+        Local->RuntimeLeft = 0;
+    }
+
+    if (Local->RuntimeLeft)
+    {
+        return Local->RuntimeLeft;
+    }
+
+    AcquireSpinLock(&__Group__->Lock);
+    uint64_t Take = __Group__->PoolLeft < SchedGroupSlice ? __Group__->PoolLeft : SchedGroupSlice;
+    __Group__->PoolLeft -= Take;
+    if (!Take && __Group__->ThrottledGen != __Group__->Generation)
+    {
+        __Group__->ThrottledGen = __Group__->Generation;
+        __Group__->Throttled++;
+    }
+    ReleaseSpinLock(&__Group__->Lock);
+
+    Local->RuntimeLeft = (uint32_t)Take;
+    return Local->RuntimeLeft;
+}
+
+void
+SchedGroupCharge(Thread* __ThreadPtr__, uint32_t __CpuId__)
+{
+    if (__ThreadPtr__->GroupId == SchedGroupRoot || __CpuId__ >= MaxCPUs)
+    {
+        return;
+    }
+
+    /*Usage rolls up so a parent sees its whole subtree*/
+    uint32_t GroupId = __ThreadPtr__->GroupId;
+    while (GroupId != SchedGroupRoot)
+    {
+        SchedGroup* Group = &SchedGroups[GroupId];
+        __atomic_fetch_add(&Group->Usage, 1, __ATOMIC_SEQ_CST);
+
+        SchedGroupCpu* Local = &Group->Cpu[__CpuId__];
+        if (Group->QuotaTicks && Local->RuntimeLeft &&
+            Local->Generation == __atomic_load_n(&Group->Generation, __ATOMIC_SEQ_CST))
+        {
+            Local->RuntimeLeft--;
+        }
+        GroupId = Group->Parent;
+    }
+}
+
+int
+SchedGroupThrottled(Thread* __ThreadPtr__, uint32_t __CpuId__)
+{
+    if (__ThreadPtr__->GroupId == SchedGroupRoot || __CpuId__ >= MaxCPUs)
+    {
+        return 0;
+    }
+
+    /*Any capped ancestor that is out of runtime holds the whole subtree back*/
+    uint64_t Now     = GetSystemTicks();
+    uint32_t GroupId = __ThreadPtr__->GroupId;
+    while (GroupId != SchedGroupRoot)
+    {
+        SchedGroup* Group = &SchedGroups[GroupId];
+        if (Group->QuotaTicks)
+        {
+            __GroupRefill__(Group, Now);
+            if (!__GroupRuntime__(Group, __CpuId__))
+            {
+                __atomic_fetch_add(&SchedGroups[__ThreadPtr__->GroupId].ThrottledPicks,
+                                   1,
+                                   __ATOMIC_SEQ_CST);
+                return 1;
+            }
+        }
+        GroupId = Group->Parent;
+    }
+    return 0;
+}
+
+/*
+ * A group of N queued threads runs as one thread weighted by Shares, so each
+ * member's stride is stretched by N and by how far Shares sits below the default.
+ * Only the leaf group is weighed; parents still cap through their quota.
+ */
+uint32_t
+SchedGroupStride(Thread* __ThreadPtr__, uint32_t __Stride__)
+{
+    if (__ThreadPtr__->GroupId == SchedGroupRoot)
+    {
+        return __Stride__;
+    }
+
+    SchedGroup* Group  = &SchedGroups[__ThreadPtr__->GroupId];
+    uint64_t    Weight = __atomic_load_n(&Group->Queued, __ATOMIC_SEQ_CST) + 1;
+    uint64_t    Stride = ((uint64_t)__Stride__ * Weight * SchedGroupDefaultShares) / Group->Shares;
+
+    if (Stride < 1)
+    {
+        Stride = 1;
+    }
+    if (Stride > SchedGroupMaxStride)
+    {
+        Stride = SchedGroupMaxStride;
+    }
+    return (uint32_t)Stride;
+}
@@ -3,7 +3,8 @@
 #include <IDT.h>
 #include <Timer.h>
 
-CpuScheduler CpuSchedulers[MaxCPUs];
+CpuScheduler    CpuSchedulers[MaxCPUs];
+RtSchedTunables RtTunables = {SchedRrDefaultQuantum, SchedRtDefaultPeriod, SchedRtDefaultRuntime};
 
 static inline void
 ThreadFxSave(void* __State__)
@@ -17,14 +18,63 @@ ThreadFxRestore(const void* __State__)
     __asm__ volatile("fxrstor %0" ::"m"(*(const char (*)[512])__State__));
 }
 
-void
-AddThreadToReadyQueue(uint32_t __CpuId__, Thread* __ThreadPtr__)
+/*Caller holds SchedulerLock*/
+static void
+__EnqueueReadyLocked__(CpuScheduler* __Scheduler__, Thread* __ThreadPtr__, int __AtHead__)
 {
-    if (__CpuId__ >= MaxCPUs || !__ThreadPtr__)
+    ThreadAcctQueued(__ThreadPtr__);
+    SchedGroupQueued(__ThreadPtr__, 1);
+
+    if (__ThreadPtr__->Policy != SchedPolicyNormal)
     {
-        return;
+        /*Ordered by RtPriority; FIFO within a level unless the thread keeps its place*/
+        Thread* Prev = NULL;
+        Thread* Curr = __Scheduler__->RtQueue;
+        while (Curr && (Curr->RtPriority > __ThreadPtr__->RtPriority ||
+                        (!__AtHead__ && Curr->RtPriority == __ThreadPtr__->RtPriority)))
+        {
+            Prev = Curr;
+            Curr = Curr->Next;
+        }
+
+        __ThreadPtr__->Prev = Prev;
+        __ThreadPtr__->Next = Curr;
+        if (Curr)
+        {
+            Curr->Prev = __ThreadPtr__;
+        }
+        if (Prev)
+        {
+            Prev->Next = __ThreadPtr__;
+        }
+        else
+        {
+            __Scheduler__->RtQueue = __ThreadPtr__;
+        }
+
+        __Scheduler__->RtReadyCount++;
     }
+    else if (!__Scheduler__->ReadyQueue)
+    {
+        __Scheduler__->ReadyQueue = __ThreadPtr__;
+    }
+    else
+    {
+        Thread* Tail = __Scheduler__->ReadyQueue;
+        while (Tail->Next)
+        {
+            Tail = Tail->Next;
+        }
+        Tail->Next          = __ThreadPtr__;
+        __ThreadPtr__->Prev = Tail;
+    }
+
+    __Scheduler__->ReadyCount++;
+}
 
+static void
+__AddReady__(uint32_t __CpuId__, Thread* __ThreadPtr__, int __AtHead__)
+{
     CpuScheduler* Scheduler = &CpuSchedulers[__CpuId__];
 
     __atomic_store_n(&__ThreadPtr__->State, ThreadStateReady, __ATOMIC_SEQ_CST);
@@ -32,27 +82,52 @@ AddThreadToReadyQueue(uint32_t __CpuId__, Thread* __ThreadPtr__)
     __ThreadPtr__->Next = NULL;
     __ThreadPtr__->Prev = NULL;
 
-    AcquireSpinLock(&Scheduler->SchedulerLock);
+    AcquireMcsLock(&Scheduler->SchedulerLock);
+
+    /* increment while still holding the lock */
+    __EnqueueReadyLocked__(Scheduler, __ThreadPtr__, __AtHead__);
+
+    ReleaseMcsLock(&Scheduler->SchedulerLock);
+}
 
-    if (!Scheduler->ReadyQueue)
+void
+AddThreadToReadyQueue(uint32_t __CpuId__, Thread* __ThreadPtr__)
+{
+    if (__CpuId__ >= MaxCPUs || !__ThreadPtr__)
     {
-        Scheduler->ReadyQueue = __ThreadPtr__;
+        return;
     }
-    else
+
+    __AddReady__(__CpuId__, __ThreadPtr__, 0);
+}
+
+static Thread*
+__RemoveRealtime__(CpuScheduler* __Scheduler__)
+{
+    AcquireMcsLock(&__Scheduler__->SchedulerLock);
+
+    Thread* ThreadPtr = __Scheduler__->RtQueue;
+    if (ThreadPtr)
     {
-        Thread* Tail = Scheduler->ReadyQueue;
-        while (Tail->Next)
+        __Scheduler__->RtQueue = ThreadPtr->Next;
+        if (ThreadPtr->Next)
         {
-            Tail = Tail->Next;
+            ThreadPtr->Next->Prev = NULL;
         }
-        Tail->Next          = __ThreadPtr__;
-        __ThreadPtr__->Prev = Tail;
-    }
 
-    /* increment while still holding the lock */
-    Scheduler->ReadyCount++;
+        ThreadPtr->Next = NULL;
+        ThreadPtr->Prev = NULL;
+        SchedGroupQueued(ThreadPtr, -1);
+
+        __Scheduler__->RtReadyCount--;
+        if (__Scheduler__->ReadyCount > 0)
+        {
+            __Scheduler__->ReadyCount--;
+        }
+    }
 
-    ReleaseSpinLock(&Scheduler->SchedulerLock);
+    ReleaseMcsLock(&__Scheduler__->SchedulerLock);
+    return ThreadPtr;
 }
 
 Thread*
@@ -65,12 +140,12 @@ RemoveThreadFromReadyQueue(uint32_t __CpuId__)
 
     CpuScheduler* Scheduler = &CpuSchedulers[__CpuId__];
 
-    AcquireSpinLock(&Scheduler->SchedulerLock);
+    AcquireMcsLock(&Scheduler->SchedulerLock);
 
     Thread* ThreadPtr = Scheduler->ReadyQueue;
     if (!ThreadPtr)
     {
-        ReleaseSpinLock(&Scheduler->SchedulerLock);
+        ReleaseMcsLock(&Scheduler->SchedulerLock);
         return NULL;
     }
 
@@ -82,6 +157,7 @@ RemoveThreadFromReadyQueue(uint32_t __CpuId__)
 
     ThreadPtr->Next = NULL;
     ThreadPtr->Prev = NULL;
+    SchedGroupQueued(ThreadPtr, -1);
 
     /* decrement while still holding the lock */
     if (Scheduler->ReadyCount > 0)
@@ -89,7 +165,7 @@ RemoveThreadFromReadyQueue(uint32_t __CpuId__)
         Scheduler->ReadyCount--;
     }
 
-    ReleaseSpinLock(&Scheduler->SchedulerLock);
+    ReleaseMcsLock(&Scheduler->SchedulerLock);
     return ThreadPtr;
 }
 
@@ -107,14 +183,82 @@ AddThreadToWaitingQueue(uint32_t __CpuId__, Thread* __ThreadPtr__)
     __atomic_store_n(&__ThreadPtr__->State, ThreadStateBlocked, __ATOMIC_SEQ_CST);
 
     /* Acquire spinlock before modifying the waiting queue */
-    AcquireSpinLock(&Scheduler->SchedulerLock);
+    AcquireMcsLock(&Scheduler->SchedulerLock);
+
+    /* A wakeup that raced with the switch-out turns the block into a requeue */
+    if (__atomic_fetch_and(&__ThreadPtr__->Flags, ~ThreadFlagWakeup, __ATOMIC_SEQ_CST) &
+        ThreadFlagWakeup)
+    {
+        __ThreadPtr__->State      = ThreadStateReady;
+        __ThreadPtr__->WaitReason = WaitReasonNone;
+        __ThreadPtr__->Next       = NULL;
+        __ThreadPtr__->Prev       = NULL;
+        __EnqueueReadyLocked__(Scheduler, __ThreadPtr__, 0);
+        ReleaseMcsLock(&Scheduler->SchedulerLock);
+        return;
+    }
 
     /* Add thread at head of waiting queue */
     __ThreadPtr__->Next     = Scheduler->WaitingQueue;
     Scheduler->WaitingQueue = __ThreadPtr__;
 
     /* Release spinlock after modification */
-    ReleaseSpinLock(&Scheduler->SchedulerLock);
+    ReleaseMcsLock(&Scheduler->SchedulerLock);
+}
+
+void
+WakeupThread(Thread* __ThreadPtr__)
+{
+    if (!__ThreadPtr__)
+    {
+        return;
+    }
+
+    uint32_t CpuId = __atomic_load_n(&__ThreadPtr__->LastCpu, __ATOMIC_SEQ_CST);
+    if (CpuId >= MaxCPUs)
+    {
+        return;
+    }
+
+    CpuScheduler* Scheduler = &CpuSchedulers[CpuId];
+    AcquireMcsLock(&Scheduler->SchedulerLock);
+
+    Thread* Prev = NULL;
+    Thread* Curr = Scheduler->WaitingQueue;
+    while (Curr && Curr != __ThreadPtr__)
+    {
+        Prev = Curr;
+        Curr = Curr->Next;
+    }
+
+    if (Curr)
+    {
+        if (Prev)
+        {
+            Prev->Next = Curr->Next;
+        }
+        else
+        {
+            Scheduler->WaitingQueue = Curr->Next;
+        }
+
+        /* A thread killed while blocked stays terminated and is reaped once dequeued */
+        if (Curr->State != ThreadStateTerminated)
+        {
+            Curr->State = ThreadStateReady;
+        }
+        Curr->WaitReason = WaitReasonNone;
+        Curr->Next       = NULL;
+        Curr->Prev       = NULL;
+        __EnqueueReadyLocked__(Scheduler, Curr, 0);
+    }
+    else
+    {
+        /* Still on its way off the CPU; AddThreadToWaitingQueue will see this */
+        __atomic_fetch_or(&__ThreadPtr__->Flags, ThreadFlagWakeup, __ATOMIC_SEQ_CST);
+    }
+
+    ReleaseMcsLock(&Scheduler->SchedulerLock);
 }
 
 void
@@ -131,14 +275,14 @@ AddThreadToZombieQueue(uint32_t __CpuId__, Thread* __ThreadPtr__)
     __atomic_store_n(&__ThreadPtr__->State, ThreadStateZombie, __ATOMIC_SEQ_CST);
 
     /* Acquire spinlock before modifying zombie queue */
-    AcquireSpinLock(&Scheduler->SchedulerLock);
+    AcquireMcsLock(&Scheduler->SchedulerLock);
 
-    /* Insert thread at the head of zombie queue */
-    __ThreadPtr__->Next    = Scheduler->ZombieQueue;
-    Scheduler->ZombieQueue = __ThreadPtr__;
+    /* Insert thread at the head of zombie queue, leaving Next/Prev to the thread list */
+    __ThreadPtr__->ReapNext = Scheduler->ZombieQueue;
+    Scheduler->ZombieQueue  = __ThreadPtr__;
 
     /* Release spinlock */
-    ReleaseSpinLock(&Scheduler->SchedulerLock);
+    ReleaseMcsLock(&Scheduler->SchedulerLock);
 
     /* Decrement overall thread count atomically */
     __atomic_fetch_sub(&Scheduler->ThreadCount, 1, __ATOMIC_SEQ_CST);
@@ -158,14 +302,14 @@ AddThreadToSleepingQueue(uint32_t __CpuId__, Thread* __ThreadPtr__)
     __atomic_store_n(&__ThreadPtr__->State, ThreadStateSleeping, __ATOMIC_SEQ_CST);
 
     /* Lock scheduler queue for safe insertion */
-    AcquireSpinLock(&Scheduler->SchedulerLock);
+    AcquireMcsLock(&Scheduler->SchedulerLock);
 
     /* Insert at head of sleeping queue */
     __ThreadPtr__->Next      = Scheduler->SleepingQueue;
     Scheduler->SleepingQueue = __ThreadPtr__;
 
     /* Unlock after modification */
-    ReleaseSpinLock(&Scheduler->SchedulerLock);
+    ReleaseMcsLock(&Scheduler->SchedulerLock);
 }
 
 void
@@ -235,7 +379,7 @@ WakeupSleepingThreads(uint32_t __CpuId__)
     CpuScheduler* Scheduler    = &CpuSchedulers[__CpuId__];
     uint64_t      CurrentTicks = GetSystemTicks();
 
-    AcquireSpinLock(&Scheduler->SchedulerLock);
+    AcquireMcsLock(&Scheduler->SchedulerLock);
 
     Thread* Current = Scheduler->SleepingQueue;
     Thread* Prev    = NULL;
@@ -258,27 +402,15 @@ WakeupSleepingThreads(uint32_t __CpuId__)
 
             __atomic_store_n(&Current->WaitReason, WaitReasonNone, __ATOMIC_SEQ_CST);
             __atomic_store_n(&Current->WakeupTime, 0, __ATOMIC_SEQ_CST);
-            Current->State = ThreadStateReady;
-            Current->Prev  = NULL;
-            Current->Next  = NULL;
-
-            /* splice into ready tail under lock */
-            if (!Scheduler->ReadyQueue)
-            {
-                Scheduler->ReadyQueue = Current;
-            }
-            else
+            if (Current->State != ThreadStateTerminated)
             {
-                Thread* Tail = Scheduler->ReadyQueue;
-                while (Tail->Next)
-                {
-                    Tail = Tail->Next;
-                }
-                Tail->Next    = Current;
-                Current->Prev = Tail;
+                Current->State = ThreadStateReady;
             }
+            Current->Prev = NULL;
+            Current->Next = NULL;
 
-            Scheduler->ReadyCount++;
+            /* splice into ready tail (or RT queue) under lock */
+            __EnqueueReadyLocked__(Scheduler, Current, 0);
         }
         else
         {
@@ -288,7 +420,7 @@ WakeupSleepingThreads(uint32_t __CpuId__)
         Current = Next;
     }
 
-    ReleaseSpinLock(&Scheduler->SchedulerLock);
+    ReleaseMcsLock(&Scheduler->SchedulerLock);
 }
 
 void
@@ -301,22 +433,23 @@ CleanupZombieThreads(uint32_t __CpuId__)
 
     CpuScheduler* Scheduler = &CpuSchedulers[__CpuId__];
 
+    /* Nothing died here since the last tick, the common case */
+    if (!__atomic_load_n(&Scheduler->ZombieQueue, __ATOMIC_SEQ_CST))
+    {
+        return;
+    }
+
     /* Acquire spinlock before clearing zombie queue */
-    AcquireSpinLock(&Scheduler->SchedulerLock);
+    AcquireMcsLock(&Scheduler->SchedulerLock);
 
     /* Extract zombie queue and clear it quickly under lock */
     Thread* Current        = Scheduler->ZombieQueue;
     Scheduler->ZombieQueue = NULL;
 
-    ReleaseSpinLock(&Scheduler->SchedulerLock);
+    ReleaseMcsLock(&Scheduler->SchedulerLock);
 
-    /* Destroy freed zombie threads outside the lock to avoid long lock holds */
-    while (Current)
-    {
-        Thread* Next = Current->Next;
-        DestroyThread(Current);
-        Current = Next;
-    }
+    /* Freeing is the reaper's job; the tick only hands the chain over */
+    ReapThreads(Current);
 }
 
 void
@@ -346,9 +479,17 @@ InitializeCpuScheduler(uint32_t __CpuId__)
     __atomic_store_n(&Scheduler->LoadAverage, 0, __ATOMIC_SEQ_CST);
     __atomic_store_n(&Scheduler->ScheduleTicks, 0, __ATOMIC_SEQ_CST);
     __atomic_store_n(&Scheduler->LastSchedule, 0, __ATOMIC_SEQ_CST);
+    __atomic_store_n(&Scheduler->PreemptCount, 0, __ATOMIC_SEQ_CST);
+
+    /* Fresh RT accounting period */
+    Scheduler->RtQueue       = NULL;
+    Scheduler->RtReadyCount  = 0;
+    Scheduler->RtPeriodStart = 0;
+    Scheduler->RtRuntimeUsed = 0;
+    Scheduler->RtThrottled   = 0;
 
     /* Initialize spinlock with identifier for debug */
-    InitializeSpinLock(&Scheduler->SchedulerLock, "CpuScheduler");
+    InitializeMcsLock(&Scheduler->SchedulerLock, "CpuScheduler");
 
     PDebug("CPU %u scheduler initialized\n", __CpuId__);
 }
@@ -432,6 +573,22 @@ LoadThreadContextToInterruptFrame(Thread* __ThreadPtr__, InterruptFrame* __Frame
     __Frame__->Ss     = Context->Ss;
 }
 
+/*Where a CPU goes when the thread it was running cannot go on; init makes one per CPU*/
+static Thread*
+__ParkedIdle__(uint32_t __CpuId__)
+{
+    Thread* Idle = SchedGroupIdleThread(__CpuId__);
+    if (!Idle)
+    {
+        PError("Schedule: CPU %u has no idle thread to park on\n", __CpuId__);
+        for (;;)
+        {
+            __asm__ volatile("cli; hlt");
+        }
+    }
+    return Idle;
+}
+
 void
 Schedule(uint32_t __CpuId__, InterruptFrame* __Frame__)
 {
@@ -443,12 +600,31 @@ Schedule(uint32_t __CpuId__, InterruptFrame* __Frame__)
     CpuScheduler* Scheduler  = &CpuSchedulers[__CpuId__];
     Thread*       Current    = Scheduler->CurrentThread;
     Thread*       NextThread = NULL;
+    uint32_t      Throttled  = 0;
+
+    /* The tick only gets here outside preempt-off sections, so no RCU reader is running */
+    RcuQuiescentState(__CpuId__);
 
     /* Update scheduler tick counters */
+    uint64_t Now = GetSystemTicks();
     __atomic_fetch_add(&Scheduler->ScheduleTicks, 1, __ATOMIC_SEQ_CST);
-    __atomic_store_n(&Scheduler->LastSchedule, GetSystemTicks(), __ATOMIC_SEQ_CST);
+    __atomic_store_n(&Scheduler->LastSchedule, Now, __ATOMIC_SEQ_CST);
+
+    /* Roll the RT budget over at each period boundary */
+    if (Now - Scheduler->RtPeriodStart >= RtTunables.RtPeriod)
+    {
+        Scheduler->RtPeriodStart = Now;
+        Scheduler->RtRuntimeUsed = 0;
+    }
+
+    /*
+     * Threads that died on this CPU last time are off its stack by now. Zombies
+     * queued below wait for the next tick, since this frame may still be theirs.
+     */
+    CleanupZombieThreads(__CpuId__);
 
-    /* If there is a currently running thread */
+    /* If there is a currently running thread; Parked once its frame must not be resumed */
+    int Parked = 0;
     if (Current)
     {
         /*FPU*/
@@ -457,58 +633,121 @@ Schedule(uint32_t __CpuId__, InterruptFrame* __Frame__)
         /* Save current thread's CPU context */
         SaveInterruptFrameToThread(Current, __Frame__);
         __atomic_fetch_add(&Current->CpuTime, 1, __ATOMIC_SEQ_CST);
+        ThreadAcctCharge(Current, AcctIrq);
+        SchedGroupCharge(Current, __CpuId__);
 
-        /* Handle current thread's state transitions */
-        switch (Current->State)
+        int KeepPlace = 0;
+        if (Current->Policy != SchedPolicyNormal)
         {
-            case ThreadStateRunning:
-                /* Thread was preempted normally, add it back to ready queue */
-                AddThreadToReadyQueue(__CpuId__, Current);
-                break;
-
-            case ThreadStateTerminated:
-                /* Thread has finished, move it to zombie queue */
-                AddThreadToZombieQueue(__CpuId__, Current);
-                break;
-
-            case ThreadStateBlocked:
-                /* Thread is waiting for I/O or resource, move to waiting queue */
-                AddThreadToWaitingQueue(__CpuId__, Current);
-                break;
-
-            case ThreadStateSleeping:
-                /* Thread is sleeping, add it to sleeping queue */
-                AddThreadToSleepingQueue(__CpuId__, Current);
-                break;
-
-            case ThreadStateReady:
-                /* Thread yielded CPU voluntarily, add back to ready queue */
-                AddThreadToReadyQueue(__CpuId__, Current);
-                break;
-
-            default:
-                /* Unknown state, safeguard by marking ready and enqueue */
-                Current->State = ThreadStateReady;
-                AddThreadToReadyQueue(__CpuId__, Current);
-                break;
+            Scheduler->RtRuntimeUsed++;
+            if (Scheduler->RtRuntimeUsed == RtTunables.RtRuntime)
+            {
+                Scheduler->RtThrottled++;
+            }
+
+            /* FIFO keeps the head of its level; RR keeps it until the quantum runs out */
+            KeepPlace = 1;
+            if (Current->Policy == SchedPolicyRr)
+            {
+                if (Current->RtSliceLeft <= 1)
+                {
+                    Current->RtSliceLeft = RtTunables.RrQuantum;
+                    KeepPlace            = 0;
+                }
+                else
+                {
+                    Current->RtSliceLeft--;
+                }
+            }
+        }
+
+        /* The idle thread is parked, never queued */
+        if (Current->Flags & ThreadFlagIdle)
+        {
+            Current->State = ThreadStateBlocked;
+            Parked         = 1;
+        }
+        else
+        {
+            /* Handle current thread's state transitions */
+            switch (Current->State)
+            {
+                case ThreadStateRunning:
+                    /* Thread was preempted normally, add it back to ready queue */
+                    __AddReady__(__CpuId__, Current, KeepPlace);
+                    break;
+
+                case ThreadStateTerminated:
+                case ThreadStateZombie:
+                    /* Thread has finished, move it to zombie queue */
+                    AddThreadToZombieQueue(__CpuId__, Current);
+                    Parked = 1;
+                    break;
+
+                case ThreadStateBlocked:
+                    /* Thread is waiting for I/O or resource, move to waiting queue */
+                    AddThreadToWaitingQueue(__CpuId__, Current);
+                    Parked = 1;
+                    break;
+
+                case ThreadStateSleeping:
+                    /* Thread is sleeping, add it to sleeping queue */
+                    AddThreadToSleepingQueue(__CpuId__, Current);
+                    Parked = 1;
+                    break;
+
+                case ThreadStateReady:
+                    /* Thread yielded CPU voluntarily, add back to ready queue */
+                    AddThreadToReadyQueue(__CpuId__, Current);
+                    break;
+
+                default:
+                    /* Unknown state, safeguard by marking ready and enqueue */
+                    Current->State = ThreadStateReady;
+                    AddThreadToReadyQueue(__CpuId__, Current);
+                    break;
+            }
         }
     }
 
 SelectAgain:
-    /* Attempt to wake up any sleeping threads whose timeout expired */
-    WakeupSleepingThreads(__CpuId__);
-
-    /* Cleanup any zombie threads */
-    CleanupZombieThreads(__CpuId__);
+    /* Realtime threads always go first, unless they used up this period's budget */
+    NextThread = NULL;
+    if (Scheduler->RtQueue &&
+        (Scheduler->RtRuntimeUsed < RtTunables.RtRuntime || !Scheduler->ReadyQueue))
+    {
+        NextThread = __RemoveRealtime__(Scheduler);
+    }
 
     /* Select next thread from ready queue */
-    NextThread = RemoveThreadFromReadyQueue(__CpuId__);
+    if (!NextThread)
+    {
+        NextThread = RemoveThreadFromReadyQueue(__CpuId__);
+    }
+
+    /* Killed while it was queued; it never runs again */
+    if (NextThread && NextThread->State == ThreadStateTerminated)
+    {
+        AddThreadToZombieQueue(__CpuId__, NextThread);
+        goto SelectAgain;
+    }
 
     /* If no ready thread exists, CPU is idle */
     if (!NextThread)
     {
-        Scheduler->CurrentThread = NULL;
         __atomic_fetch_add(&Scheduler->IdleTicks, 1, __ATOMIC_SEQ_CST);
+
+        /*
+         * A blocked, sleeping or dead thread's frame must not be resumed: it is
+         * queued elsewhere and runs again from its saved frame once woken.
+         */
+        if (Parked)
+        {
+            NextThread = __ParkedIdle__(__CpuId__);
+            goto RunThread;
+        }
+
+        Scheduler->CurrentThread = NULL;
         return;
     }
 
@@ -524,6 +763,38 @@ SelectAgain:
         NextThread->Context.Ss = KernelDataSelector;
     }
 
+    /* Realtime threads are not subject to the stride cooldown or group quotas */
+    if (NextThread->Policy != SchedPolicyNormal)
+    {
+        goto RunThread;
+    }
+
+    /* Over-quota groups wait for their next period */
+    if (SchedGroupThrottled(NextThread, __CpuId__))
+    {
+        AddThreadToReadyQueue(__CpuId__, NextThread);
+        if (++Throttled <= GetCpuReadyCount(__CpuId__))
+        {
+            goto SelectAgain;
+        }
+
+        /* Everything runnable is throttled; park on the idle thread if the frame is ours */
+        __atomic_fetch_add(&Scheduler->IdleTicks, 1, __ATOMIC_SEQ_CST);
+        if (Parked)
+        {
+            NextThread = __ParkedIdle__(__CpuId__);
+            goto RunThread;
+        }
+
+        NextThread = SchedGroupIdleThread(__CpuId__);
+        if (!Current || !NextThread)
+        {
+            Scheduler->CurrentThread = NULL;
+            return;
+        }
+        goto RunThread;
+    }
+
     /* Determine frequency stride based on thread priority */
     uint32_t Stride = 1;
     switch (NextThread->Priority)
@@ -554,6 +825,7 @@ SelectAgain:
             Stride = 16;
             break; /* Default to normal priority */
     }
+    Stride = SchedGroupStride(NextThread, Stride);
 
     /* Frequency scheduling cooldown to prevent over-scheduling lower priority threads */
     if (__atomic_load_n(&NextThread->Cooldown, __ATOMIC_SEQ_CST) > 0)
@@ -573,11 +845,13 @@ SelectAgain:
         __atomic_store_n(&NextThread->Cooldown, Stride - 1, __ATOMIC_SEQ_CST);
     }
 
+RunThread:
     /* Set the selected thread as current running and update state */
     Scheduler->CurrentThread = NextThread;
     NextThread->State        = ThreadStateRunning;
     NextThread->LastCpu      = __CpuId__;
     __atomic_store_n(&NextThread->StartTime, GetSystemTicks(), __ATOMIC_SEQ_CST);
+    ThreadAcctDispatch(NextThread);
 
     /* Update context switch statistics */
     __atomic_fetch_add(&Scheduler->ContextSwitches, 1, __ATOMIC_SEQ_CST);
@@ -608,6 +882,11 @@ DumpCpuSchedulerInfo(uint32_t __CpuId__)
           __atomic_load_n(&Scheduler->ContextSwitches, __ATOMIC_SEQ_CST));
     PInfo("  Current Thread: %u\n",
           Scheduler->CurrentThread ? Scheduler->CurrentThread->ThreadId : 0);
+    PInfo("  Realtime: %u ready, %llu/%u ticks used, throttled %llu times\n",
+          Scheduler->RtReadyCount,
+          Scheduler->RtRuntimeUsed,
+          RtTunables.RtRuntime,
+          Scheduler->RtThrottled);
 }
 
 void
@@ -619,6 +898,58 @@ DumpAllSchedulers(void)
     }
 }
 
+int
+SetRtSchedTunables(uint32_t __RrQuantum__, uint32_t __RtPeriod__, uint32_t __RtRuntime__)
+{
+    if (!__RrQuantum__ || !__RtPeriod__ || !__RtRuntime__ || __RtRuntime__ > __RtPeriod__)
+    {
+        return -1;
+    }
+
+    RtTunables.RrQuantum = __RrQuantum__;
+    RtTunables.RtPeriod  = __RtPeriod__;
+    RtTunables.RtRuntime = __RtRuntime__;
+
+    PDebug("Scheduler: RR quantum %u, RT runtime %u/%u ticks\n",
+           __RrQuantum__,
+           __RtRuntime__,
+           __RtPeriod__);
+    return 0;
+}
+
+/*Interrupts are off around the update so the count lands on the CPU we stay on*/
+void
+PreemptDisable(void)
+{
+    uint64_t Flags;
+    __asm__ volatile("pushfq; popq %0; cli" : "=r"(Flags)::"memory");
+    CpuSchedulers[GetCurrentCpuId()].PreemptCount++;
+    __asm__ volatile("pushq %0; popfq" ::"r"(Flags) : "memory");
+}
+
+void
+PreemptEnable(void)
+{
+    uint64_t Flags;
+    __asm__ volatile("pushfq; popq %0; cli" : "=r"(Flags)::"memory");
+    CpuScheduler* Scheduler = &CpuSchedulers[GetCurrentCpuId()];
+    if (Scheduler->PreemptCount > 0)
+    {
+        Scheduler->PreemptCount--;
+    }
+    __asm__ volatile("pushq %0; popfq" ::"r"(Flags) : "memory");
+}
+
+int
+PreemptDisabled(uint32_t __CpuId__)
+{
+    if (__CpuId__ >= MaxCPUs)
+    {
+        return 0;
+    }
+    return __atomic_load_n(&CpuSchedulers[__CpuId__].PreemptCount, __ATOMIC_RELAXED) != 0;
+}
+
 Thread*
 GetNextThread(uint32_t __CpuId__)
 {
@@ -0,0 +1,107 @@
+#include <AxeSchd.h>
+#include <Tsc.h>
+
+/*Every boundary closes the running interval into the mode it was spent in*/
+void
+ThreadAcctCharge(Thread* __ThreadPtr__, uint32_t __NewMode__)
+{
+    if (!__ThreadPtr__)
+    {
+        return;
+    }
+
+    uint64_t Now = ReadTsc();
+    if (__ThreadPtr__->AcctStamp && __ThreadPtr__->AcctMode < AcctModes)
+    {
+        __ThreadPtr__->AcctCycles[__ThreadPtr__->AcctMode] += Now - __ThreadPtr__->AcctStamp;
+    }
+
+    __ThreadPtr__->AcctStamp = Now;
+    __ThreadPtr__->AcctMode  = __NewMode__;
+}
+
+void
+ThreadAcctQueued(Thread* __ThreadPtr__)
+{
+    __ThreadPtr__->ReadyStamp = ReadTsc();
+}
+
+/*Called by Schedule() on switch-in, still inside the timer interrupt*/
+void
+ThreadAcctDispatch(Thread* __ThreadPtr__)
+{
+    uint64_t Now = ReadTsc();
+    if (__ThreadPtr__->ReadyStamp)
+    {
+        __ThreadPtr__->AcctCycles[AcctWait] += Now - __ThreadPtr__->ReadyStamp;
+        __ThreadPtr__->ReadyStamp = 0;
+    }
+
+    __ThreadPtr__->AcctStamp = Now;
+    __ThreadPtr__->AcctMode  = AcctIrq;
+}
+
+static inline Thread*
+__AcctCurrent__(void)
+{
+    uint32_t CpuId = GetCurrentCpuId();
+    if (CpuId >= MaxCPUs)
+    {
+        return NULL;
+    }
+    return __atomic_load_n(&CpuSchedulers[CpuId].CurrentThread, __ATOMIC_ACQUIRE);
+}
+
+void
+ThreadAcctIrqEnter(void)
+{
+    ThreadAcctCharge(__AcctCurrent__(), AcctIrq);
+}
+
+/*The frame may belong to a different thread now; its privilege level decides the mode*/
+void
+ThreadAcctIrqExit(uint64_t __Cs__)
+{
+    ThreadAcctCharge(__AcctCurrent__(), (__Cs__ & 3) ? AcctUser : AcctSys);
+}
+
+void
+ThreadAcctSyscallEnter(void)
+{
+    Thread* Current = __AcctCurrent__();
+    ThreadAcctCharge(Current, AcctSys);
+    if (Current)
+    {
+        Current->SystemCalls++;
+    }
+}
+
+void
+ThreadAcctSyscallExit(void)
+{
+    ThreadAcctCharge(__AcctCurrent__(), AcctUser);
+}
+
+uint64_t
+ThreadAcctNs(Thread* __ThreadPtr__, uint32_t __Mode__)
+{
+    if (!__ThreadPtr__ || __Mode__ >= AcctModes)
+    {
+        return 0;
+    }
+
+    uint64_t Cycles = __ThreadPtr__->AcctCycles[__Mode__];
+
+    /*Include the interval still open on the CPU so self-queries are exact*/
+    if (__ThreadPtr__->State == ThreadStateRunning && __ThreadPtr__->AcctMode == __Mode__ &&
+        __ThreadPtr__->AcctStamp)
+    {
+        uint64_t Now = ReadTsc();
+        if (Now > __ThreadPtr__->AcctStamp)
+        {
+            Cycles += Now - __ThreadPtr__->AcctStamp;
+        }
+    }
+
+    return TscToNs(Cycles);
+}
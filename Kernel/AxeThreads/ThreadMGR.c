@@ -5,20 +5,19 @@
 #include <PerCPUData.h>
 #include <SMP.h>
 #include <Sync.h>
+#include <SymAP.h>
 #include <Timer.h>
 #include <VMM.h>
 
-uint32_t        NextThreadId = 1;
-Thread*         ThreadList   = NULL;
-SpinLock        ThreadListLock;
-Thread*         CurrentThreads[MaxCPUs];
-static SpinLock CurrentThreadLock; /*Mutexes would have been fine ig*/
+uint32_t NextThreadId = 1;
+Thread*  ThreadList   = NULL;
+SpinLock ThreadListLock;
+DefinePerCpu(CurrentThreads);
 
 void
 InitializeThreadManager(void)
 {
     InitializeSpinLock(&ThreadListLock, "ThreadList");
-    InitializeSpinLock(&CurrentThreadLock, "CurrentThread");
     NextThreadId = 1;
     ThreadList   = NULL;
 
@@ -28,9 +27,11 @@ InitializeThreadManager(void)
      */
     for (uint32_t CpuIndex = 0; CpuIndex < MaxCPUs; CpuIndex++)
     {
-        CurrentThreads[CpuIndex] = NULL;
+        *PerCpuPtr(CurrentThreads, CpuIndex) = NULL;
     }
 
+    InitializeThreadPool();
+
     PSuccess("Thread Manager initialized\n");
 }
 
@@ -48,11 +49,8 @@ GetCurrentThread(uint32_t __CpuId__)
         return NULL;
     }
 
-    AcquireSpinLock(&CurrentThreadLock);
-    Thread* Result = CurrentThreads[__CpuId__];
-    ReleaseSpinLock(&CurrentThreadLock);
-
-    return Result;
+    /* One aligned word per CPU on its own line, so a plain atomic load will do */
+    return __atomic_load_n(PerCpuPtr(CurrentThreads, __CpuId__), __ATOMIC_ACQUIRE);
 }
 
 void
@@ -63,9 +61,7 @@ SetCurrentThread(uint32_t __CpuId__, Thread* __ThreadPtr__)
         return;
     }
 
-    AcquireSpinLock(&CurrentThreadLock);
-    CurrentThreads[__CpuId__] = __ThreadPtr__;
-    ReleaseSpinLock(&CurrentThreadLock);
+    __atomic_store_n(PerCpuPtr(CurrentThreads, __CpuId__), __ThreadPtr__, __ATOMIC_RELEASE);
 }
 
 Thread*
@@ -80,21 +76,14 @@ CreateThread(ThreadType     __Type__,
            __Argument__);
 
     PDebug("CreateThread: About to allocate TCB (size=%zu)\n", sizeof(Thread));
-    Thread* NewThread = (Thread*)KMalloc(sizeof(Thread));
+    Thread* NewThread = ThreadPoolGet(); /*Zeroed TCB with a guarded kernel stack*/
     if (!NewThread)
     {
         PError("CreateThread: Failed to allocate thread\n");
         ReleaseSpinLock(&ThreadListLock);
         return NULL;
     }
-    PDebug("CreateThread: TCB allocated at %p\n", NewThread);
-
-    PDebug("CreateThread: Clearing TCB\n");
-    for (size_t Index = 0; Index < sizeof(Thread); Index++)
-    {
-        ((uint8_t*)NewThread)[Index] = 0;
-    }
-    PDebug("CreateThread: TCB cleared\n");
+    PDebug("CreateThread: TCB allocated (zeroed) at %p\n", NewThread);
 
     PDebug("CreateThread: Allocating thread ID\n");
     NewThread->ThreadId = AllocateThreadId();
@@ -107,53 +96,24 @@ CreateThread(ThreadType     __Type__,
     NewThread->BasePriority = __Priority__;
     PDebug("CreateThread: Core fields initialized\n");
 
-    PDebug("CreateThread: Setting thread name\n");
-    KrnPrintf(NewThread->Name, "Thread-%u", NewThread->ThreadId);
-    PDebug("CreateThread: Thread name set to: %s\n", NewThread->Name);
-
-    PDebug("CreateThread: About to allocate stacks\n");
+    /* Kernel stack comes with the pooled TCB; KernelStack holds the top */
     if (__Type__ == ThreadTypeKernel)
     {
-        PDebug("CreateThread: Allocating kernel stack (8192 bytes)\n");
-        void* KernelStackBase = KMalloc(8192);
-        if (!KernelStackBase)
-        {
-            PError("CreateThread: Failed to allocate kernel stack\n");
-            KFree(NewThread);
-            ReleaseSpinLock(&ThreadListLock);
-            return NULL;
-        }
-        NewThread->KernelStack =
-            (uint64_t)KernelStackBase + 8192; /** Stack grows downwards; store top */
-        NewThread->UserStack = 0;             /** Kernel thread has no user stack */
-        NewThread->StackSize = 8192;
-        PDebug("CreateThread: Kernel stack allocated at %p (top: %p)\n",
-               KernelStackBase,
-               (void*)NewThread->KernelStack);
+        NewThread->UserStack = 0; /** Kernel thread has no user stack */
+        PDebug("CreateThread: Kernel stack top: %p\n", (void*)NewThread->KernelStack);
     }
     else
     {
-        PDebug("CreateThread: Allocating kernel and user stacks\n");
-        void* KernelStackBase = KMalloc(8192);
-        void* UserStackBase   = KMalloc(8192);
-        if (!KernelStackBase || !UserStackBase)
+        PDebug("CreateThread: Allocating user stack\n");
+        void* UserStackBase = KMalloc(KStackSize);
+        if (!UserStackBase)
         {
             PError("CreateThread: Failed to allocate stacks\n");
-            if (KernelStackBase)
-            {
-                KFree(KernelStackBase);
-            }
-            if (UserStackBase)
-            {
-                KFree(UserStackBase);
-            }
-            KFree(NewThread);
+            ThreadPoolPut(NewThread);
             ReleaseSpinLock(&ThreadListLock);
             return NULL;
         }
-        NewThread->KernelStack = (uint64_t)KernelStackBase + 8192;
-        NewThread->UserStack   = (uint64_t)UserStackBase + 8192;
-        NewThread->StackSize   = 8192;
+        NewThread->UserStack = (uint64_t)UserStackBase + KStackSize;
         PDebug("CreateThread: Stacks allocated - Kernel: %p, User: %p\n",
                (void*)NewThread->KernelStack,
                (void*)NewThread->UserStack);
@@ -194,6 +154,7 @@ CreateThread(ThreadType     __Type__,
     NewThread->CreationTick = GetSystemTicks();
     PDebug("CreateThread: System ticks retrieved\n");
     NewThread->WaitReason = WaitReasonNone;
+    SchedGroupInherit(NewThread);
 
     NewThread->PageDirectory = 0;
     NewThread->VirtualBase   = UserVirtualBase;
@@ -245,19 +206,23 @@ DestroyThread(Thread* __ThreadPtr__)
 
     ReleaseSpinLock(&ThreadListLock);
 
-    if (__ThreadPtr__->KernelStack)
-    {
-        KFree((void*)(__ThreadPtr__->KernelStack - __ThreadPtr__->StackSize));
-    }
+    SchedGroupLeave(__ThreadPtr__);
 
     if (__ThreadPtr__->UserStack)
     {
         KFree((void*)(__ThreadPtr__->UserStack - __ThreadPtr__->StackSize));
     }
 
-    KFree(__ThreadPtr__);
+    if (__ThreadPtr__->Cold)
+    {
+        KFree(__ThreadPtr__->Cold);
+        __ThreadPtr__->Cold = NULL;
+    }
 
     PDebug("Destroyed thread %u\n", __ThreadPtr__->ThreadId);
+
+    /* TCB and kernel stack go back to this CPU's cache */
+    ThreadPoolPut(__ThreadPtr__);
 }
 
 void
@@ -301,261 +266,139 @@ ResumeThread(Thread* __ThreadPtr__)
     PDebug("Resumed thread %u\n", __ThreadPtr__->ThreadId);
 }
 
-void
-SetThreadPriority(Thread* __ThreadPtr__, ThreadPriority __Priority__)
+ThreadCold*
+GetThreadCold(Thread* __ThreadPtr__)
 {
     if (!__ThreadPtr__)
     {
-        return;
+        return NULL;
     }
 
-    __ThreadPtr__->Priority = __Priority__;
-
-    PDebug("Set thread %u priority to %u\n", __ThreadPtr__->ThreadId, __Priority__);
-}
-
-void
-SetThreadAffinity(Thread* __ThreadPtr__, uint32_t __CpuMask__)
-{
-    if (!__ThreadPtr__)
+    if (!__ThreadPtr__->Cold)
     {
-        return;
-    }
-
-    __ThreadPtr__->CpuAffinity = __CpuMask__;
-
-    PDebug("Set thread %u affinity to 0x%x\n", __ThreadPtr__->ThreadId, __CpuMask__);
-}
+        ThreadCold* Cold = (ThreadCold*)KZalloc(sizeof(ThreadCold));
+        if (!Cold)
+        {
+            PError("Failed to allocate cold state for thread %u\n", __ThreadPtr__->ThreadId);
+            return NULL;
+        }
 
-uint32_t
-GetCpuLoad(uint32_t __CpuId__)
-{
-    if (__CpuId__ >= MaxCPUs)
-    {
-        return 0xFFFFFFFF; /* Invalid CPU indicator */
+        /*Lost the race; keep the first one*/
+        ThreadCold* Expected = NULL;
+        if (!__atomic_compare_exchange_n(
+                &__ThreadPtr__->Cold, &Expected, Cold, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST))
+        {
+            KFree(Cold);
+        }
     }
 
-    return GetCpuReadyCount(__CpuId__);
+    return __ThreadPtr__->Cold;
 }
 
-uint32_t
-FindLeastLoadedCpu(void)
+const char*
+GetThreadName(Thread* __ThreadPtr__)
 {
-    uint32_t BestCpu = 0;
-    uint32_t MinLoad = GetCpuLoad(0);
-
-    for (uint32_t CpuIndex = 1; CpuIndex < Smp.CpuCount; CpuIndex++)
+    if (!__ThreadPtr__ || !__ThreadPtr__->Cold || !__ThreadPtr__->Cold->Name[0])
     {
-        uint32_t Load = GetCpuLoad(CpuIndex);
-        if (Load < MinLoad)
-        {
-            MinLoad = Load;
-            BestCpu = CpuIndex;
-        }
+        return "Thread";
     }
-
-    return BestCpu;
+    return __ThreadPtr__->Cold->Name;
 }
 
-uint32_t
-CalculateOptimalCpu(Thread* __ThreadPtr__)
+int
+SetThreadName(Thread* __ThreadPtr__, const char* __Name__)
 {
-    if (!__ThreadPtr__)
+    ThreadCold* Cold = GetThreadCold(__ThreadPtr__);
+    if (!Cold || !__Name__)
     {
-        return 0;
+        return -1;
     }
 
-    if (__ThreadPtr__->CpuAffinity != 0xFFFFFFFF)
+    uint32_t Index = 0;
+    for (; Index < sizeof(Cold->Name) - 1 && __Name__[Index]; Index++)
     {
-        uint32_t BestCpu       = 0;
-        uint32_t MinLoad       = 0xFFFFFFFF;
-        bool     FoundValidCpu = false;
-
-        for (uint32_t CpuIndex = 0; CpuIndex < Smp.CpuCount; CpuIndex++)
-        {
-            if (__ThreadPtr__->CpuAffinity & (1 << CpuIndex))
-            {
-                uint32_t Load = GetCpuLoad(CpuIndex);
-                if (!FoundValidCpu || Load < MinLoad)
-                {
-                    MinLoad       = Load;
-                    BestCpu       = CpuIndex;
-                    FoundValidCpu = true;
-                }
-            }
-        }
-
-        return FoundValidCpu ? BestCpu : 0;
+        Cold->Name[Index] = __Name__[Index];
     }
-
-    return FindLeastLoadedCpu();
+    Cold->Name[Index] = 0;
+    return 0;
 }
 
 void
-ThreadExecute(Thread* __ThreadPtr__)
+SetThreadPriority(Thread* __ThreadPtr__, ThreadPriority __Priority__)
 {
     if (!__ThreadPtr__)
     {
         return;
     }
 
-    /* Determine best CPU for this thread */
-    uint32_t TargetCpu = CalculateOptimalCpu(__ThreadPtr__);
-
-    /* Update thread's last CPU assignment */
-    AcquireSpinLock(&ThreadListLock);
-    __ThreadPtr__->LastCpu = TargetCpu;
-    __ThreadPtr__->State   = ThreadStateReady;
-    ReleaseSpinLock(&ThreadListLock);
-
-    /* Enqueue thread in target CPU’s ready queue */
-    AddThreadToReadyQueue(TargetCpu, __ThreadPtr__);
+    __ThreadPtr__->Priority = __Priority__;
 
-    PDebug("ThreadExecute: Thread %u assigned to CPU %u (Load: %u)\n",
-           __ThreadPtr__->ThreadId,
-           TargetCpu,
-           GetCpuLoad(TargetCpu));
+    PDebug("Set thread %u priority to %u\n", __ThreadPtr__->ThreadId, __Priority__);
 }
 
 void
-ThreadExecuteMultiple(Thread** __ThreadArray__, uint32_t __ThreadCount__)
+SetThreadAffinity(Thread* __ThreadPtr__, uint32_t __CpuMask__)
 {
-    if (!__ThreadArray__ || __ThreadCount__ == 0)
+    if (!__ThreadPtr__)
     {
         return;
     }
 
-    for (uint32_t ThreadIndex = 0; ThreadIndex < __ThreadCount__; ThreadIndex++)
-    {
-        Thread* ThreadPtr = __ThreadArray__[ThreadIndex];
-        if (!ThreadPtr)
-        {
-            continue;
-        }
-
-        uint32_t TargetCpu = CalculateOptimalCpu(ThreadPtr);
-        AcquireSpinLock(&ThreadListLock);
-        ThreadPtr->LastCpu = TargetCpu;
-        ThreadPtr->State   = ThreadStateReady;
-        ReleaseSpinLock(&ThreadListLock);
-        AddThreadToReadyQueue(TargetCpu, ThreadPtr);
+    __ThreadPtr__->CpuAffinity = __CpuMask__;
 
-        PDebug("ThreadExecuteMultiple: Thread %u \u2192 CPU %u (Load: %u)\n",
-               ThreadPtr->ThreadId,
-               TargetCpu,
-               GetCpuLoad(TargetCpu));
-    }
+    PDebug("Set thread %u affinity to 0x%x\n", __ThreadPtr__->ThreadId, __CpuMask__);
 }
 
-void
-LoadBalanceThreads(void)
+int
+SetThreadScheduler(Thread* __ThreadPtr__, SchedPolicy __Policy__, uint32_t __RtPriority__)
 {
-    uint32_t CpuLoads[MaxCPUs];
-    uint32_t MaxLoad = 0;
-    uint32_t MinLoad = 0xFFFFFFFF;
-    uint32_t MaxCpu  = 0;
-    uint32_t MinCpu  = 0;
-
-    /* Gather load information */
-    for (uint32_t CpuIndex = 0; CpuIndex < Smp.CpuCount; CpuIndex++)
+    if (!__ThreadPtr__ || __Policy__ > SchedPolicyRr)
     {
-        CpuLoads[CpuIndex] = GetCpuLoad(CpuIndex);
-
-        if (CpuLoads[CpuIndex] > MaxLoad)
-        {
-            MaxLoad = CpuLoads[CpuIndex];
-            MaxCpu  = CpuIndex;
-        }
-
-        if (CpuLoads[CpuIndex] < MinLoad)
-        {
-            MinLoad = CpuLoads[CpuIndex];
-            MinCpu  = CpuIndex;
-        }
+        return -1;
     }
 
-    /* Only perform migration if load difference is significant */
-    if (MaxLoad > MinLoad + 2)
+    /*Normal threads carry no static priority; RT threads need one in range*/
+    if (__Policy__ == SchedPolicyNormal && __RtPriority__ != 0)
     {
-        Thread* ThreadToMigrate = GetNextThread(MaxCpu);
-        if (ThreadToMigrate)
-        {
-            /* Check if thread's affinity allows migration */
-            if (ThreadToMigrate->CpuAffinity == 0xFFFFFFFF ||
-                (ThreadToMigrate->CpuAffinity & (1 << MinCpu)))
-            {
-                ThreadToMigrate->LastCpu = MinCpu;
-                AddThreadToReadyQueue(MinCpu, ThreadToMigrate);
-
-                PDebug("LoadBalance: Migrated Thread %u from CPU %u to CPU %u\n",
-                       ThreadToMigrate->ThreadId,
-                       MaxCpu,
-                       MinCpu);
-            }
-            else
-            {
-                PWarn("Migration Failed\n");
-
-                /* Put thread back into original CPU’s ready queue if migration failed */
-                AddThreadToReadyQueue(MaxCpu, ThreadToMigrate);
-            }
-        }
+        return -1;
     }
-}
-
-void
-GetSystemLoadStats(uint32_t* __TotalThreads__,
-                   uint32_t* __AverageLoad__,
-                   uint32_t* __MaxLoad__,
-                   uint32_t* __MinLoad__)
-{
-    uint32_t TotalLoad = 0;
-    uint32_t MaxLoad   = 0;
-    uint32_t MinLoad   = 0xFFFFFFFF;
-
-    for (uint32_t CpuIndex = 0; CpuIndex < Smp.CpuCount; CpuIndex++)
+    if (__Policy__ != SchedPolicyNormal &&
+        (__RtPriority__ < RtPriorityMin || __RtPriority__ > RtPriorityMax))
     {
-        uint32_t Load = GetCpuLoad(CpuIndex);
-        TotalLoad += Load;
-
-        if (Load > MaxLoad)
-        {
-            MaxLoad = Load;
-        }
-        if (Load < MinLoad)
-        {
-            MinLoad = Load;
-        }
+        return -1;
     }
 
-    if (MinLoad == 0xFFFFFFFF)
-    {
-        MinLoad = 0;
-    }
+    /*A queued thread moves to its new queue the next time it is enqueued*/
+    __ThreadPtr__->RtPriority  = __RtPriority__;
+    __ThreadPtr__->RtSliceLeft = RtTunables.RrQuantum;
+    __atomic_store_n(&__ThreadPtr__->Policy, __Policy__, __ATOMIC_SEQ_CST);
 
-    if (__TotalThreads__)
-    {
-        *__TotalThreads__ = TotalLoad;
-    }
-    if (__AverageLoad__)
-    {
-        *__AverageLoad__ = (Smp.CpuCount > 0) ? TotalLoad / Smp.CpuCount : 0;
-    }
-    if (__MaxLoad__)
+    if (__Policy__ == SchedPolicyNormal)
     {
-        *__MaxLoad__ = MaxLoad;
+        __ThreadPtr__->Flags &= ~ThreadFlagRealtime;
     }
-    if (__MinLoad__)
+    else
     {
-        *__MinLoad__ = MinLoad;
+        __ThreadPtr__->Flags |= ThreadFlagRealtime;
     }
+
+    PDebug("Set thread %u policy %u rt priority %u\n",
+           __ThreadPtr__->ThreadId,
+           __Policy__,
+           __RtPriority__);
+    return 0;
 }
 
 void
 ThreadYield(void)
 {
-    /*Software Interrupt*/
-    __asm__ volatile("int $0x20");
+    uint64_t Flags;
+
+    /*Software interrupt on the timer vector; with IF off no real tick can take the flag*/
+    __asm__ volatile("pushfq; popq %0; cli" : "=r"(Flags)::"memory");
+    GetPerCpuData(GetCurrentCpuId())->SoftYield = 1;
+    __asm__ volatile("int $0x20" ::: "memory");
+    __asm__ volatile("pushq %0; popfq" ::"r"(Flags) : "memory");
 }
 
 void
@@ -571,7 +414,7 @@ ThreadSleep(uint64_t __Milliseconds__)
         Current->WakeupTime = GetSystemTicks() + __Milliseconds__;
 
         /* Trigger scheduler by invoking timer interrupt */
-        __asm__ volatile("int $0x20");
+        ThreadYield();
     }
     else
     {
@@ -602,8 +445,11 @@ ThreadExit(uint32_t __ExitCode__)
 
     PInfo("Thread %u exiting with code %u\n", Current->ThreadId, __ExitCode__);
 
-    AddThreadToZombieQueue(CpuId, Current);
-    __asm__ volatile("int $0x20");
+    /* Schedule queues us as a zombie once it has switched away; we never come back */
+    for (;;)
+    {
+        ThreadYield();
+    }
 }
 
 Thread*
@@ -673,7 +519,7 @@ DumpThreadInfo(Thread* __ThreadPtr__)
         return;
     }
 
-    PInfo("Thread %u (%s):\n", __ThreadPtr__->ThreadId, __ThreadPtr__->Name);
+    PInfo("Thread %u (%s):\n", __ThreadPtr__->ThreadId, GetThreadName(__ThreadPtr__));
     PInfo("  State: %u, Type: %u, Priority: %u\n",
           __ThreadPtr__->State,
           __ThreadPtr__->Type,
@@ -701,7 +547,7 @@ DumpAllThreads(void)
     {
         PInfo("Thread %u: %s (State: %u, CPU: %u)\n",
               Current->ThreadId,
-              Current->Name,
+              GetThreadName(Current),
               Current->State,
               Current->LastCpu);
         Current = Current->Next;
@@ -0,0 +1,362 @@
+#include <AxeThreads.h>
+#include <KHeap.h>
+#include <PMM.h>
+#include <SMP.h>
+#include <String.h>
+#include <Sync.h>
+#include <VMM.h>
+
+static ThreadCache ThreadCaches[MaxCPUs];
+
+/*A released arena slot, reusable once every online CPU has flushed its TLB since Epoch*/
+typedef struct StackSlotNode
+{
+    struct StackSlotNode* Next;
+    uint32_t              Slot;
+    uint64_t              Epoch;
+
+} StackSlotNode;
+
+static struct
+{
+    uint64_t       Base;        /*0 when the arena is unusable, stacks then come from KMalloc*/
+    uint32_t       NextSlot;    /*Slots never handed out yet*/
+    StackSlotNode* Retired;     /*Unmapped slots, oldest Epoch first*/
+    StackSlotNode* RetiredTail;
+    uint64_t       Epoch;       /*Bumped per retired slot; CPUs flush to catch up*/
+    uint32_t       Reused;      /*Slots handed out again from Retired*/
+    uint32_t       MaxDepth;    /*Deepest stack use seen at recycle time, bytes*/
+    uint64_t       Scrubbed;    /*Bytes re-zeroed on reuse*/
+    SpinLock       Lock;
+
+} StackArena;
+
+/*Last StackArena.Epoch each CPU flushed its TLB for*/
+StaticPerCpu(uint64_t, TlbEpochSeen);
+
+void
+InitializeThreadPool(void)
+{
+    for (uint32_t CpuIndex = 0; CpuIndex < MaxCPUs; CpuIndex++)
+    {
+        ThreadCaches[CpuIndex].Free     = NULL;
+        ThreadCaches[CpuIndex].Count    = 0;
+        ThreadCaches[CpuIndex].Hits     = 0;
+        ThreadCaches[CpuIndex].Misses   = 0;
+        ThreadCaches[CpuIndex].Released = 0;
+        InitializeSpinLock(&ThreadCaches[CpuIndex].Lock, "ThreadCache");
+    }
+
+    InitializeSpinLock(&StackArena.Lock, "StackArena");
+    StackArena.Base     = 0;
+    StackArena.NextSlot = 0;
+
+    /*The PDPT must exist before any address space copies the kernel half*/
+    uint32_t Pml4Index = (ThreadStackArena >> 39) & 0x1FF;
+    if (!Vmm.KernelSpace || (Vmm.KernelSpace->Pml4[Pml4Index] & PTEPRESENT))
+    {
+        PWarn("ThreadPool: Stack arena slot %u busy, using heap stacks\n", Pml4Index);
+        return;
+    }
+    if (!GetPageTable(Vmm.KernelSpace->Pml4, ThreadStackArena, 3, 1))
+    {
+        PWarn("ThreadPool: No PDPT for stack arena, using heap stacks\n");
+        return;
+    }
+
+    StackArena.Base = ThreadStackArena;
+    PSuccess("ThreadPool: Guarded kernel stacks at 0x%016lx\n", StackArena.Base);
+}
+
+/*Oldest epoch some online CPU may still hold stale arena translations from*/
+static uint64_t
+__FlushedEpoch__(void)
+{
+    uint64_t Oldest = __atomic_load_n(&StackArena.Epoch, __ATOMIC_ACQUIRE);
+
+    for (uint32_t CpuIndex = 0; CpuIndex < Smp.CpuCount; CpuIndex++)
+    {
+        if (Smp.Cpus[CpuIndex].Status != CPU_STATUS_ONLINE)
+        {
+            continue;
+        }
+
+        uint64_t Seen = __atomic_load_n(PerCpuPtr(TlbEpochSeen, CpuIndex), __ATOMIC_ACQUIRE);
+        if (Seen < Oldest)
+        {
+            Oldest = Seen;
+        }
+    }
+    return Oldest;
+}
+
+/*Slot is fully unmapped; queue it until every CPU has flushed*/
+static void
+__SlotRetire__(uint32_t __Slot__)
+{
+    StackSlotNode* Node = (StackSlotNode*)KMalloc(sizeof(StackSlotNode));
+    if (!Node)
+    {
+        return; /*Leaked, the arena is large*/
+    }
+    Node->Next = NULL;
+    Node->Slot = __Slot__;
+
+    AcquireSpinLock(&StackArena.Lock);
+    Node->Epoch = __atomic_add_fetch(&StackArena.Epoch, 1, __ATOMIC_SEQ_CST);
+    if (StackArena.RetiredTail)
+    {
+        StackArena.RetiredTail->Next = Node;
+    }
+    else
+    {
+        StackArena.Retired = Node;
+    }
+    StackArena.RetiredTail = Node;
+    ReleaseSpinLock(&StackArena.Lock);
+}
+
+static uint64_t
+__StackAlloc__(void)
+{
+    if (!StackArena.Base)
+    {
+        void* Base = KZalloc(KStackSize);
+        return Base ? (uint64_t)Base : 0;
+    }
+
+    StackSlotNode* Node = NULL;
+    uint32_t       Slot = ThreadStackSlots;
+
+    AcquireSpinLock(&StackArena.Lock);
+    if (StackArena.Retired && StackArena.Retired->Epoch <= __FlushedEpoch__())
+    {
+        Node               = StackArena.Retired;
+        StackArena.Retired = Node->Next;
+        if (!StackArena.Retired)
+        {
+            StackArena.RetiredTail = NULL;
+        }
+        Slot = Node->Slot;
+        StackArena.Reused++;
+    }
+    else if (StackArena.NextSlot < ThreadStackSlots)
+    {
+        Slot = StackArena.NextSlot++;
+    }
+    ReleaseSpinLock(&StackArena.Lock);
+
+    KFree(Node);
+    if (Slot >= ThreadStackSlots)
+    {
+        PError("ThreadPool: Stack arena exhausted\n");
+        return 0;
+    }
+
+    /*The first page of the slot stays unmapped as the guard*/
+    uint64_t Bottom = StackArena.Base + (uint64_t)Slot * ThreadStackSlot + PageSize;
+    for (uint64_t Off = 0; Off < KStackSize; Off += PageSize)
+    {
+        uint64_t Phys = AllocPage();
+        if (!Phys || !MapPage(Vmm.KernelSpace, Bottom + Off, Phys, PTEWRITABLE | PTENOEXECUTE))
+        {
+            PError("ThreadPool: Failed to map stack page 0x%016lx\n", Bottom + Off);
+            if (Phys)
+            {
+                FreePage(Phys);
+            }
+            for (uint64_t Undo = 0; Undo < Off; Undo += PageSize)
+            {
+                uint64_t Mapped = GetPhysicalAddress(Vmm.KernelSpace, Bottom + Undo);
+                UnmapPage(Vmm.KernelSpace, Bottom + Undo);
+                FreePage(Mapped);
+            }
+            __SlotRetire__(Slot);
+            return 0;
+        }
+        PmmSetFrameOwner(Phys, 1, PageOwnerStack);
+        memset(PhysToVirt(Phys), 0, PageSize);
+    }
+
+    return Bottom;
+}
+
+static void
+__StackFree__(uint64_t __Bottom__)
+{
+    if (!StackArena.Base)
+    {
+        KFree((void*)__Bottom__);
+        return;
+    }
+
+    for (uint64_t Off = 0; Off < KStackSize; Off += PageSize)
+    {
+        uint64_t Phys = GetPhysicalAddress(Vmm.KernelSpace, __Bottom__ + Off);
+        UnmapPage(Vmm.KernelSpace, __Bottom__ + Off);
+        if (Phys)
+        {
+            FreePage(Phys);
+        }
+    }
+
+    __SlotRetire__((uint32_t)((__Bottom__ - PageSize - StackArena.Base) / ThreadStackSlot));
+}
+
+/*Timer tick: one local flush covers every slot retired since the last one*/
+void
+ThreadPoolTick(uint32_t __CpuId__)
+{
+    if (__CpuId__ >= MaxCPUs)
+    {
+        return;
+    }
+
+    uint64_t  Epoch = __atomic_load_n(&StackArena.Epoch, __ATOMIC_ACQUIRE);
+    uint64_t* Seen  = PerCpuPtr(TlbEpochSeen, __CpuId__);
+    if (__atomic_load_n(Seen, __ATOMIC_RELAXED) == Epoch)
+    {
+        return;
+    }
+
+    /*Arena mappings are not global, so reloading CR3 drops all of them*/
+    uint64_t Cr3;
+    __asm__ volatile("mov %%cr3, %0" : "=r"(Cr3));
+    __asm__ volatile("mov %0, %%cr3" ::"r"(Cr3) : "memory");
+    __atomic_store_n(Seen, Epoch, __ATOMIC_RELEASE);
+}
+
+/*Pooled stacks are handed out all zero; only the span the last owner touched needs clearing*/
+static void
+__StackScrub__(uint64_t __Bottom__)
+{
+    uint64_t* Word = (uint64_t*)__Bottom__;
+    uint64_t* Top  = (uint64_t*)(__Bottom__ + KStackSize);
+    while (Word < Top && !*Word)
+    {
+        Word++;
+    }
+
+    /*Recycled on every CPU at once, so the statistics are kept with atomics*/
+    uint32_t Depth = (uint32_t)((uint64_t)Top - (uint64_t)Word);
+    uint32_t Max   = __atomic_load_n(&StackArena.MaxDepth, __ATOMIC_RELAXED);
+    do
+    {
+        if (Depth <= Max)
+        {
+            break;
+        }
+    } while (!__atomic_compare_exchange_n(
+        &StackArena.MaxDepth, &Max, Depth, 0, __ATOMIC_RELAXED, __ATOMIC_RELAXED));
+
+    memset(Word, 0, Depth);
+    __atomic_fetch_add(&StackArena.Scrubbed, Depth, __ATOMIC_RELAXED);
+}
+
+Thread*
+ThreadPoolGet(void)
+{
+    ThreadCache* Cache = &ThreadCaches[GetCurrentCpuId()];
+
+    AcquireSpinLock(&Cache->Lock);
+    Thread* ThreadPtr = Cache->Free;
+    if (ThreadPtr)
+    {
+        Cache->Free = ThreadPtr->Next;
+        Cache->Count--;
+        Cache->Hits++;
+    }
+    else
+    {
+        Cache->Misses++;
+    }
+    ReleaseSpinLock(&Cache->Lock);
+
+    uint64_t Bottom;
+    if (ThreadPtr)
+    {
+        /*The stack was released by its previous owner possibly while still running on it,
+          so it is only cleaned now*/
+        Bottom = ThreadPtr->KernelStack - ThreadPtr->StackSize;
+        __StackScrub__(Bottom);
+    }
+    else
+    {
+        /*The hot header must start a cache line; the heap only guarantees 16 bytes*/
+        void* Block = KMalloc(sizeof(Thread) + 63);
+        if (!Block)
+        {
+            return NULL;
+        }
+        ThreadPtr        = (Thread*)(((uint64_t)Block + 63) & ~63ULL);
+        ThreadPtr->Alloc = Block;
+
+        Bottom = __StackAlloc__();
+        if (!Bottom)
+        {
+            KFree(Block);
+            return NULL;
+        }
+    }
+
+    void* Alloc = ThreadPtr->Alloc;
+    memset(ThreadPtr, 0, sizeof(Thread));
+    ThreadPtr->Alloc       = Alloc;
+    ThreadPtr->KernelStack = Bottom + KStackSize;
+    ThreadPtr->StackSize   = KStackSize;
+    return ThreadPtr;
+}
+
+void
+ThreadPoolPut(Thread* __ThreadPtr__)
+{
+    if (!__ThreadPtr__)
+    {
+        return;
+    }
+
+    ThreadCache* Cache  = &ThreadCaches[GetCurrentCpuId()];
+    uint64_t     Bottom = __ThreadPtr__->KernelStack - __ThreadPtr__->StackSize;
+
+    AcquireSpinLock(&Cache->Lock);
+    if (Cache->Count < ThreadCacheDepth && __ThreadPtr__->KernelStack)
+    {
+        __ThreadPtr__->Next = Cache->Free;
+        Cache->Free         = __ThreadPtr__;
+        Cache->Count++;
+        ReleaseSpinLock(&Cache->Lock);
+        return;
+    }
+    Cache->Released++;
+    ReleaseSpinLock(&Cache->Lock);
+
+    if (__ThreadPtr__->KernelStack)
+    {
+        __StackFree__(Bottom);
+    }
+    KFree(__ThreadPtr__->Alloc);
+}
+
+void
+DumpThreadPool(void)
+{
+    uint64_t Hits = 0, Misses = 0, Released = 0, Cached = 0;
+    for (uint32_t CpuIndex = 0; CpuIndex < Smp.CpuCount; CpuIndex++)
+    {
+        Hits += ThreadCaches[CpuIndex].Hits;
+        Misses += ThreadCaches[CpuIndex].Misses;
+        Released += ThreadCaches[CpuIndex].Released;
+        Cached += ThreadCaches[CpuIndex].Count;
+    }
+
+    PInfo("ThreadPool: %lu cached, %lu hits, %lu misses, %lu released\n",
+          Cached,
+          Hits,
+          Misses,
+          Released);
+    PInfo("ThreadPool: %u stack slots used, %u reused, max depth %u, %lu bytes scrubbed\n",
+          StackArena.NextSlot,
+          StackArena.Reused,
+          StackArena.MaxDepth,
+          StackArena.Scrubbed);
+}
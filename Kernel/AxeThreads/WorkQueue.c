@@ -0,0 +1,557 @@
+#include <AxeSchd.h>
+#include <KHeap.h>
+#include <String.h>
+#include <Timer.h>
+#include <WorkQueue.h>
+
+/*
+ * Work items sit on per-CPU pools served by a fixed set of worker threads.
+ * Pool and queue locks are never held together, so queueing is safe from
+ * interrupt context.
+ */
+
+static WorkPool  WorkPools[MaxCPUs];
+static WorkQueue SystemQueue;
+WorkQueue*       SystemWq = NULL;
+
+static void
+__WorkerLoop__(void* __Arg__);
+
+static inline uint64_t
+__MsToTicks__(uint64_t __Ms__)
+{
+    uint64_t Freq = Timer.TimerFrequency ? Timer.TimerFrequency : TimerTargetFrequency;
+    return (__Ms__ * Freq + 999) / 1000;
+}
+
+static void
+__InitQueue__(WorkQueue* __Queue__, const char* __Name__, uint32_t __MaxActive__)
+{
+    __Queue__->Name      = __Name__;
+    __Queue__->MaxActive = __MaxActive__ ? __MaxActive__ : WorkDefaultMaxActive;
+    __Queue__->Active    = 0;
+    __Queue__->InFlight  = 0;
+    __Queue__->Inactive  = NULL;
+    InitializeSpinLock(&__Queue__->Lock, "WorkQueue");
+}
+
+void
+InitializeWorkQueues(void)
+{
+    __InitQueue__(&SystemQueue, "events", WorkDefaultMaxActive);
+    SystemWq = &SystemQueue;
+
+    for (uint32_t CpuIndex = 0; CpuIndex < Smp.CpuCount; CpuIndex++)
+    {
+        WorkPool* Pool = &WorkPools[CpuIndex];
+        memset(Pool, 0, sizeof(WorkPool));
+        InitializeSpinLock(&Pool->Lock, "WorkPool");
+
+        for (uint32_t Index = 0; Index < WorkMaxWorkers; Index++)
+        {
+            Thread* Worker = CreateThread(ThreadTypeKernel,
+                                          (void*)__WorkerLoop__,
+                                          (void*)(uint64_t)((CpuIndex << 8) | Index),
+                                          ThreadPrioritykernel);
+            if (!Worker)
+            {
+                PWarn("WorkQueue: No worker %u for CPU %u\n", Index, CpuIndex);
+                continue;
+            }
+
+            Worker->Flags |= ThreadFlagSystem | ThreadFlagPinned;
+            Worker->CpuAffinity  = 1U << (CpuIndex & 31);
+            Pool->Workers[Index] = Worker;
+            ThreadExecute(Worker);
+        }
+    }
+
+    PSuccess("WorkQueue: %u workers on each of %u CPUs\n", WorkMaxWorkers, Smp.CpuCount);
+}
+
+WorkQueue*
+CreateWorkQueue(const char* __Name__, uint32_t __MaxActive__)
+{
+    WorkQueue* Queue = (WorkQueue*)KZalloc(sizeof(WorkQueue));
+    if (!Queue)
+    {
+        PError("WorkQueue: Cannot allocate %s\n", __Name__ ? __Name__ : "?");
+        return NULL;
+    }
+
+    __InitQueue__(Queue, __Name__, __MaxActive__);
+    return Queue;
+}
+
+void
+DestroyWorkQueue(WorkQueue* __Queue__)
+{
+    if (!__Queue__ || __Queue__ == SystemWq)
+    {
+        return;
+    }
+
+    FlushWorkQueue(__Queue__);
+    KFree(__Queue__);
+}
+
+void
+InitWork(WorkItem* __Work__, WorkFunc __Func__)
+{
+    __Work__->Next     = NULL;
+    __Work__->Func     = __Func__;
+    __Work__->Queue    = NULL;
+    __Work__->Flags    = 0;
+    __Work__->Cpu      = 0;
+    __Work__->Deadline = 0;
+}
+
+/*Caller holds the pool lock; returns a parked worker to wake after unlocking*/
+static Thread*
+__ClaimParked__(WorkPool* __Pool__)
+{
+    for (uint32_t Index = 0; Index < WorkMaxWorkers; Index++)
+    {
+        if (__Pool__->Parked[Index])
+        {
+            __Pool__->Parked[Index] = 0;
+            return __Pool__->Workers[Index];
+        }
+    }
+    return NULL;
+}
+
+static void
+__PoolAppend__(uint32_t __CpuId__, WorkItem* __Work__)
+{
+    WorkPool* Pool = &WorkPools[__CpuId__];
+
+    AcquireSpinLock(&Pool->Lock);
+    __Work__->Cpu  = __CpuId__;
+    __Work__->Next = NULL;
+    if (Pool->Tail)
+    {
+        Pool->Tail->Next = __Work__;
+    }
+    else
+    {
+        Pool->Head = __Work__;
+    }
+    Pool->Tail     = __Work__;
+    Thread* Worker = __ClaimParked__(Pool);
+    ReleaseSpinLock(&Pool->Lock);
+
+    if (Worker)
+    {
+        WakeupThread(Worker);
+    }
+}
+
+/*Atomically claims the pending bit; only the winner may link the item*/
+static int
+__ClaimPending__(WorkQueue* __Queue__, WorkItem* __Work__)
+{
+    if (__atomic_fetch_or(&__Work__->Flags, WorkPending, __ATOMIC_SEQ_CST) & WorkPending)
+    {
+        return 0;
+    }
+
+    __Work__->Queue = __Queue__;
+    __atomic_fetch_add(&__Queue__->InFlight, 1, __ATOMIC_SEQ_CST);
+    return 1;
+}
+
+static inline uint32_t
+__PickCpu__(uint32_t __CpuId__)
+{
+    return __CpuId__ < Smp.CpuCount ? __CpuId__ : GetCurrentCpuId();
+}
+
+int
+QueueWorkOn(uint32_t __CpuId__, WorkQueue* __Queue__, WorkItem* __Work__)
+{
+    if (!__Queue__ || !__Work__ || !__Work__->Func)
+    {
+        return -1;
+    }
+    if (!__ClaimPending__(__Queue__, __Work__))
+    {
+        return 0;
+    }
+
+    __PoolAppend__(__PickCpu__(__CpuId__), __Work__);
+    return 1;
+}
+
+int
+QueueWork(WorkItem* __Work__)
+{
+    return QueueWorkOn(GetCurrentCpuId(), SystemWq, __Work__);
+}
+
+int
+QueueDelayedWorkOn(uint32_t   __CpuId__,
+                   WorkQueue* __Queue__,
+                   WorkItem*  __Work__,
+                   uint64_t   __DelayMs__)
+{
+    if (!__DelayMs__)
+    {
+        return QueueWorkOn(__CpuId__, __Queue__, __Work__);
+    }
+    if (!__Queue__ || !__Work__ || !__Work__->Func)
+    {
+        return -1;
+    }
+    if (!__ClaimPending__(__Queue__, __Work__))
+    {
+        return 0;
+    }
+
+    uint32_t  CpuId = __PickCpu__(__CpuId__);
+    WorkPool* Pool  = &WorkPools[CpuId];
+
+    __Work__->Deadline = GetSystemTicks() + __MsToTicks__(__DelayMs__);
+    __atomic_fetch_or(&__Work__->Flags, WorkDelayed, __ATOMIC_SEQ_CST);
+
+    AcquireSpinLock(&Pool->Lock);
+    __Work__->Cpu = CpuId;
+
+    WorkItem** Link = &Pool->Delayed;
+    while (*Link && (*Link)->Deadline <= __Work__->Deadline)
+    {
+        Link = &(*Link)->Next;
+    }
+    __Work__->Next     = *Link;
+    *Link              = __Work__;
+    Pool->NextDeadline = Pool->Delayed->Deadline;
+    ReleaseSpinLock(&Pool->Lock);
+    return 1;
+}
+
+int
+QueueDelayedWork(WorkItem* __Work__, uint64_t __DelayMs__)
+{
+    return QueueDelayedWorkOn(GetCurrentCpuId(), SystemWq, __Work__, __DelayMs__);
+}
+
+/*Timer tick: promote expired delayed items on this CPU*/
+void
+WorkQueueTick(uint32_t __CpuId__)
+{
+    if (__CpuId__ >= MaxCPUs)
+    {
+        return;
+    }
+
+    WorkPool* Pool = &WorkPools[__CpuId__];
+    uint64_t  Now  = GetSystemTicks();
+    if (!Pool->NextDeadline || Now < Pool->NextDeadline)
+    {
+        return;
+    }
+
+    AcquireSpinLock(&Pool->Lock);
+    while (Pool->Delayed && Pool->Delayed->Deadline <= Now)
+    {
+        WorkItem* Work = Pool->Delayed;
+        Pool->Delayed  = Work->Next;
+        __atomic_fetch_and(&Work->Flags, ~WorkDelayed, __ATOMIC_SEQ_CST);
+
+        Work->Next = NULL;
+        if (Pool->Tail)
+        {
+            Pool->Tail->Next = Work;
+        }
+        else
+        {
+            Pool->Head = Work;
+        }
+        Pool->Tail = Work;
+    }
+    Pool->NextDeadline = Pool->Delayed ? Pool->Delayed->Deadline : 0;
+    Thread* Worker     = Pool->Head ? __ClaimParked__(Pool) : NULL;
+    ReleaseSpinLock(&Pool->Lock);
+
+    if (Worker)
+    {
+        WakeupThread(Worker);
+    }
+}
+
+/*An item finished; let one held-back item of its queue through*/
+static void
+__RetireWork__(WorkQueue* __Queue__)
+{
+    WorkItem* Next = NULL;
+
+    AcquireSpinLock(&__Queue__->Lock);
+    __Queue__->Active--;
+    if (__Queue__->Inactive && __Queue__->Active < __Queue__->MaxActive)
+    {
+        Next                = __Queue__->Inactive;
+        __Queue__->Inactive = Next->Next;
+        __atomic_fetch_and(&Next->Flags, ~WorkInactive, __ATOMIC_SEQ_CST);
+    }
+    ReleaseSpinLock(&__Queue__->Lock);
+
+    if (Next)
+    {
+        __PoolAppend__(Next->Cpu, Next);
+    }
+}
+
+/*
+ * Returns 1 when the item may run now, 0 when it was held back behind
+ * MaxActive. The item arrives still pending and only an admitted one drops
+ * the bit, so a racing QueueWorkOn never links an item that is on its way
+ * to the inactive list.
+ */
+static int
+__AdmitWork__(WorkQueue* __Queue__, WorkItem* __Work__)
+{
+    AcquireSpinLock(&__Queue__->Lock);
+    if (__Queue__->Active < __Queue__->MaxActive)
+    {
+        __Queue__->Active++;
+        ReleaseSpinLock(&__Queue__->Lock);
+        __atomic_fetch_and(&__Work__->Flags, ~WorkPending, __ATOMIC_SEQ_CST);
+        return 1;
+    }
+
+    /*Stays pending; FIFO order among held-back items*/
+    __atomic_fetch_or(&__Work__->Flags, WorkInactive, __ATOMIC_SEQ_CST);
+    __Work__->Next = NULL;
+
+    WorkItem** Link = &__Queue__->Inactive;
+    while (*Link)
+    {
+        Link = &(*Link)->Next;
+    }
+    *Link = __Work__;
+    ReleaseSpinLock(&__Queue__->Lock);
+    return 0;
+}
+
+static void
+__WorkerLoop__(void* __Arg__)
+{
+    uint32_t  CpuId = (uint32_t)((uint64_t)__Arg__ >> 8);
+    uint32_t  Index = (uint32_t)((uint64_t)__Arg__ & 0xFF);
+    WorkPool* Pool  = &WorkPools[CpuId];
+    Thread*   Self  = Pool->Workers[Index];
+
+    for (;;)
+    {
+        AcquireSpinLock(&Pool->Lock);
+        WorkItem* Work = Pool->Head;
+        if (!Work)
+        {
+            /*Park; whoever queues next sees the flag under this lock and wakes us*/
+            Pool->Parked[Index] = 1;
+            Self->WaitReason    = WaitReasonIo;
+            Self->State         = ThreadStateBlocked;
+            ReleaseSpinLock(&Pool->Lock);
+            ThreadYield();
+            continue;
+        }
+
+        Pool->Head = Work->Next;
+        if (!Pool->Head)
+        {
+            Pool->Tail = NULL;
+        }
+        Work->Next = NULL;
+
+        /*Running is published before Pending drops so flushers never see a gap*/
+        __atomic_store_n(&Pool->Running[Index], Work, __ATOMIC_SEQ_CST);
+        ReleaseSpinLock(&Pool->Lock);
+
+        WorkQueue* Queue = Work->Queue;
+        if (!__AdmitWork__(Queue, Work))
+        {
+            __atomic_store_n(&Pool->Running[Index], NULL, __ATOMIC_SEQ_CST);
+            continue;
+        }
+
+        /*The function may requeue or free the item; it is not touched afterwards*/
+        Work->Func(Work);
+        __atomic_store_n(&Pool->Running[Index], NULL, __ATOMIC_SEQ_CST);
+
+        __atomic_fetch_add(&Pool->Executed, 1, __ATOMIC_SEQ_CST);
+        __atomic_fetch_sub(&Queue->InFlight, 1, __ATOMIC_SEQ_CST);
+        __RetireWork__(Queue);
+    }
+}
+
+int
+CancelWork(WorkItem* __Work__)
+{
+    if (!__Work__)
+    {
+        return 0;
+    }
+
+    uint32_t Flags = __atomic_load_n(&__Work__->Flags, __ATOMIC_SEQ_CST);
+    if (!(Flags & WorkPending) || !__Work__->Queue)
+    {
+        return 0;
+    }
+
+    WorkQueue* Queue = __Work__->Queue;
+    int        Found = 0;
+
+    if (Flags & WorkInactive)
+    {
+        AcquireSpinLock(&Queue->Lock);
+        for (WorkItem** Link = &Queue->Inactive; *Link; Link = &(*Link)->Next)
+        {
+            if (*Link == __Work__)
+            {
+                *Link = __Work__->Next;
+                Found = 1;
+                break;
+            }
+        }
+        if (Found)
+        {
+            __atomic_fetch_and(
+                &__Work__->Flags, ~(WorkPending | WorkInactive), __ATOMIC_SEQ_CST);
+        }
+        ReleaseSpinLock(&Queue->Lock);
+    }
+    else
+    {
+        WorkPool* Pool = &WorkPools[__Work__->Cpu];
+
+        AcquireSpinLock(&Pool->Lock);
+        for (WorkItem** Link = &Pool->Delayed; *Link; Link = &(*Link)->Next)
+        {
+            if (*Link == __Work__)
+            {
+                *Link = __Work__->Next;
+                Found = 1;
+                break;
+            }
+        }
+
+        WorkItem* Prev = NULL;
+        for (WorkItem* Curr = Pool->Head; Curr && !Found; Prev = Curr, Curr = Curr->Next)
+        {
+            if (Curr != __Work__)
+            {
+                continue;
+            }
+
+            if (Prev)
+            {
+                Prev->Next = Curr->Next;
+            }
+            else
+            {
+                Pool->Head = Curr->Next;
+            }
+            if (Pool->Tail == Curr)
+            {
+                Pool->Tail = Prev;
+            }
+            Found = 1;
+        }
+
+        if (Found)
+        {
+            Pool->NextDeadline = Pool->Delayed ? Pool->Delayed->Deadline : 0;
+            __atomic_fetch_and(&__Work__->Flags, ~(WorkPending | WorkDelayed), __ATOMIC_SEQ_CST);
+        }
+        ReleaseSpinLock(&Pool->Lock);
+    }
+
+    if (Found)
+    {
+        __Work__->Next = NULL;
+        __atomic_fetch_sub(&Queue->InFlight, 1, __ATOMIC_SEQ_CST);
+    }
+    return Found;
+}
+
+static int
+__WorkBusy__(WorkItem* __Work__)
+{
+    if (__atomic_load_n(&__Work__->Flags, __ATOMIC_SEQ_CST) & WorkPending)
+    {
+        return 1;
+    }
+
+    for (uint32_t CpuIndex = 0; CpuIndex < Smp.CpuCount; CpuIndex++)
+    {
+        for (uint32_t Index = 0; Index < WorkMaxWorkers; Index++)
+        {
+            if (__atomic_load_n(&WorkPools[CpuIndex].Running[Index], __ATOMIC_SEQ_CST) ==
+                __Work__)
+            {
+                return 1;
+            }
+        }
+    }
+    return 0;
+}
+
+void
+FlushWork(WorkItem* __Work__)
+{
+    while (__Work__ && __WorkBusy__(__Work__))
+    {
+        ThreadYield();
+    }
+}
+
+int
+CancelWorkSync(WorkItem* __Work__)
+{
+    int Cancelled = 0;
+    while (__Work__ && __WorkBusy__(__Work__))
+    {
+        Cancelled |= CancelWork(__Work__);
+        if (__WorkBusy__(__Work__))
+        {
+            ThreadYield();
+        }
+    }
+    return Cancelled;
+}
+
+void
+FlushWorkQueue(WorkQueue* __Queue__)
+{
+    if (!__Queue__)
+    {
+        return;
+    }
+
+    while (__atomic_load_n(&__Queue__->InFlight, __ATOMIC_SEQ_CST))
+    {
+        ThreadYield();
+    }
+}
+
+void
+DumpWorkQueues(void)
+{
+    for (uint32_t CpuIndex = 0; CpuIndex < Smp.CpuCount; CpuIndex++)
+    {
+        WorkPool* Pool   = &WorkPools[CpuIndex];
+        uint32_t  Parked = 0;
+        for (uint32_t Index = 0; Index < WorkMaxWorkers; Index++)
+        {
+            Parked += Pool->Parked[Index];
+        }
+
+        PInfo("WorkQueue: CPU %u executed %lu, %u/%u workers parked, %s\n",
+              CpuIndex,
+              Pool->Executed,
+              Parked,
+              WorkMaxWorkers,
+              Pool->Head ? "busy" : "idle");
+    }
+    PInfo("WorkQueue: events %u in flight, %u active\n", SystemQueue.InFlight, SystemQueue.Active);
+}
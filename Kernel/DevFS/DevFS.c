@@ -1,12 +1,19 @@
 
 #include <DevFS.h>
+#include <WorkQueue.h>
 
 /* Registry limits */
 static const long __MaxDevices__ = 256;
 
-/* Registry store */
+/*
+ * Registry store. Lookups and readdir walk it under RCU; register and
+ * unregister serialise on __DevLock__. Slots never move, so a walker cannot
+ * skip a live entry, and a freed slot is reused by the next registration.
+ */
 static DeviceEntry* __DevTable__[256];
-static long         __DevCount__ = 0;
+static long         __DevSlots__ = 0; /* Slots ever used, the walk bound */
+static long         __DevCount__ = 0; /* Live entries */
+static SpinLock     __DevLock__;
 
 /* Root superblock and vnode (constructed at mount) */
 static Superblock* __DevSuper__ = 0;
@@ -73,6 +80,17 @@ typedef struct DevFsNodePriv
 
 } DevFsNodePriv;
 
+/* Registry allocation, freed by a worker a grace period after unregistering */
+typedef struct DevFsRegEntry
+{
+    DeviceEntry Dev;
+    RcuHead     Rcu;
+    WorkItem    Free;
+
+} DevFsRegEntry;
+
+/* Caller holds __DevLock__ or RcuReadLock */
+
 static long
 __dev_index__(const char* __Name__)
 {
@@ -80,9 +98,11 @@ __dev_index__(const char* __Name__)
     {
         return -1;
     }
-    for (long I = 0; I < __DevCount__; I++)
+    long Slots = __atomic_load_n(&__DevSlots__, __ATOMIC_ACQUIRE);
+    for (long I = 0; I < Slots; I++)
     {
-        if (__DevTable__[I] && strcmp(__DevTable__[I]->Name, __Name__) == 0)
+        DeviceEntry* E = RcuDereference(__DevTable__[I]);
+        if (E && strcmp(E->Name, __Name__) == 0)
         {
             return I;
         }
@@ -94,12 +114,69 @@ static DeviceEntry*
 __dev_find__(const char* __Name__)
 {
     long idx = __dev_index__(__Name__);
-    return (idx >= 0) ? __DevTable__[idx] : 0;
+    return (idx >= 0) ? RcuDereference(__DevTable__[idx]) : 0;
+}
+
+/* Publish E in a free slot, unless the name is taken or the table is full */
+static int
+__dev_insert__(DeviceEntry* __E__)
+{
+    AcquireSpinLockPlain(&__DevLock__);
+    if (__dev_index__(__E__->Name) >= 0)
+    {
+        ReleaseSpinLockPlain(&__DevLock__);
+        return -1;
+    }
+
+    long Slot = 0;
+    while (Slot < __DevSlots__ && __DevTable__[Slot])
+    {
+        Slot++;
+    }
+    if (Slot >= __MaxDevices__)
+    {
+        ReleaseSpinLockPlain(&__DevLock__);
+        return -1;
+    }
+
+    RcuAssignPointer(__DevTable__[Slot], __E__);
+    if (Slot == __DevSlots__)
+    {
+        __atomic_store_n(&__DevSlots__, Slot + 1, __ATOMIC_RELEASE);
+    }
+    __DevCount__++;
+    ReleaseSpinLockPlain(&__DevLock__);
+    return 0;
+}
+
+static void
+__dev_free__(WorkItem* __Work__)
+{
+    DevFsRegEntry* R = (DevFsRegEntry*)((char*)__Work__ - offsetof(DevFsRegEntry, Free));
+
+    /* Char device names are copied at registration, block device names are the driver's */
+    if (R->Dev.Type == DevChar)
+    {
+        KFree((void*)R->Dev.Name);
+    }
+    KFree(R);
+}
+
+/* RCU callbacks run in softirq context, where KFree could land inside a KMalloc */
+static void
+__dev_free_rcu__(RcuHead* __Head__)
+{
+    DevFsRegEntry* R = (DevFsRegEntry*)((char*)__Head__ - offsetof(DevFsRegEntry, Rcu));
+
+    InitWork(&R->Free, __dev_free__);
+    QueueWork(&R->Free);
 }
 
 int
 DevFsInit(void)
 {
+    InitializeSpinLock(&__DevLock__, "DevFS");
+    __DevSlots__ = 0;
     __DevCount__ = 0;
     __DevSuper__ = 0;
     PDebug("DevFS: Init registry\n");
@@ -118,29 +195,18 @@ DevFsRegisterCharDevice(const char* __Name__,
         return -1;
     }
 
-    if (__DevCount__ >= __MaxDevices__)
-    {
-        return -1;
-    }
-
-    if (__dev_find__(__Name__))
-    {
-        return -1;
-    }
-
-    DeviceEntry* E = (DeviceEntry*)KMalloc(sizeof(DeviceEntry));
-    if (!E)
+    DevFsRegEntry* R = (DevFsRegEntry*)KZalloc(sizeof(DevFsRegEntry));
+    if (!R)
     {
         return -1;
     }
-
-    memset(E, 0, sizeof(*E));
+    DeviceEntry* E = &R->Dev;
 
     const long CapName   = 255; /*uint8 Max*/
     char*      NameStore = (char*)KMalloc(CapName + 1);
     if (!NameStore)
     {
-        KFree(E);
+        KFree(R);
         return -1;
     }
     strncpy(NameStore, __Name__, CapName);
@@ -153,8 +219,12 @@ DevFsRegisterCharDevice(const char* __Name__,
     E->Context = __Context__;
     __builtin_memcpy(&E->Ops.C, &__Ops__, sizeof(CharDevOps));
 
-    __DevTable__[__DevCount__] = E;
-    __DevCount__++;
+    if (__dev_insert__(E) != 0)
+    {
+        KFree(NameStore);
+        KFree(R);
+        return -1;
+    }
 
     return 0;
 }
@@ -170,22 +240,13 @@ DevFsRegisterBlockDevice(const char* __Name__,
     {
         return -1;
     }
-    if (__DevCount__ >= __MaxDevices__)
-    {
-        return -1;
-    }
 
-    if (__dev_find__(__Name__))
-    {
-        PWarn("DevFS: Device exists %s\n", __Name__);
-        return -1;
-    }
-
-    DeviceEntry* E = (DeviceEntry*)KMalloc(sizeof(DeviceEntry));
-    if (!E)
+    DevFsRegEntry* R = (DevFsRegEntry*)KZalloc(sizeof(DevFsRegEntry));
+    if (!R)
     {
         return -1;
     }
+    DeviceEntry* E = &R->Dev;
 
     E->Name    = __Name__;
     E->Type    = DevBlock;
@@ -194,7 +255,12 @@ DevFsRegisterBlockDevice(const char* __Name__,
     E->Context = __Context__;
     E->Ops.B   = __Ops__;
 
-    __DevTable__[__DevCount__++] = E;
+    if (__dev_insert__(E) != 0)
+    {
+        PWarn("DevFS: Device exists or table full %s\n", __Name__);
+        KFree(R);
+        return -1;
+    }
     PDebug("DevFS: Block registered %s (blk=%ld)\n", __Name__, (long)__Ops__.BlockSize);
     return 0;
 }
@@ -202,17 +268,20 @@ DevFsRegisterBlockDevice(const char* __Name__,
 int
 DevFsUnregisterDevice(const char* __Name__)
 {
+    AcquireSpinLockPlain(&__DevLock__);
     long idx = __dev_index__(__Name__);
     if (idx < 0)
     {
+        ReleaseSpinLockPlain(&__DevLock__);
         return -1;
     }
-    KFree(__DevTable__[idx]);
-    for (long J = idx; J < __DevCount__ - 1; J++)
-    {
-        __DevTable__[J] = __DevTable__[J + 1];
-    }
-    __DevTable__[--__DevCount__] = 0;
+    DeviceEntry* E = __DevTable__[idx];
+    RcuAssignPointer(__DevTable__[idx], NULL);
+    __DevCount__--;
+    ReleaseSpinLockPlain(&__DevLock__);
+
+    /* Lookups and readdir in flight may still read it */
+    CallRcu(&((DevFsRegEntry*)E)->Rcu, __dev_free_rcu__);
     PDebug("DevFS: Unregistered %s\n", __Name__);
     return 0;
 }
@@ -240,7 +309,7 @@ DevFsMountImpl(const char* __Dev__ __attribute__((unused)),
     (void)__Opts__;
 
     /* Allocate superblock and root directory vnode */
-    Superblock* Sb = (Superblock*)KMalloc(sizeof(Superblock));
+    Superblock* Sb = (Superblock*)KZalloc(sizeof(Superblock));
     if (!Sb)
     {
         PError("DevFS: Sb alloc failed\n");
@@ -736,9 +805,11 @@ DevVfsReaddir(Vnode* __Dir__, void* __Buf__, long __BufLen__)
         Wrote++;
     }
 
-    for (long I = 0; I < __DevCount__ && Wrote < Max; I++)
+    RcuReadLock();
+    long Slots = __atomic_load_n(&__DevSlots__, __ATOMIC_ACQUIRE);
+    for (long I = 0; I < Slots && Wrote < Max; I++)
     {
-        DeviceEntry* E = __DevTable__[I];
+        DeviceEntry* E = RcuDereference(__DevTable__[I]);
         if (!E)
         {
             continue;
@@ -758,6 +829,7 @@ DevVfsReaddir(Vnode* __Dir__, void* __Buf__, long __BufLen__)
 
         Wrote++;
     }
+    RcuReadUnlock();
 
     return Wrote * (long)sizeof(VfsDirEnt);
 }
@@ -774,7 +846,10 @@ DevVfsLookup(Vnode* __Dir__, const char* __Name__)
         return 0;
     }
 
+    /* The node keeps E; drivers unregister only once their nodes are closed */
+    RcuReadLock();
     DeviceEntry* E = __dev_find__(__Name__);
+    RcuReadUnlock();
     if (!E)
     {
         return 0;
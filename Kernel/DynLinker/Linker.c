@@ -210,7 +210,7 @@ InstallModule(const char* __Path__)
     }
     PInfo("ELF: Loaded symbols\n");
 
-    void** SectionBases = (void**)KMalloc((size_t)(ShNum * (long)sizeof(void*)));
+    void** SectionBases = (void**)KCalloc((size_t)ShNum, sizeof(void*));
     if (!SectionBases)
     {
         KFree(Syms);
@@ -220,7 +220,6 @@ InstallModule(const char* __Path__)
         PError("MOD: KMalloc SectionBases failed\n");
         return -1;
     }
-    memset(SectionBases, 0, (size_t)(ShNum * (long)sizeof(void*)));
 
     for (long I = 0; I < ShNum; I++)
     {
@@ -34,6 +34,9 @@ KernelWorkerThread(void* __Argument__)
 
     InitRamDiskDevDrvs();
 
+    /*Limine responses (SMP, modules, framebuffer) have all been consumed by now*/
+    PmmReclaimBootloaderMemory();
+
     __TEST__Proc();
 
     /*done*/
@@ -94,6 +97,12 @@ _start(void)
         InitializeSpinLock(&SMPLock, "SMP");
         InitializeSmp();
         InitializeScheduler();
+        SmpReleaseAps();
+        InitializeSchedGroups();
+        InitializeWorkQueues();
+        InitializeSoftirq();
+        InitializeRcu();
+        InitializeReaper();
 
         Thread* KernelWorker =
             CreateThread(ThreadTypeKernel, KernelWorkerThread, NULL, ThreadPrioritykernel);
@@ -16,13 +16,12 @@ FirmRequest(FirmwareHandle**    __OutHandle__,
         return -1;
     }
 
-    FirmwareHandle* H = (FirmwareHandle*)KMalloc(sizeof(FirmwareHandle));
+    FirmwareHandle* H = (FirmwareHandle*)KZalloc(sizeof(FirmwareHandle));
     if (!H)
     {
         PError("FirmRequest: alloc handle failed\n");
         return -3;
     }
-    memset(H, 0, sizeof(FirmwareHandle));
     H->Desc        = *__Desc__;
     H->Dev         = __Dev__;
     *__OutHandle__ = H;
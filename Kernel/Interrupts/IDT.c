@@ -319,6 +319,7 @@ __asm__("IsrCommonStub:\n\t"
         "pushq %r13\n\t"
         "pushq %r14\n\t"
         "pushq %r15\n\t"
+        "cld\n\t"             /*C code expects DF clear; iretq restores the caller's*/
         "movq %rsp, %rdi\n\t" /*Pass stack pointer as argument to C handler*/
         "call IsrHandler\n\t" /*Call the C exception handler*/
         "popq %r15\n\t"       /*Restore all registers in reverse order*/
@@ -356,6 +357,7 @@ __asm__("IrqCommonStub:\n\t"
         "pushq %r13\n\t"
         "pushq %r14\n\t"
         "pushq %r15\n\t"
+        "cld\n\t"             /*C code expects DF clear; iretq restores the caller's*/
         "movq %rsp, %rdi\n\t" /*Pass stack pointer as argument to C handler*/
         "call IrqHandler\n\t" /*Call the C interrupt handler*/
         "popq %r15\n\t"       /*Restore all registers in reverse order*/
@@ -1,14 +1,35 @@
+#include <AxeThreads.h>
 #include <IDT.h>
+#include <SMP.h>
+#include <Softirq.h>
 #include <Timer.h>
 
+/*EOI is already sent, so deferred work may run with interrupts back on*/
+static void
+__IrqExit__(InterruptFrame* __Frame__)
+{
+    /*Nested in a softirq batch: its own exit settles the accounting*/
+    if (SoftirqActive(GetCurrentCpuId()))
+    {
+        return;
+    }
+
+    SoftirqIrqExit(__Frame__);
+    ThreadAcctIrqExit(__Frame__->Cs);
+}
+
 void
 IrqHandler(InterruptFrame* __Frame__)
 {
+    /*Time from here to iret is IRQ time of whichever thread was interrupted*/
+    ThreadAcctIrqEnter();
+
     /*Handle APIC Timer on IRQ0 - Vector 32 is the first IRQ (IRQ0)*/
     if (__Frame__->IntNo == 32)
     {
         TimerHandler(__Frame__); /*Dispatch to timer subsystem*/
-        return;                  /*APIC handles its own EOI, no need for PIC EOI*/
+        __IrqExit__(__Frame__);
+        return; /*APIC handles its own EOI, no need for PIC EOI*/
     }
 
     /*Legacy PIC interrupts - Handle EOI (End of Interrupt) signaling*/
@@ -19,4 +40,6 @@ IrqHandler(InterruptFrame* __Frame__)
     }
     /*Always send EOI to master PIC to acknowledge the interrupt*/
     __asm__ volatile("outb %0, %1" : : "a"((uint8_t)0x20), "Nd"((uint16_t)0x20));
+
+    __IrqExit__(__Frame__);
 }
@@ -0,0 +1,208 @@
+#include <AxeSchd.h>
+#include <SMP.h>
+#include <Softirq.h>
+#include <Tsc.h>
+
+SoftirqCpu    Softirqs[MaxCPUs];
+SoftirqVector SoftirqVectors[SoftirqCount];
+
+int
+RegisterSoftirq(uint32_t __Nr__, SoftirqHandler __Handler__, const char* __Name__)
+{
+    if (__Nr__ >= SoftirqCount || !__Handler__ || SoftirqVectors[__Nr__].Handler)
+    {
+        PError("Softirq: Cannot register vector %u\n", __Nr__);
+        return -1;
+    }
+
+    SoftirqVectors[__Nr__].Name = __Name__;
+    __atomic_store_n(&SoftirqVectors[__Nr__].Handler, __Handler__, __ATOMIC_SEQ_CST);
+    return 0;
+}
+
+void
+RaiseSoftirqOn(uint32_t __CpuId__, uint32_t __Nr__)
+{
+    if (__CpuId__ >= MaxCPUs || __Nr__ >= SoftirqCount)
+    {
+        return;
+    }
+    __atomic_fetch_or(&Softirqs[__CpuId__].Pending, 1U << __Nr__, __ATOMIC_SEQ_CST);
+}
+
+void
+RaiseSoftirq(uint32_t __Nr__)
+{
+    RaiseSoftirqOn(GetCurrentCpuId(), __Nr__);
+}
+
+int
+SoftirqActive(uint32_t __CpuId__)
+{
+    return __CpuId__ < MaxCPUs && __atomic_load_n(&Softirqs[__CpuId__].Active, __ATOMIC_SEQ_CST);
+}
+
+/*
+ * Runs pending vectors with interrupts on. Active stays set throughout so the
+ * timer does not switch threads under us: IRQ exits from user mode share the
+ * per-CPU TSS stack. Returns the mask still pending when the budget ran out.
+ */
+static uint32_t
+__RunSoftirqs__(uint32_t __CpuId__)
+{
+    SoftirqCpu* Cpu      = &Softirqs[__CpuId__];
+    uint64_t    Start    = ReadTsc();
+    uint32_t    Restarts = 0;
+    uint32_t    Pending;
+
+    __atomic_store_n(&Cpu->Active, 1, __ATOMIC_SEQ_CST);
+    __asm__ volatile("sti" ::: "memory");
+
+    while ((Pending = __atomic_exchange_n(&Cpu->Pending, 0, __ATOMIC_SEQ_CST)) != 0)
+    {
+        for (uint32_t Nr = 0; Nr < SoftirqCount; Nr++)
+        {
+            SoftirqHandler Handler = SoftirqVectors[Nr].Handler;
+            if ((Pending & (1U << Nr)) && Handler)
+            {
+                Handler(__CpuId__);
+                Cpu->Runs[Nr]++;
+            }
+        }
+
+        if (++Restarts >= SoftirqMaxRestart || TscToNs(ReadTsc() - Start) >= SoftirqBudgetNs)
+        {
+            break;
+        }
+    }
+
+    __asm__ volatile("cli" ::: "memory");
+    __atomic_store_n(&Cpu->Active, 0, __ATOMIC_SEQ_CST);
+    return __atomic_load_n(&Cpu->Pending, __ATOMIC_SEQ_CST);
+}
+
+static void
+__WakeDaemon__(SoftirqCpu* __Cpu__)
+{
+    if (__Cpu__->Daemon && __atomic_exchange_n(&__Cpu__->DaemonParked, 0, __ATOMIC_SEQ_CST))
+    {
+        __Cpu__->Deferred++;
+        WakeupThread(__Cpu__->Daemon);
+    }
+}
+
+/*Called last on the hard IRQ path, interrupts still off*/
+void
+SoftirqIrqExit(InterruptFrame* __Frame__)
+{
+    uint32_t    CpuId = GetCurrentCpuId();
+    SoftirqCpu* Cpu   = &Softirqs[CpuId];
+
+    /*Nested inside a running batch, a BH lock is held, or the interrupted code had IF clear*/
+    if (!Cpu->Pending || Cpu->Active || Cpu->BhDisabled || !(__Frame__->Rflags & 0x200))
+    {
+        return;
+    }
+
+    /*Sustained load belongs to ksoftirqd; do not compete with it on every exit*/
+    if (Cpu->Daemon && !Cpu->DaemonParked)
+    {
+        return;
+    }
+
+    if (__RunSoftirqs__(CpuId))
+    {
+        __WakeDaemon__(Cpu);
+    }
+}
+
+/*Also holds off preemption, so the CPU stays the same until LocalBhEnable*/
+void
+LocalBhDisable(void)
+{
+    PreemptDisable();
+    Softirqs[GetCurrentCpuId()].BhDisabled++;
+}
+
+/*Whatever was raised meanwhile runs at the next IRQ exit, at most a tick away*/
+void
+LocalBhEnable(void)
+{
+    SoftirqCpu* Cpu = &Softirqs[GetCurrentCpuId()];
+    if (Cpu->BhDisabled > 0)
+    {
+        Cpu->BhDisabled--;
+    }
+    PreemptEnable();
+}
+
+static void
+__SoftirqDaemon__(void* __Arg__)
+{
+    uint32_t    CpuId = (uint32_t)(uint64_t)__Arg__;
+    SoftirqCpu* Cpu   = &Softirqs[CpuId];
+    Thread*     Self  = Cpu->Daemon;
+
+    for (;;)
+    {
+        __asm__ volatile("cli" ::: "memory");
+        if (!__atomic_load_n(&Cpu->Pending, __ATOMIC_SEQ_CST))
+        {
+            /*Park; IRQ exits run softirqs inline again until the next overload*/
+            Self->WaitReason = WaitReasonIo;
+            Self->State      = ThreadStateBlocked;
+            __atomic_store_n(&Cpu->DaemonParked, 1, __ATOMIC_SEQ_CST);
+            __asm__ volatile("sti" ::: "memory");
+            ThreadYield();
+            continue;
+        }
+
+        /*One budgeted batch, then let everything else on this CPU run*/
+        __RunSoftirqs__(CpuId);
+        __asm__ volatile("sti" ::: "memory");
+        ThreadYield();
+    }
+}
+
+void
+InitializeSoftirq(void)
+{
+    for (uint32_t CpuIndex = 0; CpuIndex < Smp.CpuCount; CpuIndex++)
+    {
+        Thread* Daemon = CreateThread(
+            ThreadTypeKernel, (void*)__SoftirqDaemon__, (void*)(uint64_t)CpuIndex, ThreadPrioritykernel);
+        if (!Daemon)
+        {
+            PWarn("Softirq: No ksoftirqd for CPU %u\n", CpuIndex);
+            continue;
+        }
+
+        Daemon->Flags |= ThreadFlagSystem | ThreadFlagPinned;
+        Daemon->CpuAffinity = 1U << (CpuIndex & 31);
+        SetThreadName(Daemon, "ksoftirqd");
+        Softirqs[CpuIndex].Daemon = Daemon;
+        ThreadExecute(Daemon);
+    }
+
+    PSuccess("Softirq: ksoftirqd started on %u CPUs\n", Smp.CpuCount);
+}
+
+void
+DumpSoftirqs(void)
+{
+    for (uint32_t CpuIndex = 0; CpuIndex < Smp.CpuCount; CpuIndex++)
+    {
+        SoftirqCpu* Cpu = &Softirqs[CpuIndex];
+        PInfo("Softirq: CPU %u pending 0x%02x, deferred %lu\n",
+              CpuIndex,
+              Cpu->Pending,
+              Cpu->Deferred);
+        for (uint32_t Nr = 0; Nr < SoftirqCount; Nr++)
+        {
+            if (SoftirqVectors[Nr].Handler)
+            {
+                PInfo("  %s: %lu\n", SoftirqVectors[Nr].Name, Cpu->Runs[Nr]);
+            }
+        }
+    }
+}
@@ -1,7 +1,109 @@
 #include <KHeap.h>
+#include <String.h>
 
 KernelHeapManager KHeap;
 
+#ifdef KHeapTrackSites
+KHeapSite KHeapSites[KHeapMaxSites];
+uint32_t  KHeapSiteCount;
+uint64_t  KHeapUntracked;
+
+/*Live allocation -> (site, size), open addressed; Ptr 1 marks a deleted slot*/
+typedef struct
+{
+    uint64_t Ptr;
+    uint32_t Size;
+    uint32_t SiteIdx;
+
+} KHeapTrackEntry;
+
+static KHeapTrackEntry __KHeapTracked__[KHeapMaxTracked];
+
+static inline uint32_t
+__KHeapHash__(uint64_t __Key__)
+{
+    /*Fibonacci hashing; slab objects are at least 16 byte aligned*/
+    return (uint32_t)(((__Key__ >> 4) * 0x9E3779B97F4A7C15ULL) >> 32) & (KHeapMaxTracked - 1);
+}
+
+static KHeapSite*
+__KHeapSiteFor__(uint64_t __Site__, uint32_t* __OutIdx__)
+{
+    for (uint32_t Index = 0; Index < KHeapSiteCount; Index++)
+    {
+        if (KHeapSites[Index].Site == __Site__)
+        {
+            *__OutIdx__ = Index;
+            return &KHeapSites[Index];
+        }
+    }
+
+    if (KHeapSiteCount >= KHeapMaxSites)
+    {
+        return 0;
+    }
+
+    KHeapSite* Site = &KHeapSites[KHeapSiteCount];
+    Site->Site      = __Site__;
+    Site->Allocs    = 0;
+    Site->Frees     = 0;
+    Site->LiveBytes = 0;
+    *__OutIdx__     = KHeapSiteCount++;
+    return Site;
+}
+
+static void
+__KHeapTrackAlloc__(void* __Ptr__, size_t __Size__, uint64_t __Site__)
+{
+    uint32_t   SiteIdx;
+    KHeapSite* Site = __KHeapSiteFor__(__Site__, &SiteIdx);
+    if (!Site)
+    {
+        KHeapUntracked++;
+        return;
+    }
+
+    uint32_t Slot = __KHeapHash__((uint64_t)__Ptr__);
+    for (uint32_t Probe = 0; Probe < KHeapMaxTracked; Probe++)
+    {
+        KHeapTrackEntry* E = &__KHeapTracked__[(Slot + Probe) & (KHeapMaxTracked - 1)];
+        if (E->Ptr <= 1)
+        {
+            E->Ptr     = (uint64_t)__Ptr__;
+            E->Size    = (uint32_t)__Size__;
+            E->SiteIdx = SiteIdx;
+            Site->Allocs++;
+            Site->LiveBytes += __Size__;
+            return;
+        }
+    }
+
+    KHeapUntracked++;
+}
+
+static void
+__KHeapTrackFree__(void* __Ptr__)
+{
+    uint32_t Slot = __KHeapHash__((uint64_t)__Ptr__);
+    for (uint32_t Probe = 0; Probe < KHeapMaxTracked; Probe++)
+    {
+        KHeapTrackEntry* E = &__KHeapTracked__[(Slot + Probe) & (KHeapMaxTracked - 1)];
+        if (E->Ptr == 0)
+        {
+            return; /*Allocated while a table was full*/
+        }
+        if (E->Ptr == (uint64_t)__Ptr__)
+        {
+            KHeapSite* Site = &KHeapSites[E->SiteIdx];
+            Site->Frees++;
+            Site->LiveBytes -= E->Size;
+            E->Ptr = 1;
+            return;
+        }
+    }
+}
+#endif
+
 void
 InitializeKHeap(void)
 {
@@ -22,6 +124,12 @@ InitializeKHeap(void)
         SlabCache* Cache  = &KHeap.Caches[Index];
         Cache->Slabs      = 0; /*No slabs allocated initially*/
         Cache->ObjectSize = KHeap.SlabSizes[Index];
+        /*Statistics start from zero*/
+        Cache->ActiveObjects = 0;
+        Cache->TotalObjects  = 0;
+        Cache->SlabCount     = 0;
+        Cache->AllocCount    = 0;
+        Cache->FreeCount     = 0;
         /*Calculate how many objects fit in a page minus slab header*/
         Cache->ObjectsPerSlab = (PageSize - sizeof(Slab)) / Cache->ObjectSize;
 
@@ -32,11 +140,15 @@ InitializeKHeap(void)
         }
     }
 
+    /*Empty slabs go back to the PMM under memory pressure*/
+    PmmRegisterShrinker("kheap-slabs", KHeapShrink);
+
     PSuccess("KHeap initialized with %u slab caches\n", KHeap.CacheCount);
 }
 
-void*
-KMalloc(size_t __Size__)
+/*Allocator core; __Site__ is the caller recorded when KHeapTrackSites is on*/
+static void*
+__KMallocAt__(size_t __Size__, uint64_t __Site__)
 {
     /*Reject zero-sized allocations*/
     if (__Size__ == 0)
@@ -54,7 +166,22 @@ KMalloc(size_t __Size__)
         {
             return 0; /*Out of memory*/
         }
-        return PhysToVirt(PhysAddr);
+        PmmSetFrameOwner(PhysAddr, Pages, PageOwnerHeap);
+
+        /*KFree only gets the pointer back, so the head frame keeps the length*/
+        PageFrame* Head = PmmGetFrame(PhysAddr);
+        if (Head)
+        {
+            Head->RunPages = Pages;
+        }
+        KHeap.LargeAllocCount++;
+        KHeap.LargePages += Pages;
+
+        void* Ptr = PhysToVirt(PhysAddr);
+#ifdef KHeapTrackSites
+        __KHeapTrackAlloc__(Ptr, Pages * PageSize, __Site__);
+#endif
+        return Ptr;
     }
 
     /*Find the appropriate slab cache for this size*/
@@ -87,6 +214,8 @@ KMalloc(size_t __Size__)
         /*Add new slab to the front of the cache's slab list*/
         CurrentSlab->Next = Cache->Slabs;
         Cache->Slabs      = CurrentSlab;
+        Cache->SlabCount++;
+        Cache->TotalObjects += CurrentSlab->FreeCount;
     }
 
     /*Remove object from free list*/
@@ -98,15 +227,54 @@ KMalloc(size_t __Size__)
 
     CurrentSlab->FreeList = Object->Next;
     CurrentSlab->FreeCount--;
+    Cache->ActiveObjects++;
+    Cache->AllocCount++;
+
+#ifdef KHeapTrackSites
+    __KHeapTrackAlloc__(Object, Cache->ObjectSize, __Site__);
+#endif
+
+    /*Contents are left uninitialised; use KZalloc when zeroed memory is required*/
+    return (void*)Object;
+}
 
-    /*Zero out the allocated object for security*/
-    uint8_t* ObjectBytes = (uint8_t*)Object;
-    for (uint32_t Index = 0; Index < Cache->ObjectSize; Index++)
+void*
+KMalloc(size_t __Size__)
+{
+    return __KMallocAt__(__Size__, (uint64_t)__builtin_return_address(0));
+}
+
+void*
+KZalloc(size_t __Size__)
+{
+    void* Ptr = __KMallocAt__(__Size__, (uint64_t)__builtin_return_address(0));
+    if (!Ptr)
     {
-        ObjectBytes[Index] = 0;
+        return 0;
     }
 
-    return (void*)Object;
+    /*memset picks rep stosb (ERMS) or rep stosq for the fill*/
+    memset(Ptr, 0, __Size__);
+    return Ptr;
+}
+
+void*
+KCalloc(size_t __Count__, size_t __Size__)
+{
+    /*Reject Count * Size overflow instead of returning a short buffer*/
+    if (__Size__ && __Count__ > ((size_t)-1) / __Size__)
+    {
+        return 0;
+    }
+
+    void* Ptr = __KMallocAt__(__Count__ * __Size__, (uint64_t)__builtin_return_address(0));
+    if (!Ptr)
+    {
+        return 0;
+    }
+
+    memset(Ptr, 0, __Count__ * __Size__);
+    return Ptr;
 }
 
 void
@@ -118,6 +286,10 @@ KFree(void* __Ptr__)
         return;
     }
 
+#ifdef KHeapTrackSites
+    __KHeapTrackFree__(__Ptr__);
+#endif
+
     /*Calculate the slab address by masking off the page offset*/
     uint64_t ObjectAddr = (uint64_t)__Ptr__;
     uint64_t SlabAddr   = ObjectAddr & ~(PageSize - 1);
@@ -127,8 +299,17 @@ KFree(void* __Ptr__)
     if (TargetSlab->Magic != SlabMagic)
     {
         /*Not a slab allocation - must be a large page allocation*/
-        uint64_t PhysAddr = VirtToPhys(__Ptr__);
-        FreePage(PhysAddr);
+        uint64_t   PhysAddr = VirtToPhys(__Ptr__);
+        PageFrame* Head     = PmmGetFrame(PhysAddr);
+        uint64_t   Pages    = (Head && Head->RunPages) ? Head->RunPages : 1;
+
+        if (Head)
+        {
+            Head->RunPages = 0;
+        }
+        FreePages(PhysAddr, Pages);
+        KHeap.LargeFreeCount++;
+        KHeap.LargePages -= Pages;
         return;
     }
 
@@ -138,4 +319,44 @@ KFree(void* __Ptr__)
     Object->Magic        = FreeObjectMagic; /*Mark as free for debugging*/
     TargetSlab->FreeList = Object;
     TargetSlab->FreeCount++;
+
+    SlabCache* Cache = GetSlabCache(TargetSlab->ObjectSize);
+    if (Cache)
+    {
+        Cache->ActiveObjects--;
+        Cache->FreeCount++;
+    }
+}
+
+uint64_t
+KHeapShrink(uint64_t __Target__)
+{
+    uint64_t Freed = 0;
+
+    for (uint32_t Index = 0; Index < KHeap.CacheCount && Freed < __Target__; Index++)
+    {
+        SlabCache* Cache   = &KHeap.Caches[Index];
+        uint32_t   PerSlab = (PageSize - sizeof(Slab)) / Cache->ObjectSize;
+        Slab**     Link    = &Cache->Slabs;
+
+        /*Unlink and release every slab with no live objects*/
+        while (*Link && Freed < __Target__)
+        {
+            Slab* Current = *Link;
+            if (Current->FreeCount != PerSlab)
+            {
+                Link = &Current->Next;
+                continue;
+            }
+
+            *Link = Current->Next;
+            Cache->SlabCount--;
+            Cache->TotalObjects -= PerSlab;
+            Current->Magic = 0; /*Stale pointers into this page no longer look like a slab*/
+            FreeSlab(Current);
+            Freed++;
+        }
+    }
+
+    return Freed;
 }
@@ -24,6 +24,8 @@ AllocateSlab(uint32_t __ObjectSize__)
         return 0; /*Out of memory*/
     }
 
+    PmmSetFrameOwner(PhysAddr, 1, PageOwnerSlab);
+
     Slab* NewSlab = (Slab*)PhysToVirt(PhysAddr);
 
     /*Initialize slab metadata*/
@@ -24,12 +24,14 @@
 #include <POSIXSignals.h>
 #include <SMP.h>
 #include <Serial.h>
+#include <Softirq.h>
 #include <SymAP.h>
 #include <Sync.h>
 #include <Syscall.h>
 #include <Timer.h>
 #include <VFS.h>
 #include <VMM.h>
+#include <WorkQueue.h>
 
 /*for sensitive testing*/
 extern SpinLock TestLock;
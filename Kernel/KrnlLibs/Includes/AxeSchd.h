@@ -3,7 +3,8 @@
 #include <AxeThreads.h>
 #include <IDT.h>
 
-typedef struct
+/*Cache line aligned so one CPU's queue updates never touch its neighbour's*/
+typedef struct __attribute__((aligned(64)))
 {
     Thread*  ReadyQueue;      /*Ready queue*/
     Thread*  WaitingQueue;    /*Blocked threads*/
@@ -17,14 +18,81 @@ typedef struct
     uint32_t Priority;        /*Current priority level*/
     uint64_t LastSchedule;    /*Last schedule time*/
     uint64_t ScheduleTicks;   /*Schedule counter*/
-    SpinLock SchedulerLock;   /*Protect scheduler state*/
+    McsLock  SchedulerLock;   /*Queued, remote wakeups contend for it*/
     uint64_t ContextSwitches; /*Context switch count*/
     uint64_t IdleTicks;       /*Time spent idle*/
     uint32_t LoadAverage;     /*Load average*/
+    uint32_t PreemptCount;    /*Plain and BH spinlocks held; the tick does not switch*/
+
+    /*Realtime*/
+    Thread*  RtQueue;       /*FIFO/RR threads, highest RtPriority first*/
+    uint32_t RtReadyCount;  /*Threads on RtQueue, also counted in ReadyCount*/
+    uint64_t RtPeriodStart; /*Tick the current RT period began*/
+    uint64_t RtRuntimeUsed; /*RT ticks consumed this period*/
+    uint64_t RtThrottled;   /*Periods in which the RT cap was hit*/
 
 } CpuScheduler;
 
-extern CpuScheduler CpuSchedulers[MaxCPUs];
+#define SchedRrDefaultQuantum 10   /*Ticks*/
+#define SchedRtDefaultPeriod  1000 /*Ticks*/
+#define SchedRtDefaultRuntime 950  /*Ticks of each period RT threads may use*/
+
+typedef struct
+{
+    uint32_t RrQuantum; /*Ticks an RR thread runs before rotating*/
+    uint32_t RtPeriod;  /*Accounting window for the RT cap*/
+    uint32_t RtRuntime; /*RT budget per period, RtPeriod disables the cap*/
+
+} RtSchedTunables;
+
+#define MaxSchedGroups          32
+#define SchedGroupRoot          0
+#define SchedGroupNameLen       32
+#define SchedGroupDefaultShares 1024
+#define SchedGroupMinShares     2
+#define SchedGroupMaxShares     262144
+#define SchedGroupMaxStride     4096
+#define SchedGroupSlice         5 /*Ticks a CPU pulls from the group pool at once*/
+
+#define SchedGroupOpCreate    0 /*(Name, Parent) -> Id*/
+#define SchedGroupOpDestroy   1 /*(Id)*/
+#define SchedGroupOpSetShares 2 /*(Id, Shares)*/
+#define SchedGroupOpSetQuota  3 /*(Id, QuotaMs, PeriodMs), QuotaMs 0 lifts the cap*/
+#define SchedGroupOpAttach    4 /*(Id, Pid), Pid 0 is the caller*/
+
+typedef struct
+{
+    uint32_t RuntimeLeft; /*Ticks this CPU may still run the group*/
+    uint32_t Generation;  /*Period the runtime was pulled in*/
+
+} SchedGroupCpu;
+
+typedef struct
+{
+    char          Name[SchedGroupNameLen];
+    uint32_t      InUse;
+    uint32_t      Parent;
+    uint32_t      Shares;         /*Weight against other groups, 1024 is one thread*/
+    uint32_t      Members;        /*Threads attached*/
+    uint32_t      Queued;         /*Members sitting on a ready queue*/
+    uint32_t      Children;       /*Groups whose parent this is*/
+    uint32_t      Generation;     /*Bumped at every refill*/
+    uint32_t      ThrottledGen;   /*Last period the pool ran dry*/
+    uint64_t      QuotaTicks;     /*Runtime per period, 0 is unlimited*/
+    uint64_t      PeriodTicks;    /*Refill interval*/
+    uint64_t      PeriodStart;    /*Tick of the last refill*/
+    uint64_t      PoolLeft;       /*Runtime not yet handed to a CPU this period*/
+    uint64_t      Usage;          /*Ticks run, child groups included*/
+    uint64_t      Throttled;      /*Periods in which the quota ran out*/
+    uint64_t      ThrottledPicks; /*Times a member was passed over*/
+    SpinLock      Lock;           /*Protect the pool and period*/
+    SchedGroupCpu Cpu[MaxCPUs];   /*Per-CPU runtime pools*/
+
+} SchedGroup;
+
+extern CpuScheduler    CpuSchedulers[MaxCPUs];
+extern RtSchedTunables RtTunables;
+extern SchedGroup      SchedGroups[MaxSchedGroups];
 
 void     InitializeScheduler(void);
 void     InitializeCpuScheduler(uint32_t __CpuId__);
@@ -33,6 +101,7 @@ Thread*  GetNextThread(uint32_t __CpuId__);
 void     AddThreadToReadyQueue(uint32_t __CpuId__, Thread* __ThreadPtr__);
 Thread*  RemoveThreadFromReadyQueue(uint32_t __CpuId__);
 void     AddThreadToWaitingQueue(uint32_t __CpuId__, Thread* __ThreadPtr__);
+void     WakeupThread(Thread* __ThreadPtr__);
 void     AddThreadToZombieQueue(uint32_t __CpuId__, Thread* __ThreadPtr__);
 void     AddThreadToSleepingQueue(uint32_t __CpuId__, Thread* __ThreadPtr__);
 void     SaveInterruptFrameToThread(Thread* __ThreadPtr__, InterruptFrame* __Frame__);
@@ -44,4 +113,33 @@ uint32_t GetCpuLoadAverage(uint32_t __CpuId__);
 void     WakeupSleepingThreads(uint32_t __CpuId__);
 void     CleanupZombieThreads(uint32_t __CpuId__);
 void     DumpCpuSchedulerInfo(uint32_t __CpuId__);
-void     DumpAllSchedulers(void);
\ No newline at end of file
+void     DumpAllSchedulers(void);
+int      SetRtSchedTunables(uint32_t __RrQuantum__, uint32_t __RtPeriod__, uint32_t __RtRuntime__);
+void     PreemptDisable(void);
+void     PreemptEnable(void);
+int      PreemptDisabled(uint32_t __CpuId__);
+
+/*CPU Groups*/
+void     InitializeSchedGroups(void);
+int      SchedGroupCreate(const char* __Name__, uint32_t __Parent__);
+int      SchedGroupDestroy(uint32_t __GroupId__);
+int      SchedGroupSetShares(uint32_t __GroupId__, uint32_t __Shares__);
+int      SchedGroupSetQuota(uint32_t __GroupId__, uint64_t __QuotaTicks__, uint64_t __PeriodTicks__);
+int      SchedGroupAttach(Thread* __ThreadPtr__, uint32_t __GroupId__);
+void     SchedGroupInherit(Thread* __ThreadPtr__);
+void     SchedGroupLeave(Thread* __ThreadPtr__);
+void     SchedGroupQueued(Thread* __ThreadPtr__, int __Delta__);
+void     SchedGroupCharge(Thread* __ThreadPtr__, uint32_t __CpuId__);
+int      SchedGroupThrottled(Thread* __ThreadPtr__, uint32_t __CpuId__);
+uint32_t SchedGroupStride(Thread* __ThreadPtr__, uint32_t __Stride__);
+Thread*  SchedGroupIdleThread(uint32_t __CpuId__);
+
+KEXPORT(SetRtSchedTunables);
+KEXPORT(WakeupThread);
+KEXPORT(PreemptDisable);
+KEXPORT(PreemptEnable);
+KEXPORT(SchedGroupCreate);
+KEXPORT(SchedGroupDestroy);
+KEXPORT(SchedGroupSetShares);
+KEXPORT(SchedGroupSetQuota);
+KEXPORT(SchedGroupAttach);
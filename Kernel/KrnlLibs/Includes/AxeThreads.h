@@ -1,6 +1,7 @@
 #pragma once
 
 #include <AllTypes.h>
+#include <PerCpu.h>
 #include <SMP.h>
 #include <Sync.h>
 #include <VMM.h>
@@ -38,6 +39,15 @@ typedef enum
 
 } ThreadPriority;
 
+typedef enum
+{
+
+    SchedPolicyNormal, /*SCHED_OTHER, priority stride*/
+    SchedPolicyFifo,   /*SCHED_FIFO, runs until it blocks or yields*/
+    SchedPolicyRr      /*SCHED_RR, FIFO with a quantum*/
+
+} SchedPolicy;
+
 typedef struct
 {
     /*GPR*/
@@ -56,67 +66,93 @@ typedef struct
 
 } ThreadContext;
 
-typedef struct Thread
+#define AcctUser  0
+#define AcctSys   1
+#define AcctIrq   2
+#define AcctWait  3 /*Runnable but still queued*/
+#define AcctModes 4
+
+/*Rarely used per-thread state, allocated on first use by GetThreadCold*/
+typedef struct ThreadCold
 {
     /*Core ID*/
-    uint32_t ThreadId;
-    uint32_t ProcessId; /*Parent*/
-    char     Name[64];
+    char Name[64];
+
+    /*File descr*/
+    void*    FileTable[64];
+    uint32_t FileCount;
+
+    /*Signals*/
+    uint64_t SignalMask;
+    void*    SignalHandlers[32];
+
+    /*Debugging*/
+    void* DebugInfo;
+
+} ThreadCold;
 
-    /*State mgr*/
+typedef struct __attribute__((aligned(64))) Thread
+{
+    /*Hot: queue walks and Schedule only touch this cache line*/
+    struct Thread* Next;
+    struct Thread* Prev;
     ThreadState    State;
     ThreadType     Type;
     ThreadPriority Priority;
+    SchedPolicy    Policy;
+    uint32_t       RtPriority;  /*1..99 under FIFO/RR*/
+    uint32_t       RtSliceLeft; /*Ticks left of the RR quantum*/
+    uint32_t       Cooldown;
+    uint32_t       LastCpu;
+    uint64_t       WakeupTime;
+    uint64_t       PageDirectory;
+
+    /*Warm: accounting updated on every switch*/
+    uint64_t       CpuTime;
+    uint64_t       StartTime;
+    uint64_t       ContextSwitches;
+    uint64_t       TimeSlice;
+    uint32_t       ThreadId;
+    uint32_t       ProcessId; /*Parent*/
+    uint32_t       CpuAffinity;
+    uint32_t       WaitReason;
+    uint32_t       Flags;
     ThreadPriority BasePriority;
-
-    /*CPU snap*/
-    ThreadContext Context;
-    uint64_t      KernelStack;
-    uint64_t      UserStack;
-    uint32_t      StackSize;
-
-    /*MM*/
-    uint64_t PageDirectory;
+    uint32_t       ExitCode;
+    uint32_t       MemoryUsage;
+
+    /*CPU time per Acct* mode in TSC cycles*/
+    uint64_t AcctCycles[AcctModes];
+    uint64_t AcctStamp;  /*TSC at the last mode change*/
+    uint64_t ReadyStamp; /*TSC when queued, 0 while not runnable*/
+    uint32_t AcctMode;
+    uint32_t GroupId; /*SchedGroup, 0 is the root group*/
+
+    /*Stacks & MM*/
+    uint64_t KernelStack;
+    uint64_t UserStack;
+    uint32_t StackSize;
     uint64_t VirtualBase;
-    uint32_t MemoryUsage;
-
-    /*Scheduling*/
-    uint32_t CpuAffinity;
-    uint32_t LastCpu;
-    uint64_t TimeSlice;
-    uint64_t CpuTime;
-    uint64_t StartTime;
-    uint64_t WakeupTime;
 
     /*Sync*/
-    void*    WaitingOn;
-    uint32_t WaitReason;
-    uint32_t ExitCode;
-    uint32_t Cooldown;
+    void* WaitingOn;
 
     /*Linked lists*/
-    struct Thread* Next;
-    struct Thread* Prev;
     struct Thread* Parent;
     struct Thread* Children;
-
-    /*File descr*/
-    void*    FileTable[64];
-    uint32_t FileCount;
-
-    /*Signals*/
-    uint64_t SignalMask;
-    void*    SignalHandlers[32];
+    struct Thread* ReapNext; /*Zombie queue and reaper list, never the run queues*/
 
     /*Statistics*/
-    uint64_t ContextSwitches;
     uint64_t PageFaults;
     uint64_t SystemCalls;
-
-    /*Debugging*/
     uint64_t CreationTick;
-    uint32_t Flags;
-    void*    DebugInfo;
+
+    /*Cold*/
+    ThreadCold* Cold;  /*NULL until something needs it*/
+    void*       Alloc; /*Unaligned block the TCB was carved from*/
+
+    /*CPU snap, only read and written at switch time*/
+    ThreadContext Context;
 
 } Thread;
 
@@ -126,6 +162,11 @@ typedef struct Thread
 #define ThreadFlagTraced    (1 << 3)
 #define ThreadFlagSuspended (1 << 4)
 #define ThreadFlagCritical  (1 << 5)
+#define ThreadFlagIdle      (1 << 6) /*Per-CPU idle thread, never queued*/
+#define ThreadFlagWakeup    (1 << 7) /*Woken before it reached the waiting queue*/
+
+#define RtPriorityMin 1
+#define RtPriorityMax 99
 
 #define WaitReasonNone      0
 #define WaitReasonMutex     1
@@ -138,16 +179,58 @@ typedef struct Thread
 #define UserVirtualBase 0x0000000000400000ULL
 #define KStackSize      8192
 
+#define ThreadCacheDepth 16                     /*Recycled TCBs kept per CPU*/
+#define ThreadStackArena 0xFFFFFE0000000000ULL  /*PML4 slot 508, kernel stacks*/
+#define ThreadStackSlot  (KStackSize + PageSize) /*Stack plus the guard page below*/
+#define ThreadStackSlots (1U << 20)
+
+#define ReaperBatch      32  /*Threads freed between reaper yields*/
+#define LoadBalanceTicks 100 /*Ticks between LoadBalanceThreads runs from the timer softirq*/
+
+typedef struct __attribute__((aligned(64)))
+{
+    Thread*  Free;     /*Dead TCBs with their kernel stack, linked by Next*/
+    uint32_t Count;    /*Entries on Free*/
+    SpinLock Lock;     /*Protect the cache*/
+    uint64_t Hits;     /*Creates served from the cache*/
+    uint64_t Misses;   /*Creates that hit the allocators*/
+    uint64_t Released; /*TCBs freed because the cache was full*/
+
+} ThreadCache;
+
 extern uint32_t NextThreadId;
 extern Thread*  ThreadList;
 extern SpinLock ThreadListLock;
-extern Thread*  CurrentThreads[MaxCPUs];
+
+/*Written only by the owning CPU at switch time, read lock-free from anywhere*/
+DeclarePerCpu(Thread*, CurrentThreads);
 
 /*Thread Manager Core*/
 void    InitializeThreadManager(void);
 Thread* GetCurrentThread(uint32_t __CpuId__);
 void    SetCurrentThread(uint32_t __CpuId__, Thread* __ThreadPtr__); //
 
+/*TCB and Stack Pool*/
+void    InitializeThreadPool(void);
+Thread* ThreadPoolGet(void);
+void    ThreadPoolPut(Thread* __ThreadPtr__);
+void    ThreadPoolTick(uint32_t __CpuId__);
+void    DumpThreadPool(void); //
+
+/*Zombie Reaper*/
+void InitializeReaper(void);
+void ReapThreads(Thread* __Chain__); /*Linked by ReapNext, none still running*/
+
+/*CPU Time Accounting*/
+void     ThreadAcctCharge(Thread* __ThreadPtr__, uint32_t __NewMode__);
+void     ThreadAcctQueued(Thread* __ThreadPtr__);
+void     ThreadAcctDispatch(Thread* __ThreadPtr__);
+void     ThreadAcctIrqEnter(void);
+void     ThreadAcctIrqExit(uint64_t __Cs__);
+void     ThreadAcctSyscallEnter(void);
+void     ThreadAcctSyscallExit(void);
+uint64_t ThreadAcctNs(Thread* __ThreadPtr__, uint32_t __Mode__);
+
 /*Thread Lifecycle*/
 Thread* CreateThread(ThreadType     __Type__,
                      void*          __EntryPoint__,
@@ -158,8 +241,13 @@ void    SuspendThread(Thread* __ThreadPtr__);
 void    ResumeThread(Thread* __ThreadPtr__);
 
 /*Thread Properties*/
+ThreadCold* GetThreadCold(Thread* __ThreadPtr__);
+const char* GetThreadName(Thread* __ThreadPtr__);
+int         SetThreadName(Thread* __ThreadPtr__, const char* __Name__);
+
 void SetThreadPriority(Thread* __ThreadPtr__, ThreadPriority __Priority__);
 void SetThreadAffinity(Thread* __ThreadPtr__, uint32_t __CpuMask__);
+int  SetThreadScheduler(Thread* __ThreadPtr__, SchedPolicy __Policy__, uint32_t __RtPriority__);
 
 /*Thread Control*/
 void ThreadYield(void);
@@ -194,6 +282,11 @@ KEXPORT(SuspendThread);
 KEXPORT(ResumeThread);
 KEXPORT(SetThreadPriority);
 KEXPORT(SetThreadAffinity);
+KEXPORT(SetThreadScheduler);
+KEXPORT(GetThreadCold);
+KEXPORT(ThreadAcctNs);
+KEXPORT(GetThreadName);
+KEXPORT(SetThreadName);
 KEXPORT(ThreadYield);
 KEXPORT(ThreadSleep);
 KEXPORT(ThreadExit);
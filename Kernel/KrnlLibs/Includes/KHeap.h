@@ -5,10 +5,16 @@
 #include <PMM.h>
 #include <VMM.h>
 
+/*Uncomment to record the caller of every KMalloc (/proc/kmalloc_sites)*/
+// #define KHeapTrackSites
+
 #define MaxSlabSizes    8
 #define SlabMagic       0xDEADBEEF
 #define FreeObjectMagic 0xFEEDFACE
 
+#define KHeapMaxSites   256  /*Distinct callsites tracked*/
+#define KHeapMaxTracked 8192 /*Live allocations tracked (power of two)*/
+
 typedef struct SlabObject
 {
     struct SlabObject* Next;
@@ -32,6 +38,13 @@ typedef struct
     uint32_t ObjectSize;
     uint32_t ObjectsPerSlab;
 
+    /*Statistics (/proc/slabinfo)*/
+    uint64_t ActiveObjects; /*Objects currently handed out*/
+    uint64_t TotalObjects;  /*Object capacity across all slabs*/
+    uint64_t SlabCount;     /*Slabs owned by this cache*/
+    uint64_t AllocCount;    /*Lifetime allocations*/
+    uint64_t FreeCount;     /*Lifetime frees*/
+
 } SlabCache;
 
 typedef struct
@@ -40,17 +53,43 @@ typedef struct
     uint32_t  SlabSizes[MaxSlabSizes];
     uint32_t  CacheCount;
 
+    /*Allocations above the largest slab go straight to the PMM*/
+    uint64_t LargeAllocCount;
+    uint64_t LargeFreeCount;
+    uint64_t LargePages; /*Pages handed out by large allocations*/
+
 } KernelHeapManager;
 
+#ifdef KHeapTrackSites
+typedef struct
+{
+    uint64_t Site;      /*Return address of the KMalloc caller*/
+    uint64_t Allocs;    /*Lifetime allocations from this site*/
+    uint64_t Frees;     /*Lifetime frees of objects from this site*/
+    uint64_t LiveBytes; /*Bytes currently outstanding*/
+
+} KHeapSite;
+
+extern KHeapSite KHeapSites[KHeapMaxSites];
+extern uint32_t  KHeapSiteCount;
+extern uint64_t  KHeapUntracked; /*Allocations dropped because a table was full*/
+#endif
+
 extern KernelHeapManager KHeap;
 
 void  InitializeKHeap(void);
 void* KMalloc(size_t __Size__);
+void* KZalloc(size_t __Size__);
+void* KCalloc(size_t __Count__, size_t __Size__);
 void  KFree(void* __Ptr__);
 
+uint64_t KHeapShrink(uint64_t __Target__);
+
 SlabCache* GetSlabCache(size_t __Size__);
 Slab*      AllocateSlab(uint32_t __ObjectSize__);
 void       FreeSlab(Slab* __Slab__);
 
 KEXPORT(KMalloc);
+KEXPORT(KZalloc);
+KEXPORT(KCalloc);
 KEXPORT(KFree);
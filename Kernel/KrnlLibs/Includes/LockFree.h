@@ -0,0 +1,69 @@
+#pragma once
+
+#include <AllTypes.h>
+
+/*
+ * Lock-free building blocks. Storage is handed in by the caller, sizes are
+ * powers of two, and every call returns 0 on success or -1 when full, empty
+ * or misused, so they work from any context including interrupts.
+ */
+
+/*Single producer, single consumer; the two indices sit on separate lines*/
+typedef struct
+{
+    volatile uint32_t Head __attribute__((aligned(64))); /*Next slot to pop, consumer only*/
+    volatile uint32_t Tail __attribute__((aligned(64))); /*Next slot to push, producer only*/
+    uint32_t          Mask;
+    void**            Slots;
+
+} SpscRing;
+
+int InitializeSpscRing(SpscRing* __Ring__, void** __Slots__, uint32_t __Size__);
+int SpscRingPush(SpscRing* __Ring__, void* __Item__);
+int SpscRingPop(SpscRing* __Ring__, void** __Item__);
+
+/*Slot of an MPSC ring; Seq says whose turn it is*/
+typedef struct
+{
+    volatile uint64_t Seq;
+    void*             Item;
+
+} MpscSlot;
+
+/*Many producers, one consumer; producers claim slots with a CAS on Tail*/
+typedef struct
+{
+    volatile uint64_t Head __attribute__((aligned(64))); /*Consumer only*/
+    volatile uint64_t Tail __attribute__((aligned(64))); /*Claimed by producers*/
+    uint64_t          Mask;
+    MpscSlot*         Slots;
+
+} MpscRing;
+
+int InitializeMpscRing(MpscRing* __Ring__, MpscSlot* __Slots__, uint32_t __Size__);
+int MpscRingPush(MpscRing* __Ring__, void* __Item__);
+int MpscRingPop(MpscRing* __Ring__, void** __Item__);
+
+/*Embedded in whatever goes on a stack*/
+typedef struct LfStackNode
+{
+    struct LfStackNode* Next;
+
+} LfStackNode;
+
+/*
+ * Treiber stack. Top and a generation Tag change together with cmpxchg16b,
+ * so a node popped and pushed back between a pop's read and its CAS cannot
+ * fool it. Popped nodes may still be read by racing pops: keep them mapped,
+ * reuse them or free them through CallRcu.
+ */
+typedef struct __attribute__((aligned(16)))
+{
+    LfStackNode* volatile Top;
+    volatile uint64_t     Tag;
+
+} LfStack;
+
+void InitializeLfStack(LfStack* __Stack__);
+void LfStackPush(LfStack* __Stack__, LfStackNode* __Node__);
+int  LfStackPop(LfStack* __Stack__, LfStackNode** __Node__);
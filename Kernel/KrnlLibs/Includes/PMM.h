@@ -2,6 +2,7 @@
 
 #include <AllTypes.h>
 #include <KrnPrintf.h>
+#include <Sync.h>
 /*Limine*/
 #include <LimineHHDM.h>
 #include <LimineMmap.h>
@@ -10,13 +11,39 @@
 #define PageSizeBits      12
 #define BitsPerByte       8
 #define BitsPerUint64     64
-#define MaxMemoryRegions  64
+#define MaxMemoryRegions  256 /*Adjacent same-type entries are merged*/
 #define PmmBitmapNotFound 0xFFFFFFFFFFFFFFFF
 
 #define MemoryTypeUsable   0
 #define MemoryTypeReserved 1
 #define MemoryTypeKernel   2
 #define MemoryTypeBad      3
+#define MemoryTypeReclaim  4 /*Bootloader-reclaimable, freed by PmmReclaimBootloaderMemory*/
+
+#define PmmBootStackPages 16 /*Pinned around the BSP boot stack (Limine gives >= 64 KiB)*/
+
+/*Page frame owners*/
+#define PageOwnerFree      0
+#define PageOwnerReserved  1 /*Firmware, MMIO, holes*/
+#define PageOwnerKernel    2 /*Kernel image, modules, generic kernel pages*/
+#define PageOwnerBoot      3 /*Bootloader-reclaimable, not yet reclaimed*/
+#define PageOwnerPageTable 4
+#define PageOwnerSlab      5
+#define PageOwnerHeap      6 /*Large KMalloc allocations*/
+#define PageOwnerUser      7 /*Anonymous user memory*/
+#define PageOwnerPageCache 8
+#define PageOwnerStack     9 /*Pooled kernel thread stacks*/
+#define PageOwnerCount     10
+
+/*Memory pressure*/
+#define MaxShrinkers          16
+#define PmmMinWatermarkPages  128 /*Floor for the low watermark*/
+#define PmmWatermarkDivisor   64  /*Low watermark = free pages at boot / divisor*/
+
+/*Page frame flags*/
+#define PageFlagPinned (1 << 0) /*Never returned to the allocator*/
+#define PageFlagShared (1 << 1) /*Referenced more than once*/
+#define PageFlagDirty  (1 << 2)
 
 typedef struct
 {
@@ -26,9 +53,45 @@ typedef struct
     uint64_t ReservedPages;
     uint64_t KernelPages;
     uint64_t BitmapPages;
+    uint64_t ReclaimedPages;
+    uint64_t OwnerPages[PageOwnerCount]; /*Allocated pages per owner type*/
+    uint64_t ShrinkRuns;
+    uint64_t ShrunkPages;
+    uint64_t OomKills;
 
 } PmmStats;
 
+typedef struct PageFrame
+{
+    union
+    {
+        struct
+        {
+            struct PageFrame* Next; /*Owner list links (free lists, LRU)*/
+            struct PageFrame* Prev;
+        };
+        uint64_t RunPages; /*Heap: pages in the allocation this frame heads*/
+    };
+    uint32_t          RefCount;
+    uint16_t          Owner;
+    uint16_t          Flags;
+
+} PageFrame;
+
+/*Return the number of pages given back, aiming for __Target__*/
+typedef uint64_t (*PmmShrinkFn)(uint64_t __Target__);
+/*Wake the OOM killer; runs in the allocator, so it must not sleep or allocate*/
+typedef void (*PmmOomFn)(void);
+
+typedef struct
+{
+    const char* Name;
+    PmmShrinkFn Shrink;
+    uint64_t    Calls;
+    uint64_t    Freed;
+
+} PmmShrinker;
+
 typedef struct
 {
     uint64_t Base;
@@ -44,9 +107,18 @@ typedef struct
     uint64_t     TotalPages;
     uint64_t     LastAllocHint;
     uint64_t     HhdmOffset;
+    uint64_t     BootStackPhys; /*BSP stack at PMM init, kept through reclaim*/
+    PageFrame*   Frames;        /*One descriptor per frame below FrameCount*/
+    uint64_t     FrameCount;
+    uint64_t     LowWatermark; /*Shrinkers run when free pages drop below this*/
+    PmmShrinker  Shrinkers[MaxShrinkers];
+    uint32_t     ShrinkerCount;
+    volatile int Reclaiming;
+    PmmOomFn     OomHandler;
     MemoryRegion Regions[MaxMemoryRegions];
     uint32_t     RegionCount;
     PmmStats     Stats;
+    SpinLock     Lock; /*Bitmap, free counts and frame hand-out; never held across a shrink*/
 
 } PhysicalMemoryManager;
 
@@ -60,6 +132,16 @@ uint64_t AllocPage(void);
 void     FreePage(uint64_t __PhysAddr__);
 uint64_t AllocPages(size_t __Count__);
 void     FreePages(uint64_t __PhysAddr__, size_t __Count__);
+uint64_t PmmReclaimBootloaderMemory(void);
+
+PageFrame* PmmGetFrame(uint64_t __PhysAddr__);
+void       PmmSetFrameOwner(uint64_t __PhysAddr__, size_t __Count__, uint16_t __Owner__);
+uint32_t   PmmFrameRef(uint64_t __PhysAddr__);
+
+int      PmmRegisterShrinker(const char* __Name__, PmmShrinkFn __Fn__);
+int      PmmUnregisterShrinker(PmmShrinkFn __Fn__);
+void     PmmSetOomHandler(PmmOomFn __Fn__);
+uint64_t PmmShrink(uint64_t __Target__);
 
 void PmmDumpStats(void);                     //
 void PmmDumpRegions(void);                   //
@@ -72,6 +154,13 @@ void SetBitmapBit(uint64_t __PageIndex__);   //
 void ClearBitmapBit(uint64_t __PageIndex__); //
 int  TestBitmapBit(uint64_t __PageIndex__);  //
 
+void InitializePageFrames(void);              //
+void PmmFrameOnAlloc(uint64_t __PageIndex__); //
+int  PmmFrameRelease(uint64_t __PageIndex__); //
+
+void PmmCheckPressure(size_t __Count__);   //
+int  PmmReclaimForAlloc(size_t __Count__); //
+
 KEXPORT(InitializePmm);
 KEXPORT(AllocPage);
 KEXPORT(FreePage);
@@ -79,3 +168,9 @@ KEXPORT(AllocPages);
 KEXPORT(FreePages);
 KEXPORT(PhysToVirt);
 KEXPORT(VirtToPhys);
+KEXPORT(PmmGetFrame);
+KEXPORT(PmmSetFrameOwner);
+KEXPORT(PmmFrameRef);
+KEXPORT(PmmRegisterShrinker);
+KEXPORT(PmmUnregisterShrinker);
+KEXPORT(PmmShrink);
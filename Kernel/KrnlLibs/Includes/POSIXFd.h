@@ -23,7 +23,7 @@ typedef struct PosixFdTable
     long     StdinFd;
     long     StdoutFd;
     long     StderrFd;
-    SpinLock Lock;
+    Mutex    Lock; /*Recursive, and may be held across VFS calls that sleep*/
 } PosixFdTable;
 
 typedef struct Iovec
@@ -10,6 +10,9 @@ typedef struct PosixTimes
     uint64_t UserUsec;
     uint64_t SysUsec;
     uint64_t StartTick;
+    uint64_t Ns[AcctModes];      /*Per Acct* mode, refreshed by PosixRefreshTimes*/
+    uint64_t DeadNs[AcctModes];  /*Folded in from destroyed threads*/
+    uint64_t ChildNs[AcctModes]; /*Reaped children, including theirs*/
 } PosixTimes;
 
 typedef struct PosixRusage
@@ -67,7 +70,7 @@ typedef struct PosixProcTable
     PosixProc** Items;
     long        Count;
     long        Cap;
-    SpinLock    Lock;
+    RwLock      Lock; /*Insert, remove and the OOM scan; PosixFind walks under RCU*/
 } PosixProcTable;
 
 #ifndef WNOHANG
@@ -99,6 +102,7 @@ int        PosixFchdir(PosixProc* __Proc__, int __Fd__);
 int        PosixSetUmask(PosixProc* __Proc__, long __Mask__);
 int        PosixGetTty(PosixProc* __Proc__, char* __Out__, long __Len__);
 PosixProc* PosixFind(long __Pid__);
+void       PosixRefreshTimes(PosixProc* __Proc__);
 /*Global Helpers*/
 char __ProcStateCode__(PosixProc* __Proc__);
 
@@ -117,4 +121,5 @@ KEXPORT(PosixChdir)
 KEXPORT(PosixFchdir)
 KEXPORT(PosixSetUmask)
 KEXPORT(PosixGetTty)
-KEXPORT(PosixFind)
\ No newline at end of file
+KEXPORT(PosixFind)
+KEXPORT(PosixRefreshTimes)
\ No newline at end of file
@@ -42,6 +42,15 @@ long ProcFsWriteState(PosixProc* __Proc__, const char* __Buf__, long __Len__);
 long ProcFsWriteExec(PosixProc* __Proc__, const char* __Buf__, long __Len__);
 long ProcFsWriteSignal(PosixProc* __Proc__, const char* __Buf__, long __Len__);
 
+/*Kernel-wide files in the proc root*/
+long ProcFsMakeSlabInfo(char* __Buf__, long __Cap__);
+long ProcFsMakeKmallocSites(char* __Buf__, long __Cap__);
+long ProcFsMakeMemInfo(char* __Buf__, long __Cap__);
+long ProcFsMakeSchedGroups(char* __Buf__, long __Cap__);
+long ProcFsMakeSoftirqs(char* __Buf__, long __Cap__);
+long ProcFsMakeLockStat(char* __Buf__, long __Cap__);
+long ProcFsWriteLockStat(const char* __Buf__, long __Len__);
+
 int         ProcFsInit(void);
 Superblock* ProcFsMountImpl(const char* __Dev__, const char* __Opts__);
 int         ProcFsRegisterMount(const char* __MountPath__, Superblock* __Super__);
@@ -1,8 +1,10 @@
 #pragma once
 
 #include <IDT.h>
+#include <Topology.h>
 
-typedef struct
+/*One per CPU, each on its own lines since the timer tick writes it*/
+typedef struct __attribute__((aligned(64)))
 {
 
     GdtEntry         Gdt[MaxGdt]; /* GDT*/
@@ -14,5 +16,7 @@ typedef struct
     uint64_t         ApicBase;   /* APIC Base*/
     uint64_t         LocalTicks; /* Timer Data*/
     uint32_t         LocalInterrupts;
+    uint32_t         SoftYield; /* ThreadYield's int $0x20, not a timer tick*/
+    CpuTopology      Topo;       /* SMT, cache and NUMA placement*/
 
 } PerCpuData;
\ No newline at end of file
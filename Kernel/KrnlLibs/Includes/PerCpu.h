@@ -0,0 +1,54 @@
+#pragma once
+
+#include <AllTypes.h>
+#include <SMP.h>
+
+#define PerCpuLineSize 64 /*Each CPU's copy gets its own cache line*/
+
+/*
+ * Per-CPU variables: one padded copy per CPU, so a CPU updating its own
+ * never bounces a line with its neighbours. DeclarePerCpu goes in a header
+ * and DefinePerCpu in one source file; StaticPerCpu does both, file-local.
+ */
+#define DeclarePerCpu(__Type__, __Name__)                                                          \
+    struct PerCpuSlot_##__Name__                                                                   \
+    {                                                                                              \
+        __Type__ Value;                                                                            \
+    } __attribute__((aligned(PerCpuLineSize)));                                                    \
+    extern struct PerCpuSlot_##__Name__ __Name__[MaxCPUs]
+
+#define DefinePerCpu(__Name__) struct PerCpuSlot_##__Name__ __Name__[MaxCPUs]
+
+#define StaticPerCpu(__Type__, __Name__)                                                           \
+    static struct __attribute__((aligned(PerCpuLineSize)))                                         \
+    {                                                                                              \
+        __Type__ Value;                                                                            \
+    } __Name__[MaxCPUs]
+
+#define PerCpuPtr(__Name__, __CpuId__) (&(__Name__)[(__CpuId__)].Value)
+
+/*
+ * The this-CPU accessors do not pin the caller. A thread preempted and moved
+ * in between may touch the copy of the CPU it left; hold off preemption when
+ * that matters, ThisCpuAdd alone is always safe.
+ */
+#define ThisCpuPtr(__Name__)            PerCpuPtr(__Name__, GetCurrentCpuId())
+#define ThisCpuRead(__Name__)           (*ThisCpuPtr(__Name__))
+#define ThisCpuWrite(__Name__, __Val__) (*ThisCpuPtr(__Name__) = (__Val__))
+#define ThisCpuAdd(__Name__, __Val__)                                                              \
+    __atomic_fetch_add(ThisCpuPtr(__Name__), (__Val__), __ATOMIC_RELAXED)
+
+/*Statistic counter: adds touch only the local slot, reads sum every CPU's*/
+typedef struct
+{
+    struct __attribute__((aligned(PerCpuLineSize)))
+    {
+        volatile int64_t Value;
+    } Slots[MaxCPUs];
+
+} PerCpuCounter;
+
+void    PerCpuCounterAdd(PerCpuCounter* __Counter__, int64_t __Delta__);
+void    PerCpuCounterAddOn(PerCpuCounter* __Counter__, uint32_t __CpuId__, int64_t __Delta__);
+int64_t PerCpuCounterSum(PerCpuCounter* __Counter__);
+void    PerCpuCounterReset(PerCpuCounter* __Counter__);
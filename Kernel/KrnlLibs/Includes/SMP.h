@@ -23,6 +23,7 @@ typedef struct
     CpuStatus               Status;
     volatile uint32_t       Started;
     struct limine_smp_info* LimineInfo;
+    uint64_t                StackTop; /*Allocated by the BSP before the AP is released*/
 
 } CpuInfo;
 
@@ -41,4 +42,6 @@ extern volatile uint32_t CpuStartupCount;
 void     InitializeSmp(void);
 void     ApEntryPoint(struct limine_smp_info* __CpuInfo__);
 uint32_t GetCurrentCpuId(void);
-void     PerCpuInterruptInit(uint32_t __CpuId__, uint64_t __InterruptStack__);
\ No newline at end of file
+void     PerCpuInterruptInit(uint32_t __CpuId__, uint64_t __InterruptStack__);
+void     SmpApRendezvous(uint32_t __CpuNumber__);
+void     SmpReleaseAps(void);
\ No newline at end of file
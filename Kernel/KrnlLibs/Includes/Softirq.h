@@ -0,0 +1,56 @@
+#pragma once
+
+#include <AllTypes.h>
+#include <AxeThreads.h>
+#include <IDT.h>
+#include <KExports.h>
+
+#define SoftirqTimer   0 /*Sleeper wakeups and delayed work*/
+#define SoftirqBlock   1
+#define SoftirqNet     2
+#define SoftirqTasklet 3
+#define SoftirqRcu     4 /*Grace period progress and RCU callbacks*/
+#define SoftirqCount   8
+
+#define SoftirqMaxRestart 10      /*Passes over the pending mask per IRQ exit*/
+#define SoftirqBudgetNs   2000000 /*Time per IRQ exit before ksoftirqd takes over*/
+
+typedef void (*SoftirqHandler)(uint32_t __CpuId__);
+
+typedef struct
+{
+    SoftirqHandler Handler;
+    const char*    Name;
+
+} SoftirqVector;
+
+typedef struct __attribute__((aligned(64)))
+{
+    uint32_t Pending;            /*Raised vectors, set from hard IRQ context*/
+    uint32_t Active;             /*Handlers running on this CPU; no preemption meanwhile*/
+    Thread*  Daemon;             /*ksoftirqd*/
+    uint32_t DaemonParked;       /*Daemon is waiting to be woken*/
+    uint64_t Runs[SoftirqCount]; /*Handler invocations*/
+    uint64_t Deferred;           /*Exits that handed the rest to ksoftirqd*/
+    uint32_t BhDisabled;         /*LocalBhDisable depth; IRQ exits leave softirqs pending*/
+
+} SoftirqCpu;
+
+extern SoftirqCpu    Softirqs[MaxCPUs];
+extern SoftirqVector SoftirqVectors[SoftirqCount];
+
+void InitializeSoftirq(void);
+int  RegisterSoftirq(uint32_t __Nr__, SoftirqHandler __Handler__, const char* __Name__);
+void RaiseSoftirq(uint32_t __Nr__);
+void RaiseSoftirqOn(uint32_t __CpuId__, uint32_t __Nr__);
+void SoftirqIrqExit(InterruptFrame* __Frame__);
+int  SoftirqActive(uint32_t __CpuId__);
+void DumpSoftirqs(void);
+void LocalBhDisable(void);
+void LocalBhEnable(void);
+
+KEXPORT(RegisterSoftirq);
+KEXPORT(RaiseSoftirq);
+KEXPORT(RaiseSoftirqOn);
+KEXPORT(LocalBhDisable);
+KEXPORT(LocalBhEnable);
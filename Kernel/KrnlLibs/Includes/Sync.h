@@ -3,26 +3,169 @@
 #include <AllTypes.h>
 #include <KExports.h>
 
+/*Uncomment to time SpinLock and Mutex acquisitions per lock class (/proc/lock_stat)*/
+// #define SyncLockStat
+
+#define LockStatMaxClasses 256 /*Distinct lock names tracked*/
+#define LockClassNameLen   32  /*Copied, so a module's names may go away with it*/
+
+#define LockClassSpin  0
+#define LockClassMutex 1
+
+/*Every lock initialised with the same name and kind feeds one class*/
+typedef struct LockClass
+{
+    char        Name[LockClassNameLen];
+    uint32_t    Kind;
+    uint64_t    Acquisitions;
+    uint64_t    Contentions; /*Acquisitions that found it held*/
+    uint64_t    WaitTotal;   /*TSC cycles spent waiting*/
+    uint64_t    WaitMax;     /*Longest single wait*/
+    uint64_t    HoldTotal;   /*TSC cycles from acquisition to release*/
+    uint64_t    HoldMax;     /*Longest single hold*/
+
+} LockClass;
+
+#ifdef SyncLockStat
+extern LockClass LockClasses[LockStatMaxClasses];
+extern uint32_t  LockClassCount;
+extern uint64_t  LockStatUntracked; /*Locks left without a class because the table was full*/
+
+LockClass* LockStatClass(const char* __Name__, uint32_t __Kind__);
+void       LockStatAcquired(LockClass* __Class__, bool __Contended__, uint64_t __WaitCycles__);
+void       LockStatReleased(LockClass* __Class__, uint64_t __HoldCycles__);
+void       LockStatReset(void);
+#endif
+
+/*Ticket lock: CPUs are served in the order they took a ticket*/
 typedef struct
 {
-    volatile uint32_t Lock;
-    uint32_t          CpuId;
-    const char*       Name;
-    uint64_t          Flags;
+    union
+    {
+        volatile uint32_t Lock; /*Both halves at once, for trylock*/
+        struct
+        {
+            volatile uint16_t Owner; /*Ticket now holding the lock*/
+            volatile uint16_t Next;  /*Ticket the next acquirer draws*/
+        };
+    };
+    uint32_t    CpuId;
+    const char* Name;
+    uint64_t    Flags;       /*RFLAGS of the IRQ-saving acquisition that holds it*/
+    LockClass*  Class;       /*Statistics, only set under SyncLockStat*/
+    uint64_t    AcquiredTsc; /*When the holder got it, for the hold time*/
 
 } SpinLock;
 
+/*
+ * AcquireSpinLock disables interrupts and keeps the caller's RFLAGS in the
+ * lock; use it for anything an interrupt handler also takes. The Bh variant
+ * holds off softirqs and preemption for locks shared with softirq handlers.
+ * The Plain variant only holds off preemption, for thread context alone.
+ */
 void InitializeSpinLock(SpinLock* __Lock__, const char* __Name__);
 void AcquireSpinLock(SpinLock* __Lock__);
 void ReleaseSpinLock(SpinLock* __Lock__);
 bool TryAcquireSpinLock(SpinLock* __Lock__);
+void AcquireSpinLockBh(SpinLock* __Lock__);
+void ReleaseSpinLockBh(SpinLock* __Lock__);
+void AcquireSpinLockPlain(SpinLock* __Lock__);
+void ReleaseSpinLockPlain(SpinLock* __Lock__);
+
+/*One blocked thread; lives on its stack for the length of the wait*/
+typedef struct WaitQueueEntry
+{
+    struct Thread*         Thread;
+    struct WaitQueueEntry* Next;
+    uint32_t               Queued; /*Cleared by the waker that unlinks it*/
+
+} WaitQueueEntry;
+
+/*Threads asleep until a condition holds; wakers make it true first, then call WakeUp*/
+typedef struct
+{
+    WaitQueueEntry* volatile Head;
+    WaitQueueEntry*          Tail;
+    SpinLock                 Lock;
+    uint32_t                 Reason; /*WaitReason* of the threads blocked here*/
+
+} WaitQueue;
+
+/*Runs under the queue lock with interrupts off, and may claim what it tests for*/
+typedef bool (*WaitCondition)(void* __Arg__);
+
+/*
+ * WaitEvent returns once Cond has held. Callers that cannot sleep, with
+ * interrupts or preemption off, in a softirq or before threads run, spin on
+ * Cond instead. WakeUp is safe from interrupt context.
+ */
+void InitializeWaitQueue(WaitQueue* __Queue__, const char* __Name__);
+void WaitEvent(WaitQueue* __Queue__, WaitCondition __Cond__, void* __Arg__);
+int  WakeUp(WaitQueue* __Queue__);
+int  WakeUpAll(WaitQueue* __Queue__);
+
+#define McsMaxNesting 4 /*MCS locks one CPU may hold or wait on at once*/
+
+/*Queue entry; each waiter spins on its own line until its predecessor hands over*/
+typedef struct __attribute__((aligned(64))) McsNode
+{
+    struct McsNode* volatile Next;
+    volatile uint32_t        Locked;
+    uint64_t                 Flags; /*RFLAGS from before this acquisition*/
+
+} McsNode;
+
+/*Queued lock for hot paths, handoff costs one remote line instead of a broadcast*/
+typedef struct
+{
+    McsNode* volatile Tail;
+    McsNode*          Holder;
+    uint32_t          CpuId;
+    const char*       Name;
+
+} McsLock;
+
+void InitializeMcsLock(McsLock* __Lock__, const char* __Name__);
+void AcquireMcsLock(McsLock* __Lock__);
+void ReleaseMcsLock(McsLock* __Lock__);
+bool TryAcquireMcsLock(McsLock* __Lock__);
+
+#define RwLockWriterLocked  0x0FFU /*Low byte while a writer holds the lock*/
+#define RwLockWriterWaiting 0x100U /*Queued writer is next, new readers wait behind it*/
+#define RwLockWriterMask    0x1FFU
+#define RwLockReaderBias    0x200U /*Each reader inside adds one*/
+
+/*Queued reader-writer spinlock: readers share it, contended acquirers line up on Wait*/
+typedef struct
+{
+    volatile uint32_t Count; /*Readers times RwLockReaderBias, plus the writer bits*/
+    SpinLock          Wait;
+    const char*       Name;
+
+} RwLock;
+
+/*Holders run with preemption off; not for data an interrupt handler touches*/
+void InitializeRwLock(RwLock* __Lock__, const char* __Name__);
+void AcquireRwLockRead(RwLock* __Lock__);
+void ReleaseRwLockRead(RwLock* __Lock__);
+void AcquireRwLockWrite(RwLock* __Lock__);
+void ReleaseRwLockWrite(RwLock* __Lock__);
+
+#define MutexUnlocked  0
+#define MutexLocked    1
+#define MutexContended 2    /*Held, and a waiter may be asleep on Waiters*/
+#define MutexSpinLimit 2048 /*Pauses spent on a running owner before going to sleep*/
 
+/*Adaptive and recursive: waiters spin while the owner is on a CPU, then sleep*/
 typedef struct
 {
-    volatile uint32_t Lock;
-    uint32_t          Owner;
+    volatile uint32_t Lock; /*MutexUnlocked, MutexLocked or MutexContended*/
     uint32_t          RecursionCount;
+    uintptr_t         Owner; /*Holding thread, or CPU number + 1 before threads run*/
     const char*       Name;
+    WaitQueue         Waiters;
+    LockClass*        Class;       /*Statistics, only set under SyncLockStat*/
+    uint64_t          AcquiredTsc; /*When the holder got it, for the hold time*/
 } Mutex;
 
 void InitializeMutex(Mutex* __Mutex__, const char* __Name__);
@@ -30,12 +173,12 @@ void AcquireMutex(Mutex* __Mutex__);
 void ReleaseMutex(Mutex* __Mutex__);
 bool TryAcquireMutex(Mutex* __Mutex__);
 
+/*Counting semaphore; Acquire sleeps while Count is zero*/
 typedef struct
 {
-    volatile int32_t  Count;
-    volatile uint32_t WaitQueue;
-    SpinLock          QueueLock;
-    const char*       Name;
+    volatile int32_t Count;
+    WaitQueue        Waiters;
+    const char*      Name;
 } Semaphore;
 
 void InitializeSemaphore(Semaphore* __Semaphore__, int32_t __InitialCount__, const char* __Name__);
@@ -43,12 +186,108 @@ void AcquireSemaphore(Semaphore* __Semaphore__);
 void ReleaseSemaphore(Semaphore* __Semaphore__);
 bool TryAcquireSemaphore(Semaphore* __Semaphore__);
 
+#define RwSemaphoreWriter (-1) /*Count while a writer holds it*/
+
+/*Reader-writer semaphore for long holds; waiters sleep instead of spinning*/
+typedef struct
+{
+    volatile int32_t  Count;   /*Readers inside, or RwSemaphoreWriter*/
+    volatile uint32_t Writers; /*Writers waiting; new readers hold back for them*/
+    WaitQueue         Waiters;
+    const char*       Name;
+
+} RwSemaphore;
+
+/*Not recursive: a reader that reads again can deadlock behind a waiting writer*/
+void InitializeRwSemaphore(RwSemaphore* __Sem__, const char* __Name__);
+void AcquireRwSemaphoreRead(RwSemaphore* __Sem__);
+void ReleaseRwSemaphoreRead(RwSemaphore* __Sem__);
+void AcquireRwSemaphoreWrite(RwSemaphore* __Sem__);
+void ReleaseRwSemaphoreWrite(RwSemaphore* __Sem__);
+
+/*Sequence lock for small read-mostly data; readers never write shared memory*/
+typedef struct
+{
+    volatile uint32_t Sequence; /*Odd while a writer is inside*/
+    SpinLock          Lock;     /*Serialises writers, interrupts off*/
+
+} SeqLock;
+
+void InitializeSeqLock(SeqLock* __Seq__, const char* __Name__);
+void AcquireSeqLockWrite(SeqLock* __Seq__);
+void ReleaseSeqLockWrite(SeqLock* __Seq__);
+
+/*Snapshot the data between Begin and Retry; go again while Retry says so*/
+static inline uint32_t
+ReadSeqLockBegin(const SeqLock* __Seq__)
+{
+    uint32_t Sequence;
+    while ((Sequence = __atomic_load_n(&__Seq__->Sequence, __ATOMIC_ACQUIRE)) & 1)
+    {
+        __asm__ volatile("pause");
+    }
+    return Sequence;
+}
+
+static inline bool
+ReadSeqLockRetry(const SeqLock* __Seq__, uint32_t __Start__)
+{
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    return __atomic_load_n(&__Seq__->Sequence, __ATOMIC_RELAXED) != __Start__;
+}
+
+/*Deferred free for RCU; embed it in the object and recover the object in Func*/
+typedef struct RcuHead
+{
+    struct RcuHead* Next;
+    void (*Func)(struct RcuHead* __Head__);
+    uint64_t Gp; /*Grace period that must end before Func runs*/
+
+} RcuHead;
+
+/*Publish with the release store, read with the acquire load, inside RcuReadLock*/
+#define RcuAssignPointer(__Ptr__, __Val__) __atomic_store_n(&(__Ptr__), (__Val__), __ATOMIC_RELEASE)
+#define RcuDereference(__Ptr__)            __atomic_load_n(&(__Ptr__), __ATOMIC_ACQUIRE)
+
+/*
+ * Readers only hold off preemption and may nest. Writers serialise among
+ * themselves, unpublish, then free through CallRcu, or after SynchronizeRcu
+ * from a thread that may sleep.
+ */
+void InitializeRcu(void);
+void RcuReadLock(void);
+void RcuReadUnlock(void);
+void CallRcu(RcuHead* __Head__, void (*__Func__)(RcuHead* __Head__));
+int  SynchronizeRcu(void);
+void RcuQuiescentState(uint32_t __CpuId__);
+void RcuTick(uint32_t __CpuId__);
+
 extern SpinLock ConsoleLock;
 
 KEXPORT(InitializeSpinLock);
 KEXPORT(AcquireSpinLock);
 KEXPORT(ReleaseSpinLock);
 KEXPORT(TryAcquireSpinLock);
+KEXPORT(AcquireSpinLockBh);
+KEXPORT(ReleaseSpinLockBh);
+KEXPORT(AcquireSpinLockPlain);
+KEXPORT(ReleaseSpinLockPlain);
+
+KEXPORT(InitializeMcsLock);
+KEXPORT(AcquireMcsLock);
+KEXPORT(ReleaseMcsLock);
+KEXPORT(TryAcquireMcsLock);
+
+KEXPORT(InitializeRwLock);
+KEXPORT(AcquireRwLockRead);
+KEXPORT(ReleaseRwLockRead);
+KEXPORT(AcquireRwLockWrite);
+KEXPORT(ReleaseRwLockWrite);
+
+KEXPORT(InitializeWaitQueue);
+KEXPORT(WaitEvent);
+KEXPORT(WakeUp);
+KEXPORT(WakeUpAll);
 
 KEXPORT(InitializeMutex);
 KEXPORT(AcquireMutex);
@@ -59,3 +298,18 @@ KEXPORT(InitializeSemaphore);
 KEXPORT(AcquireSemaphore);
 KEXPORT(ReleaseSemaphore);
 KEXPORT(TryAcquireSemaphore);
+
+KEXPORT(InitializeRwSemaphore);
+KEXPORT(AcquireRwSemaphoreRead);
+KEXPORT(ReleaseRwSemaphoreRead);
+KEXPORT(AcquireRwSemaphoreWrite);
+KEXPORT(ReleaseRwSemaphoreWrite);
+
+KEXPORT(InitializeSeqLock);
+KEXPORT(AcquireSeqLockWrite);
+KEXPORT(ReleaseSeqLockWrite);
+
+KEXPORT(RcuReadLock);
+KEXPORT(RcuReadUnlock);
+KEXPORT(CallRcu);
+KEXPORT(SynchronizeRcu);
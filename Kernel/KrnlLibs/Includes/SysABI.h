@@ -208,5 +208,8 @@ enum SysNo
     SysClockSettime        = 227,
     SysClockGettime        = 228,
     SysClockGetres         = 229,
-    SysClockNanosleep      = 230
+    SysClockNanosleep      = 230,
+
+    /*AxeialOS private*/
+    SysSchedGroup = 1000
 };
@@ -116,6 +116,54 @@ int64_t __Handle__SchedYield(uint64_t __U1__,
                              uint64_t __U4__,
                              uint64_t __U5__,
                              uint64_t __U6__);
+int64_t __Handle__SchedSetparam(uint64_t __Pid__,
+                                uint64_t __ParamPtr__,
+                                uint64_t __U3__,
+                                uint64_t __U4__,
+                                uint64_t __U5__,
+                                uint64_t __U6__);
+int64_t __Handle__SchedGetparam(uint64_t __Pid__,
+                                uint64_t __ParamPtr__,
+                                uint64_t __U3__,
+                                uint64_t __U4__,
+                                uint64_t __U5__,
+                                uint64_t __U6__);
+int64_t __Handle__SchedSetscheduler(uint64_t __Pid__,
+                                    uint64_t __Policy__,
+                                    uint64_t __ParamPtr__,
+                                    uint64_t __U4__,
+                                    uint64_t __U5__,
+                                    uint64_t __U6__);
+int64_t __Handle__SchedGetscheduler(uint64_t __Pid__,
+                                    uint64_t __U2__,
+                                    uint64_t __U3__,
+                                    uint64_t __U4__,
+                                    uint64_t __U5__,
+                                    uint64_t __U6__);
+int64_t __Handle__SchedGetPriorityMax(uint64_t __Policy__,
+                                      uint64_t __U2__,
+                                      uint64_t __U3__,
+                                      uint64_t __U4__,
+                                      uint64_t __U5__,
+                                      uint64_t __U6__);
+int64_t __Handle__SchedGetPriorityMin(uint64_t __Policy__,
+                                      uint64_t __U2__,
+                                      uint64_t __U3__,
+                                      uint64_t __U4__,
+                                      uint64_t __U5__,
+                                      uint64_t __U6__);
+int64_t __Handle__SchedRrGetInterval(uint64_t __Pid__,
+                                     uint64_t __TsPtr__,
+                                     uint64_t __U3__,
+                                     uint64_t __U4__,
+                                     uint64_t __U5__,
+                                     uint64_t __U6__);
+int64_t __Handle__SchedGroup(uint64_t __Op__,
+                             uint64_t __A1__,
+                             uint64_t __A2__,
+                             uint64_t __A3__,
+                             uint64_t __U5__,
+                             uint64_t __U6__);
 int64_t __Handle__Nanosleep(uint64_t __ReqPtr__,
                             uint64_t __RemPtr__,
                             uint64_t __U3__,
@@ -200,12 +248,24 @@ int64_t __Handle__Times(uint64_t __TmsPtr__,
                         uint64_t __U4__,
                         uint64_t __U5__,
                         uint64_t __U6__);
+int64_t __Handle__Getrusage(uint64_t __Who__,
+                            uint64_t __RusagePtr__,
+                            uint64_t __U3__,
+                            uint64_t __U4__,
+                            uint64_t __U5__,
+                            uint64_t __U6__);
 int64_t __Handle__ClockGettime(uint64_t __ClkId__,
                                uint64_t __Tp__,
                                uint64_t __U3__,
                                uint64_t __U4__,
                                uint64_t __U5__,
                                uint64_t __U6__);
+int64_t __Handle__ClockGetres(uint64_t __ClkId__,
+                              uint64_t __Res__,
+                              uint64_t __U3__,
+                              uint64_t __U4__,
+                              uint64_t __U5__,
+                              uint64_t __U6__);
 int64_t __Handle__Mmap(uint64_t __Addr__,
                        uint64_t __Len__,
                        uint64_t __Prot__,
@@ -3,6 +3,7 @@
 #include <AllTypes.h>
 #include <IDT.h>
 #include <KrnPrintf.h>
+#include <Sync.h>
 
 typedef enum
 {
@@ -16,6 +17,21 @@ typedef enum
 
 #define TimerTargetFrequency 1000
 #define TimerVector          32
+#define TimekeeperNone       0xFFFFFFFF
+#define TimekeeperStallTicks 4 /*Missed ticks before another CPU takes over timekeeping*/
+
+#define ClockSourceTick 0 /*SystemTicks, filled in between ticks from the TSC*/
+#define ClockSourceTsc  1 /*Invariant, calibrated TSC, read directly*/
+
+/*clock_gettime clock ids*/
+#define ClockRealtime        0
+#define ClockMonotonic       1
+#define ClockProcessCputime  2
+#define ClockThreadCputime   3
+#define ClockMonotonicRaw    4
+#define ClockRealtimeCoarse  5
+#define ClockMonotonicCoarse 6
+#define ClockBoottime        7
 
 typedef struct
 {
@@ -24,16 +40,28 @@ typedef struct
     uint64_t  HpetBase;
     uint32_t  TimerFrequency;
     uint64_t  SystemTicks;
+    uint64_t  TickTsc;       /*TSC when SystemTicks last moved*/
+    SeqLock   Clock;         /*Covers SystemTicks, TickTsc and the clock fields below*/
+    uint32_t  TimekeeperCpu; /*The one CPU whose tick moves SystemTicks*/
+    uint32_t  ClockSource;   /*ClockSourceTick or ClockSourceTsc*/
+    uint64_t  CycleBase;     /*TSC reading at BaseNs*/
+    uint64_t  BaseNs;        /*Monotonic time at CycleBase*/
+    uint32_t  ClockMult;     /*ns = (cycles * ClockMult) >> ClockShift*/
+    uint32_t  ClockShift;
+    int64_t   RealtimeOffset; /*CLOCK_REALTIME minus CLOCK_MONOTONIC, in ns*/
     uint32_t  TimerInitialized;
 
 } TimerManager;
 
-extern TimerManager      Timer;
-extern volatile uint32_t TimerInterruptCount;
+extern TimerManager Timer;
 
 void     InitializeTimer(void);
 void     TimerHandler(InterruptFrame* __Frame__);
 uint64_t GetSystemTicks(void);
+uint64_t GetSystemTimeNs(void);
+uint64_t GetRealtimeNs(void);
+uint64_t GetClockResolutionNs(void);
+uint64_t ReadRtcSeconds(void);
 void     Sleep(uint32_t __Milliseconds__);
 uint32_t GetTimerInterruptCount(void);
 
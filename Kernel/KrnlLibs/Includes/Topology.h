@@ -0,0 +1,36 @@
+#pragma once
+
+#include <AllTypes.h>
+#include <KExports.h>
+
+#define TopoMaxSiblings 8 /*SMT threads per core we keep track of*/
+#define TopoNoNode      0xFFFFFFFF
+#define TopoLlcMigrate  1 /*Imbalance that justifies a move inside the LLC*/
+#define TopoFarMigrate  2 /*Imbalance that justifies leaving the LLC*/
+
+/*Domain ids are APIC ids with the lower levels shifted out, unique system-wide*/
+typedef struct
+{
+    uint32_t ApicId;                    /*x2APIC id when leaf 0xB/0x1F exists*/
+    uint32_t SmtId;                     /*Thread within the core*/
+    uint32_t CoreId;                    /*Shared by SMT siblings*/
+    uint32_t L2Id;                      /*Shared by CPUs on one L2*/
+    uint32_t LlcId;                     /*Shared by CPUs on the last level cache*/
+    uint32_t PackageId;
+    uint32_t NumaNode;                  /*SRAT proximity domain, TopoNoNode without one*/
+    uint32_t Siblings[TopoMaxSiblings]; /*Other CPU numbers on this core*/
+    uint32_t SiblingCount;
+    uint32_t Valid;
+
+} CpuTopology;
+
+void     DetectCpuTopology(uint32_t __CpuId__);
+void     BuildCpuTopology(void);
+int      CpusShareCore(uint32_t __CpuA__, uint32_t __CpuB__);
+int      CpusShareLlc(uint32_t __CpuA__, uint32_t __CpuB__);
+uint32_t GetCpuNumaNode(uint32_t __CpuId__);
+void     DumpCpuTopology(void);
+
+KEXPORT(CpusShareCore);
+KEXPORT(CpusShareLlc);
+KEXPORT(GetCpuNumaNode);
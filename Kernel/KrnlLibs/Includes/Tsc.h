@@ -0,0 +1,37 @@
+#pragma once
+
+#include <AllTypes.h>
+#include <KrnPrintf.h>
+
+#define TscPitHz              1193182
+#define TscCalibrateMs        100           /*Per run, on the free-running PIT*/
+#define TscCalibrateRuns      3             /*The median wins, so one SMI cannot skew it*/
+#define TscCalibrateSpreadPpm 200           /*Runs further apart leave the TSC untrusted*/
+#define TscPitReadTries       8             /*Reads per sample, the tightest bracket wins*/
+#define TscFallbackFreqHz     1000000000ULL /*Used when calibration fails, 1 cycle = 1 ns*/
+
+typedef struct
+{
+    uint64_t Frequency;  /*Cycles per second*/
+    uint64_t NsMult;     /*ns = (cycles * NsMult) >> 32*/
+    uint32_t Calibrated; /*0 on the fallback frequency or when the PIT runs disagreed*/
+    uint32_t Invariant;  /*Constant rate through P-, C- and T-states, CPUID 0x80000007 EDX[8]*/
+    uint32_t Mult;       /*ns = (cycles * Mult) >> Shift, with Mult held to 32 bits*/
+    uint32_t Shift;
+
+} TscManager;
+
+extern TscManager Tsc;
+
+static inline uint64_t
+ReadTsc(void)
+{
+    uint32_t Lo, Hi;
+    __asm__ volatile("rdtsc" : "=a"(Lo), "=d"(Hi));
+    return ((uint64_t)Hi << 32) | Lo;
+}
+
+void     InitializeTsc(void);
+uint64_t TscToNs(uint64_t __Cycles__);
+
+KEXPORT(TscToNs);
@@ -49,6 +49,7 @@ int                 MapPage(VirtualMemorySpace* __Space__,
 int                 UnmapPage(VirtualMemorySpace* __Space__, uint64_t __VirtAddr__);
 uint64_t            GetPhysicalAddress(VirtualMemorySpace* __Space__, uint64_t __VirtAddr__);
 void                SwitchVirtualSpace(VirtualMemorySpace* __Space__);
+uint64_t            VmmCountUserPages(VirtualMemorySpace* __Space__);
 
 uint64_t* GetPageTable(uint64_t* __Pml4__, uint64_t __VirtAddr__, int __Level__, int __Create__);
 void      FlushTlb(uint64_t __VirtAddr__);
@@ -0,0 +1,87 @@
+#pragma once
+
+#include <AllTypes.h>
+#include <AxeThreads.h>
+#include <KExports.h>
+#include <Sync.h>
+
+#define WorkMaxWorkers       2 /*Worker threads per CPU, the concurrency bound*/
+#define WorkDefaultMaxActive 16
+
+#define WorkPending  (1 << 0) /*On a pool list or the queue's inactive list*/
+#define WorkDelayed  (1 << 1) /*On the pool's delayed list*/
+#define WorkInactive (1 << 2) /*Held back behind MaxActive*/
+
+struct WorkItem;
+struct WorkQueue;
+
+typedef void (*WorkFunc)(struct WorkItem* __Work__);
+
+/*Embedded by the user; queueing never allocates*/
+typedef struct WorkItem
+{
+    struct WorkItem*  Next;
+    WorkFunc          Func;
+    struct WorkQueue* Queue;
+    uint32_t          Flags;
+    uint32_t          Cpu;      /*Pool it is queued on*/
+    uint64_t          Deadline; /*Tick a delayed item becomes pending*/
+
+} WorkItem;
+
+typedef struct WorkQueue
+{
+    const char* Name;
+    uint32_t    MaxActive; /*Items of this queue running at once, all CPUs*/
+    uint32_t    Active;
+    uint32_t    InFlight;  /*Queued, delayed or running; flush waits for zero*/
+    WorkItem*   Inactive;  /*Over MaxActive, released as items finish*/
+    SpinLock    Lock;
+
+} WorkQueue;
+
+typedef struct __attribute__((aligned(64)))
+{
+    WorkItem* Head;
+    WorkItem* Tail;
+    WorkItem* Delayed;                 /*Sorted by Deadline*/
+    uint64_t  NextDeadline;            /*Deadline of the first delayed item, 0 when none*/
+    Thread*   Workers[WorkMaxWorkers]; /*Bound to this CPU*/
+    uint32_t  Parked[WorkMaxWorkers];  /*Set while that worker waits for work*/
+    WorkItem* Running[WorkMaxWorkers]; /*Item each worker is executing, compared only*/
+    uint64_t  Executed;
+    SpinLock  Lock;
+
+} WorkPool;
+
+extern WorkQueue* SystemWq;
+
+void       InitializeWorkQueues(void);
+WorkQueue* CreateWorkQueue(const char* __Name__, uint32_t __MaxActive__);
+void       DestroyWorkQueue(WorkQueue* __Queue__);
+void       InitWork(WorkItem* __Work__, WorkFunc __Func__);
+int        QueueWork(WorkItem* __Work__);
+int        QueueWorkOn(uint32_t __CpuId__, WorkQueue* __Queue__, WorkItem* __Work__);
+int        QueueDelayedWork(WorkItem* __Work__, uint64_t __DelayMs__);
+int        QueueDelayedWorkOn(uint32_t   __CpuId__,
+                              WorkQueue* __Queue__,
+                              WorkItem*  __Work__,
+                              uint64_t   __DelayMs__);
+int        CancelWork(WorkItem* __Work__);
+int        CancelWorkSync(WorkItem* __Work__);
+void       FlushWork(WorkItem* __Work__);
+void       FlushWorkQueue(WorkQueue* __Queue__);
+void       WorkQueueTick(uint32_t __CpuId__);
+void       DumpWorkQueues(void);
+
+KEXPORT(CreateWorkQueue);
+KEXPORT(DestroyWorkQueue);
+KEXPORT(InitWork);
+KEXPORT(QueueWork);
+KEXPORT(QueueWorkOn);
+KEXPORT(QueueDelayedWork);
+KEXPORT(QueueDelayedWorkOn);
+KEXPORT(CancelWork);
+KEXPORT(CancelWorkSync);
+KEXPORT(FlushWork);
+KEXPORT(FlushWorkQueue);
@@ -0,0 +1,192 @@
+#include <LockFree.h>
+
+static int
+__IsPowerOfTwo__(uint32_t __Size__)
+{
+    return __Size__ && !(__Size__ & (__Size__ - 1));
+}
+
+int
+InitializeSpscRing(SpscRing* __Ring__, void** __Slots__, uint32_t __Size__)
+{
+    if (!__Ring__ || !__Slots__ || !__IsPowerOfTwo__(__Size__))
+    {
+        return -1;
+    }
+
+    __Ring__->Head  = 0;
+    __Ring__->Tail  = 0;
+    __Ring__->Mask  = __Size__ - 1;
+    __Ring__->Slots = __Slots__;
+    return 0;
+}
+
+int
+SpscRingPush(SpscRing* __Ring__, void* __Item__)
+{
+    uint32_t Tail = __atomic_load_n(&__Ring__->Tail, __ATOMIC_RELAXED);
+    uint32_t Head = __atomic_load_n(&__Ring__->Head, __ATOMIC_ACQUIRE);
+
+    /* Free-running indices; the difference is the fill level even across wraparound */
+    if (Tail - Head > __Ring__->Mask)
+    {
+        return -1;
+    }
+
+    __Ring__->Slots[Tail & __Ring__->Mask] = __Item__;
+    __atomic_store_n(&__Ring__->Tail, Tail + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+int
+SpscRingPop(SpscRing* __Ring__, void** __Item__)
+{
+    uint32_t Head = __atomic_load_n(&__Ring__->Head, __ATOMIC_RELAXED);
+    uint32_t Tail = __atomic_load_n(&__Ring__->Tail, __ATOMIC_ACQUIRE);
+
+    if (Head == Tail)
+    {
+        return -1;
+    }
+
+    *__Item__ = __Ring__->Slots[Head & __Ring__->Mask];
+    __atomic_store_n(&__Ring__->Head, Head + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+int
+InitializeMpscRing(MpscRing* __Ring__, MpscSlot* __Slots__, uint32_t __Size__)
+{
+    if (!__Ring__ || !__Slots__ || !__IsPowerOfTwo__(__Size__))
+    {
+        return -1;
+    }
+
+    /* Slot I is free for the producer that claims position I */
+    for (uint32_t Index = 0; Index < __Size__; Index++)
+    {
+        __Slots__[Index].Seq  = Index;
+        __Slots__[Index].Item = NULL;
+    }
+
+    __Ring__->Head  = 0;
+    __Ring__->Tail  = 0;
+    __Ring__->Mask  = __Size__ - 1;
+    __Ring__->Slots = __Slots__;
+    return 0;
+}
+
+int
+MpscRingPush(MpscRing* __Ring__, void* __Item__)
+{
+    uint64_t  Pos = __atomic_load_n(&__Ring__->Tail, __ATOMIC_RELAXED);
+    MpscSlot* Slot;
+
+    while (1)
+    {
+        Slot         = &__Ring__->Slots[Pos & __Ring__->Mask];
+        uint64_t Seq = __atomic_load_n(&Slot->Seq, __ATOMIC_ACQUIRE);
+        int64_t  Dif = (int64_t)(Seq - Pos);
+
+        if (Dif == 0)
+        {
+            /* Free for this position; claim it against the other producers */
+            if (__atomic_compare_exchange_n(
+                    &__Ring__->Tail, &Pos, Pos + 1, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            {
+                break;
+            }
+        }
+        else if (Dif < 0)
+        {
+            /* The consumer has not got to the item from one lap ago */
+            return -1;
+        }
+        else
+        {
+            /* Another producer got here first */
+            Pos = __atomic_load_n(&__Ring__->Tail, __ATOMIC_RELAXED);
+        }
+    }
+
+    Slot->Item = __Item__;
+    __atomic_store_n(&Slot->Seq, Pos + 1, __ATOMIC_RELEASE);
+    return 0;
+}
+
+int
+MpscRingPop(MpscRing* __Ring__, void** __Item__)
+{
+    uint64_t  Pos  = __Ring__->Head;
+    MpscSlot* Slot = &__Ring__->Slots[Pos & __Ring__->Mask];
+
+    /* Empty, or the producer that claimed it is still writing the item */
+    if (__atomic_load_n(&Slot->Seq, __ATOMIC_ACQUIRE) != Pos + 1)
+    {
+        return -1;
+    }
+
+    *__Item__ = Slot->Item;
+
+    /* Hand the slot to the producer one lap ahead */
+    __atomic_store_n(&Slot->Seq, Pos + __Ring__->Mask + 1, __ATOMIC_RELEASE);
+    __Ring__->Head = Pos + 1;
+    return 0;
+}
+
+/*Swap Top and Tag together; on failure the expected pair is reloaded with what is there*/
+static bool
+__LfStackCas__(LfStack*      __Stack__,
+               LfStackNode** __Top__,
+               uint64_t*     __Tag__,
+               LfStackNode*  __NewTop__,
+               uint64_t      __NewTag__)
+{
+    bool Swapped;
+    __asm__ volatile("lock cmpxchg16b %1"
+                     : "=@ccz"(Swapped), "+m"(*__Stack__), "+a"(*__Top__), "+d"(*__Tag__)
+                     : "b"(__NewTop__), "c"(__NewTag__)
+                     : "memory");
+    return Swapped;
+}
+
+void
+InitializeLfStack(LfStack* __Stack__)
+{
+    __Stack__->Top = NULL;
+    __Stack__->Tag = 0;
+}
+
+void
+LfStackPush(LfStack* __Stack__, LfStackNode* __Node__)
+{
+    uint64_t     Tag = __atomic_load_n(&__Stack__->Tag, __ATOMIC_RELAXED);
+    LfStackNode* Top = __atomic_load_n(&__Stack__->Top, __ATOMIC_RELAXED);
+
+    do
+    {
+        __Node__->Next = Top;
+    } while (!__LfStackCas__(__Stack__, &Top, &Tag, __Node__, Tag));
+}
+
+int
+LfStackPop(LfStack* __Stack__, LfStackNode** __Node__)
+{
+    /* A torn read of the pair only costs a failed CAS, which reloads both halves */
+    uint64_t     Tag = __atomic_load_n(&__Stack__->Tag, __ATOMIC_ACQUIRE);
+    LfStackNode* Top = __atomic_load_n(&__Stack__->Top, __ATOMIC_ACQUIRE);
+
+    while (Top)
+    {
+        /* Top may be popped by someone else meanwhile; the bumped Tag catches that */
+        LfStackNode* Next = Top->Next;
+        if (__LfStackCas__(__Stack__, &Top, &Tag, Next, Tag + 1))
+        {
+            Top->Next = NULL;
+            *__Node__ = Top;
+            return 0;
+        }
+    }
+
+    return -1;
+}
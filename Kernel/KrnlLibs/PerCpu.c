@@ -0,0 +1,46 @@
+#include <PerCpu.h>
+
+/*Add to this CPU's slot; atomic, so a caller moved to another CPU still counts right*/
+void
+PerCpuCounterAdd(PerCpuCounter* __Counter__, int64_t __Delta__)
+{
+    PerCpuCounterAddOn(__Counter__, GetCurrentCpuId(), __Delta__);
+}
+
+/*For callers that already know their CPU, such as the timer and the scheduler*/
+void
+PerCpuCounterAddOn(PerCpuCounter* __Counter__, uint32_t __CpuId__, int64_t __Delta__)
+{
+    if (__CpuId__ >= MaxCPUs)
+    {
+        return;
+    }
+
+    __atomic_fetch_add(&__Counter__->Slots[__CpuId__].Value, __Delta__, __ATOMIC_RELAXED);
+}
+
+/*
+ * Not a snapshot: adds racing with the walk may or may not be in the total.
+ * Walks every slot, since early on GetCurrentCpuId can hand out raw APIC IDs.
+ */
+int64_t
+PerCpuCounterSum(PerCpuCounter* __Counter__)
+{
+    int64_t Sum = 0;
+
+    for (uint32_t CpuIndex = 0; CpuIndex < MaxCPUs; CpuIndex++)
+    {
+        Sum += __atomic_load_n(&__Counter__->Slots[CpuIndex].Value, __ATOMIC_RELAXED);
+    }
+
+    return Sum;
+}
+
+void
+PerCpuCounterReset(PerCpuCounter* __Counter__)
+{
+    for (uint32_t CpuIndex = 0; CpuIndex < MaxCPUs; CpuIndex++)
+    {
+        __atomic_store_n(&__Counter__->Slots[CpuIndex].Value, 0, __ATOMIC_RELAXED);
+    }
+}
@@ -28,17 +28,55 @@ __builtin_memcpy(void* __Dest__, const void* __Src__, size_t __Size__)
     return __Dest__;
 }
 
+/*ERMS (Enhanced REP MOVSB/STOSB) probe, cached after the first call*/
+static int
+__HasErms__(void)
+{
+    static int Erms = -1;
+
+    if (Erms < 0)
+    {
+        uint32_t Eax = 0, Ebx = 0, Ecx = 0, Edx = 0;
+        __asm__ volatile("cpuid" : "+a"(Eax), "=b"(Ebx), "+c"(Ecx), "=d"(Edx));
+
+        /* Past the last basic leaf CPUID returns some other leaf's data */
+        if (Eax < 7)
+        {
+            Erms = 0;
+            return Erms;
+        }
+
+        Eax = 7;
+        Ecx = 0;
+        __asm__ volatile("cpuid" : "+a"(Eax), "=b"(Ebx), "+c"(Ecx), "=d"(Edx));
+        Erms = (Ebx >> 9) & 1; /*CPUID.(EAX=7,ECX=0):EBX[9]*/
+    }
+
+    return Erms;
+}
+
 /*Memset*/
 void*
 memset(void* __Dest__, int __Value__, size_t __Index__)
 {
-    unsigned char* ptr = (unsigned char*)__Dest__;
+    unsigned char* ptr  = (unsigned char*)__Dest__;
+    uint64_t       Fill = (uint8_t)__Value__ * 0x0101010101010101ULL;
 
-    while (__Index__--)
+    /*ERMS cores make rep stosb the fastest fill for any length*/
+    /*The entry stubs clear DF; cld again so a missed path cannot fill backwards*/
+    if (__HasErms__())
     {
-        *ptr++ = (unsigned char)__Value__;
+        __asm__ volatile("cld; rep stosb" : "+D"(ptr), "+c"(__Index__) : "a"(Fill) : "memory");
+        return __Dest__;
     }
 
+    /*Otherwise store qwords, then finish the tail bytewise*/
+    size_t Quads = __Index__ >> 3;
+    size_t Tail  = __Index__ & 7;
+
+    __asm__ volatile("cld; rep stosq" : "+D"(ptr), "+c"(Quads) : "a"(Fill) : "memory");
+    __asm__ volatile("rep stosb" : "+D"(ptr), "+c"(Tail) : "a"(Fill) : "memory");
+
     return __Dest__;
 }
 
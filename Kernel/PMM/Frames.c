@@ -0,0 +1,201 @@
+#include <PMM.h>
+#include <String.h>
+
+void
+InitializePageFrames(void)
+{
+    /*Only frames up to the end of the last RAM region can ever be handed out*/
+    uint64_t HighestRam = 0;
+    for (uint32_t Index = 0; Index < Pmm.RegionCount; Index++)
+    {
+        uint32_t Type = Pmm.Regions[Index].Type;
+        if (Type == MemoryTypeUsable || Type == MemoryTypeKernel || Type == MemoryTypeReclaim)
+        {
+            uint64_t End = Pmm.Regions[Index].Base + Pmm.Regions[Index].Length;
+            if (End > HighestRam)
+            {
+                HighestRam = End;
+            }
+        }
+    }
+
+    uint64_t FrameCount = HighestRam / PageSize;
+    if (FrameCount > Pmm.TotalPages)
+    {
+        FrameCount = Pmm.TotalPages;
+    }
+
+    /*Frames is still NULL here, so this allocation is not accounted per owner*/
+    uint64_t Pages = (FrameCount * sizeof(PageFrame) + PageSize - 1) / PageSize;
+    uint64_t Phys  = AllocPages(Pages);
+    if (!Phys)
+    {
+        PWarn("PMM: No memory for %lu page frame descriptors\n", FrameCount);
+        return;
+    }
+
+    PageFrame* Frames = (PageFrame*)PhysToVirt(Phys);
+    memset(Frames, 0, FrameCount * sizeof(PageFrame));
+
+    /*Anything in use that no region claims (holes, MMIO) is reserved*/
+    for (uint64_t Page = 0; Page < FrameCount; Page++)
+    {
+        if (TestBitmapBit(Page))
+        {
+            Frames[Page].RefCount = 1;
+            Frames[Page].Owner    = PageOwnerReserved;
+            Frames[Page].Flags    = PageFlagPinned;
+        }
+    }
+
+    /*Refine owners of in-use frames from the region they sit in*/
+    for (uint32_t Index = 0; Index < Pmm.RegionCount; Index++)
+    {
+        MemoryRegion* Region = &Pmm.Regions[Index];
+        uint16_t      Owner  = PageOwnerKernel; /*Usable pages already in use: bitmap, this array*/
+
+        if (Region->Type == MemoryTypeReserved || Region->Type == MemoryTypeBad)
+        {
+            continue;
+        }
+        if (Region->Type == MemoryTypeReclaim)
+        {
+            Owner = PageOwnerBoot;
+        }
+
+        uint64_t StartPage = Region->Base / PageSize;
+        uint64_t EndPage   = (Region->Base + Region->Length) / PageSize;
+        for (uint64_t Page = StartPage; Page < EndPage && Page < FrameCount; Page++)
+        {
+            if (Frames[Page].RefCount)
+            {
+                Frames[Page].Owner = Owner;
+                /*Boot frames are released later by PmmReclaimBootloaderMemory*/
+                Frames[Page].Flags = (Owner == PageOwnerBoot) ? 0 : PageFlagPinned;
+            }
+        }
+    }
+
+    for (uint64_t Page = 0; Page < FrameCount; Page++)
+    {
+        if (Frames[Page].RefCount)
+        {
+            Pmm.Stats.OwnerPages[Frames[Page].Owner]++;
+        }
+    }
+
+    Pmm.FrameCount = FrameCount;
+    Pmm.Frames     = Frames;
+
+    PSuccess("PMM: %lu page frame descriptors (%lu KB)\n", FrameCount, (Pages * PageSize) / 1024);
+}
+
+PageFrame*
+PmmGetFrame(uint64_t __PhysAddr__)
+{
+    uint64_t PageIndex = __PhysAddr__ / PageSize;
+    if (!Pmm.Frames || PageIndex >= Pmm.FrameCount)
+    {
+        return 0;
+    }
+    return &Pmm.Frames[PageIndex];
+}
+
+void
+PmmSetFrameOwner(uint64_t __PhysAddr__, size_t __Count__, uint16_t __Owner__)
+{
+    if (__Owner__ >= PageOwnerCount)
+    {
+        return;
+    }
+
+    for (size_t Index = 0; Index < __Count__; Index++)
+    {
+        PageFrame* Frame = PmmGetFrame(__PhysAddr__ + Index * PageSize);
+        if (!Frame || !Frame->RefCount)
+        {
+            continue;
+        }
+
+        Pmm.Stats.OwnerPages[Frame->Owner]--;
+        Pmm.Stats.OwnerPages[__Owner__]++;
+        Frame->Owner = __Owner__;
+    }
+}
+
+uint32_t
+PmmFrameRef(uint64_t __PhysAddr__)
+{
+    PageFrame* Frame = PmmGetFrame(__PhysAddr__);
+    if (!Frame)
+    {
+        return 0;
+    }
+
+    uint32_t Refs = __atomic_add_fetch(&Frame->RefCount, 1, __ATOMIC_SEQ_CST);
+    if (Refs > 1)
+    {
+        __atomic_fetch_or(&Frame->Flags, PageFlagShared, __ATOMIC_SEQ_CST);
+    }
+    return Refs;
+}
+
+void
+PmmFrameOnAlloc(uint64_t __PageIndex__)
+{
+    if (!Pmm.Frames || __PageIndex__ >= Pmm.FrameCount)
+    {
+        return;
+    }
+
+    PageFrame* Frame = &Pmm.Frames[__PageIndex__];
+    Frame->Next      = 0;
+    Frame->Prev      = 0;
+    Frame->Owner     = PageOwnerKernel; /*Callers retag with PmmSetFrameOwner*/
+    Frame->Flags     = 0;
+    __atomic_store_n(&Frame->RefCount, 1, __ATOMIC_SEQ_CST);
+
+    Pmm.Stats.OwnerPages[PageOwnerKernel]++;
+}
+
+int
+PmmFrameRelease(uint64_t __PageIndex__)
+{
+    /*Without descriptors the bitmap alone decides*/
+    if (!Pmm.Frames || __PageIndex__ >= Pmm.FrameCount)
+    {
+        return 0;
+    }
+
+    PageFrame* Frame = &Pmm.Frames[__PageIndex__];
+    if (Frame->Flags & PageFlagPinned)
+    {
+        PError("Refusing to free pinned frame: 0x%016lx\n", __PageIndex__ * PageSize);
+        return -1;
+    }
+
+    uint32_t Old = __atomic_load_n(&Frame->RefCount, __ATOMIC_SEQ_CST);
+    do
+    {
+        if (Old == 0)
+        {
+            PError("Double free detected at: 0x%016lx\n", __PageIndex__ * PageSize);
+            return -1;
+        }
+    } while (!__atomic_compare_exchange_n(
+        &Frame->RefCount, &Old, Old - 1, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST));
+
+    if (Old > 1)
+    {
+        if (Old == 2)
+        {
+            __atomic_fetch_and(&Frame->Flags, (uint16_t)~PageFlagShared, __ATOMIC_SEQ_CST);
+        }
+        return (int)(Old - 1);
+    }
+
+    Pmm.Stats.OwnerPages[Frame->Owner]--;
+    Frame->Owner = PageOwnerFree;
+    Frame->Flags = 0;
+    return 0;
+}
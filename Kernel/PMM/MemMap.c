@@ -1,4 +1,6 @@
 #include <PMM.h>
+#include <SMP.h>
+#include <VMM.h>
 
 void
 ParseMemoryMap(void)
@@ -19,27 +21,24 @@ ParseMemoryMap(void)
     {
         struct limine_memmap_entry* Entry = MemmapRequest.response->entries[Index];
 
-        if (Pmm.RegionCount >= MaxMemoryRegions)
-        {
-            PWarn("Too many memory regions, truncating at %u\n", MaxMemoryRegions);
-            break;
-        }
-
-        /*Store region information*/
-        Pmm.Regions[Pmm.RegionCount].Base   = Entry->base;
-        Pmm.Regions[Pmm.RegionCount].Length = Entry->length;
-
         /*Classify region type based on Limine type*/
+        uint32_t Type;
         switch (Entry->type)
         {
             case LIMINE_MEMMAP_USABLE:
-                Pmm.Regions[Pmm.RegionCount].Type = MemoryTypeUsable;
+                Type = MemoryTypeUsable;
                 break;
             case LIMINE_MEMMAP_KERNEL_AND_MODULES:
-                Pmm.Regions[Pmm.RegionCount].Type = MemoryTypeKernel;
+                Type = MemoryTypeKernel;
+                break;
+            case LIMINE_MEMMAP_BAD_MEMORY:
+                Type = MemoryTypeBad;
+                break;
+            case LIMINE_MEMMAP_BOOTLOADER_RECLAIMABLE:
+                Type = MemoryTypeReclaim;
                 break;
             default:
-                Pmm.Regions[Pmm.RegionCount].Type = MemoryTypeReserved;
+                Type = MemoryTypeReserved;
                 break;
         }
 
@@ -50,6 +49,28 @@ ParseMemoryMap(void)
             HighestAddr = EndAddr;
         }
 
+        /*Limine sorts the map; fold touching entries of one type into a single region*/
+        if (Pmm.RegionCount > 0)
+        {
+            MemoryRegion* Prev = &Pmm.Regions[Pmm.RegionCount - 1];
+            if (Prev->Type == Type && Prev->Base + Prev->Length == Entry->base)
+            {
+                Prev->Length += Entry->length;
+                continue;
+            }
+        }
+
+        if (Pmm.RegionCount >= MaxMemoryRegions)
+        {
+            PWarn("Too many memory regions, truncating at %u\n", MaxMemoryRegions);
+            break;
+        }
+
+        /*Store region information*/
+        Pmm.Regions[Pmm.RegionCount].Base   = Entry->base;
+        Pmm.Regions[Pmm.RegionCount].Length = Entry->length;
+        Pmm.Regions[Pmm.RegionCount].Type   = Type;
+
         Pmm.RegionCount++;
 
         PDebug("Region %lu: 0x%016lx-0x%016lx Type=%u\n",
@@ -112,3 +133,158 @@ MarkMemoryRegions(void)
     PInfo("Protected %lu bitmap pages from allocation\n", BitmapPageCount);
     PSuccess("Memory regions marked: %lu pages available\n", TotalFreePages - BitmapPageCount);
 }
+
+static inline void
+__PinFrame__(uint64_t* __Pinned__, uint64_t __PhysAddr__)
+{
+    uint64_t Page = __PhysAddr__ / PageSize;
+    if (Page < Pmm.TotalPages)
+    {
+        __Pinned__[Page / BitsPerUint64] |= 1ULL << (Page % BitsPerUint64);
+    }
+}
+
+/*Mark every paging-structure frame reachable from the kernel PML4*/
+static void
+__PinPageTables__(uint64_t* __Pinned__)
+{
+    uint64_t  Pml4Phys = Vmm.KernelPml4Physical;
+    uint64_t* Pml4     = (uint64_t*)PhysToVirt(Pml4Phys);
+
+    __PinFrame__(__Pinned__, Pml4Phys);
+
+    for (uint32_t I4 = 0; I4 < PageTableEntries; I4++)
+    {
+        if (!(Pml4[I4] & PTEPRESENT))
+        {
+            continue;
+        }
+
+        uint64_t  PdptPhys = Pml4[I4] & 0x000FFFFFFFFFF000ULL;
+        uint64_t* Pdpt     = (uint64_t*)PhysToVirt(PdptPhys);
+        __PinFrame__(__Pinned__, PdptPhys);
+
+        for (uint32_t I3 = 0; I3 < PageTableEntries; I3++)
+        {
+            /*1 GiB pages have no lower level*/
+            if (!(Pdpt[I3] & PTEPRESENT) || (Pdpt[I3] & PTEHUGEPAGE))
+            {
+                continue;
+            }
+
+            uint64_t  PdPhys = Pdpt[I3] & 0x000FFFFFFFFFF000ULL;
+            uint64_t* Pd     = (uint64_t*)PhysToVirt(PdPhys);
+            __PinFrame__(__Pinned__, PdPhys);
+
+            for (uint32_t I2 = 0; I2 < PageTableEntries; I2++)
+            {
+                /*2 MiB pages have no page table*/
+                if (!(Pd[I2] & PTEPRESENT) || (Pd[I2] & PTEHUGEPAGE))
+                {
+                    continue;
+                }
+
+                __PinFrame__(__Pinned__, Pd[I2] & 0x000FFFFFFFFFF000ULL);
+            }
+        }
+    }
+}
+
+uint64_t
+PmmReclaimBootloaderMemory(void)
+{
+    PInfo("Reclaiming bootloader memory...\n");
+
+    /*An AP that never came online may still be running on its Limine stack*/
+    for (uint32_t CpuIndex = 0; CpuIndex < Smp.CpuCount; CpuIndex++)
+    {
+        if (Smp.Cpus[CpuIndex].Status != CPU_STATUS_ONLINE)
+        {
+            PWarn("Reclaim: CPU %u is not online, keeping bootloader memory\n", CpuIndex);
+            return 0;
+        }
+    }
+
+    /*
+     * Limine's page tables and the BSP boot stack live in reclaimable memory and are
+     * still in use, so collect them in a scratch bitmap and skip those frames.
+     */
+    uint64_t ScratchPages = (Pmm.BitmapSize * sizeof(uint64_t) + PageSize - 1) / PageSize;
+    uint64_t ScratchPhys  = AllocPages(ScratchPages);
+    if (!ScratchPhys)
+    {
+        PError("Reclaim: no memory for pin bitmap\n");
+        return 0;
+    }
+
+    uint64_t* Pinned = (uint64_t*)PhysToVirt(ScratchPhys);
+    for (uint64_t Index = 0; Index < Pmm.BitmapSize; Index++)
+    {
+        Pinned[Index] = 0;
+    }
+
+    __PinPageTables__(Pinned);
+
+    for (int64_t Delta = -PmmBootStackPages; Delta <= PmmBootStackPages; Delta++)
+    {
+        __PinFrame__(Pinned, Pmm.BootStackPhys + (uint64_t)(Delta * PageSize));
+    }
+
+    uint64_t Reclaimed = 0;
+    uint64_t Kept      = 0;
+    for (uint32_t RegionIndex = 0; RegionIndex < Pmm.RegionCount; RegionIndex++)
+    {
+        MemoryRegion* Region = &Pmm.Regions[RegionIndex];
+        if (Region->Type != MemoryTypeReclaim)
+        {
+            continue;
+        }
+
+        uint64_t StartPage = Region->Base / PageSize;
+        uint64_t PageCount = Region->Length / PageSize;
+
+        AcquireSpinLock(&Pmm.Lock);
+
+        for (uint64_t Page = StartPage; Page < StartPage + PageCount && Page < Pmm.TotalPages; Page++)
+        {
+            PageFrame* Frame = PmmGetFrame(Page * PageSize);
+
+            if (Pinned[Page / BitsPerUint64] & (1ULL << (Page % BitsPerUint64)))
+            {
+                if (Frame)
+                {
+                    Frame->Flags |= PageFlagPinned;
+                }
+                Kept++;
+                continue;
+            }
+            if (TestBitmapBit(Page))
+            {
+                if (Frame && Frame->RefCount)
+                {
+                    Pmm.Stats.OwnerPages[Frame->Owner]--;
+                    Frame->RefCount = 0;
+                    Frame->Owner    = PageOwnerFree;
+                    Frame->Flags    = 0;
+                }
+                ClearBitmapBit(Page);
+                Pmm.Stats.UsedPages--;
+                Pmm.Stats.FreePages++;
+                Reclaimed++;
+            }
+        }
+
+        /*Allocations may now come from here*/
+        Region->Type = MemoryTypeUsable;
+        ReleaseSpinLock(&Pmm.Lock);
+    }
+
+    FreePages(ScratchPhys, ScratchPages);
+
+    Pmm.Stats.ReclaimedPages += Reclaimed;
+    PSuccess("Reclaimed %lu pages (%lu KB) from bootloader, kept %lu pinned\n",
+             Reclaimed,
+             (Reclaimed * PageSize) / 1024,
+             Kept);
+    return Reclaimed;
+}
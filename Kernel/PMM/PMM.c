@@ -30,10 +30,48 @@ FindFreePage(void)
     return PmmBitmapNotFound;
 }
 
+uint64_t
+FindFreeRun(size_t __Count__)
+{
+    if (__Count__ > Pmm.Stats.FreePages || __Count__ > Pmm.TotalPages)
+    {
+        PDebug("Not enough free pages: requested %lu, available %lu\n",
+               __Count__,
+               Pmm.Stats.FreePages);
+        return PmmBitmapNotFound;
+    }
+
+    PDebug("Searching for %lu contiguous pages...\n", __Count__);
+
+    /*Search for contiguous free block*/
+    for (uint64_t StartIndex = 0; StartIndex <= Pmm.TotalPages - __Count__; StartIndex++)
+    {
+        int Found = 1;
+
+        /*Check if all pages in range are free*/
+        for (size_t Offset = 0; Offset < __Count__; Offset++)
+        {
+            if (TestBitmapBit(StartIndex + Offset))
+            {
+                Found = 0;
+                break;
+            }
+        }
+
+        if (Found)
+        {
+            return StartIndex;
+        }
+    }
+
+    return PmmBitmapNotFound;
+}
+
 void
 InitializePmm(void)
 {
     PInfo("Initializing Physical Memory Manager...\n");
+    InitializeSpinLock(&Pmm.Lock, "PMM");
 
     /*Retrieve HHDM offset for address translation*/
     if (!HhdmRequest.response)
@@ -44,6 +82,11 @@ InitializePmm(void)
     Pmm.HhdmOffset = HhdmRequest.response->offset;
     PDebug("HHDM offset: 0x%016lx\n", Pmm.HhdmOffset);
 
+    /*Still on the Limine stack (reclaimable memory); remember it so reclaim leaves it alone*/
+    uint64_t Rsp;
+    __asm__ volatile("mov %%rsp, %0" : "=r"(Rsp));
+    Pmm.BootStackPhys = VirtToPhys((void*)Rsp);
+
     /*Parse system memory map from bootloader*/
     ParseMemoryMap();
     if (Pmm.RegionCount == 0)
@@ -80,15 +123,70 @@ InitializePmm(void)
         }
     }
 
+    /*Per-frame descriptors (refcount, owner, flags)*/
+    InitializePageFrames();
+
+    Pmm.LowWatermark = Pmm.Stats.FreePages / PmmWatermarkDivisor;
+    if (Pmm.LowWatermark < PmmMinWatermarkPages)
+    {
+        Pmm.LowWatermark = PmmMinWatermarkPages;
+    }
+
     PSuccess("PMM initialized: %lu MB total, %lu MB free\n",
              (Pmm.Stats.TotalPages * PageSize) / (1024 * 1024),
              (Pmm.Stats.FreePages * PageSize) / (1024 * 1024));
 }
 
+/*Find and claim one page under the lock; PmmBitmapNotFound when there is none*/
+static uint64_t
+__TakePage__(void)
+{
+    AcquireSpinLock(&Pmm.Lock);
+    uint64_t PageIndex = FindFreePage();
+    if (PageIndex != PmmBitmapNotFound)
+    {
+        SetBitmapBit(PageIndex);
+        Pmm.Stats.UsedPages++;
+        Pmm.Stats.FreePages--;
+        PmmFrameOnAlloc(PageIndex);
+    }
+    ReleaseSpinLock(&Pmm.Lock);
+    return PageIndex;
+}
+
+static uint64_t
+__TakeRun__(size_t __Count__)
+{
+    AcquireSpinLock(&Pmm.Lock);
+    uint64_t StartIndex = FindFreeRun(__Count__);
+    if (StartIndex != PmmBitmapNotFound)
+    {
+        /*Mark all pages in block as used*/
+        for (size_t Offset = 0; Offset < __Count__; Offset++)
+        {
+            SetBitmapBit(StartIndex + Offset);
+            PmmFrameOnAlloc(StartIndex + Offset);
+        }
+
+        Pmm.Stats.UsedPages += __Count__;
+        Pmm.Stats.FreePages -= __Count__;
+    }
+    ReleaseSpinLock(&Pmm.Lock);
+    return StartIndex;
+}
+
 uint64_t
 AllocPage(void)
 {
-    uint64_t PageIndex = FindFreePage();
+    /*Let caches shrink before free memory falls under the watermark*/
+    PmmCheckPressure(1);
+
+    /*Shrinkers free pages themselves, so reclaim runs between two attempts, unlocked*/
+    uint64_t PageIndex = __TakePage__();
+    if (PageIndex == PmmBitmapNotFound && PmmReclaimForAlloc(1))
+    {
+        PageIndex = __TakePage__();
+    }
 
     if (PageIndex == PmmBitmapNotFound)
     {
@@ -96,11 +194,6 @@ AllocPage(void)
         return 0;
     }
 
-    /*Mark page as used in bitmap*/
-    SetBitmapBit(PageIndex);
-    Pmm.Stats.UsedPages++;
-    Pmm.Stats.FreePages--;
-
     uint64_t PhysAddr = PageIndex * PageSize;
     PDebug("Allocated page: 0x%016lx (index %lu)\n", PhysAddr, PageIndex);
 
@@ -118,8 +211,18 @@ FreePage(uint64_t __PhysAddr__)
 
     uint64_t PageIndex = __PhysAddr__ / PageSize;
 
+    AcquireSpinLock(&Pmm.Lock);
+
+    /*Drop one reference; the frame only goes back once nobody holds it*/
+    if (PmmFrameRelease(PageIndex) != 0)
+    {
+        ReleaseSpinLock(&Pmm.Lock);
+        return;
+    }
+
     if (!TestBitmapBit(PageIndex))
     {
+        ReleaseSpinLock(&Pmm.Lock);
         PError("Double free detected at: 0x%016lx\n", __PhysAddr__);
         return;
     }
@@ -129,6 +232,8 @@ FreePage(uint64_t __PhysAddr__)
     Pmm.Stats.UsedPages--;
     Pmm.Stats.FreePages++;
 
+    ReleaseSpinLock(&Pmm.Lock);
+
     PDebug("Freed page: 0x%016lx (index %lu)\n", __PhysAddr__, PageIndex);
 }
 
@@ -146,47 +251,20 @@ AllocPages(size_t __Count__)
         return AllocPage();
     }
 
-    if (__Count__ > Pmm.Stats.FreePages)
+    PmmCheckPressure(__Count__);
+
+    uint64_t StartIndex = __TakeRun__(__Count__);
+    if (StartIndex == PmmBitmapNotFound && PmmReclaimForAlloc(__Count__))
     {
-        PError("Not enough free pages: requested %lu, available %lu\n",
-               __Count__,
-               Pmm.Stats.FreePages);
-        return 0;
+        StartIndex = __TakeRun__(__Count__);
     }
 
-    PDebug("Searching for %lu contiguous pages...\n", __Count__);
-
-    /*Search for contiguous free block*/
-    for (uint64_t StartIndex = 0; StartIndex <= Pmm.TotalPages - __Count__; StartIndex++)
+    if (StartIndex != PmmBitmapNotFound)
     {
-        int Found = 1;
-
-        /*Check if all pages in range are free*/
-        for (size_t Offset = 0; Offset < __Count__; Offset++)
-        {
-            if (TestBitmapBit(StartIndex + Offset))
-            {
-                Found = 0;
-                break;
-            }
-        }
+        uint64_t PhysAddr = StartIndex * PageSize;
+        PDebug("Allocated %lu contiguous pages at: 0x%016lx\n", __Count__, PhysAddr);
 
-        if (Found)
-        {
-            /*Mark all pages in block as used*/
-            for (size_t Offset = 0; Offset < __Count__; Offset++)
-            {
-                SetBitmapBit(StartIndex + Offset);
-            }
-
-            Pmm.Stats.UsedPages += __Count__;
-            Pmm.Stats.FreePages -= __Count__;
-
-            uint64_t PhysAddr = StartIndex * PageSize;
-            PDebug("Allocated %lu contiguous pages at: 0x%016lx\n", __Count__, PhysAddr);
-
-            return PhysAddr;
-        }
+        return PhysAddr;
     }
 
     PError("Failed to find %lu contiguous pages\n", __Count__);
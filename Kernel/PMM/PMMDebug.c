@@ -28,7 +28,7 @@ PmmDumpRegions(void)
 {
     PInfo("Memory Regions (%u total):\n", Pmm.RegionCount);
 
-    const char* TypeNames[] = {"Usable", "Reserved", "Kernel", "Bad"};
+    const char* TypeNames[] = {"Usable", "Reserved", "Kernel", "Bad", "Reclaimable"};
 
     for (uint32_t Index = 0; Index < Pmm.RegionCount; Index++)
     {
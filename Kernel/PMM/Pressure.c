@@ -0,0 +1,106 @@
+#include <PMM.h>
+
+int
+PmmRegisterShrinker(const char* __Name__, PmmShrinkFn __Fn__)
+{
+    if (!__Fn__ || Pmm.ShrinkerCount >= MaxShrinkers)
+    {
+        PError("PMM: Cannot register shrinker %s\n", __Name__ ? __Name__ : "?");
+        return -1;
+    }
+
+    PmmShrinker* S = &Pmm.Shrinkers[Pmm.ShrinkerCount];
+    S->Name        = __Name__;
+    S->Shrink      = __Fn__;
+    S->Calls       = 0;
+    S->Freed       = 0;
+    Pmm.ShrinkerCount++;
+
+    PDebug("PMM: Shrinker %s registered\n", __Name__);
+    return 0;
+}
+
+int
+PmmUnregisterShrinker(PmmShrinkFn __Fn__)
+{
+    for (uint32_t Index = 0; Index < Pmm.ShrinkerCount; Index++)
+    {
+        if (Pmm.Shrinkers[Index].Shrink != __Fn__)
+        {
+            continue;
+        }
+
+        for (uint32_t Next = Index + 1; Next < Pmm.ShrinkerCount; Next++)
+        {
+            Pmm.Shrinkers[Next - 1] = Pmm.Shrinkers[Next];
+        }
+        Pmm.ShrinkerCount--;
+        return 0;
+    }
+    return -1;
+}
+
+void
+PmmSetOomHandler(PmmOomFn __Fn__)
+{
+    Pmm.OomHandler = __Fn__;
+}
+
+uint64_t
+PmmShrink(uint64_t __Target__)
+{
+    /*Shrinkers free pages themselves; never recurse into them*/
+    if (__atomic_exchange_n(&Pmm.Reclaiming, 1, __ATOMIC_SEQ_CST))
+    {
+        return 0;
+    }
+
+    uint64_t Freed = 0;
+    for (uint32_t Index = 0; Index < Pmm.ShrinkerCount && Freed < __Target__; Index++)
+    {
+        PmmShrinker* S   = &Pmm.Shrinkers[Index];
+        uint64_t     Got = S->Shrink(__Target__ - Freed);
+        S->Calls++;
+        S->Freed += Got;
+        Freed += Got;
+    }
+
+    Pmm.Stats.ShrinkRuns++;
+    Pmm.Stats.ShrunkPages += Freed;
+    __atomic_store_n(&Pmm.Reclaiming, 0, __ATOMIC_SEQ_CST);
+
+    PDebug("PMM: Shrink wanted %lu pages, freed %lu\n", __Target__, Freed);
+    return Freed;
+}
+
+void
+PmmCheckPressure(size_t __Count__)
+{
+    uint64_t Want = Pmm.LowWatermark + __Count__;
+    if (Pmm.Stats.FreePages < Want && !__atomic_load_n(&Pmm.Reclaiming, __ATOMIC_ACQUIRE))
+    {
+        PmmShrink(Want - Pmm.Stats.FreePages);
+    }
+}
+
+int
+PmmReclaimForAlloc(size_t __Count__)
+{
+    if (__atomic_load_n(&Pmm.Reclaiming, __ATOMIC_ACQUIRE))
+    {
+        return 0;
+    }
+
+    PmmShrink(__Count__ + Pmm.LowWatermark);
+    if (Pmm.Stats.FreePages >= __Count__)
+    {
+        return 1;
+    }
+
+    /*Caches are dry; the killer runs in its own thread, this allocation just fails*/
+    if (Pmm.OomHandler)
+    {
+        Pmm.OomHandler();
+    }
+    return 0;
+}
@@ -13,6 +13,7 @@
 #include <VFS.h>
 #include <VMM.h>
 #include <VirtBin.h>
+#include <WorkQueue.h>
 
 #define __attribute_unused__ __attribute__((unused))
 
@@ -26,9 +27,15 @@
 
 #define RlimitMaxRss (64ULL * 1024ULL * 1024ULL)
 
+#define OomSettleMs    10  /*Poll interval while an OOM victim dies*/
+#define OomSettlePolls 500 /*Give up on a victim that is still around after this many*/
+
 static long    __NextPid__ = 1;
 PosixProcTable PosixProcs  = {0};
 
+static WorkQueue* OomWq;
+static WorkItem   OomWork;
+
 static PosixProc* __AllocProc__(void);
 static void       __FreeProc__(PosixProc* __Proc__);
 static int        __AttachThread__(PosixProc* __Proc__, Thread* __Th__);
@@ -43,10 +50,13 @@ static int  __BuildArgsEnv__(const char* const* __Argv__,
                              PosixProc*         __Proc__);
 static int  __PopulateTimesStart__(PosixProc* __Proc__);
 static int  __UpdateTimesOnExit__(PosixProc* __Proc__);
+static void __FoldThreadTimes__(PosixProc* __Proc__, Thread* __Th__);
 static int  __CreateTableIfNeeded__(void);
 static int  __TableInsert__(PosixProc* __Proc__);
 static int  __TableRemove__(PosixProc* __Proc__);
 static long __FindFreePid__(void);
+static void __OomWake__(void);
+static void __OomKill__(WorkItem* __Work__);
 static int  __ResolveExecFile__(const char* __Path__, File** __OutFile__);
 static int  __EnsureCwdRoot__(PosixProc* __Proc__);
 
@@ -442,6 +452,8 @@ PosixFork(PosixProc* __Parent__, PosixProc** __OutChild__)
                         return -1;
                     }
 
+                    PmmSetFrameOwner(__NewPhys__, 1, PageOwnerUser);
+
                     uint8_t* __Dst__ = (uint8_t*)PhysToVirt(__NewPhys__);
                     uint8_t* __Src__ = (uint8_t*)PhysToVirt(__SrcPhys__);
                     __builtin_memcpy(__Dst__, __Src__, (size_t)PageSize);
@@ -486,17 +498,15 @@ PosixExit(PosixProc* __Proc__, int __Status__)
     __Proc__->ExitCode = __Status__;
     __Proc__->Zombie   = 1;
 
-    __UpdateTimesOnExit__(__Proc__);
-
     AcquireSpinLock(&ThreadListLock);
 
     /* clear per-CPU current thread references */
     for (uint32_t CpuIndex = 0; CpuIndex < MaxCPUs; CpuIndex++)
     {
-        Thread* Ct = CurrentThreads[CpuIndex];
+        Thread* Ct = GetCurrentThread(CpuIndex);
         if (Ct && (long)Ct->ProcessId == __Proc__->Pid)
         {
-            CurrentThreads[CpuIndex] = NULL;
+            SetCurrentThread(CpuIndex, NULL);
         }
     }
 
@@ -508,15 +518,19 @@ PosixExit(PosixProc* __Proc__, int __Status__)
         Thread* NextThread = ThreadPtr->Next;
         if ((long)ThreadPtr->ProcessId == __Proc__->Pid)
         {
+            /* the scheduler hands it to the reaper once no CPU is running it */
             ThreadPtr->State = ThreadStateTerminated;
-            DestroyThread(ThreadPtr);
-            PInfo("Exit: Destroyed ThreadId=%u of Pid=%u\n", ThreadPtr->ThreadId, __Proc__->Pid);
+            __FoldThreadTimes__(__Proc__, ThreadPtr);
+            PInfo("Exit: Terminated ThreadId=%u of Pid=%u\n", ThreadPtr->ThreadId, __Proc__->Pid);
         }
         ThreadPtr = NextThread;
     }
 
     ReleaseSpinLock(&ThreadListLock);
 
+    /* every thread is folded in by now */
+    __UpdateTimesOnExit__(__Proc__);
+
     PosixProc* ParentProc = PosixFind(__Proc__->Ppid);
     if (ParentProc)
     {
@@ -562,6 +576,11 @@ PosixWait4(PosixProc*   __Parent__,
                 {
                     *__OutStatus__ = P->ExitCode;
                 }
+                for (uint32_t Mode = 0; Mode < AcctModes; Mode++)
+                {
+                    __Parent__->Times.ChildNs[Mode] += P->Times.Ns[Mode] + P->Times.ChildNs[Mode];
+                }
+
                 if (__OutUsage__)
                 {
                     __OutUsage__->UtimeUsec       = P->Times.UserUsec;
@@ -576,6 +595,7 @@ PosixWait4(PosixProc*   __Parent__,
                 long ReapedId = P->Pid;
                 ProcFsNotifyProcRemoved(P);
                 __TableRemove__(P);
+                SynchronizeRcu(); /*PosixFind may still be reading P*/
                 __FreeProc__(P);
                 PSuccess("Wait4: reaped=%ld\n", ReapedId);
                 return ReapedId;
@@ -749,7 +769,8 @@ PosixSigaction(int __Sig__, const PosixSigAction* __Act__, PosixSigAction* __Old
     /* Old */
     if (__OldAct__)
     {
-        __OldAct__->Handler = (PosixSigHandler)P->MainThread->SignalHandlers[__Sig__];
+        ThreadCold* Cold    = P->MainThread->Cold;
+        __OldAct__->Handler = Cold ? (PosixSigHandler)Cold->SignalHandlers[__Sig__] : NULL;
         __OldAct__->Mask    = P->SigMask;
         __OldAct__->Flags   = 0;
     }
@@ -757,8 +778,13 @@ PosixSigaction(int __Sig__, const PosixSigAction* __Act__, PosixSigAction* __Old
     /* New */
     if (__Act__)
     {
-        P->MainThread->SignalHandlers[__Sig__] = (void*)__Act__->Handler;
-        P->SigMask                             = __Act__->Mask;
+        ThreadCold* Cold = GetThreadCold(P->MainThread);
+        if (!Cold)
+        {
+            return -1;
+        }
+        Cold->SignalHandlers[__Sig__] = (void*)__Act__->Handler;
+        P->SigMask                    = __Act__->Mask;
     }
 
     return 0;
@@ -852,15 +878,21 @@ PosixFind(long __Pid__)
     {
         return NULL;
     }
-    for (long I = 0; I < PosixProcs.Count; I++)
+
+    /*Backwards: removal moves the last entry down, so this walk cannot step over it*/
+    PosixProc* Found = NULL;
+    RcuReadLock();
+    for (long I = __atomic_load_n(&PosixProcs.Count, __ATOMIC_ACQUIRE) - 1; I >= 0; I--)
     {
-        PosixProc* P = PosixProcs.Items[I];
+        PosixProc* P = RcuDereference(PosixProcs.Items[I]);
         if (P && P->Pid == __Pid__)
         {
-            return P;
+            Found = P;
+            break;
         }
     }
-    return NULL;
+    RcuReadUnlock();
+    return Found;
 }
 
 static int
@@ -877,10 +909,84 @@ __CreateTableIfNeeded__(void)
     {
         return -1;
     }
-    InitializeSpinLock(&PosixProcs.Lock, "PosixProcs");
+    InitializeRwLock(&PosixProcs.Lock, "PosixProcs");
+
+    /*Processes exist from here on; one OOM kill in flight at a time*/
+    OomWq = CreateWorkQueue("oom", 1);
+    InitWork(&OomWork, __OomKill__);
+    PmmSetOomHandler(__OomWake__);
     return 0;
 }
 
+/*Called by the allocator from any context, so it only queues the kill*/
+static void
+__OomWake__(void)
+{
+    QueueWorkOn(GetCurrentCpuId(), OomWq, &OomWork);
+}
+
+/*
+ * Runs in a worker. The victim is held by pid: PosixFind re-resolves it, so
+ * nothing dangles once the table lock is dropped. The queue stays busy until
+ * the victim is reaped, so a backlog of failed allocations costs one kill.
+ */
+static void
+__OomKill__(WorkItem* __Work__)
+{
+    long     VictimPid = 0;
+    uint64_t VictimRss = 0;
+    char     VictimComm[64];
+
+    /*The last kill, or someone else, may have freed enough already*/
+    if (__atomic_load_n(&Pmm.Stats.FreePages, __ATOMIC_RELAXED) >= Pmm.LowWatermark)
+    {
+        return;
+    }
+
+    AcquireRwLockRead(&PosixProcs.Lock);
+    for (long I = 0; I < PosixProcs.Count; I++)
+    {
+        PosixProc* P = PosixProcs.Items[I];
+
+        /*Never init, never a process that is already on its way out*/
+        if (!P || P->Pid <= 1 || P->Zombie || (P->SigPending & (1ULL << SigKill)))
+        {
+            continue;
+        }
+
+        uint64_t Rss = VmmCountUserPages(P->Space);
+        if (Rss > VictimRss)
+        {
+            VictimPid = P->Pid;
+            VictimRss = Rss;
+            StringCopy(VictimComm, P->Comm[0] ? P->Comm : "?", sizeof(VictimComm));
+        }
+    }
+    ReleaseRwLockRead(&PosixProcs.Lock);
+
+    if (!VictimPid)
+    {
+        PError("OOM: No process to kill\n");
+        return;
+    }
+
+    PWarn("OOM: Killing pid %ld (%s), rss %lu KB\n",
+          VictimPid,
+          VictimComm,
+          (VictimRss * PageSize) / 1024);
+    if (PosixKill(VictimPid, SigKill) != 0)
+    {
+        return;
+    }
+    __atomic_fetch_add(&Pmm.Stats.OomKills, 1, __ATOMIC_RELAXED);
+
+    /*Its pages only come back when it is reaped; choose again after that*/
+    for (uint32_t Poll = 0; Poll < OomSettlePolls && PosixFind(VictimPid); Poll++)
+    {
+        ThreadSleep(OomSettleMs);
+    }
+}
+
 static long
 __FindFreePid__(void)
 {
@@ -896,21 +1002,22 @@ __FindFreePid__(void)
 static int
 __TableInsert__(PosixProc* __Proc__)
 {
-    AcquireSpinLock(&PosixProcs.Lock);
+    AcquireRwLockWrite(&PosixProcs.Lock);
     if (PosixProcs.Count >= PosixProcs.Cap)
     {
-        ReleaseSpinLock(&PosixProcs.Lock);
+        ReleaseRwLockWrite(&PosixProcs.Lock);
         return -1;
     }
-    PosixProcs.Items[PosixProcs.Count++] = __Proc__;
-    ReleaseSpinLock(&PosixProcs.Lock);
+    RcuAssignPointer(PosixProcs.Items[PosixProcs.Count], __Proc__);
+    __atomic_store_n(&PosixProcs.Count, PosixProcs.Count + 1, __ATOMIC_RELEASE);
+    ReleaseRwLockWrite(&PosixProcs.Lock);
     return 0;
 }
 
 static int
 __TableRemove__(PosixProc* __Proc__)
 {
-    AcquireSpinLock(&PosixProcs.Lock);
+    AcquireRwLockWrite(&PosixProcs.Lock);
     long idx = -1;
     for (long I = 0; I < PosixProcs.Count; I++)
     {
@@ -922,23 +1029,23 @@ __TableRemove__(PosixProc* __Proc__)
     }
     if (idx >= 0)
     {
-        PosixProcs.Items[idx]                  = PosixProcs.Items[PosixProcs.Count - 1];
-        PosixProcs.Items[PosixProcs.Count - 1] = NULL;
-        PosixProcs.Count--;
+        /*The copy lands before the original goes, for PosixFind walking without the lock*/
+        RcuAssignPointer(PosixProcs.Items[idx], PosixProcs.Items[PosixProcs.Count - 1]);
+        RcuAssignPointer(PosixProcs.Items[PosixProcs.Count - 1], NULL);
+        __atomic_store_n(&PosixProcs.Count, PosixProcs.Count - 1, __ATOMIC_RELEASE);
     }
-    ReleaseSpinLock(&PosixProcs.Lock);
+    ReleaseRwLockWrite(&PosixProcs.Lock);
     return 0;
 }
 
 static PosixProc*
 __AllocProc__(void)
 {
-    PosixProc* P = (PosixProc*)KMalloc(sizeof(PosixProc));
+    PosixProc* P = (PosixProc*)KZalloc(sizeof(PosixProc));
     if (!P)
     {
         return NULL;
     }
-    memset(P, 0, sizeof(*P));
     InitializeSpinLock(&P->Lock, "proc");
 
     /* allocate cmdline/environ buffers */
@@ -1027,8 +1134,8 @@ __DetachThread__(PosixProc* __Proc__)
     Thread* Th = __Proc__->MainThread;
     if (Th)
     {
-        Th->State = ThreadStateTerminated; /*Sceduler will automatically remove from ready*/
-        DestroyThread(Th);
+        Th->State = ThreadStateTerminated; /*Sceduler reaps it off the ready queue or the CPU*/
+        __FoldThreadTimes__(__Proc__, Th);
         __Proc__->MainThread = NULL;
     }
     return 0;
@@ -1045,9 +1152,8 @@ __ForkCopyFds__(PosixProc* __Parent__, PosixProc* __Child__)
 
     __Child__->SigMask         = __Parent__->SigMask;
     __Child__->SigPending      = 0;
-    __Child__->MainThread      = NULL;
-    __Child__->Times.UserUsec  = 0;
-    __Child__->Times.SysUsec   = 0;
+    __Child__->MainThread = NULL;
+    __builtin_memset(&__Child__->Times, 0, sizeof(__Child__->Times));
     __Child__->Times.StartTick = __Parent__->Times.StartTick;
 
     __Child__->Fds = (PosixFdTable*)KMalloc(sizeof(PosixFdTable));
@@ -1275,21 +1381,46 @@ __BuildArgsEnv__(const char* const* __Argv__,
 static int
 __PopulateTimesStart__(PosixProc* __Proc__)
 {
-    __Proc__->Times.UserUsec  = 0;
-    __Proc__->Times.SysUsec   = 0;
+    __builtin_memset(&__Proc__->Times, 0, sizeof(__Proc__->Times));
     __Proc__->Times.StartTick = GetSystemTicks();
     return 0;
 }
 
+static void
+__FoldThreadTimes__(PosixProc* __Proc__, Thread* __Th__)
+{
+    for (uint32_t Mode = 0; Mode < AcctModes; Mode++)
+    {
+        __Proc__->Times.DeadNs[Mode] += ThreadAcctNs(__Th__, Mode);
+    }
+}
+
 static int
 __UpdateTimesOnExit__(PosixProc* __Proc__)
 {
-    uint64_t now = GetSystemTicks();
-    uint64_t dur = (now > __Proc__->Times.StartTick) ? (now - __Proc__->Times.StartTick) : 0;
-    __Proc__->Times.SysUsec += dur * 1000; /* pretend 1 tick = 1ms */
+    PosixRefreshTimes(__Proc__);
     return 0;
 }
 
+void
+PosixRefreshTimes(PosixProc* __Proc__)
+{
+    if (!__Proc__)
+    {
+        return;
+    }
+
+    /*Processes run on their main thread; anything else was folded into DeadNs when destroyed*/
+    for (uint32_t Mode = 0; Mode < AcctModes; Mode++)
+    {
+        __Proc__->Times.Ns[Mode] =
+            __Proc__->Times.DeadNs[Mode] + ThreadAcctNs(__Proc__->MainThread, Mode);
+    }
+
+    __Proc__->Times.UserUsec = __Proc__->Times.Ns[AcctUser] / 1000;
+    __Proc__->Times.SysUsec  = __Proc__->Times.Ns[AcctSys] / 1000;
+}
+
 static int
 __ResolveExecFile__(const char* __Path__, File** __OutFile__)
 {
@@ -1387,11 +1518,12 @@ __DeliverPendingSignals__(PosixProc* __Proc__)
             continue;
         }
 
-        if (__Proc__->MainThread && __Proc__->MainThread->SignalHandlers[S])
+        ThreadCold* Cold = __Proc__->MainThread ? __Proc__->MainThread->Cold : NULL;
+        if (Cold && Cold->SignalHandlers[S])
         {
             /* x86-64 SysV ABI: first arg RDI */
             __Proc__->MainThread->Context.Rdi = (uint64_t)S;
-            __Proc__->MainThread->Context.Rip = (uint64_t)__Proc__->MainThread->SignalHandlers[S];
+            __Proc__->MainThread->Context.Rip = (uint64_t)Cold->SignalHandlers[S];
 
             __Proc__->SigPending &= ~bit;
         }
@@ -66,7 +66,7 @@ static long
 __PipeWrite__(PosixPipeT* __P__, const void* __Buf__, long __Len__)
 {
     long W = 0;
-    AcquireSpinLock(&__P__->Lock);
+    AcquireSpinLockPlain(&__P__->Lock);
     while (W < __Len__ && __P__->Len < __P__->Cap)
     {
         __P__->Buf[__P__->Tail] = ((const char*)__Buf__)[W];
@@ -74,7 +74,7 @@ __PipeWrite__(PosixPipeT* __P__, const void* __Buf__, long __Len__)
         __P__->Len++;
         W++;
     }
-    ReleaseSpinLock(&__P__->Lock);
+    ReleaseSpinLockPlain(&__P__->Lock);
     return W;
 }
 
@@ -82,7 +82,7 @@ static long
 __PipeRead__(PosixPipeT* __P__, void* __Buf__, long __Len__)
 {
     long R = 0;
-    AcquireSpinLock(&__P__->Lock);
+    AcquireSpinLockPlain(&__P__->Lock);
     while (R < __Len__ && __P__->Len > 0)
     {
         ((char*)__Buf__)[R] = __P__->Buf[__P__->Head];
@@ -90,7 +90,7 @@ __PipeRead__(PosixPipeT* __P__, void* __Buf__, long __Len__)
         __P__->Len--;
         R++;
     }
-    ReleaseSpinLock(&__P__->Lock);
+    ReleaseSpinLockPlain(&__P__->Lock);
     return R;
 }
 
@@ -103,7 +103,7 @@ PosixFdInit(PosixFdTable* __Tab__, long __Cap__)
     __Tab__->StdinFd  = -1;
     __Tab__->StdoutFd = -1;
     __Tab__->StderrFd = -1;
-    InitializeSpinLock(&__Tab__->Lock, "PosixFdTable");
+    InitializeMutex(&__Tab__->Lock, "PosixFdTable");
     long I = 0;
     for (I = 0; I < __Cap__; I++)
     {
@@ -120,18 +120,18 @@ PosixOpen(PosixFdTable* __Tab__, const char* __Path__, long __Flags__, long __Mo
         return -1;
     }
 
-    AcquireSpinLock(&__Tab__->Lock);
+    AcquireMutex(&__Tab__->Lock);
     int NewFd = __FindFreeFd__(__Tab__, 0);
     if (NewFd < 0)
     {
-        ReleaseSpinLock(&__Tab__->Lock);
+        ReleaseMutex(&__Tab__->Lock);
         return -1;
     }
 
     File* F = VfsOpen(__Path__, __Flags__);
     if (!F)
     {
-        ReleaseSpinLock(&__Tab__->Lock);
+        ReleaseMutex(&__Tab__->Lock);
         return -1;
     }
 
@@ -144,18 +144,18 @@ PosixOpen(PosixFdTable* __Tab__, const char* __Path__, long __Flags__, long __Mo
     E->IsChar  = 0;
     E->IsBlock = 0;
     __Tab__->Count++;
-    ReleaseSpinLock(&__Tab__->Lock);
+    ReleaseMutex(&__Tab__->Lock);
     return NewFd;
 }
 
 int
 PosixClose(PosixFdTable* __Tab__, int __Fd__)
 {
-    AcquireSpinLock(&__Tab__->Lock);
+    AcquireMutex(&__Tab__->Lock);
     PosixFd* E = __GetEntry__(__Tab__, __Fd__);
     if (!E || E->Fd < 0)
     {
-        ReleaseSpinLock(&__Tab__->Lock);
+        ReleaseMutex(&__Tab__->Lock);
         return -1;
     }
     if (--E->Refcnt <= 0)
@@ -173,44 +173,44 @@ PosixClose(PosixFdTable* __Tab__, int __Fd__)
         __InitEntry__(E);
         __Tab__->Count--;
     }
-    ReleaseSpinLock(&__Tab__->Lock);
+    ReleaseMutex(&__Tab__->Lock);
     return 0;
 }
 
 long
 PosixRead(PosixFdTable* __Tab__, int __Fd__, void* __Buf__, long __Len__)
 {
-    AcquireSpinLock(&__Tab__->Lock);
+    AcquireMutex(&__Tab__->Lock);
     PosixFd* E = __GetEntry__(__Tab__, __Fd__);
     if (!E || E->Fd < 0)
     {
-        ReleaseSpinLock(&__Tab__->Lock);
+        ReleaseMutex(&__Tab__->Lock);
         return -1;
     }
     if (E->IsFile)
     {
         long R = VfsRead((File*)E->Obj, __Buf__, __Len__);
-        ReleaseSpinLock(&__Tab__->Lock);
+        ReleaseMutex(&__Tab__->Lock);
         return R;
     }
     if (E->IsChar)
     {
         long R = __PipeRead__((PosixPipeT*)E->Obj, __Buf__, __Len__);
-        ReleaseSpinLock(&__Tab__->Lock);
+        ReleaseMutex(&__Tab__->Lock);
         return R;
     }
-    ReleaseSpinLock(&__Tab__->Lock);
+    ReleaseMutex(&__Tab__->Lock);
     return -1;
 }
 
 long
 PosixWrite(PosixFdTable* __Tab__, int __Fd__, const void* __Buf__, long __Len__)
 {
-    AcquireSpinLock(&__Tab__->Lock);
+    AcquireMutex(&__Tab__->Lock);
     PosixFd* E = __GetEntry__(__Tab__, __Fd__);
     if (!E || E->Fd < 0)
     {
-        ReleaseSpinLock(&__Tab__->Lock);
+        ReleaseMutex(&__Tab__->Lock);
         PError("PosixWrite: bad fd=%d\n", __Fd__);
         return -1;
     }
@@ -226,7 +226,7 @@ PosixWrite(PosixFdTable* __Tab__, int __Fd__, const void* __Buf__, long __Len__)
         PDebug("PosixWrite: dispatching to VfsWrite, len=%ld\n", __Len__);
         long W = VfsWrite((File*)E->Obj, __Buf__, __Len__);
         PDebug("PosixWrite: VfsWrite returned %ld\n", W);
-        ReleaseSpinLock(&__Tab__->Lock);
+        ReleaseMutex(&__Tab__->Lock);
         return W;
     }
 
@@ -235,11 +235,11 @@ PosixWrite(PosixFdTable* __Tab__, int __Fd__, const void* __Buf__, long __Len__)
         PDebug("PosixWrite: dispatching to __PipeWrite__, len=%ld\n", __Len__);
         long W = __PipeWrite__((PosixPipeT*)E->Obj, __Buf__, __Len__);
         PDebug("PosixWrite: __PipeWrite__ returned %ld\n", W);
-        ReleaseSpinLock(&__Tab__->Lock);
+        ReleaseMutex(&__Tab__->Lock);
         return W;
     }
 
-    ReleaseSpinLock(&__Tab__->Lock);
+    ReleaseMutex(&__Tab__->Lock);
     PError("PosixWrite: fd=%d not file/char, returning -1\n", __Fd__);
     return -1;
 }
@@ -247,32 +247,32 @@ PosixWrite(PosixFdTable* __Tab__, int __Fd__, const void* __Buf__, long __Len__)
 long
 PosixLseek(PosixFdTable* __Tab__, int __Fd__, long __Off__, int __Wh__)
 {
-    AcquireSpinLock(&__Tab__->Lock);
+    AcquireMutex(&__Tab__->Lock);
     PosixFd* E = __GetEntry__(__Tab__, __Fd__);
     if (!E || E->Fd < 0 || !E->IsFile)
     {
-        ReleaseSpinLock(&__Tab__->Lock);
+        ReleaseMutex(&__Tab__->Lock);
         return -1;
     }
     long R = VfsLseek((File*)E->Obj, __Off__, __Wh__);
-    ReleaseSpinLock(&__Tab__->Lock);
+    ReleaseMutex(&__Tab__->Lock);
     return R;
 }
 
 int
 PosixDup(PosixFdTable* __Tab__, int __Fd__)
 {
-    AcquireSpinLock(&__Tab__->Lock);
+    AcquireMutex(&__Tab__->Lock);
     PosixFd* E = __GetEntry__(__Tab__, __Fd__);
     if (!E || E->Fd < 0)
     {
-        ReleaseSpinLock(&__Tab__->Lock);
+        ReleaseMutex(&__Tab__->Lock);
         return -1;
     }
     int NewFd = __FindFreeFd__(__Tab__, 0);
     if (NewFd < 0)
     {
-        ReleaseSpinLock(&__Tab__->Lock);
+        ReleaseMutex(&__Tab__->Lock);
         return -1;
     }
     PosixFd* N = &__Tab__->Entries[NewFd];
@@ -284,23 +284,23 @@ PosixDup(PosixFdTable* __Tab__, int __Fd__)
         ((File*)N->Obj)->Refcnt++;
     }
     __Tab__->Count++;
-    ReleaseSpinLock(&__Tab__->Lock);
+    ReleaseMutex(&__Tab__->Lock);
     return NewFd;
 }
 
 int
 PosixDup2(PosixFdTable* __Tab__, int __OldFd__, int __NewFd__)
 {
-    AcquireSpinLock(&__Tab__->Lock);
+    AcquireMutex(&__Tab__->Lock);
     PosixFd* E = __GetEntry__(__Tab__, __OldFd__);
     if (!E || E->Fd < 0 || !__IsValidFd__(__Tab__, __NewFd__))
     {
-        ReleaseSpinLock(&__Tab__->Lock);
+        ReleaseMutex(&__Tab__->Lock);
         return -1;
     }
     if (__OldFd__ == __NewFd__)
     {
-        ReleaseSpinLock(&__Tab__->Lock);
+        ReleaseMutex(&__Tab__->Lock);
         return __NewFd__;
     }
     PosixFd* D = &__Tab__->Entries[__NewFd__];
@@ -309,7 +309,7 @@ PosixDup2(PosixFdTable* __Tab__, int __OldFd__, int __NewFd__)
         int rc = PosixClose(__Tab__, __NewFd__);
         if (rc != 0)
         {
-            ReleaseSpinLock(&__Tab__->Lock);
+            ReleaseMutex(&__Tab__->Lock);
             return -1;
         }
     }
@@ -321,19 +321,19 @@ PosixDup2(PosixFdTable* __Tab__, int __OldFd__, int __NewFd__)
         ((File*)D->Obj)->Refcnt++;
     }
     __Tab__->Count++;
-    ReleaseSpinLock(&__Tab__->Lock);
+    ReleaseMutex(&__Tab__->Lock);
     return __NewFd__;
 }
 
 int
 PosixPipe(PosixFdTable* __Tab__, int __Pipefd__[2])
 {
-    AcquireSpinLock(&__Tab__->Lock);
+    AcquireMutex(&__Tab__->Lock);
     int Rd = __FindFreeFd__(__Tab__, 0);
     int Wr = __FindFreeFd__(__Tab__, Rd + 1);
     if (Rd < 0 || Wr < 0)
     {
-        ReleaseSpinLock(&__Tab__->Lock);
+        ReleaseMutex(&__Tab__->Lock);
         return -1;
     }
     PosixPipeT* P = (PosixPipeT*)KMalloc(sizeof(PosixPipeT));
@@ -368,23 +368,23 @@ PosixPipe(PosixFdTable* __Tab__, int __Pipefd__[2])
     __Tab__->Count += 2;
     __Pipefd__[0] = Rd;
     __Pipefd__[1] = Wr;
-    ReleaseSpinLock(&__Tab__->Lock);
+    ReleaseMutex(&__Tab__->Lock);
     return 0;
 }
 
 int
 PosixFcntl(PosixFdTable* __Tab__, int __Fd__, int __Cmd__, long __Arg__ __attribute__((unused)))
 {
-    AcquireSpinLock(&__Tab__->Lock);
+    AcquireMutex(&__Tab__->Lock);
     PosixFd* E = __GetEntry__(__Tab__, __Fd__);
     if (!E || E->Fd < 0)
     {
-        ReleaseSpinLock(&__Tab__->Lock);
+        ReleaseMutex(&__Tab__->Lock);
         return -1;
     }
     if (__Cmd__ == 0)
     {
-        ReleaseSpinLock(&__Tab__->Lock);
+        ReleaseMutex(&__Tab__->Lock);
         return E->Flags;
     }
     if (__Cmd__ == 1)
@@ -392,7 +392,7 @@ PosixFcntl(PosixFdTable* __Tab__, int __Fd__, int __Cmd__, long __Arg__ __attrib
         int NewFd = __FindFreeFd__(__Tab__, 0);
         if (NewFd < 0)
         {
-            ReleaseSpinLock(&__Tab__->Lock);
+            ReleaseMutex(&__Tab__->Lock);
             return -1;
         }
         PosixFd* N = &__Tab__->Entries[NewFd];
@@ -404,25 +404,25 @@ PosixFcntl(PosixFdTable* __Tab__, int __Fd__, int __Cmd__, long __Arg__ __attrib
             ((File*)N->Obj)->Refcnt++;
         }
         __Tab__->Count++;
-        ReleaseSpinLock(&__Tab__->Lock);
+        ReleaseMutex(&__Tab__->Lock);
         return NewFd;
     }
-    ReleaseSpinLock(&__Tab__->Lock);
+    ReleaseMutex(&__Tab__->Lock);
     return -1;
 }
 
 int
 PosixIoctl(PosixFdTable* __Tab__, int __Fd__, unsigned long __Cmd__, void* __Arg__)
 {
-    AcquireSpinLock(&__Tab__->Lock);
+    AcquireMutex(&__Tab__->Lock);
     PosixFd* E = __GetEntry__(__Tab__, __Fd__);
     if (!E || E->Fd < 0 || !E->IsFile)
     {
-        ReleaseSpinLock(&__Tab__->Lock);
+        ReleaseMutex(&__Tab__->Lock);
         return -1;
     }
     int R = VfsIoctl((File*)E->Obj, __Cmd__, __Arg__);
-    ReleaseSpinLock(&__Tab__->Lock);
+    ReleaseMutex(&__Tab__->Lock);
     return R;
 }
 
@@ -441,15 +441,15 @@ PosixStatPath(const char* __Path__, VfsStat* __Out__)
 int
 PosixFstat(PosixFdTable* __Tab__, int __Fd__, VfsStat* __Out__)
 {
-    AcquireSpinLock(&__Tab__->Lock);
+    AcquireMutex(&__Tab__->Lock);
     PosixFd* E = __GetEntry__(__Tab__, __Fd__);
     if (!E || E->Fd < 0 || !E->IsFile)
     {
-        ReleaseSpinLock(&__Tab__->Lock);
+        ReleaseMutex(&__Tab__->Lock);
         return -1;
     }
     int R = VfsFstats((File*)E->Obj, __Out__);
-    ReleaseSpinLock(&__Tab__->Lock);
+    ReleaseMutex(&__Tab__->Lock);
     return R;
 }
 
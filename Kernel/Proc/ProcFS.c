@@ -56,6 +56,78 @@ __CurrentProc__(void)
     return Th ? PosixFind((long)Th->ProcessId) : NULL;
 }
 
+/*Generated kernel-wide files listed in the proc root after uptime/self; Write is optional*/
+typedef struct ProcRootFile
+{
+    const char* Name;
+    long (*Make)(char* __Buf__, long __Cap__);
+    long (*Write)(const char* __Buf__, long __Len__);
+} ProcRootFile;
+
+static const ProcRootFile __ProcRootFiles__[] = {
+    {"slabinfo", ProcFsMakeSlabInfo, 0},
+    {"kmalloc_sites", ProcFsMakeKmallocSites, 0},
+    {"meminfo", ProcFsMakeMemInfo, 0},
+    {"schedgroups", ProcFsMakeSchedGroups, 0},
+    {"softirqs", ProcFsMakeSoftirqs, 0},
+    {"lock_stat", ProcFsMakeLockStat, ProcFsWriteLockStat},
+};
+
+#define ProcRootFileCount ((long)(sizeof(__ProcRootFiles__) / sizeof(__ProcRootFiles__[0])))
+#define ProcRootGenCap    16384 /*Scratch size for one generated root file*/
+
+static inline const ProcRootFile*
+__ProcRootFileOf__(ProcFsNode* __Node__)
+{
+    const ProcRootFile* Rf = (const ProcRootFile*)__Node__->Priv;
+    if (Rf >= &__ProcRootFiles__[0] && Rf < &__ProcRootFiles__[ProcRootFileCount])
+    {
+        return Rf;
+    }
+    return NULL;
+}
+
+/*A root file rendered once per open; later reads and seeks walk the same text*/
+typedef struct ProcRootSnap
+{
+    long Len;
+    char Data[];
+} ProcRootSnap;
+
+static long
+__ProcReadRootFile__(const ProcRootFile* __Rf__, File* __File__, char* __Buf__, long __Cap__)
+{
+    ProcRootSnap* Snap = (ProcRootSnap*)__File__->Priv;
+
+    if (!Snap)
+    {
+        Snap = (ProcRootSnap*)KMalloc(sizeof(ProcRootSnap) + ProcRootGenCap);
+        if (!Snap)
+        {
+            return -1;
+        }
+
+        Snap->Len = __Rf__->Make(Snap->Data, ProcRootGenCap);
+        if (Snap->Len < 0)
+        {
+            KFree(Snap);
+            return -1;
+        }
+        __File__->Priv = Snap;
+    }
+
+    long Off = __File__->Offset;
+    long Got = 0;
+
+    if (Off >= 0 && Off < Snap->Len)
+    {
+        Got = __Min__(Snap->Len - Off, __Cap__);
+        __builtin_memcpy(__Buf__, Snap->Data + Off, (size_t)Got);
+    }
+
+    return Got;
+}
+
 int
 ProcFsNotifyProcAdded(PosixProc* __Proc__)
 {
@@ -76,13 +148,12 @@ ProcFsNotifyProcAdded(PosixProc* __Proc__)
     char Num[32];
     UnsignedToStringEx((uint64_t)__Proc__->Pid, Num, 10, 0);
 
-    ProcFsNode* D = (ProcFsNode*)KMalloc(sizeof(ProcFsNode));
+    ProcFsNode* D = (ProcFsNode*)KZalloc(sizeof(ProcFsNode));
     if (!D)
     {
         ReleaseSpinLock(&ProcPriv->Lock);
         return -1;
     }
-    memset(D, 0, sizeof(*D));
     D->Kind = ProcFsNodeDir;
     D->Name = (char*)KMalloc((uint32_t)(strlen(Num) + 1));
     if (!D->Name)
@@ -143,6 +214,11 @@ ProcOpen(Vnode* __Node__, File* __File__)
 int
 ProcClose(File* __File__)
 {
+    if (__File__ && __File__->Priv)
+    {
+        KFree(__File__->Priv);
+        __File__->Priv = NULL;
+    }
     return 0;
 }
 
@@ -173,6 +249,12 @@ ProcRead(File* __File__, void* __Buf__, long __Len__)
     {
         const char* Nm = Pn->Name;
 
+        const ProcRootFile* Rf = __ProcRootFileOf__(Pn);
+        if (Rf)
+        {
+            return __ProcReadRootFile__(Rf, __File__, Buf, Cap);
+        }
+
         if (strcmp(Nm, "uptime") == 0)
         {
             uint64_t ticks = GetSystemTicks();
@@ -318,6 +400,12 @@ ProcWrite(File* __File__, const void* __Buf__, long __Len__)
     const char* Nm  = Pn->Name;
     const char* Src = (const char*)__Buf__;
 
+    const ProcRootFile* Rf = __ProcRootFileOf__(Pn);
+    if (Rf)
+    {
+        return Rf->Write ? Rf->Write(Src, __Len__) : -1;
+    }
+
     if (strcmp(Nm, "state") == 0)
     {
         PosixProc* Pr = (PosixProc*)Pn->Priv;
@@ -497,7 +585,16 @@ ProcReaddir(Vnode* __Node__, void* __Buf__, long __Len__)
             return sizeof(VfsDirEnt);
         }
 
-        long ListIdx = Base - 2;
+        if (Base >= 2 && Base < 2 + ProcRootFileCount)
+        {
+            StringCopy(Ent->Name, __ProcRootFiles__[Base - 2].Name, 256);
+            Ent->Type = VNodeFILE;
+            Ent->Ino  = Pn->Ino + 1 + Base;
+            __AdvanceCursor__(Cur);
+            return sizeof(VfsDirEnt);
+        }
+
+        long ListIdx = Base - 2 - ProcRootFileCount;
         long Seen    = 0;
 
         for (long pid = 1; pid < ProcMaxPIDS; pid++)
@@ -526,21 +623,26 @@ ProcReaddir(Vnode* __Node__, void* __Buf__, long __Len__)
             return sizeof(VfsDirEnt);
         }
 
+        /*Only the pid is taken out; the process may be reaped once the section ends*/
         long FallbackIdx = ListIdx - Seen;
-        long Count       = PosixProcs.Count;
-        if (FallbackIdx >= 0 && FallbackIdx < Count)
+        long Pid         = 0;
+        RcuReadLock();
+        if (FallbackIdx >= 0 && FallbackIdx < __atomic_load_n(&PosixProcs.Count, __ATOMIC_ACQUIRE))
         {
-            PosixProc* Pr = PosixProcs.Items[FallbackIdx];
-            if (Pr)
-            {
-                char Num[32];
-                UnsignedToStringEx((uint64_t)Pr->Pid, Num, 10, 0);
-                StringCopy(Ent->Name, Num, 256);
-                Ent->Type = VNodeDIR;
-                Ent->Ino  = Pn->Ino + 100 + (long)Pr->Pid;
-                __AdvanceCursor__(Cur);
-                return sizeof(VfsDirEnt);
-            }
+            PosixProc* Pr = RcuDereference(PosixProcs.Items[FallbackIdx]);
+            Pid           = Pr ? Pr->Pid : 0;
+        }
+        RcuReadUnlock();
+
+        if (Pid > 0)
+        {
+            char Num[32];
+            UnsignedToStringEx((uint64_t)Pid, Num, 10, 0);
+            StringCopy(Ent->Name, Num, 256);
+            Ent->Type = VNodeDIR;
+            Ent->Ino  = Pn->Ino + 100 + Pid;
+            __AdvanceCursor__(Cur);
+            return sizeof(VfsDirEnt);
         }
         __ResetCursor__(Cur);
         return 0;
@@ -659,23 +761,21 @@ ProcLookup(Vnode* __Dir__, const char* __Name__)
     {
         if (strcmp(__Name__, "uptime") == 0)
         {
-            ProcFsNode* F = (ProcFsNode*)KMalloc(sizeof(ProcFsNode));
+            ProcFsNode* F = (ProcFsNode*)KZalloc(sizeof(ProcFsNode));
             if (!F)
             {
                 return NULL;
             }
-            memset(F, 0, sizeof(*F));
             F->Kind      = ProcFsNodeFile;
             F->Name      = "uptime";
             F->Ino       = Pn->Ino + 1;
             F->Perm.Mode = VModeRUSR | VModeRGRP | VModeROTH;
 
-            Vnode* N = (Vnode*)KMalloc(sizeof(Vnode));
+            Vnode* N = (Vnode*)KZalloc(sizeof(Vnode));
             if (!N)
             {
                 return NULL;
             }
-            memset(N, 0, sizeof(*N));
             N->Type   = VNodeFILE;
             N->Ops    = &__ProcFsOps__;
             N->Sb     = ProcSuper;
@@ -686,23 +786,57 @@ ProcLookup(Vnode* __Dir__, const char* __Name__)
 
         if (strcmp(__Name__, "self") == 0)
         {
-            ProcFsNode* F = (ProcFsNode*)KMalloc(sizeof(ProcFsNode));
+            ProcFsNode* F = (ProcFsNode*)KZalloc(sizeof(ProcFsNode));
             if (!F)
             {
                 return NULL;
             }
-            memset(F, 0, sizeof(*F));
             F->Kind      = ProcFsNodeFile;
             F->Name      = "self";
             F->Ino       = Pn->Ino + 2;
             F->Perm.Mode = VModeRUSR | VModeRGRP | VModeROTH;
 
-            Vnode* N = (Vnode*)KMalloc(sizeof(Vnode));
+            Vnode* N = (Vnode*)KZalloc(sizeof(Vnode));
+            if (!N)
+            {
+                return NULL;
+            }
+            N->Type   = VNodeFILE;
+            N->Ops    = &__ProcFsOps__;
+            N->Sb     = ProcSuper;
+            N->Priv   = F;
+            N->Refcnt = 1;
+            return N;
+        }
+
+        for (long RIdx = 0; RIdx < ProcRootFileCount; RIdx++)
+        {
+            if (strcmp(__Name__, __ProcRootFiles__[RIdx].Name) != 0)
+            {
+                continue;
+            }
+
+            ProcFsNode* F = (ProcFsNode*)KZalloc(sizeof(ProcFsNode));
+            if (!F)
+            {
+                return NULL;
+            }
+            F->Kind      = ProcFsNodeFile;
+            F->Name      = (char*)__ProcRootFiles__[RIdx].Name;
+            F->Ino       = Pn->Ino + 3 + RIdx;
+            F->Perm.Mode = VModeRUSR | VModeRGRP | VModeROTH;
+            F->Priv      = (void*)&__ProcRootFiles__[RIdx];
+            if (__ProcRootFiles__[RIdx].Write)
+            {
+                F->Perm.Mode |= VModeWUSR;
+            }
+
+            Vnode* N = (Vnode*)KZalloc(sizeof(Vnode));
             if (!N)
             {
+                KFree(F);
                 return NULL;
             }
-            memset(N, 0, sizeof(*N));
             N->Type   = VNodeFILE;
             N->Ops    = &__ProcFsOps__;
             N->Sb     = ProcSuper;
@@ -721,12 +855,11 @@ ProcLookup(Vnode* __Dir__, const char* __Name__)
 
             if (D && D->Priv)
             {
-                Vnode* N = (Vnode*)KMalloc(sizeof(Vnode));
+                Vnode* N = (Vnode*)KZalloc(sizeof(Vnode));
                 if (!N)
                 {
                     return NULL;
                 }
-                memset(N, 0, sizeof(*N));
                 N->Type   = VNodeDIR;
                 N->Ops    = &__ProcFsOps__;
                 N->Sb     = ProcSuper;
@@ -736,51 +869,45 @@ ProcLookup(Vnode* __Dir__, const char* __Name__)
             }
         }
 
-        for (long I = 0; I < PosixProcs.Count; I++)
+        /*Pids outside the cache; only the canonical spelling names a process*/
+        PosixProc* Pr = PosixFind(pid);
+        char       Num[32];
+        if (Pr)
         {
-            PosixProc* Pr = PosixProcs.Items[I];
-            if (!Pr)
+            UnsignedToStringEx((uint64_t)Pr->Pid, Num, 10, 0);
+        }
+        if (Pr && strcmp(__Name__, Num) == 0)
+        {
+            ProcFsNode* D = (ProcFsNode*)KZalloc(sizeof(ProcFsNode));
+            if (!D)
             {
-                continue;
+                return NULL;
             }
-            char Num[32];
-            UnsignedToStringEx((uint64_t)Pr->Pid, Num, 10, 0);
-            if (strcmp(__Name__, Num) == 0)
+            D->Kind = ProcFsNodeDir;
+            D->Name = (char*)KMalloc(32);
+            if (!D->Name)
             {
-                ProcFsNode* D = (ProcFsNode*)KMalloc(sizeof(ProcFsNode));
-                if (!D)
-                {
-                    return NULL;
-                }
-                memset(D, 0, sizeof(*D));
-                D->Kind = ProcFsNodeDir;
-                D->Name = (char*)KMalloc(32);
-                if (!D->Name)
-                {
-                    KFree(D);
-                    return NULL;
-                }
-                StringCopy(D->Name, Num, 32);
-                D->Ino = Pn->Ino + 100 + (long)Pr->Pid;
-                D->Perm.Mode =
-                    VModeRUSR | VModeRGRP | VModeROTH | VModeXUSR | VModeXGRP | VModeXOTH;
-                D->Priv = (void*)Pr;
+                KFree(D);
+                return NULL;
+            }
+            StringCopy(D->Name, Num, 32);
+            D->Ino       = Pn->Ino + 100 + (long)Pr->Pid;
+            D->Perm.Mode = VModeRUSR | VModeRGRP | VModeROTH | VModeXUSR | VModeXGRP | VModeXOTH;
+            D->Priv      = (void*)Pr;
 
-                Vnode* N = (Vnode*)KMalloc(sizeof(Vnode));
-                if (!N)
-                {
-                    KFree(D->Name);
-                    KFree(D);
-                    return NULL;
-                }
-                memset(N, 0, sizeof(*N));
-                N->Type   = VNodeDIR;
-                N->Ops    = &__ProcFsOps__;
-                N->Sb     = ProcSuper;
-                N->Priv   = D;
-                N->Refcnt = 1;
-                return N;
+            Vnode* N = (Vnode*)KZalloc(sizeof(Vnode));
+            if (!N)
+            {
+                KFree(D->Name);
+                KFree(D);
+                return NULL;
             }
+            N->Type   = VNodeDIR;
+            N->Ops    = &__ProcFsOps__;
+            N->Sb     = ProcSuper;
+            N->Priv   = D;
+            N->Refcnt = 1;
+            return N;
         }
         return NULL;
     }
@@ -806,12 +933,11 @@ ProcLookup(Vnode* __Dir__, const char* __Name__)
         {
             if (strcmp(__Name__, Fn[KIdx]) == 0)
             {
-                ProcFsNode* F = (ProcFsNode*)KMalloc(sizeof(ProcFsNode));
+                ProcFsNode* F = (ProcFsNode*)KZalloc(sizeof(ProcFsNode));
                 if (!F)
                 {
                     return NULL;
                 }
-                memset(F, 0, sizeof(*F));
                 F->Kind = ProcFsNodeFile;
                 F->Name = (char*)KMalloc((uint32_t)(strlen(Fn[KIdx]) + 1));
                 if (F->Name)
@@ -826,7 +952,7 @@ ProcLookup(Vnode* __Dir__, const char* __Name__)
                 }
                 F->Priv = (void*)Pr;
 
-                Vnode* N = (Vnode*)KMalloc(sizeof(Vnode));
+                Vnode* N = (Vnode*)KZalloc(sizeof(Vnode));
                 if (!N)
                 {
                     if (F->Name)
@@ -836,7 +962,6 @@ ProcLookup(Vnode* __Dir__, const char* __Name__)
                     KFree(F);
                     return NULL;
                 }
-                memset(N, 0, sizeof(*N));
                 N->Type   = VNodeFILE;
                 N->Ops    = &__ProcFsOps__;
                 N->Sb     = ProcSuper;
@@ -985,12 +1110,11 @@ const SuperOps __ProcFsSuperOps__ = {
 int
 ProcFsInit(void)
 {
-    ProcPriv = (ProcFsPriv*)KMalloc(sizeof(ProcFsPriv));
+    ProcPriv = (ProcFsPriv*)KZalloc(sizeof(ProcFsPriv));
     if (!ProcPriv)
     {
         return -1;
     }
-    memset(ProcPriv, 0, sizeof(*ProcPriv));
     InitializeSpinLock(&ProcPriv->Lock, "procfs");
 
     memset(__ProcPidCache__, 0, sizeof(__ProcPidCache__));
@@ -1010,34 +1134,31 @@ ProcFsInit(void)
 Superblock*
 ProcFsMountImpl(const char* __Dev__, const char* __Opts__)
 {
-    ProcSuper = (Superblock*)KMalloc(sizeof(Superblock));
+    ProcSuper = (Superblock*)KZalloc(sizeof(Superblock));
     if (!ProcSuper)
     {
         return NULL;
     }
-    memset(ProcSuper, 0, sizeof(*ProcSuper));
     ProcSuper->Type  = NULL;
     ProcSuper->Dev   = NULL;
     ProcSuper->Flags = 0;
     ProcSuper->Ops   = &__ProcFsSuperOps__;
 
-    ProcFsNode* Root = (ProcFsNode*)KMalloc(sizeof(ProcFsNode));
+    ProcFsNode* Root = (ProcFsNode*)KZalloc(sizeof(ProcFsNode));
     if (!Root)
     {
         return NULL;
     }
-    memset(Root, 0, sizeof(*Root));
     Root->Kind      = ProcFsNodeDir;
     Root->Name      = "";
     Root->Ino       = 1;
     Root->Perm.Mode = VModeRUSR | VModeRGRP | VModeROTH | VModeXUSR | VModeXGRP | VModeXOTH;
 
-    Vnode* RootV = (Vnode*)KMalloc(sizeof(Vnode));
+    Vnode* RootV = (Vnode*)KZalloc(sizeof(Vnode));
     if (!RootV)
     {
         return NULL;
     }
-    memset(RootV, 0, sizeof(*RootV));
     RootV->Type   = VNodeDIR;
     RootV->Ops    = &__ProcFsOps__;
     RootV->Sb     = ProcSuper;
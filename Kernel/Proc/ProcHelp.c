@@ -1,10 +1,15 @@
 #include <AllTypes.h>
+#include <AxeSchd.h>
 #include <KHeap.h>
 #include <KrnPrintf.h>
 #include <POSIXFd.h>
 #include <POSIXProc.h>
 #include <POSIXSignals.h>
+#include <SMP.h>
+#include <Softirq.h>
 #include <String.h>
+#include <Timer.h>
+#include <Tsc.h>
 
 static inline long
 __AppendStr__(char* __Buf__, long __Cap__, long* __Off__, const char* __Str__)
@@ -124,6 +129,8 @@ ProcFsMakeStatus(PosixProc* __Proc__, char* __Buff__, long __Caps__)
     long N  = 0;
     char St = __ProcStateCode__(__Proc__);
 
+    PosixRefreshTimes(__Proc__);
+
     __AppendStr__(__Buff__, __Caps__, &N, "Name:\t");
     PDebug("Status Name N=%ld", N);
     __AppendStr__(__Buff__, __Caps__, &N, (__Proc__->Comm[0] ? __Proc__->Comm : "NA"));
@@ -218,6 +225,15 @@ ProcFsMakeStatus(PosixProc* __Proc__, char* __Buff__, long __Caps__)
     __AppendChar__(__Buff__, __Caps__, &N, '\n');
     PDebug("Status Stime N=%ld", N);
 
+    static const char* AcctLabels[AcctModes] = {
+        "UserNs:\t", "SysNs:\t", "IrqNs:\t", "WaitNs:\t"};
+    for (uint32_t Mode = 0; Mode < AcctModes; Mode++)
+    {
+        __AppendStr__(__Buff__, __Caps__, &N, AcctLabels[Mode]);
+        __AppendU64Dec__(__Buff__, __Caps__, &N, __Proc__->Times.Ns[Mode]);
+        __AppendChar__(__Buff__, __Caps__, &N, '\n');
+    }
+
     __AppendStr__(__Buff__, __Caps__, &N, "StartTick:\t");
     __AppendU64Dec__(__Buff__, __Caps__, &N, __Proc__->Times.StartTick);
     __AppendChar__(__Buff__, __Caps__, &N, '\n');
@@ -263,6 +279,8 @@ ProcFsMakeStat(PosixProc* __Proc__, char* __Buf__, long __Cap__)
         return -1;
     }
 
+    PosixRefreshTimes(__Proc__);
+
     long N  = 0;
     char St = __ProcStateCode__(__Proc__);
     char Num[64];
@@ -310,7 +328,8 @@ ProcFsMakeStat(PosixProc* __Proc__, char* __Buf__, long __Cap__)
     PDebug("stat: starttime N=%ld", N);
 
     __AppendField__(__Buf__, __Cap__, &N, "0");
-    __AppendField__(__Buf__, __Cap__, &N, "0");
+    UnsignedToStringEx(VmmCountUserPages(__Proc__->Space), Num, 10, 0);
+    __AppendField__(__Buf__, __Cap__, &N, Num);
     PDebug("stat: vsize/rss N=%ld", N);
 
     __AppendChar__(__Buf__, __Cap__, &N, '\n');
@@ -443,4 +462,371 @@ ProcFsWriteSignal(PosixProc* __Proc__, const char* __Buf__, long __Len__)
         return PosixKill(__Proc__->Pid, SigCont) == 0 ? __Len__ : -1;
     }
     return -1;
-}
\ No newline at end of file
+}
+static inline void
+__AppendMemLine__(char* __Buf__, long __Cap__, long* __Off__, const char* __Key__, uint64_t __Pages__)
+{
+    __AppendStr__(__Buf__, __Cap__, __Off__, __Key__);
+    __AppendStr__(__Buf__, __Cap__, __Off__, ":\t");
+    __AppendU64Dec__(__Buf__, __Cap__, __Off__, (__Pages__ * PageSize) / 1024);
+    __AppendStr__(__Buf__, __Cap__, __Off__, " kB\n");
+}
+
+long
+ProcFsMakeMemInfo(char* __Buf__, long __Cap__)
+{
+    if (!__Buf__ || __Cap__ <= 0)
+    {
+        PError("ProcFsMakeMemInfo: bad args\n");
+        return -1;
+    }
+
+    static const char* const OwnerNames[PageOwnerCount] = {"Free",
+                                                           "Reserved",
+                                                           "Kernel",
+                                                           "Bootloader",
+                                                           "PageTables",
+                                                           "Slab",
+                                                           "KHeapLarge",
+                                                           "AnonPages",
+                                                           "PageCache",
+                                                           "KernelStack"};
+
+    long     N     = 0;
+    uint64_t Total = Pmm.Stats.FreePages;
+    for (uint32_t I = PageOwnerKernel; I < PageOwnerCount; I++)
+    {
+        Total += Pmm.Stats.OwnerPages[I];
+    }
+
+    __AppendMemLine__(__Buf__, __Cap__, &N, "MemTotal", Total);
+    __AppendMemLine__(__Buf__, __Cap__, &N, "MemFree", Pmm.Stats.FreePages);
+    __AppendMemLine__(__Buf__, __Cap__, &N, "MemUsed", Total - Pmm.Stats.FreePages);
+    __AppendMemLine__(__Buf__, __Cap__, &N, "Reclaimed", Pmm.Stats.ReclaimedPages);
+
+    /*Breakdown by frame owner; Reserved is not part of MemTotal*/
+    for (uint32_t I = PageOwnerReserved; I < PageOwnerCount; I++)
+    {
+        __AppendMemLine__(__Buf__, __Cap__, &N, OwnerNames[I], Pmm.Stats.OwnerPages[I]);
+    }
+
+    /*Memory pressure*/
+    __AppendMemLine__(__Buf__, __Cap__, &N, "LowWatermark", Pmm.LowWatermark);
+    __AppendMemLine__(__Buf__, __Cap__, &N, "Shrunk", Pmm.Stats.ShrunkPages);
+    __AppendStr__(__Buf__, __Cap__, &N, "ShrinkRuns:\t");
+    __AppendU64Dec__(__Buf__, __Cap__, &N, Pmm.Stats.ShrinkRuns);
+    __AppendStr__(__Buf__, __Cap__, &N, "\nOomKills:\t");
+    __AppendU64Dec__(__Buf__, __Cap__, &N, Pmm.Stats.OomKills);
+    __AppendChar__(__Buf__, __Cap__, &N, '\n');
+
+    return N;
+}
+
+/*Snapshot of the previous /proc/slabinfo read, used for the per-second rates*/
+static uint64_t __SlabSnapAllocs__[MaxSlabSizes];
+static uint64_t __SlabSnapFrees__[MaxSlabSizes];
+static uint64_t __SlabSnapTick__;
+
+static inline uint64_t
+__RatePerSec__(uint64_t __Now__, uint64_t __Then__, uint64_t __Ms__)
+{
+    if (!__Ms__ || __Now__ < __Then__)
+    {
+        return 0;
+    }
+    return ((__Now__ - __Then__) * 1000) / __Ms__;
+}
+
+long
+ProcFsMakeSlabInfo(char* __Buf__, long __Cap__)
+{
+    if (!__Buf__ || __Cap__ <= 0)
+    {
+        PError("ProcFsMakeSlabInfo: bad args\n");
+        return -1;
+    }
+
+    long     N   = 0;
+    uint64_t Now = GetSystemTicks(); /* 1 tick = 1ms */
+    uint64_t Ms  = Now - __SlabSnapTick__;
+
+    __AppendStr__(__Buf__, __Cap__, &N, "slabinfo - version: 2.1\n");
+    __AppendStr__(__Buf__,
+                  __Cap__,
+                  &N,
+                  "# name active_objs num_objs objsize objperslab num_slabs"
+                  " allocs frees allocs/s frees/s\n");
+
+    for (uint32_t I = 0; I < KHeap.CacheCount; I++)
+    {
+        SlabCache* C      = &KHeap.Caches[I];
+        uint64_t   Allocs = C->AllocCount;
+        uint64_t   Frees  = C->FreeCount;
+
+        __AppendStr__(__Buf__, __Cap__, &N, "kmalloc-");
+        __AppendU64Dec__(__Buf__, __Cap__, &N, C->ObjectSize);
+        __AppendChar__(__Buf__, __Cap__, &N, ' ');
+        __AppendU64Dec__(__Buf__, __Cap__, &N, C->ActiveObjects);
+        __AppendChar__(__Buf__, __Cap__, &N, ' ');
+        __AppendU64Dec__(__Buf__, __Cap__, &N, C->TotalObjects);
+        __AppendChar__(__Buf__, __Cap__, &N, ' ');
+        __AppendU64Dec__(__Buf__, __Cap__, &N, C->ObjectSize);
+        __AppendChar__(__Buf__, __Cap__, &N, ' ');
+        __AppendU64Dec__(__Buf__, __Cap__, &N, C->ObjectsPerSlab);
+        __AppendChar__(__Buf__, __Cap__, &N, ' ');
+        __AppendU64Dec__(__Buf__, __Cap__, &N, C->SlabCount);
+        __AppendChar__(__Buf__, __Cap__, &N, ' ');
+        __AppendU64Dec__(__Buf__, __Cap__, &N, Allocs);
+        __AppendChar__(__Buf__, __Cap__, &N, ' ');
+        __AppendU64Dec__(__Buf__, __Cap__, &N, Frees);
+        __AppendChar__(__Buf__, __Cap__, &N, ' ');
+        __AppendU64Dec__(__Buf__, __Cap__, &N, __RatePerSec__(Allocs, __SlabSnapAllocs__[I], Ms));
+        __AppendChar__(__Buf__, __Cap__, &N, ' ');
+        __AppendU64Dec__(__Buf__, __Cap__, &N, __RatePerSec__(Frees, __SlabSnapFrees__[I], Ms));
+        __AppendChar__(__Buf__, __Cap__, &N, '\n');
+
+        __SlabSnapAllocs__[I] = Allocs;
+        __SlabSnapFrees__[I]  = Frees;
+    }
+    __SlabSnapTick__ = Now;
+
+    /*Page-backed allocations above the largest slab*/
+    __AppendStr__(__Buf__, __Cap__, &N, "# large allocs frees pages\nkmalloc-large ");
+    __AppendU64Dec__(__Buf__, __Cap__, &N, KHeap.LargeAllocCount);
+    __AppendChar__(__Buf__, __Cap__, &N, ' ');
+    __AppendU64Dec__(__Buf__, __Cap__, &N, KHeap.LargeFreeCount);
+    __AppendChar__(__Buf__, __Cap__, &N, ' ');
+    __AppendU64Dec__(__Buf__, __Cap__, &N, KHeap.LargePages);
+    __AppendChar__(__Buf__, __Cap__, &N, '\n');
+
+    return N;
+}
+
+long
+ProcFsMakeKmallocSites(char* __Buf__, long __Cap__)
+{
+    if (!__Buf__ || __Cap__ <= 0)
+    {
+        PError("ProcFsMakeKmallocSites: bad args\n");
+        return -1;
+    }
+
+    long N = 0;
+
+#ifdef KHeapTrackSites
+    /*Order sites by outstanding bytes, biggest first*/
+    uint16_t Order[KHeapMaxSites];
+    uint32_t Count = KHeapSiteCount;
+    for (uint32_t I = 0; I < Count; I++)
+    {
+        uint32_t J = I;
+        while (J > 0 && KHeapSites[Order[J - 1]].LiveBytes < KHeapSites[I].LiveBytes)
+        {
+            Order[J] = Order[J - 1];
+            J--;
+        }
+        Order[J] = (uint16_t)I;
+    }
+
+    __AppendStr__(__Buf__, __Cap__, &N, "# site live_bytes allocs frees\n");
+    for (uint32_t I = 0; I < Count; I++)
+    {
+        KHeapSite* S = &KHeapSites[Order[I]];
+
+        __AppendStr__(__Buf__, __Cap__, &N, "0x");
+        __AppendU64Hex__(__Buf__, __Cap__, &N, S->Site);
+        __AppendChar__(__Buf__, __Cap__, &N, ' ');
+        __AppendU64Dec__(__Buf__, __Cap__, &N, S->LiveBytes);
+        __AppendChar__(__Buf__, __Cap__, &N, ' ');
+        __AppendU64Dec__(__Buf__, __Cap__, &N, S->Allocs);
+        __AppendChar__(__Buf__, __Cap__, &N, ' ');
+        __AppendU64Dec__(__Buf__, __Cap__, &N, S->Frees);
+        __AppendChar__(__Buf__, __Cap__, &N, '\n');
+    }
+
+    __AppendStr__(__Buf__, __Cap__, &N, "# untracked ");
+    __AppendU64Dec__(__Buf__, __Cap__, &N, KHeapUntracked);
+    __AppendChar__(__Buf__, __Cap__, &N, '\n');
+#else
+    __AppendStr__(__Buf__, __Cap__, &N, "# callsite tracking disabled, build with KHeapTrackSites\n");
+#endif
+
+    return N;
+}
+
+long
+ProcFsMakeSchedGroups(char* __Buf__, long __Cap__)
+{
+    if (!__Buf__ || __Cap__ <= 0)
+    {
+        PError("ProcFsMakeSchedGroups: bad args\n");
+        return -1;
+    }
+
+    long N = 0;
+    __AppendStr__(__Buf__,
+                  __Cap__,
+                  &N,
+                  "id parent name shares quota period members queued usage throttled passed\n");
+
+    for (uint32_t Id = 0; Id < MaxSchedGroups; Id++)
+    {
+        SchedGroup* Group = &SchedGroups[Id];
+        if (!Group->InUse)
+        {
+            continue;
+        }
+
+        const uint64_t Fields[] = {Group->Shares,
+                                   Group->QuotaTicks,
+                                   Group->PeriodTicks,
+                                   Group->Members,
+                                   Group->Queued,
+                                   Group->Usage,
+                                   Group->Throttled,
+                                   Group->ThrottledPicks};
+
+        __AppendU64Dec__(__Buf__, __Cap__, &N, Id);
+        __AppendChar__(__Buf__, __Cap__, &N, ' ');
+        __AppendU64Dec__(__Buf__, __Cap__, &N, Group->Parent);
+        __AppendChar__(__Buf__, __Cap__, &N, ' ');
+        __AppendStr__(__Buf__, __Cap__, &N, Group->Name);
+        for (uint32_t F = 0; F < sizeof(Fields) / sizeof(Fields[0]); F++)
+        {
+            __AppendChar__(__Buf__, __Cap__, &N, ' ');
+            __AppendU64Dec__(__Buf__, __Cap__, &N, Fields[F]);
+        }
+        __AppendChar__(__Buf__, __Cap__, &N, '\n');
+    }
+
+    return N;
+}
+
+long
+ProcFsMakeSoftirqs(char* __Buf__, long __Cap__)
+{
+    if (!__Buf__ || __Cap__ <= 0)
+    {
+        PError("ProcFsMakeSoftirqs: bad args\n");
+        return -1;
+    }
+
+    long N = 0;
+    __AppendStr__(__Buf__, __Cap__, &N, "vector");
+    for (uint32_t CpuIndex = 0; CpuIndex < Smp.CpuCount; CpuIndex++)
+    {
+        __AppendStr__(__Buf__, __Cap__, &N, " cpu");
+        __AppendU64Dec__(__Buf__, __Cap__, &N, CpuIndex);
+    }
+    __AppendChar__(__Buf__, __Cap__, &N, '\n');
+
+    for (uint32_t Nr = 0; Nr < SoftirqCount; Nr++)
+    {
+        if (!SoftirqVectors[Nr].Handler)
+        {
+            continue;
+        }
+
+        __AppendStr__(__Buf__, __Cap__, &N, SoftirqVectors[Nr].Name);
+        for (uint32_t CpuIndex = 0; CpuIndex < Smp.CpuCount; CpuIndex++)
+        {
+            __AppendChar__(__Buf__, __Cap__, &N, ' ');
+            __AppendU64Dec__(__Buf__, __Cap__, &N, Softirqs[CpuIndex].Runs[Nr]);
+        }
+        __AppendChar__(__Buf__, __Cap__, &N, '\n');
+    }
+
+    /*Exits that ran out of budget and woke ksoftirqd*/
+    __AppendStr__(__Buf__, __Cap__, &N, "deferred");
+    for (uint32_t CpuIndex = 0; CpuIndex < Smp.CpuCount; CpuIndex++)
+    {
+        __AppendChar__(__Buf__, __Cap__, &N, ' ');
+        __AppendU64Dec__(__Buf__, __Cap__, &N, Softirqs[CpuIndex].Deferred);
+    }
+    __AppendChar__(__Buf__, __Cap__, &N, '\n');
+
+    return N;
+}
+
+long
+ProcFsMakeLockStat(char* __Buf__, long __Cap__)
+{
+    if (!__Buf__ || __Cap__ <= 0)
+    {
+        PError("ProcFsMakeLockStat: bad args\n");
+        return -1;
+    }
+
+    long N = 0;
+
+#ifdef SyncLockStat
+    /*Most time lost waiting first*/
+    uint16_t Order[LockStatMaxClasses];
+    uint32_t Count = __atomic_load_n(&LockClassCount, __ATOMIC_ACQUIRE);
+    for (uint32_t I = 0; I < Count; I++)
+    {
+        uint32_t J = I;
+        while (J > 0 && LockClasses[Order[J - 1]].WaitTotal < LockClasses[I].WaitTotal)
+        {
+            Order[J] = Order[J - 1];
+            J--;
+        }
+        Order[J] = (uint16_t)I;
+    }
+
+    __AppendStr__(__Buf__,
+                  __Cap__,
+                  &N,
+                  "# class type acquisitions contentions wait_total_ns wait_max_ns "
+                  "hold_total_ns hold_max_ns\n");
+    for (uint32_t I = 0; I < Count; I++)
+    {
+        LockClass* Class = &LockClasses[Order[I]];
+        if (!Class->Acquisitions)
+        {
+            continue;
+        }
+
+        const uint64_t Fields[] = {Class->Acquisitions,
+                                   Class->Contentions,
+                                   TscToNs(Class->WaitTotal),
+                                   TscToNs(Class->WaitMax),
+                                   TscToNs(Class->HoldTotal),
+                                   TscToNs(Class->HoldMax)};
+
+        __AppendStr__(__Buf__, __Cap__, &N, Class->Name);
+        __AppendStr__(__Buf__, __Cap__, &N, Class->Kind == LockClassMutex ? " mutex" : " spin");
+        for (uint32_t F = 0; F < sizeof(Fields) / sizeof(Fields[0]); F++)
+        {
+            __AppendChar__(__Buf__, __Cap__, &N, ' ');
+            __AppendU64Dec__(__Buf__, __Cap__, &N, Fields[F]);
+        }
+        __AppendChar__(__Buf__, __Cap__, &N, '\n');
+    }
+
+    __AppendStr__(__Buf__, __Cap__, &N, "# untracked ");
+    __AppendU64Dec__(__Buf__, __Cap__, &N, LockStatUntracked);
+    __AppendChar__(__Buf__, __Cap__, &N, '\n');
+#else
+    __AppendStr__(__Buf__, __Cap__, &N, "# lock statistics disabled, build with SyncLockStat\n");
+#endif
+
+    return N;
+}
+
+/*Writing 0 clears every class*/
+long
+ProcFsWriteLockStat(const char* __Buf__, long __Len__)
+{
+    if (!__Buf__ || __Len__ <= 0 || __Buf__[0] != '0')
+    {
+        return -1;
+    }
+
+#ifdef SyncLockStat
+    LockStatReset();
+    return __Len__;
+#else
+    return -1;
+#endif
+}
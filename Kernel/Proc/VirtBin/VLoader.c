@@ -41,6 +41,7 @@ VirtMapRangeZeroed(VirtualMemorySpace* __Space__,
     {
         return -1;
     }
+    PmmSetFrameOwner(Phys, Pages, PageOwnerUser);
 
     uint64_t Va   = __VaStart__;
     uint64_t Pcur = Phys;
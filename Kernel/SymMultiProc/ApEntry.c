@@ -6,43 +6,13 @@
 #include <Timer.h> /* Timer management interfaces */
 #include <VMM.h>   /* Virtual Memory Management functions */
 
-void
-ApEntryPoint(struct limine_smp_info* __CpuInfo__)
+/*Runs on the stack the BSP allocated; per-CPU init happens on all APs at once*/
+static __attribute__((used)) noreturn void
+__ApMain__(uint32_t __CpuNumber__, uint64_t __StackTop__)
 {
-    uint32_t CpuNumber = 0;
-    for (uint32_t Index = 0; Index < Smp.CpuCount; Index++)
-    {
-        if (Smp.Cpus[Index].ApicId == __CpuInfo__->lapic_id)
-        {
-            CpuNumber = Index;
-            break;
-        }
-    }
-
-    Smp.Cpus[CpuNumber].Status  = CPU_STATUS_ONLINE;
-    Smp.Cpus[CpuNumber].Started = 1; /* Boolean flag indicating startup completion */
-
-    __atomic_fetch_add(&CpuStartupCount, 1, __ATOMIC_SEQ_CST);
-    __atomic_fetch_add(&Smp.OnlineCpus, 1, __ATOMIC_SEQ_CST);
-
-    uint64_t CpuStackPhys = AllocPages(SMPCPUStackSize / 0x1000);
-    if (!CpuStackPhys)
-    {
-        PError("AP: Failed to allocate stack for CPU %u\n", CpuNumber);
-        while (1)
-        {
-            __asm__("hlt"); /* Infinite loop of shame; CPU cannot proceed */
-        }
-    }
+    PDebug("AP: CPU %u online with stack at 0x%016lx\n", __CpuNumber__, __StackTop__);
 
-    void* CpuStack = PhysToVirt(CpuStackPhys);
-
-    uint64_t NewStackTop = (uint64_t)CpuStack + SMPCPUStackSize - 16;
-    __asm__ volatile("movq %0, %%rsp" : : "r"(NewStackTop));
-
-    PInfo("AP: CPU %u online with stack at 0x%016lx\n", CpuNumber, NewStackTop);
-
-    PerCpuInterruptInit(CpuNumber, NewStackTop);
+    PerCpuInterruptInit(__CpuNumber__, __StackTop__);
 
     unsigned long Cr0, Cr4;
 
@@ -63,11 +33,14 @@ ApEntryPoint(struct limine_smp_info* __CpuInfo__)
     /* Initialize x87/SSE state */
     __asm__ volatile("fninit");
 
+    /* Programs the local timer from the BSP's calibration, no measuring here */
     SetupApicTimerForThisCpu();
 
-    InitializeCpuScheduler(CpuNumber);
+    /* CPUID describes only the CPU executing it, so each AP records its own place */
+    DetectCpuTopology(__CpuNumber__);
 
-    SetIdtEntry(0x80, (uint64_t)SysEntASM, KernelCodeSelector, 0xEE);
+    /* Wait for the BSP to finish the shared scheduler state before taking ticks */
+    SmpApRendezvous(__CpuNumber__);
 
     __asm__ volatile("sti");
 
@@ -76,3 +49,27 @@ ApEntryPoint(struct limine_smp_info* __CpuInfo__)
         __asm__ volatile("hlt");
     }
 }
+
+void
+ApEntryPoint(struct limine_smp_info* __CpuInfo__)
+{
+    uint32_t CpuNumber = 0;
+    for (uint32_t Index = 0; Index < Smp.CpuCount; Index++)
+    {
+        if (Smp.Cpus[Index].ApicId == __CpuInfo__->lapic_id)
+        {
+            CpuNumber = Index;
+            break;
+        }
+    }
+
+    /* Switch off the bootloader stack before anything else touches it */
+    uint64_t NewStackTop = __CpuInfo__->extra_argument;
+    __asm__ volatile("movq %0, %%rsp\n\t"
+                     "xorq %%rbp, %%rbp\n\t"
+                     "call __ApMain__"
+                     :
+                     : "r"(NewStackTop), "D"((uint64_t)CpuNumber), "S"(NewStackTop)
+                     : "memory");
+    __builtin_unreachable();
+}
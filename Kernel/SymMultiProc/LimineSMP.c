@@ -1,12 +1,17 @@
 #include <LimineSMP.h>      /* Limine SMP protocol definitions */
 #include <LimineServices.h> /* Limine service interfaces */
+#include <PMM.h>            /* AP stacks, allocated before release */
 #include <SMP.h>            /* SMP manager and CPU structures */
+#include <SymAP.h>          /* AP stack size and startup timeout */
 #include <Timer.h>          /* Timer functions for timeouts */
+#include <Topology.h>       /* Per-CPU topology discovery */
+#include <Tsc.h>            /* Rendezvous timeout */
 #include <VMM.h>            /* Virtual memory management for APIC access */
 
 SmpManager        Smp;
 SpinLock          SMPLock;
 volatile uint32_t CpuStartupCount = 0;
+static uint32_t   ApsReleased     = 0; /*Gate the APs wait at after their per-CPU init*/
 
 uint32_t
 GetCurrentCpuId(void)
@@ -43,6 +48,8 @@ InitializeSmp(void)
         Smp.Cpus[0].CpuNumber = 0;
         Smp.Cpus[0].Status    = CPU_STATUS_ONLINE;
         Smp.Cpus[0].Started   = 1;
+        DetectCpuTopology(0);
+        BuildCpuTopology();
         return;
     }
 
@@ -63,7 +70,12 @@ InitializeSmp(void)
         Smp.Cpus[Index].LimineInfo = NULL;
     }
 
-    uint32_t StartedAps = 0;
+    uint32_t BspIndex = 0;
+
+    /*
+     * Everything an AP would otherwise allocate is handed out here: the PMM
+     * takes no lock, and every AP runs its per-CPU init at the same time.
+     */
     for (uint64_t Index = 0; Index < SmpResponse->cpu_count; Index++)
     {
         struct limine_smp_info* CpuInfo = SmpResponse->cpus[Index];
@@ -76,39 +88,122 @@ InitializeSmp(void)
         {
             Smp.Cpus[Index].Status  = CPU_STATUS_ONLINE;
             Smp.Cpus[Index].Started = 1;
+            BspIndex                = Index;
             PDebug("SMP: BSP CPU %u (LAPIC ID %u)\n", Index, CpuInfo->lapic_id);
+            continue;
         }
-        else
+
+        uint64_t StackPhys = AllocPages(SMPCPUStackSize / PageSize);
+        if (!StackPhys)
         {
-            Smp.Cpus[Index].Status = CPU_STATUS_STARTING;
-            CpuInfo->goto_address  = ApEntryPoint; /* Set AP entry point */
-            StartedAps++;
-            PInfo("SMP: Starting AP %u (LAPIC ID %u)\n", Index, CpuInfo->lapic_id);
+            PError("SMP: No stack for AP %u, leaving it parked\n", Index);
+            Smp.Cpus[Index].Status = CPU_STATUS_FAILED;
+            continue;
         }
+
+        Smp.Cpus[Index].StackTop = (uint64_t)PhysToVirt(StackPhys) + SMPCPUStackSize - 16;
+        Smp.Cpus[Index].Status   = CPU_STATUS_STARTING;
     }
 
-    if (StartedAps > 0)
+    DetectCpuTopology(BspIndex);
+
+    /* Release every AP at once, the table above is complete before the first one runs */
+    uint32_t StartedAps = 0;
+    uint64_t Start      = ReadTsc();
+    for (uint64_t Index = 0; Index < SmpResponse->cpu_count; Index++)
     {
-        PInfo("SMP: Waiting for %u APs to start...\n", StartedAps);
+        if (Smp.Cpus[Index].Status != CPU_STATUS_STARTING)
+        {
+            continue;
+        }
 
-#define ApCountTimeout 99999999 /* Large timeout value for AP startup */
-        uint32_t Timeout = ApCountTimeout;
+        struct limine_smp_info* CpuInfo = SmpResponse->cpus[Index];
+        CpuInfo->extra_argument         = Smp.Cpus[Index].StackTop;
+        __atomic_store_n(&CpuInfo->goto_address, ApEntryPoint, __ATOMIC_SEQ_CST);
+        StartedAps++;
+    }
 
-        while (CpuStartupCount < StartedAps && Timeout > 0)
+    if (StartedAps > 0)
+    {
+        PInfo("SMP: Released %u APs, waiting at the rendezvous...\n", StartedAps);
+
+        uint64_t TimeoutNs = (uint64_t)ApStartupTimeout * 1000000ULL;
+        while (__atomic_load_n(&CpuStartupCount, __ATOMIC_SEQ_CST) < StartedAps &&
+               TscToNs(ReadTsc() - Start) < TimeoutNs)
         {
             __asm__ volatile("pause");
-            Timeout--;
         }
 
-        if (CpuStartupCount > StartedAps)
+        /* Stragglers are written off; one that shows up later halts at the gate */
+        for (uint32_t Index = 0; Index < Smp.CpuCount; Index++)
+        {
+            CpuStatus Expected = CPU_STATUS_STARTING;
+            if (__atomic_compare_exchange_n(&Smp.Cpus[Index].Status,
+                                            &Expected,
+                                            CPU_STATUS_FAILED,
+                                            false,
+                                            __ATOMIC_SEQ_CST,
+                                            __ATOMIC_SEQ_CST))
+            {
+                PWarn("SMP: AP %u (LAPIC ID %u) missed the rendezvous\n",
+                      Index,
+                      Smp.Cpus[Index].ApicId);
+            }
+        }
+
+        uint32_t Arrived = __atomic_load_n(&CpuStartupCount, __ATOMIC_SEQ_CST);
+        if (Arrived < StartedAps)
         {
-            PWarn("SMP: %u out of %u APs started!\n", CpuStartupCount, StartedAps);
+            PWarn("SMP: %u out of %u APs started!\n", Arrived, StartedAps);
         }
         else
         {
-            PSuccess("SMP: %u out of %u APs started successfully\n", CpuStartupCount, StartedAps);
+            PSuccess("SMP: %u out of %u APs started in %lu us\n",
+                     Arrived,
+                     StartedAps,
+                     TscToNs(ReadTsc() - Start) / 1000);
         }
     }
 
+    /* Every AP that made the rendezvous has filled in its own topology */
+    BuildCpuTopology();
+
     PSuccess("SMP initialized: %u CPU(s) total, %u online\n", Smp.CpuCount, Smp.OnlineCpus);
 }
+
+/*Called by each AP once its per-CPU state is set up; returns when the BSP opens the gate*/
+void
+SmpApRendezvous(uint32_t __CpuNumber__)
+{
+    CpuStatus Expected = CPU_STATUS_STARTING;
+    if (!__atomic_compare_exchange_n(&Smp.Cpus[__CpuNumber__].Status,
+                                     &Expected,
+                                     CPU_STATUS_ONLINE,
+                                     false,
+                                     __ATOMIC_SEQ_CST,
+                                     __ATOMIC_SEQ_CST))
+    {
+        /* Too late, the BSP has already counted us out */
+        for (;;)
+        {
+            __asm__ volatile("cli; hlt");
+        }
+    }
+
+    Smp.Cpus[__CpuNumber__].Started = 1;
+    __atomic_fetch_add(&Smp.OnlineCpus, 1, __ATOMIC_SEQ_CST);
+    __atomic_fetch_add(&CpuStartupCount, 1, __ATOMIC_SEQ_CST);
+
+    while (!__atomic_load_n(&ApsReleased, __ATOMIC_SEQ_CST))
+    {
+        __asm__ volatile("pause");
+    }
+}
+
+/*Lets the APs take interrupts; the schedulers they tick must exist by now*/
+void
+SmpReleaseAps(void)
+{
+    __atomic_store_n(&ApsReleased, 1, __ATOMIC_SEQ_CST);
+    PDebug("SMP: Rendezvous gate opened for %u APs\n", CpuStartupCount);
+}
@@ -0,0 +1,392 @@
+#include <LimineRSDP.h> /* ACPI root pointer for the SRAT */
+#include <PMM.h>        /* Physical to virtual for ACPI tables */
+#include <PerCPUData.h> /* Per-CPU topology storage */
+#include <SMP.h>        /* CPU table */
+#include <String.h>     /* Table signature compares */
+#include <SymAP.h>      /* GetPerCpuData */
+#include <Topology.h>   /* Topology types */
+#include <VMM.h>        /* HHDM offset */
+
+typedef struct
+{
+    char     Signature[8];
+    uint8_t  Checksum;
+    char     OemId[6];
+    uint8_t  Revision;
+    uint32_t RsdtAddress;
+    uint32_t Length;
+    uint64_t XsdtAddress;
+
+} __attribute__((packed)) AcpiRsdp;
+
+typedef struct
+{
+    char     Signature[4];
+    uint32_t Length;
+    uint8_t  Revision;
+    uint8_t  Checksum;
+    char     OemId[6];
+    char     OemTableId[8];
+    uint32_t OemRevision;
+    uint32_t CreatorId;
+    uint32_t CreatorRevision;
+
+} __attribute__((packed)) AcpiSdtHeader;
+
+#define SratEntriesOffset 48 /*Header plus 12 reserved bytes*/
+#define SratLocalApic     0
+#define SratX2Apic        2
+#define SratEnabled       (1 << 0)
+
+static inline void
+__Cpuid__(uint32_t  __Leaf__,
+          uint32_t  __Sub__,
+          uint32_t* __Eax__,
+          uint32_t* __Ebx__,
+          uint32_t* __Ecx__,
+          uint32_t* __Edx__)
+{
+    __asm__ volatile("cpuid"
+                     : "=a"(*__Eax__), "=b"(*__Ebx__), "=c"(*__Ecx__), "=d"(*__Edx__)
+                     : "a"(__Leaf__), "c"(__Sub__));
+}
+
+/*Bits needed to number __Count__ ids*/
+static uint32_t
+__CountShift__(uint32_t __Count__)
+{
+    uint32_t Shift = 0;
+    while ((1U << Shift) < __Count__ && Shift < 31)
+    {
+        Shift++;
+    }
+    return Shift;
+}
+
+/*APIC id shift of the cache shared at __Level__, 0 when the CPU does not report it*/
+static uint32_t
+__CacheShift__(uint32_t __Level__, uint32_t* __Found__)
+{
+    uint32_t Eax, Ebx, Ecx, Edx;
+    uint32_t Leaves[] = {0x4, 0x8000001D};
+
+    __Cpuid__(0x80000000, 0, &Eax, &Ebx, &Ecx, &Edx);
+    uint32_t MaxExt = Eax;
+    __Cpuid__(0, 0, &Eax, &Ebx, &Ecx, &Edx);
+    uint32_t MaxStd = Eax;
+
+    for (uint32_t L = 0; L < sizeof(Leaves) / sizeof(Leaves[0]); L++)
+    {
+        uint32_t Leaf = Leaves[L];
+        if ((Leaf < 0x80000000 && Leaf > MaxStd) || (Leaf >= 0x80000000 && Leaf > MaxExt))
+        {
+            continue;
+        }
+
+        for (uint32_t Sub = 0; Sub < 16; Sub++)
+        {
+            __Cpuid__(Leaf, Sub, &Eax, &Ebx, &Ecx, &Edx);
+            uint32_t Type = Eax & 0x1F;
+            if (Type == 0)
+            {
+                break;
+            }
+
+            /*Data or unified caches only*/
+            if (Type != 2 && ((Eax >> 5) & 0x7) == __Level__)
+            {
+                *__Found__ = 1;
+                return __CountShift__(((Eax >> 14) & 0xFFF) + 1);
+            }
+        }
+    }
+
+    *__Found__ = 0;
+    return 0;
+}
+
+/*Runs on the CPU being described: CPUID only reports the caller*/
+void
+DetectCpuTopology(uint32_t __CpuId__)
+{
+    if (__CpuId__ >= MaxCPUs)
+    {
+        return;
+    }
+
+    CpuTopology* Topo = &GetPerCpuData(__CpuId__)->Topo;
+    uint32_t     Eax, Ebx, Ecx, Edx;
+
+    __Cpuid__(0, 0, &Eax, &Ebx, &Ecx, &Edx);
+    uint32_t MaxStd = Eax;
+
+    __Cpuid__(1, 0, &Eax, &Ebx, &Ecx, &Edx);
+    uint32_t ApicId   = (Ebx >> 24) & 0xFF;
+    uint32_t SmtShift = 0;
+    uint32_t PkgShift = 0;
+    int      Extended = 0;
+
+    /*Prefer the V2 extended leaf, then 0xB; both give x2APIC ids and per-level shifts*/
+    uint32_t Leaves[] = {0x1F, 0xB};
+    for (uint32_t L = 0; L < 2 && !Extended; L++)
+    {
+        if (Leaves[L] > MaxStd)
+        {
+            continue;
+        }
+
+        __Cpuid__(Leaves[L], 0, &Eax, &Ebx, &Ecx, &Edx);
+        if (!Ebx)
+        {
+            continue;
+        }
+
+        for (uint32_t Sub = 0; Sub < 8; Sub++)
+        {
+            __Cpuid__(Leaves[L], Sub, &Eax, &Ebx, &Ecx, &Edx);
+            uint32_t Type = (Ecx >> 8) & 0xFF;
+            if (Type == 0)
+            {
+                break;
+            }
+
+            if (Type == 1)
+            {
+                SmtShift = Eax & 0x1F;
+            }
+            PkgShift = Eax & 0x1F;
+            ApicId   = Edx;
+        }
+        Extended = 1;
+    }
+
+    /*Legacy: logical count from leaf 1, cores per package from leaf 4*/
+    if (!Extended)
+    {
+        __Cpuid__(1, 0, &Eax, &Ebx, &Ecx, &Edx);
+        uint32_t Logical = (Edx & (1 << 28)) ? ((Ebx >> 16) & 0xFF) : 1;
+        uint32_t Cores   = 1;
+        if (MaxStd >= 4)
+        {
+            __Cpuid__(4, 0, &Eax, &Ebx, &Ecx, &Edx);
+            Cores = (Eax & 0x1F) ? ((Eax >> 26) & 0x3F) + 1 : 1;
+        }
+
+        PkgShift = __CountShift__(Logical ? Logical : 1);
+        SmtShift = __CountShift__(Logical > Cores ? Logical / Cores : 1);
+    }
+
+    uint32_t Found    = 0;
+    uint32_t L2Shift  = __CacheShift__(2, &Found);
+    uint32_t L2Found  = Found;
+    uint32_t LlcShift = __CacheShift__(3, &Found);
+    if (!Found)
+    {
+        LlcShift = L2Found ? L2Shift : PkgShift;
+    }
+    if (!L2Found)
+    {
+        L2Shift = SmtShift;
+    }
+
+    Topo->ApicId    = ApicId;
+    Topo->SmtId     = ApicId & ((1U << SmtShift) - 1);
+    Topo->CoreId    = ApicId >> SmtShift;
+    Topo->L2Id      = ApicId >> L2Shift;
+    Topo->LlcId     = ApicId >> LlcShift;
+    Topo->PackageId = ApicId >> PkgShift;
+    Topo->NumaNode  = TopoNoNode;
+    __atomic_store_n(&Topo->Valid, 1, __ATOMIC_SEQ_CST);
+}
+
+static void*
+__AcpiMap__(uint64_t __Addr__)
+{
+    /*Older Limine revisions hand out HHDM pointers, newer ones physical addresses*/
+    return __Addr__ >= Vmm.HhdmOffset ? (void*)__Addr__ : PhysToVirt(__Addr__);
+}
+
+static AcpiSdtHeader*
+__FindAcpiTable__(const char* __Signature__)
+{
+    if (!EarlyLimineRsdp.response || !EarlyLimineRsdp.response->address)
+    {
+        return NULL;
+    }
+
+    AcpiRsdp* Rsdp    = (AcpiRsdp*)__AcpiMap__((uint64_t)EarlyLimineRsdp.response->address);
+    int       UseXsdt = Rsdp->Revision >= 2 && Rsdp->XsdtAddress;
+    uint64_t  Root    = UseXsdt ? Rsdp->XsdtAddress : Rsdp->RsdtAddress;
+    if (!Root)
+    {
+        return NULL;
+    }
+
+    AcpiSdtHeader* Sdt     = (AcpiSdtHeader*)__AcpiMap__(Root);
+    uint32_t       Width   = UseXsdt ? 8 : 4;
+    uint32_t       Entries = (Sdt->Length - sizeof(AcpiSdtHeader)) / Width;
+    uint8_t*       Table   = (uint8_t*)Sdt + sizeof(AcpiSdtHeader);
+
+    for (uint32_t Index = 0; Index < Entries; Index++)
+    {
+        uint64_t Addr = 0;
+        __builtin_memcpy(&Addr, Table + Index * Width, Width);
+
+        AcpiSdtHeader* Header = (AcpiSdtHeader*)__AcpiMap__(Addr);
+        if (Header && !strncmp(Header->Signature, __Signature__, 4))
+        {
+            return Header;
+        }
+    }
+
+    return NULL;
+}
+
+static void
+__ApplySrat__(void)
+{
+    AcpiSdtHeader* Srat = __FindAcpiTable__("SRAT");
+    if (!Srat)
+    {
+        PDebug("Topology: No SRAT, treating memory as uniform\n");
+        return;
+    }
+
+    uint8_t* Entry = (uint8_t*)Srat + SratEntriesOffset;
+    uint8_t* End   = (uint8_t*)Srat + Srat->Length;
+
+    while (Entry + 2 <= End && Entry[1] >= 2)
+    {
+        uint32_t ApicId = 0xFFFFFFFF;
+        uint32_t Domain = 0;
+        uint32_t Flags  = 0;
+
+        if (Entry[0] == SratLocalApic && Entry[1] >= 16)
+        {
+            Domain = Entry[2] | ((uint32_t)Entry[9] << 8) | ((uint32_t)Entry[10] << 16) |
+                     ((uint32_t)Entry[11] << 24);
+            ApicId = Entry[3];
+            __builtin_memcpy(&Flags, Entry + 4, 4);
+        }
+        else if (Entry[0] == SratX2Apic && Entry[1] >= 24)
+        {
+            __builtin_memcpy(&Domain, Entry + 4, 4);
+            __builtin_memcpy(&ApicId, Entry + 8, 4);
+            __builtin_memcpy(&Flags, Entry + 12, 4);
+        }
+
+        if (Flags & SratEnabled)
+        {
+            for (uint32_t CpuIndex = 0; CpuIndex < Smp.CpuCount; CpuIndex++)
+            {
+                CpuTopology* Topo = &GetPerCpuData(CpuIndex)->Topo;
+                if (Topo->Valid && Topo->ApicId == ApicId)
+                {
+                    Topo->NumaNode = Domain;
+                }
+            }
+        }
+
+        Entry += Entry[1];
+    }
+}
+
+/*BSP, once every AP has described itself at the boot rendezvous*/
+void
+BuildCpuTopology(void)
+{
+    for (uint32_t CpuIndex = 0; CpuIndex < Smp.CpuCount; CpuIndex++)
+    {
+        CpuTopology* Topo = &GetPerCpuData(CpuIndex)->Topo;
+        if (!Topo->Valid)
+        {
+            /*Never came up; give it a core of its own so it is never anyone's sibling*/
+            Topo->ApicId    = Smp.Cpus[CpuIndex].ApicId;
+            Topo->CoreId    = 0x80000000 | CpuIndex;
+            Topo->L2Id      = Topo->CoreId;
+            Topo->LlcId     = Topo->CoreId;
+            Topo->PackageId = Topo->CoreId;
+            Topo->NumaNode  = TopoNoNode;
+            continue;
+        }
+
+        Topo->SiblingCount = 0;
+        for (uint32_t Other = 0; Other < Smp.CpuCount; Other++)
+        {
+            CpuTopology* OtherTopo = &GetPerCpuData(Other)->Topo;
+            if (Other != CpuIndex && OtherTopo->Valid && OtherTopo->CoreId == Topo->CoreId &&
+                Topo->SiblingCount < TopoMaxSiblings)
+            {
+                Topo->Siblings[Topo->SiblingCount++] = Other;
+            }
+        }
+    }
+
+    __ApplySrat__();
+    DumpCpuTopology();
+}
+
+int
+CpusShareCore(uint32_t __CpuA__, uint32_t __CpuB__)
+{
+    if (__CpuA__ >= MaxCPUs || __CpuB__ >= MaxCPUs)
+    {
+        return 0;
+    }
+    return GetPerCpuData(__CpuA__)->Topo.CoreId == GetPerCpuData(__CpuB__)->Topo.CoreId;
+}
+
+int
+CpusShareLlc(uint32_t __CpuA__, uint32_t __CpuB__)
+{
+    if (__CpuA__ >= MaxCPUs || __CpuB__ >= MaxCPUs)
+    {
+        return 0;
+    }
+    return GetPerCpuData(__CpuA__)->Topo.LlcId == GetPerCpuData(__CpuB__)->Topo.LlcId;
+}
+
+uint32_t
+GetCpuNumaNode(uint32_t __CpuId__)
+{
+    if (__CpuId__ >= MaxCPUs)
+    {
+        return TopoNoNode;
+    }
+    return GetPerCpuData(__CpuId__)->Topo.NumaNode;
+}
+
+void
+DumpCpuTopology(void)
+{
+    uint32_t Cores = 0;
+    uint32_t Llcs  = 0;
+
+    for (uint32_t CpuIndex = 0; CpuIndex < Smp.CpuCount; CpuIndex++)
+    {
+        CpuTopology* Topo      = &GetPerCpuData(CpuIndex)->Topo;
+        int          FirstCore = 1;
+        int          FirstLlc  = 1;
+
+        /*Count each domain at its lowest-numbered CPU*/
+        for (uint32_t Other = 0; Other < CpuIndex; Other++)
+        {
+            FirstCore &= !CpusShareCore(CpuIndex, Other);
+            FirstLlc &= !CpusShareLlc(CpuIndex, Other);
+        }
+        Cores += FirstCore;
+        Llcs += FirstLlc;
+
+        PDebug("Topology: CPU %u apic %u core %u smt %u l2 %u llc %u pkg %u node %d\n",
+               CpuIndex,
+               Topo->ApicId,
+               Topo->CoreId,
+               Topo->SmtId,
+               Topo->L2Id,
+               Topo->LlcId,
+               Topo->PackageId,
+               (int)Topo->NumaNode);
+    }
+
+    PSuccess("Topology: %u CPUs, %u cores, %u last-level caches\n", Smp.CpuCount, Cores, Llcs);
+}
@@ -0,0 +1,105 @@
+#include <String.h> /* Class names */
+#include <Sync.h>   /* Synchronization primitives definitions */
+
+#ifdef SyncLockStat
+
+LockClass LockClasses[LockStatMaxClasses];
+uint32_t  LockClassCount;
+uint64_t  LockStatUntracked;
+
+/*Guards adding classes; a SpinLock cannot, since initialising one lands here*/
+static volatile uint32_t LockClassBusy;
+
+LockClass*
+LockStatClass(const char* __Name__, uint32_t __Kind__)
+{
+    if (!__Name__)
+    {
+        return NULL;
+    }
+
+    uint64_t Flags;
+    __asm__ volatile("pushfq; popq %0; cli" : "=r"(Flags)::"memory");
+    while (__atomic_exchange_n(&LockClassBusy, 1, __ATOMIC_ACQUIRE))
+    {
+        __asm__ volatile("pause");
+    }
+
+    LockClass* Class = NULL;
+    for (uint32_t I = 0; I < LockClassCount; I++)
+    {
+        if (LockClasses[I].Kind == __Kind__ &&
+            strncmp(LockClasses[I].Name, __Name__, LockClassNameLen - 1) == 0)
+        {
+            Class = &LockClasses[I];
+            break;
+        }
+    }
+
+    if (!Class && LockClassCount < LockStatMaxClasses)
+    {
+        Class       = &LockClasses[LockClassCount];
+        Class->Kind = __Kind__;
+        StringCopy(Class->Name, __Name__, LockClassNameLen);
+        __atomic_store_n(&LockClassCount, LockClassCount + 1, __ATOMIC_RELEASE);
+    }
+    else if (!Class)
+    {
+        LockStatUntracked++;
+    }
+
+    __atomic_store_n(&LockClassBusy, 0, __ATOMIC_RELEASE);
+    __asm__ volatile("pushq %0; popfq" ::"r"(Flags) : "memory");
+    return Class;
+}
+
+static void
+__LockStatMax__(uint64_t* __Max__, uint64_t __Value__)
+{
+    uint64_t Seen = __atomic_load_n(__Max__, __ATOMIC_RELAXED);
+    while (__Value__ > Seen &&
+           !__atomic_compare_exchange_n(
+               __Max__, &Seen, __Value__, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+    }
+}
+
+void
+LockStatAcquired(LockClass* __Class__, bool __Contended__, uint64_t __WaitCycles__)
+{
+    __atomic_fetch_add(&__Class__->Acquisitions, 1, __ATOMIC_RELAXED);
+    if (!__Contended__)
+    {
+        return;
+    }
+
+    __atomic_fetch_add(&__Class__->Contentions, 1, __ATOMIC_RELAXED);
+    __atomic_fetch_add(&__Class__->WaitTotal, __WaitCycles__, __ATOMIC_RELAXED);
+    __LockStatMax__(&__Class__->WaitMax, __WaitCycles__);
+}
+
+void
+LockStatReleased(LockClass* __Class__, uint64_t __HoldCycles__)
+{
+    __atomic_fetch_add(&__Class__->HoldTotal, __HoldCycles__, __ATOMIC_RELAXED);
+    __LockStatMax__(&__Class__->HoldMax, __HoldCycles__);
+}
+
+/*Classes stay registered; holders in flight may add one stale hold time*/
+void
+LockStatReset(void)
+{
+    uint32_t Count = __atomic_load_n(&LockClassCount, __ATOMIC_ACQUIRE);
+    for (uint32_t I = 0; I < Count; I++)
+    {
+        LockClass* Class = &LockClasses[I];
+        __atomic_store_n(&Class->Acquisitions, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&Class->Contentions, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&Class->WaitTotal, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&Class->WaitMax, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&Class->HoldTotal, 0, __ATOMIC_RELAXED);
+        __atomic_store_n(&Class->HoldMax, 0, __ATOMIC_RELAXED);
+    }
+}
+
+#endif
@@ -0,0 +1,140 @@
+#include <KrnPrintf.h> /* Error reporting */
+#include <PerCpu.h>    /* Padded per-CPU node masks */
+#include <SMP.h>       /* Symmetric multiprocessing functions */
+#include <Sync.h>      /* Synchronization primitives definitions */
+
+/*
+ * MCS queued locks. Each acquisition links a per-CPU node into the lock's
+ * queue and spins on that node alone; release writes only the successor's
+ * node. Interrupts stay off while a node is in use, so a CPU only needs as
+ * many nodes as locks it nests.
+ */
+
+static McsNode McsNodes[MaxCPUs][McsMaxNesting];
+StaticPerCpu(uint32_t, McsNodesUsed); /* Bit per node in McsNodes[CpuId] */
+
+static McsNode*
+__GetNode__(uint32_t __CpuId__)
+{
+    uint32_t Free = ~*PerCpuPtr(McsNodesUsed, __CpuId__) & ((1U << McsMaxNesting) - 1);
+    if (!Free)
+    {
+        PError("McsLock: CPU %u nested more than %u locks\n", __CpuId__, McsMaxNesting);
+        for (;;)
+        {
+            __asm__ volatile("cli; hlt");
+        }
+    }
+
+    uint32_t Index = (uint32_t)__builtin_ctz(Free);
+    *PerCpuPtr(McsNodesUsed, __CpuId__) |= 1U << Index;
+    return &McsNodes[__CpuId__][Index];
+}
+
+static void
+__PutNode__(uint32_t __CpuId__, McsNode* __Node__)
+{
+    *PerCpuPtr(McsNodesUsed, __CpuId__) &= ~(1U << (uint32_t)(__Node__ - McsNodes[__CpuId__]));
+}
+
+void
+InitializeMcsLock(McsLock* __Lock__, const char* __Name__)
+{
+    __Lock__->Tail   = NULL;       /* Empty queue, unlocked */
+    __Lock__->Holder = NULL;       /* Node of the current holder */
+    __Lock__->CpuId  = 0xFFFFFFFF; /* No owner (kernel value) */
+    __Lock__->Name   = __Name__;   /* Assign name for debugging */
+}
+
+void
+AcquireMcsLock(McsLock* __Lock__)
+{
+    uint64_t Flags;
+    __asm__ volatile("pushfq; popq %0; cli" : "=r"(Flags)::"memory");
+
+    uint32_t CpuId = GetCurrentCpuId();
+    McsNode* Node  = __GetNode__(CpuId);
+    Node->Next     = NULL;
+    Node->Locked   = 1;
+    Node->Flags    = Flags;
+
+    /* Join the tail; a predecessor means we wait for it to clear Locked */
+    McsNode* Prev = __atomic_exchange_n(&__Lock__->Tail, Node, __ATOMIC_ACQ_REL);
+    if (Prev)
+    {
+        __atomic_store_n(&Prev->Next, Node, __ATOMIC_RELEASE);
+        while (__atomic_load_n(&Node->Locked, __ATOMIC_ACQUIRE))
+        {
+            __asm__ volatile("pause");
+        }
+    }
+
+    __Lock__->Holder = Node;
+    __Lock__->CpuId  = CpuId;
+}
+
+void
+ReleaseMcsLock(McsLock* __Lock__)
+{
+    McsNode* Node  = __Lock__->Holder;
+    uint32_t CpuId = __Lock__->CpuId;
+    uint64_t Flags = Node->Flags;
+
+    __Lock__->Holder = NULL;
+    __Lock__->CpuId  = 0xFFFFFFFF;
+
+    McsNode* Next = __atomic_load_n(&Node->Next, __ATOMIC_ACQUIRE);
+    if (!Next)
+    {
+        /* Nobody queued: swing the tail back to empty */
+        McsNode* Expected = Node;
+        if (__atomic_compare_exchange_n(
+                &__Lock__->Tail, &Expected, NULL, false, __ATOMIC_RELEASE, __ATOMIC_RELAXED))
+        {
+            __PutNode__(CpuId, Node);
+            __asm__ volatile("pushq %0; popfq" ::"r"(Flags) : "memory");
+            return;
+        }
+
+        /* A waiter swapped itself in but has not linked to us yet */
+        while (!(Next = __atomic_load_n(&Node->Next, __ATOMIC_ACQUIRE)))
+        {
+            __asm__ volatile("pause");
+        }
+    }
+
+    __atomic_store_n(&Next->Locked, 0, __ATOMIC_RELEASE);
+    __PutNode__(CpuId, Node);
+    __asm__ volatile("pushq %0; popfq" ::"r"(Flags) : "memory");
+}
+
+bool
+TryAcquireMcsLock(McsLock* __Lock__)
+{
+    if (__atomic_load_n(&__Lock__->Tail, __ATOMIC_RELAXED))
+    {
+        return false;
+    }
+
+    uint64_t Flags;
+    __asm__ volatile("pushfq; popq %0; cli" : "=r"(Flags)::"memory");
+
+    uint32_t CpuId    = GetCurrentCpuId();
+    McsNode* Node     = __GetNode__(CpuId);
+    McsNode* Expected = NULL;
+    Node->Next        = NULL;
+    Node->Locked      = 0;
+    Node->Flags       = Flags;
+
+    if (__atomic_compare_exchange_n(
+            &__Lock__->Tail, &Expected, Node, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+    {
+        __Lock__->Holder = Node;
+        __Lock__->CpuId  = CpuId;
+        return true;
+    }
+
+    __PutNode__(CpuId, Node);
+    __asm__ volatile("pushq %0; popfq" ::"r"(Flags) : "memory");
+    return false;
+}
@@ -1,49 +1,126 @@
-#include <SMP.h>  /* Symmetric multiprocessing functions */
-#include <Sync.h> /* Synchronization primitives definitions */
+#include <AxeThreads.h> /* Owners and their run state */
+#include <SMP.h>        /* Symmetric multiprocessing functions */
+#include <Sync.h>       /* Synchronization primitives definitions */
+#include <Tsc.h>        /* Wait and hold times for lock statistics */
 
 void
 InitializeMutex(Mutex* __Mutex__, const char* __Name__)
 {
-    __Mutex__->Lock           = 0;          /* Initially unlocked */
-    __Mutex__->Owner          = 0xFFFFFFFF; /* No owner (kernel value) */
-    __Mutex__->RecursionCount = 0;          /* No recursive locks */
-    __Mutex__->Name           = __Name__;   /* Assign name for debugging */
+    __Mutex__->Lock           = MutexUnlocked; /* Initially unlocked */
+    __Mutex__->Owner          = 0;             /* No owner */
+    __Mutex__->RecursionCount = 0;             /* No recursive locks */
+    __Mutex__->Name           = __Name__;      /* Assign name for debugging */
+    InitializeWaitQueue(&__Mutex__->Waiters, __Name__);
+    __Mutex__->Waiters.Reason = WaitReasonMutex;
+#ifdef SyncLockStat
+    __Mutex__->Class = LockStatClass(__Name__, LockClassMutex);
+#else
+    __Mutex__->Class = NULL; /* Untracked */
+#endif
+}
+
+/*Who takes the mutex: the running thread, or the CPU while there are none yet*/
+static uintptr_t
+__MutexSelf__(void)
+{
+    uint32_t CpuId = GetCurrentCpuId();
+    Thread*  Self  = GetCurrentThread(CpuId);
+
+    return Self ? (uintptr_t)Self : (uintptr_t)CpuId + 1;
+}
+
+/*Spinning only pays while the owner is on a CPU and can let go soon*/
+static bool
+__MutexOwnerRunning__(uintptr_t __Owner__)
+{
+    if (__Owner__ <= MaxCPUs)
+    {
+        return __Owner__ != 0;
+    }
+
+    /* Only read; an owner that just let go and exited ends the spin on the next check */
+    return __atomic_load_n(&((Thread*)__Owner__)->State, __ATOMIC_RELAXED) == ThreadStateRunning;
+}
+
+/*Wait condition; marks the mutex contended so the holder knows to wake somebody*/
+static bool
+__MutexTake__(void* __Arg__)
+{
+    Mutex* M = (Mutex*)__Arg__;
+    return __atomic_exchange_n(&M->Lock, MutexContended, __ATOMIC_ACQUIRE) == MutexUnlocked;
+}
+
+static bool
+__MutexTryLock__(Mutex* __Mutex__)
+{
+    uint32_t Expected = MutexUnlocked;
+    return __atomic_compare_exchange_n(
+        &__Mutex__->Lock, &Expected, MutexLocked, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
 }
 
 void
 AcquireMutex(Mutex* __Mutex__)
 {
-    uint32_t CpuId = GetCurrentCpuId();
+    uintptr_t Self = __MutexSelf__();
 
-    if (__Mutex__->Owner == CpuId)
+    if (__Mutex__->Owner == Self)
     {
         __Mutex__->RecursionCount++;
         return;
     }
 
-    while (1)
+#ifdef SyncLockStat
+    uint64_t WaitStart = ReadTsc();
+#endif
+
+    bool Contended = !__MutexTryLock__(__Mutex__);
+    if (Contended)
     {
-        uint32_t Expected = 0; /* Expect the lock to be free (0) */
-        if (__atomic_compare_exchange_n(
-                &__Mutex__->Lock, &Expected, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        /* Adaptive: a running owner is usually about to release, so spin a while first */
+        bool Taken = false;
+        for (uint32_t Spin = 0; Spin < MutexSpinLimit; Spin++)
         {
-            /* Successfully acquired the lock */
-            __Mutex__->Owner          = CpuId;
-            __Mutex__->RecursionCount = 1;
-            break;
+            uint32_t Lock = __atomic_load_n(&__Mutex__->Lock, __ATOMIC_RELAXED);
+            if (Lock == MutexUnlocked && __MutexTryLock__(__Mutex__))
+            {
+                Taken = true;
+                break;
+            }
+
+            /* Somebody already sleeps on it, or the owner does: no point spinning */
+            if (Lock == MutexContended ||
+                !__MutexOwnerRunning__(__atomic_load_n(&__Mutex__->Owner, __ATOMIC_RELAXED)))
+            {
+                break;
+            }
+
+            __asm__ volatile("pause");
         }
 
-        /* Lock is held by another CPU, spin with pause for efficiency */
-        __asm__ volatile("pause");
+        if (!Taken)
+        {
+            WaitEvent(&__Mutex__->Waiters, __MutexTake__, __Mutex__);
+        }
     }
+
+    __atomic_store_n(&__Mutex__->Owner, Self, __ATOMIC_RELAXED);
+    __Mutex__->RecursionCount = 1;
+
+#ifdef SyncLockStat
+    __Mutex__->AcquiredTsc = ReadTsc();
+    if (__Mutex__->Class)
+    {
+        LockStatAcquired(__Mutex__->Class, Contended, __Mutex__->AcquiredTsc - WaitStart);
+    }
+#else
+    (void)Contended;
+#endif
 }
 
 void
 ReleaseMutex(Mutex* __Mutex__)
 {
-    uint32_t CpuId = GetCurrentCpuId();
-
-    if (__Mutex__->Owner != CpuId)
+    if (__Mutex__->Owner != __MutexSelf__())
     {
         return;
     }
@@ -52,29 +129,46 @@ ReleaseMutex(Mutex* __Mutex__)
 
     if (__Mutex__->RecursionCount == 0)
     {
-        __Mutex__->Owner = 0xFFFFFFFF;                           /* Reset owner to kernel/none */
-        __atomic_store_n(&__Mutex__->Lock, 0, __ATOMIC_RELEASE); /* Unlock atomically */
+#ifdef SyncLockStat
+        if (__Mutex__->Class)
+        {
+            LockStatReleased(__Mutex__->Class, ReadTsc() - __Mutex__->AcquiredTsc);
+        }
+#endif
+        __atomic_store_n(&__Mutex__->Owner, 0, __ATOMIC_RELAXED); /* Reset owner to none */
+
+        /* Only a contended mutex can have sleepers to hand over to */
+        if (__atomic_exchange_n(&__Mutex__->Lock, MutexUnlocked, __ATOMIC_RELEASE) ==
+            MutexContended)
+        {
+            WakeUp(&__Mutex__->Waiters);
+        }
     }
 }
 
 bool
 TryAcquireMutex(Mutex* __Mutex__)
 {
-    uint32_t CpuId = GetCurrentCpuId();
+    uintptr_t Self = __MutexSelf__();
 
-    if (__Mutex__->Owner == CpuId)
+    if (__Mutex__->Owner == Self)
     {
         __Mutex__->RecursionCount++;
         return true;
     }
 
-    uint32_t Expected = 0;
-    if (__atomic_compare_exchange_n(
-            &__Mutex__->Lock, &Expected, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+    if (__MutexTryLock__(__Mutex__))
     {
         /* Successfully acquired */
-        __Mutex__->Owner          = CpuId;
+        __atomic_store_n(&__Mutex__->Owner, Self, __ATOMIC_RELAXED);
         __Mutex__->RecursionCount = 1;
+#ifdef SyncLockStat
+        __Mutex__->AcquiredTsc = ReadTsc();
+        if (__Mutex__->Class)
+        {
+            LockStatAcquired(__Mutex__->Class, false, 0);
+        }
+#endif
         return true;
     }
 
@@ -0,0 +1,218 @@
+#include <AxeSchd.h>    /* Preemption control */
+#include <AxeThreads.h> /* Yielding while a grace period runs */
+#include <KrnPrintf.h>  /* Error reporting */
+#include <SMP.h>        /* Online CPUs */
+#include <Softirq.h>    /* Callback processing */
+#include <Sync.h>       /* Synchronization primitives definitions */
+
+/*
+ * Read-copy-update. A read section only holds off preemption, so a CPU that
+ * gets into Schedule has left every section it was in. Grace period G starts
+ * after the updates it covers and ends once every online CPU has been through
+ * Schedule having seen G; nobody can still hold what those updates unlinked.
+ */
+
+typedef struct __attribute__((aligned(64)))
+{
+    volatile uint64_t Qs;   /*Newest grace period this CPU has been quiescent in*/
+    RcuHead*          Head; /*Callbacks in grace period order, interrupts off*/
+    RcuHead**         Tail;
+
+} RcuCpu;
+
+static RcuCpu            RcuCpus[MaxCPUs];
+static SpinLock          RcuLock;      /*Starts and ends grace periods*/
+static volatile uint64_t RcuGpSeq;     /*Newest grace period started*/
+static volatile uint64_t RcuCompleted; /*Newest grace period ended*/
+static volatile uint64_t RcuNeeded;    /*Newest grace period somebody waits on*/
+
+void
+RcuReadLock(void)
+{
+    PreemptDisable();
+}
+
+void
+RcuReadUnlock(void)
+{
+    PreemptEnable();
+}
+
+/*Called at the top of Schedule, which never runs inside a read section*/
+void
+RcuQuiescentState(uint32_t __CpuId__)
+{
+    if (__CpuId__ >= MaxCPUs)
+    {
+        return;
+    }
+
+    uint64_t Gp = __atomic_load_n(&RcuGpSeq, __ATOMIC_ACQUIRE);
+    if (RcuCpus[__CpuId__].Qs != Gp)
+    {
+        /* Everything read before here is done with before the report is seen */
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+        __atomic_store_n(&RcuCpus[__CpuId__].Qs, Gp, __ATOMIC_RELEASE);
+    }
+}
+
+/*The grace period after the one running now; the caller's unlinking is already visible*/
+static uint64_t
+__RcuRequest__(void)
+{
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+    uint64_t Target = __atomic_load_n(&RcuGpSeq, __ATOMIC_SEQ_CST) + 1;
+    uint64_t Needed = __atomic_load_n(&RcuNeeded, __ATOMIC_RELAXED);
+    while (Needed < Target &&
+           !__atomic_compare_exchange_n(
+               &RcuNeeded, &Needed, Target, false, __ATOMIC_SEQ_CST, __ATOMIC_RELAXED))
+    {
+    }
+    return Target;
+}
+
+/*End the running grace period if every CPU has passed it, then start the next one wanted*/
+static void
+__RcuAdvance__(void)
+{
+    /* Whoever holds it is doing the same work */
+    if (!TryAcquireSpinLock(&RcuLock))
+    {
+        return;
+    }
+
+    uint64_t Gp = RcuGpSeq;
+    if (Gp != RcuCompleted)
+    {
+        for (uint32_t CpuIndex = 0; CpuIndex < Smp.CpuCount; CpuIndex++)
+        {
+            if (Smp.Cpus[CpuIndex].Status == CPU_STATUS_ONLINE &&
+                __atomic_load_n(&RcuCpus[CpuIndex].Qs, __ATOMIC_ACQUIRE) < Gp)
+            {
+                ReleaseSpinLock(&RcuLock);
+                return;
+            }
+        }
+        __atomic_store_n(&RcuCompleted, Gp, __ATOMIC_RELEASE);
+    }
+
+    if (__atomic_load_n(&RcuNeeded, __ATOMIC_ACQUIRE) > Gp)
+    {
+        __atomic_store_n(&RcuGpSeq, Gp + 1, __ATOMIC_SEQ_CST);
+    }
+
+    ReleaseSpinLock(&RcuLock);
+}
+
+static void
+__RcuSoftirq__(uint32_t __CpuId__)
+{
+    RcuCpu* Cpu = &RcuCpus[__CpuId__];
+
+    __RcuAdvance__();
+    uint64_t Completed = __atomic_load_n(&RcuCompleted, __ATOMIC_ACQUIRE);
+
+    /* Cut off the callbacks whose grace period is over; CallRcu may run from an IRQ */
+    uint64_t Flags;
+    __asm__ volatile("pushfq; popq %0; cli" : "=r"(Flags)::"memory");
+
+    RcuHead* Ready = NULL;
+    RcuHead* Last  = NULL;
+    for (RcuHead* Head = Cpu->Head; Head && Head->Gp <= Completed; Head = Head->Next)
+    {
+        Last = Head;
+    }
+    if (Last)
+    {
+        Ready     = Cpu->Head;
+        Cpu->Head = Last->Next;
+        if (!Cpu->Head)
+        {
+            Cpu->Tail = &Cpu->Head;
+        }
+        Last->Next = NULL;
+    }
+
+    __asm__ volatile("pushq %0; popfq" ::"r"(Flags) : "memory");
+
+    while (Ready)
+    {
+        RcuHead* Next = Ready->Next;
+        Ready->Func(Ready);
+        Ready = Next;
+    }
+}
+
+void
+InitializeRcu(void)
+{
+    InitializeSpinLock(&RcuLock, "Rcu");
+    RegisterSoftirq(SoftirqRcu, __RcuSoftirq__, "rcu");
+    PSuccess("RCU initialized\n");
+}
+
+/*Only CPUs with callbacks queued push grace periods along; SynchronizeRcu drives its own*/
+void
+RcuTick(uint32_t __CpuId__)
+{
+    if (__CpuId__ < MaxCPUs && __atomic_load_n(&RcuCpus[__CpuId__].Head, __ATOMIC_RELAXED))
+    {
+        RaiseSoftirqOn(__CpuId__, SoftirqRcu);
+    }
+}
+
+void
+CallRcu(RcuHead* __Head__, void (*__Func__)(RcuHead* __Head__))
+{
+    if (!__Head__ || !__Func__)
+    {
+        return;
+    }
+
+    uint64_t Flags;
+    __asm__ volatile("pushfq; popq %0; cli" : "=r"(Flags)::"memory");
+
+    /* Asked for with interrupts off, so each CPU's list stays in grace period order */
+    __Head__->Next = NULL;
+    __Head__->Func = __Func__;
+    __Head__->Gp   = __RcuRequest__();
+
+    RcuCpu* Cpu = &RcuCpus[GetCurrentCpuId()];
+    if (!Cpu->Tail)
+    {
+        Cpu->Tail = &Cpu->Head;
+    }
+    *Cpu->Tail = __Head__;
+    Cpu->Tail  = &__Head__->Next;
+
+    __asm__ volatile("pushq %0; popfq" ::"r"(Flags) : "memory");
+}
+
+int
+SynchronizeRcu(void)
+{
+    uint64_t Flags;
+    __asm__ volatile("pushfq; popq %0" : "=r"(Flags));
+
+    /* Waiting needs this CPU to reach Schedule, which it never would from here */
+    uint32_t CpuId = GetCurrentCpuId();
+    if (!(Flags & 0x200) || PreemptDisabled(CpuId) || SoftirqActive(CpuId) ||
+        !GetCurrentThread(CpuId))
+    {
+        PError("Rcu: SynchronizeRcu on CPU %u cannot sleep\n", CpuId);
+        return -1;
+    }
+
+    uint64_t Target = __RcuRequest__();
+    while (__atomic_load_n(&RcuCompleted, __ATOMIC_ACQUIRE) < Target)
+    {
+        __RcuAdvance__();
+        if (__atomic_load_n(&RcuCompleted, __ATOMIC_ACQUIRE) < Target)
+        {
+            ThreadYield();
+        }
+    }
+
+    return 0;
+}
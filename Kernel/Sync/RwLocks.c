@@ -0,0 +1,179 @@
+#include <AxeSchd.h>    /* Preemption control */
+#include <AxeThreads.h> /* Wait reasons */
+#include <SMP.h>        /* Symmetric multiprocessing functions */
+#include <Sync.h>       /* Synchronization primitives definitions */
+
+/*
+ * Queued reader-writer spinlock. An uncontended reader or writer costs one
+ * atomic on Count. Anyone who finds it taken queues on the Wait ticket lock,
+ * so a stream of readers cannot starve a writer: once a writer is at the head
+ * it sets RwLockWriterWaiting and new readers fall in behind it.
+ */
+
+void
+InitializeRwLock(RwLock* __Lock__, const char* __Name__)
+{
+    __Lock__->Count = 0;        /* No readers, no writer */
+    __Lock__->Name  = __Name__; /* Assign name for debugging */
+    InitializeSpinLock(&__Lock__->Wait, __Name__);
+}
+
+void
+AcquireRwLockRead(RwLock* __Lock__)
+{
+    PreemptDisable();
+
+    uint32_t Count = __atomic_add_fetch(&__Lock__->Count, RwLockReaderBias, __ATOMIC_ACQUIRE);
+    if (!(Count & RwLockWriterMask))
+    {
+        return;
+    }
+
+    /* A writer holds it or is next: back out and take our turn in the queue */
+    __atomic_sub_fetch(&__Lock__->Count, RwLockReaderBias, __ATOMIC_RELAXED);
+    AcquireSpinLockPlain(&__Lock__->Wait);
+
+    __atomic_add_fetch(&__Lock__->Count, RwLockReaderBias, __ATOMIC_ACQUIRE);
+    while (__atomic_load_n(&__Lock__->Count, __ATOMIC_ACQUIRE) & RwLockWriterLocked)
+    {
+        __asm__ volatile("pause");
+    }
+
+    /* Readers queued behind us get in as soon as we let go of the queue */
+    ReleaseSpinLockPlain(&__Lock__->Wait);
+}
+
+void
+ReleaseRwLockRead(RwLock* __Lock__)
+{
+    __atomic_sub_fetch(&__Lock__->Count, RwLockReaderBias, __ATOMIC_RELEASE);
+    PreemptEnable();
+}
+
+void
+AcquireRwLockWrite(RwLock* __Lock__)
+{
+    PreemptDisable();
+
+    uint32_t Expected = 0;
+    if (__atomic_compare_exchange_n(&__Lock__->Count,
+                                    &Expected,
+                                    RwLockWriterLocked,
+                                    false,
+                                    __ATOMIC_ACQUIRE,
+                                    __ATOMIC_RELAXED))
+    {
+        return;
+    }
+
+    AcquireSpinLockPlain(&__Lock__->Wait);
+
+    /* At the head of the queue: stop new readers, then wait for the ones inside to drain */
+    __atomic_fetch_or(&__Lock__->Count, RwLockWriterWaiting, __ATOMIC_RELAXED);
+    while (1)
+    {
+        Expected = RwLockWriterWaiting;
+        if (__atomic_compare_exchange_n(&__Lock__->Count,
+                                        &Expected,
+                                        RwLockWriterLocked,
+                                        false,
+                                        __ATOMIC_ACQUIRE,
+                                        __ATOMIC_RELAXED))
+        {
+            break;
+        }
+        __asm__ volatile("pause");
+    }
+
+    ReleaseSpinLockPlain(&__Lock__->Wait);
+}
+
+void
+ReleaseRwLockWrite(RwLock* __Lock__)
+{
+    /* Queued readers may already be adding their bias, so only clear the writer byte */
+    __atomic_sub_fetch(&__Lock__->Count, RwLockWriterLocked, __ATOMIC_RELEASE);
+    PreemptEnable();
+}
+
+void
+InitializeRwSemaphore(RwSemaphore* __Sem__, const char* __Name__)
+{
+    __Sem__->Count   = 0;        /* No readers, no writer */
+    __Sem__->Writers = 0;        /* Nobody waiting to write */
+    __Sem__->Name    = __Name__; /* Assign name for debugging */
+    InitializeWaitQueue(&__Sem__->Waiters, __Name__);
+    __Sem__->Waiters.Reason = WaitReasonSemaphore;
+}
+
+/*Wait condition for readers*/
+static bool
+__RwSemaphoreTakeRead__(void* __Arg__)
+{
+    RwSemaphore* Sem   = (RwSemaphore*)__Arg__;
+    int32_t      Count = __atomic_load_n(&Sem->Count, __ATOMIC_RELAXED);
+
+    /* Waiting writers go first, or mounts would never get in between lookups */
+    while (Count >= 0 && !__atomic_load_n(&Sem->Writers, __ATOMIC_RELAXED))
+    {
+        if (__atomic_compare_exchange_n(
+                &Sem->Count, &Count, Count + 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+/*Wait condition for writers*/
+static bool
+__RwSemaphoreTakeWrite__(void* __Arg__)
+{
+    RwSemaphore* Sem      = (RwSemaphore*)__Arg__;
+    int32_t      Expected = 0;
+
+    return __atomic_compare_exchange_n(
+        &Sem->Count, &Expected, RwSemaphoreWriter, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED);
+}
+
+void
+AcquireRwSemaphoreRead(RwSemaphore* __Sem__)
+{
+    if (!__RwSemaphoreTakeRead__(__Sem__))
+    {
+        WaitEvent(&__Sem__->Waiters, __RwSemaphoreTakeRead__, __Sem__);
+    }
+}
+
+void
+ReleaseRwSemaphoreRead(RwSemaphore* __Sem__)
+{
+    /* The last reader out lets a sleeping writer in */
+    if (__atomic_sub_fetch(&__Sem__->Count, 1, __ATOMIC_RELEASE) == 0)
+    {
+        WakeUpAll(&__Sem__->Waiters);
+    }
+}
+
+void
+AcquireRwSemaphoreWrite(RwSemaphore* __Sem__)
+{
+    if (__RwSemaphoreTakeWrite__(__Sem__))
+    {
+        return;
+    }
+
+    __atomic_add_fetch(&__Sem__->Writers, 1, __ATOMIC_RELAXED);
+    WaitEvent(&__Sem__->Waiters, __RwSemaphoreTakeWrite__, __Sem__);
+
+    /* Readers that held back for us may go again once we are done */
+    __atomic_sub_fetch(&__Sem__->Writers, 1, __ATOMIC_RELAXED);
+}
+
+void
+ReleaseRwSemaphoreWrite(RwSemaphore* __Sem__)
+{
+    __atomic_store_n(&__Sem__->Count, 0, __ATOMIC_RELEASE);
+    WakeUpAll(&__Sem__->Waiters);
+}
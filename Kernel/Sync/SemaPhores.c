@@ -1,65 +1,61 @@
-#include <SMP.h>  /* Symmetric multiprocessing functions */
-#include <Sync.h> /* Synchronization primitives definitions */
+#include <AxeThreads.h> /* Wait reasons */
+#include <SMP.h>        /* Symmetric multiprocessing functions */
+#include <Sync.h>       /* Synchronization primitives definitions */
 
 void
 InitializeSemaphore(Semaphore* __Semaphore__, int32_t __InitialCount__, const char* __Name__)
 {
-    __Semaphore__->Count     = __InitialCount__; /* Set initial count */
-    __Semaphore__->WaitQueue = 0;                /* No waiting threads initially */
-    InitializeSpinLock(&__Semaphore__->QueueLock, "SemaphoreQueue"); /* Initialize queue lock */
-    __Semaphore__->Name = __Name__;                                  /* Assign name for debugging */
+    __Semaphore__->Count = __InitialCount__; /* Set initial count */
+    __Semaphore__->Name  = __Name__;         /* Assign name for debugging */
+    InitializeWaitQueue(&__Semaphore__->Waiters, __Name__);
+    __Semaphore__->Waiters.Reason = WaitReasonSemaphore;
 }
 
-void
-AcquireSemaphore(Semaphore* __Semaphore__)
+/*Wait condition; takes one count if there is one*/
+static bool
+__SemaphoreTake__(void* __Arg__)
 {
-    while (1)
-    {
-        int32_t CurrentCount = __atomic_load_n(&__Semaphore__->Count, __ATOMIC_ACQUIRE);
+    Semaphore* S            = (Semaphore*)__Arg__;
+    int32_t    CurrentCount = __atomic_load_n(&S->Count, __ATOMIC_ACQUIRE);
 
-        if (CurrentCount > 0)
+    while (CurrentCount > 0)
+    {
+        if (__atomic_compare_exchange_n(&S->Count,
+                                        &CurrentCount,
+                                        CurrentCount - 1,
+                                        false,
+                                        __ATOMIC_ACQUIRE,
+                                        __ATOMIC_RELAXED))
         {
-            if (__atomic_compare_exchange_n(&__Semaphore__->Count,
-                                            &CurrentCount,
-                                            CurrentCount - 1,
-                                            false,
-                                            __ATOMIC_ACQUIRE,
-                                            __ATOMIC_RELAXED))
-            {
-                break; /* Successfully acquired */
-            }
-            /* Compare-exchange failed, retry */
+            return true; /* Successfully acquired */
         }
+        /* Compare-exchange failed, CurrentCount reloaded, retry */
+    }
+
+    return false;
+}
 
-        /* Count is zero or compare-exchange failed, spin with pause */
-        __asm__ volatile("pause");
+void
+AcquireSemaphore(Semaphore* __Semaphore__)
+{
+    if (__SemaphoreTake__(__Semaphore__))
+    {
+        return;
     }
+
+    /* Count is zero: sleep until a release hands one over */
+    WaitEvent(&__Semaphore__->Waiters, __SemaphoreTake__, __Semaphore__);
 }
 
 void
 ReleaseSemaphore(Semaphore* __Semaphore__)
 {
     __atomic_fetch_add(&__Semaphore__->Count, 1, __ATOMIC_RELEASE);
+    WakeUp(&__Semaphore__->Waiters);
 }
 
 bool
 TryAcquireSemaphore(Semaphore* __Semaphore__)
 {
-    int32_t CurrentCount = __atomic_load_n(&__Semaphore__->Count, __ATOMIC_ACQUIRE);
-
-    if (CurrentCount > 0)
-    {
-        if (__atomic_compare_exchange_n(&__Semaphore__->Count,
-                                        &CurrentCount,
-                                        CurrentCount - 1,
-                                        false,
-                                        __ATOMIC_ACQUIRE,
-                                        __ATOMIC_RELAXED))
-        {
-            return true; /* Successfully acquired */
-        }
-    }
-
-    /* Count is zero or compare-exchange failed */
-    return false;
+    return __SemaphoreTake__(__Semaphore__);
 }
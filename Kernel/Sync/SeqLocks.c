@@ -0,0 +1,27 @@
+#include <Sync.h> /* Synchronization primitives definitions */
+
+void
+InitializeSeqLock(SeqLock* __Seq__, const char* __Name__)
+{
+    __Seq__->Sequence = 0; /* Even, no writer inside */
+    InitializeSpinLock(&__Seq__->Lock, __Name__);
+}
+
+void
+AcquireSeqLockWrite(SeqLock* __Seq__)
+{
+    AcquireSpinLock(&__Seq__->Lock);
+
+    /* Odd from here on; the fence keeps the data stores after it */
+    __atomic_store_n(&__Seq__->Sequence, __Seq__->Sequence + 1, __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void
+ReleaseSeqLockWrite(SeqLock* __Seq__)
+{
+    /* Even again, published only after the data stores */
+    __atomic_store_n(&__Seq__->Sequence, __Seq__->Sequence + 1, __ATOMIC_RELEASE);
+
+    ReleaseSpinLock(&__Seq__->Lock);
+}
@@ -1,50 +1,96 @@
-#include <SMP.h>  /* Symmetric multiprocessing functions */
-#include <Sync.h> /* Synchronization primitives definitions */
+#include <AxeSchd.h> /* Preemption control */
+#include <SMP.h>     /* Symmetric multiprocessing functions */
+#include <Softirq.h> /* Bottom half control */
+#include <Sync.h>    /* Synchronization primitives definitions */
+#include <Tsc.h>     /* Wait and hold times for lock statistics */
 
-SpinLock        ConsoleLock;
-static uint64_t SavedFlags[MaxCPUs];
+SpinLock ConsoleLock;
 
 void
 InitializeSpinLock(SpinLock* __Lock__, const char* __Name__)
 {
-    __Lock__->Lock  = 0;          /* Initially unlocked */
+    __Lock__->Lock  = 0;          /* Owner == Next, unlocked */
     __Lock__->CpuId = 0xFFFFFFFF; /* No owner (kernel value) */
     __Lock__->Name  = __Name__;   /* Assign name for debugging */
+    __Lock__->Flags = 0;          /* Only meaningful while held */
+#ifdef SyncLockStat
+    __Lock__->Class = LockStatClass(__Name__, LockClassSpin);
+#else
+    __Lock__->Class = NULL; /* Untracked */
+#endif
 }
 
-void
-AcquireSpinLock(SpinLock* __Lock__)
+static void
+__TicketLock__(SpinLock* __Lock__)
 {
-    uint32_t CpuId = GetCurrentCpuId();
+    /* Draw a ticket; everyone ahead of us is served first */
+    uint16_t Ticket = __atomic_fetch_add(&__Lock__->Next, 1, __ATOMIC_RELAXED);
 
-    uint64_t Flags;
-    __asm__ volatile("pushfq; popq %0; cli" : "=r"(Flags)::"memory");
+#ifdef SyncLockStat
+    uint64_t WaitStart = ReadTsc();
+    bool     Contended = __atomic_load_n(&__Lock__->Owner, __ATOMIC_RELAXED) != Ticket;
+#endif
 
     while (1)
     {
-        uint32_t Expected = 0; /* Expect the lock to be free (0) */
-        if (__atomic_compare_exchange_n(
-                &__Lock__->Lock, &Expected, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+        uint16_t Owner = __atomic_load_n(&__Lock__->Owner, __ATOMIC_ACQUIRE);
+        if (Owner == Ticket)
         {
-            /* Successfully acquired the lock */
-            __Lock__->CpuId   = CpuId;
-            SavedFlags[CpuId] = Flags; /* Save flags for this CPU */
+            /* Our turn */
+            __Lock__->CpuId = GetCurrentCpuId();
             break;
         }
-        /* Lock is held by another CPU, spin with pause for efficiency */
-        __asm__ volatile("pause");
+
+        /* Back off in proportion to our place in line so the lock word is read less */
+        for (uint16_t Wait = (uint16_t)(Ticket - Owner); Wait; Wait--)
+        {
+            __asm__ volatile("pause");
+        }
     }
+
+#ifdef SyncLockStat
+    __Lock__->AcquiredTsc = ReadTsc();
+    if (__Lock__->Class)
+    {
+        LockStatAcquired(__Lock__->Class, Contended, __Lock__->AcquiredTsc - WaitStart);
+    }
+#endif
+}
+
+static void
+__TicketUnlock__(SpinLock* __Lock__)
+{
+#ifdef SyncLockStat
+    if (__Lock__->Class)
+    {
+        LockStatReleased(__Lock__->Class, ReadTsc() - __Lock__->AcquiredTsc);
+    }
+#endif
+
+    __Lock__->CpuId = 0xFFFFFFFF; /* Reset owner to none */
+
+    /* Only the holder writes Owner, so a plain increment hands over to the next ticket */
+    __atomic_store_n(&__Lock__->Owner, (uint16_t)(__Lock__->Owner + 1), __ATOMIC_RELEASE);
 }
 
 void
-ReleaseSpinLock(SpinLock* __Lock__)
+AcquireSpinLock(SpinLock* __Lock__)
 {
-    uint32_t CpuId = GetCurrentCpuId();
+    uint64_t Flags;
+    __asm__ volatile("pushfq; popq %0; cli" : "=r"(Flags)::"memory");
 
-    uint64_t Flags = SavedFlags[CpuId];
+    __TicketLock__(__Lock__);
 
-    __Lock__->CpuId = 0xFFFFFFFF;                           /* Reset owner to none */
-    __atomic_store_n(&__Lock__->Lock, 0, __ATOMIC_RELEASE); /* Unlock */
+    /* Kept in the lock, so nested locks each restore their own caller's state */
+    __Lock__->Flags = Flags;
+}
+
+void
+ReleaseSpinLock(SpinLock* __Lock__)
+{
+    uint64_t Flags = __Lock__->Flags;
+
+    __TicketUnlock__(__Lock__);
 
     __asm__ volatile("pushq %0; popfq" ::"r"(Flags) : "memory");
 }
@@ -52,15 +98,61 @@ ReleaseSpinLock(SpinLock* __Lock__)
 bool
 TryAcquireSpinLock(SpinLock* __Lock__)
 {
-    uint32_t Expected = 0;
-    if (__atomic_compare_exchange_n(
-            &__Lock__->Lock, &Expected, 1, false, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED))
+    uint64_t Flags;
+    __asm__ volatile("pushfq; popq %0; cli" : "=r"(Flags)::"memory");
+
+    /* Free only when nobody holds or waits for a ticket; take the next one in one go */
+    uint32_t Expected = __atomic_load_n(&__Lock__->Lock, __ATOMIC_RELAXED);
+    if ((Expected & 0xFFFF) == (Expected >> 16) &&
+        __atomic_compare_exchange_n(&__Lock__->Lock,
+                                    &Expected,
+                                    Expected + 0x10000,
+                                    false,
+                                    __ATOMIC_ACQUIRE,
+                                    __ATOMIC_RELAXED))
     {
-        /* Successfully acquired */
+        /* Successfully acquired, released with ReleaseSpinLock */
         __Lock__->CpuId = GetCurrentCpuId();
+        __Lock__->Flags = Flags;
+#ifdef SyncLockStat
+        __Lock__->AcquiredTsc = ReadTsc();
+        if (__Lock__->Class)
+        {
+            LockStatAcquired(__Lock__->Class, false, 0);
+        }
+#endif
         return true;
     }
 
     /* Failed to acquire */
+    __asm__ volatile("pushq %0; popfq" ::"r"(Flags) : "memory");
     return false;
 }
+
+void
+AcquireSpinLockBh(SpinLock* __Lock__)
+{
+    LocalBhDisable();
+    __TicketLock__(__Lock__);
+}
+
+void
+ReleaseSpinLockBh(SpinLock* __Lock__)
+{
+    __TicketUnlock__(__Lock__);
+    LocalBhEnable();
+}
+
+void
+AcquireSpinLockPlain(SpinLock* __Lock__)
+{
+    PreemptDisable();
+    __TicketLock__(__Lock__);
+}
+
+void
+ReleaseSpinLockPlain(SpinLock* __Lock__)
+{
+    __TicketUnlock__(__Lock__);
+    PreemptEnable();
+}
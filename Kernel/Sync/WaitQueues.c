@@ -0,0 +1,176 @@
+#include <AxeSchd.h>    /* Preemption control and waking blocked threads */
+#include <AxeThreads.h> /* Blocking the current thread */
+#include <SMP.h>        /* Symmetric multiprocessing functions */
+#include <Softirq.h>    /* Softirqs cannot sleep */
+#include <Sync.h>       /* Synchronization primitives definitions */
+
+/*
+ * Sleep/wake queues. A waiter puts itself on the queue before it tests the
+ * condition, and a waker makes the condition true before it looks at the
+ * queue, so one of the two always sees the other. Waiters are woken under
+ * the queue lock: a woken thread cannot get back out of WaitEvent, and off
+ * its stack entry, until the waker is done with it.
+ */
+
+void
+InitializeWaitQueue(WaitQueue* __Queue__, const char* __Name__)
+{
+    __Queue__->Head   = NULL;         /* Nobody waiting */
+    __Queue__->Tail   = NULL;         /* Empty queue */
+    __Queue__->Reason = WaitReasonIo; /* Owners narrow this down */
+    InitializeSpinLock(&__Queue__->Lock, __Name__);
+}
+
+/*The thread to block, or NULL where only spinning is allowed*/
+static Thread*
+__WaitSelf__(void)
+{
+    uint64_t Flags;
+    __asm__ volatile("pushfq; popq %0" : "=r"(Flags));
+
+    uint32_t CpuId = GetCurrentCpuId();
+    if (!(Flags & 0x200) || PreemptDisabled(CpuId) || SoftirqActive(CpuId))
+    {
+        return NULL;
+    }
+
+    return GetCurrentThread(CpuId);
+}
+
+static void
+__WaitUnlink__(WaitQueue* __Queue__, WaitQueueEntry* __Entry__)
+{
+    WaitQueueEntry* Prev = NULL;
+    WaitQueueEntry* Curr = __Queue__->Head;
+    while (Curr && Curr != __Entry__)
+    {
+        Prev = Curr;
+        Curr = Curr->Next;
+    }
+
+    if (!Curr)
+    {
+        return;
+    }
+
+    if (Prev)
+    {
+        Prev->Next = Curr->Next;
+    }
+    else
+    {
+        __Queue__->Head = Curr->Next;
+    }
+
+    if (__Queue__->Tail == Curr)
+    {
+        __Queue__->Tail = Prev;
+    }
+
+    Curr->Next   = NULL;
+    Curr->Queued = 0;
+}
+
+void
+WaitEvent(WaitQueue* __Queue__, WaitCondition __Cond__, void* __Arg__)
+{
+    Thread*        Self  = __WaitSelf__();
+    WaitQueueEntry Entry = {Self, NULL, 0};
+
+    while (1)
+    {
+        AcquireSpinLock(&__Queue__->Lock);
+
+        /* Queued again after every wakeup, at the back, so nobody jumps the line twice */
+        if (Self && !Entry.Queued)
+        {
+            Entry.Queued = 1;
+            if (__Queue__->Tail)
+            {
+                __Queue__->Tail->Next = &Entry;
+            }
+            else
+            {
+                __Queue__->Head = &Entry;
+            }
+            __Queue__->Tail = &Entry;
+        }
+
+        /* Pairs with the fence in the wakers: queued first, tested second */
+        __atomic_thread_fence(__ATOMIC_SEQ_CST);
+
+        if (__Cond__(__Arg__))
+        {
+            if (Entry.Queued)
+            {
+                __WaitUnlink__(__Queue__, &Entry);
+            }
+            ReleaseSpinLock(&__Queue__->Lock);
+
+            if (Self)
+            {
+                Self->WaitingOn = NULL;
+            }
+            return;
+        }
+
+        if (!Self)
+        {
+            ReleaseSpinLock(&__Queue__->Lock);
+            __asm__ volatile("pause");
+            continue;
+        }
+
+        /* A wakeup from here on finds us blocked, or turns the switch-out into a requeue */
+        Self->WaitingOn  = __Queue__;
+        Self->WaitReason = __Queue__->Reason;
+        Self->State      = ThreadStateBlocked;
+        ReleaseSpinLock(&__Queue__->Lock);
+        ThreadYield();
+    }
+}
+
+/*Wake up to Count waiters from the front of the queue*/
+static int
+__WakeQueue__(WaitQueue* __Queue__, int __Count__)
+{
+    /* Whatever the caller changed is visible before we look for sleepers */
+    __atomic_thread_fence(__ATOMIC_SEQ_CST);
+    if (!__atomic_load_n(&__Queue__->Head, __ATOMIC_RELAXED))
+    {
+        return 0;
+    }
+
+    int Woken = 0;
+    AcquireSpinLock(&__Queue__->Lock);
+
+    while (__Queue__->Head && (__Count__ < 0 || Woken < __Count__))
+    {
+        WaitQueueEntry* Entry = __Queue__->Head;
+        __Queue__->Head       = Entry->Next;
+        if (!__Queue__->Head)
+        {
+            __Queue__->Tail = NULL;
+        }
+
+        Entry->Next   = NULL;
+        Entry->Queued = 0;
+        WakeupThread(Entry->Thread);
+        Woken++;
+    }
+
+    ReleaseSpinLock(&__Queue__->Lock);
+    return Woken;
+}
+
+int
+WakeUp(WaitQueue* __Queue__)
+{
+    return __WakeQueue__(__Queue__, 1);
+}
+
+int
+WakeUpAll(WaitQueue* __Queue__)
+{
+    return __WakeQueue__(__Queue__, -1);
+}
@@ -26,6 +26,7 @@
 #include <Sync.h>
 #include <Syscall.h>
 #include <Timer.h>
+#include <Tsc.h>
 #include <VFS.h>
 #include <VMM.h>
 #include <VirtBin.h>
@@ -372,6 +373,236 @@ __Handle__SchedYield(uint64_t __U1__,
     return 0;
 }
 
+/*pid 0 is the caller; others resolve to the main thread of that process*/
+static Thread*
+__SchedTarget__(uint64_t __Pid__, int __Modify__)
+{
+    PosixProc* Self = __GetCurrentProc__();
+    if (!__Pid__)
+    {
+        return GetCurrentThread(GetCurrentCpuId());
+    }
+
+    PosixProc* Proc = PosixFind((long)__Pid__);
+    if (!Proc || Proc->Zombie)
+    {
+        return NULL;
+    }
+
+    /*Only root may retune someone else's threads*/
+    if (__Modify__ && Self && Self != Proc && Self->Cred.Euid != 0 &&
+        Self->Cred.Euid != Proc->Cred.Ruid)
+    {
+        return NULL;
+    }
+    return Proc->MainThread;
+}
+
+static int64_t
+__SchedApply__(uint64_t __Pid__, uint64_t __Policy__, uint64_t __ParamPtr__, int __KeepPolicy__)
+{
+    if (!__ParamPtr__)
+    {
+        return -1;
+    }
+
+    Thread* Target = __SchedTarget__(__Pid__, 1);
+    if (!Target)
+    {
+        return -1;
+    }
+
+    struct
+    {
+        int Priority;
+    }*       Param  = (void*)__ParamPtr__;
+    uint64_t Policy = __KeepPolicy__ ? (uint64_t)Target->Policy : __Policy__;
+
+    /*Entering a realtime class is a privileged operation*/
+    PosixProc* Self = __GetCurrentProc__();
+    if (Policy != SchedPolicyNormal && Self && Self->Cred.Euid != 0)
+    {
+        return -1;
+    }
+
+    if (Policy > SchedPolicyRr || Param->Priority < 0)
+    {
+        return -1;
+    }
+
+    return SetThreadScheduler(Target, (SchedPolicy)Policy, (uint32_t)Param->Priority);
+}
+
+int64_t
+__Handle__SchedSetparam(uint64_t __Pid__,
+                        uint64_t __ParamPtr__,
+                        uint64_t __U3__,
+                        uint64_t __U4__,
+                        uint64_t __U5__,
+                        uint64_t __U6__)
+{
+    return __SchedApply__(__Pid__, 0, __ParamPtr__, 1);
+}
+
+int64_t
+__Handle__SchedGetparam(uint64_t __Pid__,
+                        uint64_t __ParamPtr__,
+                        uint64_t __U3__,
+                        uint64_t __U4__,
+                        uint64_t __U5__,
+                        uint64_t __U6__)
+{
+    Thread* Target = __SchedTarget__(__Pid__, 0);
+    if (!Target || !__ParamPtr__)
+    {
+        return -1;
+    }
+
+    struct
+    {
+        int Priority;
+    }* Param        = (void*)__ParamPtr__;
+    Param->Priority = (int)Target->RtPriority;
+    return 0;
+}
+
+int64_t
+__Handle__SchedSetscheduler(uint64_t __Pid__,
+                            uint64_t __Policy__,
+                            uint64_t __ParamPtr__,
+                            uint64_t __U4__,
+                            uint64_t __U5__,
+                            uint64_t __U6__)
+{
+    return __SchedApply__(__Pid__, __Policy__, __ParamPtr__, 0);
+}
+
+int64_t
+__Handle__SchedGetscheduler(uint64_t __Pid__,
+                            uint64_t __U2__,
+                            uint64_t __U3__,
+                            uint64_t __U4__,
+                            uint64_t __U5__,
+                            uint64_t __U6__)
+{
+    Thread* Target = __SchedTarget__(__Pid__, 0);
+    return Target ? (int64_t)Target->Policy : -1;
+}
+
+int64_t
+__Handle__SchedGetPriorityMax(uint64_t __Policy__,
+                              uint64_t __U2__,
+                              uint64_t __U3__,
+                              uint64_t __U4__,
+                              uint64_t __U5__,
+                              uint64_t __U6__)
+{
+    if (__Policy__ > SchedPolicyRr)
+    {
+        return -1;
+    }
+    return __Policy__ == SchedPolicyNormal ? 0 : RtPriorityMax;
+}
+
+int64_t
+__Handle__SchedGetPriorityMin(uint64_t __Policy__,
+                              uint64_t __U2__,
+                              uint64_t __U3__,
+                              uint64_t __U4__,
+                              uint64_t __U5__,
+                              uint64_t __U6__)
+{
+    if (__Policy__ > SchedPolicyRr)
+    {
+        return -1;
+    }
+    return __Policy__ == SchedPolicyNormal ? 0 : RtPriorityMin;
+}
+
+int64_t
+__Handle__SchedRrGetInterval(uint64_t __Pid__,
+                             uint64_t __TsPtr__,
+                             uint64_t __U3__,
+                             uint64_t __U4__,
+                             uint64_t __U5__,
+                             uint64_t __U6__)
+{
+    Thread* Target = __SchedTarget__(__Pid__, 0);
+    if (!Target || !__TsPtr__)
+    {
+        return -1;
+    }
+
+    /*FIFO has no quantum and normal threads are rotated every tick*/
+    uint64_t Ticks = 1;
+    if (Target->Policy == SchedPolicyFifo)
+    {
+        Ticks = 0;
+    }
+    else if (Target->Policy == SchedPolicyRr)
+    {
+        Ticks = RtTunables.RrQuantum;
+    }
+
+    uint64_t Freq = Timer.TimerFrequency ? Timer.TimerFrequency : TimerTargetFrequency;
+    uint64_t Ns   = Ticks * 1000000000ULL / Freq;
+    struct
+    {
+        long Sec;
+        long Nsec;
+    }* ts    = (void*)__TsPtr__;
+    ts->Sec  = (long)(Ns / 1000000000ULL);
+    ts->Nsec = (long)(Ns % 1000000000ULL);
+    return 0;
+}
+
+int64_t
+__Handle__SchedGroup(uint64_t __Op__,
+                     uint64_t __A1__,
+                     uint64_t __A2__,
+                     uint64_t __A3__,
+                     uint64_t __U5__,
+                     uint64_t __U6__)
+{
+    PosixProc* Self = __GetCurrentProc__();
+    int        Root = !Self || Self->Cred.Euid == 0;
+    uint64_t   Freq = Timer.TimerFrequency ? Timer.TimerFrequency : TimerTargetFrequency;
+
+    switch (__Op__)
+    {
+        case SchedGroupOpCreate:
+            if (!Root || !__A1__)
+            {
+                return -1;
+            }
+            return SchedGroupCreate((const char*)__A1__, (uint32_t)__A2__);
+
+        case SchedGroupOpDestroy:
+            return Root ? SchedGroupDestroy((uint32_t)__A1__) : -1;
+
+        case SchedGroupOpSetShares:
+            return Root ? SchedGroupSetShares((uint32_t)__A1__, (uint32_t)__A2__) : -1;
+
+        case SchedGroupOpSetQuota:
+            if (!Root)
+            {
+                return -1;
+            }
+            return SchedGroupSetQuota(
+                (uint32_t)__A1__, __A2__ * Freq / 1000ULL, __A3__ * Freq / 1000ULL);
+
+        case SchedGroupOpAttach:
+        {
+            /*Otherwise a capped process could just move itself out*/
+            Thread* Target = Root ? __SchedTarget__(__A2__, 1) : NULL;
+            return Target ? SchedGroupAttach(Target, (uint32_t)__A1__) : -1;
+        }
+
+        default:
+            return -1;
+    }
+}
+
 int64_t
 __Handle__Nanosleep(uint64_t __ReqPtr__,
                     uint64_t __RemPtr__,
@@ -481,7 +712,12 @@ __Handle__Exit(uint64_t __Status__,
         return -1;
     }
     PosixExit(Proc, (int)__Status__);
-    return 0;
+
+    /*The caller is terminated now; the scheduler switches away and hands it to the reaper*/
+    for (;;)
+    {
+        ThreadYield();
+    }
 }
 
 int64_t
@@ -605,10 +841,10 @@ __Handle__Gettimeofday(uint64_t __Tv__,
     {
         long Sec;
         long Usec;
-    }*       tv    = (void*)__Tv__;
-    uint64_t ticks = GetSystemTicks();
-    tv->Sec        = (long)(ticks / 1000ULL);
-    tv->Usec       = (long)((ticks % 1000ULL) * 1000ULL);
+    }*       tv = (void*)__Tv__;
+    uint64_t Ns = GetRealtimeNs();
+    tv->Sec     = (long)(Ns / 1000000000ULL);
+    tv->Usec    = (long)((Ns % 1000000000ULL) / 1000ULL);
     return 0;
 }
 
@@ -635,11 +871,58 @@ __Handle__Times(uint64_t __TmsPtr__,
         long Stime;
         long Cutime;
         long Cstime;
-    }* tms      = (void*)__TmsPtr__;
+    }* tms = (void*)__TmsPtr__;
+    PosixRefreshTimes(Proc);
     tms->Utime  = (long)(Proc->Times.UserUsec / 10000ULL); /* arbitrary 1/100 sec units */
     tms->Stime  = (long)(Proc->Times.SysUsec / 10000ULL);
-    tms->Cutime = 0;
-    tms->Cstime = 0;
+    tms->Cutime = (long)(Proc->Times.ChildNs[AcctUser] / 10000000ULL);
+    tms->Cstime = (long)(Proc->Times.ChildNs[AcctSys] / 10000000ULL);
+    return 0;
+}
+
+int64_t
+__Handle__Getrusage(uint64_t __Who__,
+                    uint64_t __RusagePtr__,
+                    uint64_t __U3__,
+                    uint64_t __U4__,
+                    uint64_t __U5__,
+                    uint64_t __U6__)
+{
+    if (!__RusagePtr__)
+    {
+        return -1;
+    }
+    PosixProc* Proc = __GetCurrentProc__();
+    if (!Proc)
+    {
+        return -1;
+    }
+
+    uint64_t UserNs, SysNs;
+    PosixRefreshTimes(Proc);
+    if ((int64_t)__Who__ == 0) /*RUSAGE_SELF*/
+    {
+        UserNs = Proc->Times.Ns[AcctUser];
+        SysNs  = Proc->Times.Ns[AcctSys];
+    }
+    else if ((int64_t)__Who__ == -1) /*RUSAGE_CHILDREN*/
+    {
+        UserNs = Proc->Times.ChildNs[AcctUser];
+        SysNs  = Proc->Times.ChildNs[AcctSys];
+    }
+    else
+    {
+        return -1;
+    }
+
+    PosixRusage ru = {0};
+    ru.UtimeUsec   = UserNs / 1000ULL;
+    ru.StimeUsec   = SysNs / 1000ULL;
+    if (Proc->MainThread && (int64_t)__Who__ == 0)
+    {
+        ru.InvoluntaryCtxt = Proc->MainThread->ContextSwitches;
+    }
+    *(PosixRusage*)__RusagePtr__ = ru;
     return 0;
 }
 
@@ -659,10 +942,82 @@ __Handle__ClockGettime(uint64_t __ClkId__,
     {
         long Sec;
         long Nsec;
-    }*       tp    = (void*)__Tp__;
-    uint64_t ticks = GetSystemTicks();
-    tp->Sec        = (long)(ticks / 1000ULL);
-    tp->Nsec       = (long)((ticks % 1000ULL) * 1000000ULL);
+    }* tp = (void*)__Tp__;
+
+    /*CPU-time clocks come from the per-thread cycle accounting*/
+    if (__ClkId__ == ClockProcessCputime || __ClkId__ == ClockThreadCputime)
+    {
+        PosixProc* Proc = __GetCurrentProc__();
+        if (!Proc || !Proc->MainThread)
+        {
+            return -1;
+        }
+        uint64_t Ns;
+        if (__ClkId__ == ClockProcessCputime)
+        {
+            PosixRefreshTimes(Proc);
+            Ns = Proc->Times.Ns[AcctUser] + Proc->Times.Ns[AcctSys];
+        }
+        else
+        {
+            Ns = ThreadAcctNs(Proc->MainThread, AcctUser) + ThreadAcctNs(Proc->MainThread, AcctSys);
+        }
+        tp->Sec  = (long)(Ns / 1000000000ULL);
+        tp->Nsec = (long)(Ns % 1000000000ULL);
+        return 0;
+    }
+
+    uint64_t Ns;
+    switch (__ClkId__)
+    {
+        case ClockRealtime:
+        case ClockRealtimeCoarse:
+            Ns = GetRealtimeNs();
+            break;
+        case ClockMonotonic:
+        case ClockMonotonicRaw:
+        case ClockMonotonicCoarse:
+        case ClockBoottime:
+            Ns = GetSystemTimeNs();
+            break;
+        default:
+            return -1;
+    }
+    tp->Sec  = (long)(Ns / 1000000000ULL);
+    tp->Nsec = (long)(Ns % 1000000000ULL);
+    return 0;
+}
+
+int64_t
+__Handle__ClockGetres(uint64_t __ClkId__,
+                      uint64_t __Res__,
+                      uint64_t __U3__,
+                      uint64_t __U4__,
+                      uint64_t __U5__,
+                      uint64_t __U6__)
+{
+    if (__ClkId__ > ClockBoottime)
+    {
+        return -1;
+    }
+    if (!__Res__)
+    {
+        return 0;
+    }
+    struct
+    {
+        long Sec;
+        long Nsec;
+    }* res = (void*)__Res__;
+
+    /*CPU-time clocks count TSC cycles, so they resolve as finely as the TSC does*/
+    uint64_t Ns = GetClockResolutionNs();
+    if (__ClkId__ == ClockProcessCputime || __ClkId__ == ClockThreadCputime)
+    {
+        Ns = (1000000000ULL + Tsc.Frequency - 1) / Tsc.Frequency;
+    }
+    res->Sec  = 0;
+    res->Nsec = (long)Ns;
     return 0;
 }
 
@@ -1,3 +1,4 @@
+#include <AxeThreads.h>
 #include <SysABI.h>
 #include <SysTbl.h>
 #include <Syscall.h>
@@ -16,7 +17,11 @@ SyscallHandler(uint64_t __SyscallNo__,
         __asm__ volatile("movq $-1, %%rax" : : : "rax");
         return;
     }
+
+    ThreadAcctSyscallEnter();
     int64_t RaxrRes = SysTbl[__SyscallNo__].Handler(__A1__, __A2__, __A3__, __A4__, __A5__, __A6__);
+    ThreadAcctSyscallExit(); /*Before rax is loaded, the call would clobber it*/
+
     __asm__ volatile("movq %0, %%rax" : : "r"(RaxrRes) : "rax");
 }
 
@@ -36,6 +41,7 @@ __asm__(".global SysEntASM\n"
         " pushq %r13\n"
         " pushq %r14\n"
         " pushq %r15\n"
+        " cld # C code expects DF clear; iretq restores the caller's\n"
         " \n"
         " # RAX = syscall number\n"
         " # RDI = __A1__, RSI = __A2__, RDX = __A3__\n"
@@ -115,6 +121,30 @@ InitSyscall(void)
     SysTbl[SysSchedYield].Handler = __Handle__SchedYield;
     SysTbl[SysSchedYield].SysName = "sched_yield";
 
+    SysTbl[SysSchedSetparam].Handler = __Handle__SchedSetparam;
+    SysTbl[SysSchedSetparam].SysName = "sched_setparam";
+
+    SysTbl[SysSchedGetparam].Handler = __Handle__SchedGetparam;
+    SysTbl[SysSchedGetparam].SysName = "sched_getparam";
+
+    SysTbl[SysSchedSetscheduler].Handler = __Handle__SchedSetscheduler;
+    SysTbl[SysSchedSetscheduler].SysName = "sched_setscheduler";
+
+    SysTbl[SysSchedGetscheduler].Handler = __Handle__SchedGetscheduler;
+    SysTbl[SysSchedGetscheduler].SysName = "sched_getscheduler";
+
+    SysTbl[SysSchedGetPriorityMax].Handler = __Handle__SchedGetPriorityMax;
+    SysTbl[SysSchedGetPriorityMax].SysName = "sched_get_priority_max";
+
+    SysTbl[SysSchedGetPriorityMin].Handler = __Handle__SchedGetPriorityMin;
+    SysTbl[SysSchedGetPriorityMin].SysName = "sched_get_priority_min";
+
+    SysTbl[SysSchedRrGetInterval].Handler = __Handle__SchedRrGetInterval;
+    SysTbl[SysSchedRrGetInterval].SysName = "sched_rr_get_interval";
+
+    SysTbl[SysSchedGroup].Handler = __Handle__SchedGroup;
+    SysTbl[SysSchedGroup].SysName = "axe_sched_group";
+
     SysTbl[SysMkdir].Handler = __Handle__Mkdir;
     SysTbl[SysMkdir].SysName = "mkdir";
 
@@ -175,9 +205,15 @@ InitSyscall(void)
     SysTbl[SysTimes].Handler = __Handle__Times;
     SysTbl[SysTimes].SysName = "times";
 
+    SysTbl[SysGetrusage].Handler = __Handle__Getrusage;
+    SysTbl[SysGetrusage].SysName = "getrusage";
+
     SysTbl[SysClockGettime].Handler = __Handle__ClockGettime;
     SysTbl[SysClockGettime].SysName = "clock_gettime";
 
+    SysTbl[SysClockGetres].Handler = __Handle__ClockGetres;
+    SysTbl[SysClockGetres].SysName = "clock_getres";
+
     SysTbl[SysMmap].Handler = __Handle__Mmap;
     SysTbl[SysMmap].SysName = "mmap";
 
@@ -0,0 +1,129 @@
+#include <Timer.h> /* Timer management structures */
+
+#define RtcPortIndex   0x70
+#define RtcPortData    0x71
+#define RtcRegStatusA  0x0A
+#define RtcRegStatusB  0x0B
+#define RtcUpdating    0x80 /*Status A: the chip is rolling the time over*/
+#define RtcBinary      0x04 /*Status B: binary, not BCD*/
+#define RtcHour24      0x02 /*Status B: 24 hour clock*/
+#define RtcHourPm      0x80 /*Hour register PM bit in 12 hour mode*/
+#define RtcMaxAttempts 1000
+
+typedef struct
+{
+    uint8_t Second;
+    uint8_t Minute;
+    uint8_t Hour;
+    uint8_t Day;
+    uint8_t Month;
+    uint8_t Year;
+
+} RtcTime;
+
+static uint8_t
+__CmosRead__(uint8_t __Reg__)
+{
+    uint8_t Value;
+    __asm__ volatile("outb %0, %1" : : "a"(__Reg__), "Nd"((uint16_t)RtcPortIndex));
+    __asm__ volatile("inb %1, %0" : "=a"(Value) : "Nd"((uint16_t)RtcPortData));
+    return Value;
+}
+
+static void
+__RtcRead__(RtcTime* __Time__)
+{
+    /* Registers are not stable while an update is in progress */
+    for (uint32_t Spin = 0; Spin < RtcMaxAttempts && (__CmosRead__(RtcRegStatusA) & RtcUpdating);
+         Spin++)
+    {
+        __asm__ volatile("pause");
+    }
+
+    __Time__->Second = __CmosRead__(0x00);
+    __Time__->Minute = __CmosRead__(0x02);
+    __Time__->Hour   = __CmosRead__(0x04);
+    __Time__->Day    = __CmosRead__(0x07);
+    __Time__->Month  = __CmosRead__(0x08);
+    __Time__->Year   = __CmosRead__(0x09);
+}
+
+static int
+__RtcSame__(const RtcTime* __A__, const RtcTime* __B__)
+{
+    return __A__->Second == __B__->Second && __A__->Minute == __B__->Minute &&
+           __A__->Hour == __B__->Hour && __A__->Day == __B__->Day &&
+           __A__->Month == __B__->Month && __A__->Year == __B__->Year;
+}
+
+static uint8_t
+__FromBcd__(uint8_t __Value__)
+{
+    return (uint8_t)((__Value__ & 0x0F) + (__Value__ >> 4) * 10);
+}
+
+/*Days from 1970-01-01 to a civil date, proleptic Gregorian*/
+static int64_t
+__DaysFromCivil__(int64_t __Year__, int64_t __Month__, int64_t __Day__)
+{
+    __Year__ -= __Month__ <= 2;
+    int64_t Era = (__Year__ >= 0 ? __Year__ : __Year__ - 399) / 400;
+    int64_t Yoe = __Year__ - Era * 400;
+    int64_t Doy = (153 * (__Month__ + (__Month__ > 2 ? -3 : 9)) + 2) / 5 + __Day__ - 1;
+    int64_t Doe = Yoe * 365 + Yoe / 4 - Yoe / 100 + Doy;
+
+    return Era * 146097 + Doe - 719468;
+}
+
+/*Wall clock seconds since the epoch from the CMOS RTC, 0 when it reads as garbage*/
+uint64_t
+ReadRtcSeconds(void)
+{
+    RtcTime Now;
+    RtcTime Again;
+
+    /* Read until two passes agree, so no field was caught mid-rollover */
+    __RtcRead__(&Now);
+    for (uint32_t Attempt = 0; Attempt < RtcMaxAttempts; Attempt++)
+    {
+        __RtcRead__(&Again);
+        if (__RtcSame__(&Now, &Again))
+        {
+            break;
+        }
+        Now = Again;
+    }
+
+    uint8_t StatusB = __CmosRead__(RtcRegStatusB);
+    uint8_t Pm      = Now.Hour & RtcHourPm;
+    Now.Hour &= (uint8_t)~RtcHourPm;
+
+    if (!(StatusB & RtcBinary))
+    {
+        Now.Second = __FromBcd__(Now.Second);
+        Now.Minute = __FromBcd__(Now.Minute);
+        Now.Hour   = __FromBcd__(Now.Hour);
+        Now.Day    = __FromBcd__(Now.Day);
+        Now.Month  = __FromBcd__(Now.Month);
+        Now.Year   = __FromBcd__(Now.Year);
+    }
+
+    if (!(StatusB & RtcHour24))
+    {
+        Now.Hour = (uint8_t)((Now.Hour % 12) + (Pm ? 12 : 0));
+    }
+
+    if (Now.Month < 1 || Now.Month > 12 || Now.Day < 1 || Now.Day > 31 || Now.Hour > 23 ||
+        Now.Minute > 59 || Now.Second > 59)
+    {
+        PWarn("RTC: Unreadable time, realtime starts at the epoch\n");
+        return 0;
+    }
+
+    /* No century register without ACPI; two digit years pivot at 1970 */
+    int64_t Year = Now.Year < 70 ? 2000 + Now.Year : 1900 + Now.Year;
+    int64_t Days = __DaysFromCivil__(Year, Now.Month, Now.Day);
+
+    return (uint64_t)(Days * 86400 + (int64_t)Now.Hour * 3600 + (int64_t)Now.Minute * 60 +
+                      (int64_t)Now.Second);
+}
@@ -0,0 +1,199 @@
+#include <Tsc.h>
+
+TscManager Tsc;
+
+static inline uint8_t
+__PortIn__(uint16_t __Port__)
+{
+    uint8_t Value;
+    __asm__ volatile("inb %1, %0" : "=a"(Value) : "Nd"(__Port__));
+    return Value;
+}
+
+static inline void
+__PortOut__(uint16_t __Port__, uint8_t __Value__)
+{
+    __asm__ volatile("outb %0, %1" : : "a"(__Value__), "Nd"(__Port__));
+}
+
+/*CPUID 0x15 reports TSC/crystal ratio and, on newer parts, the crystal frequency*/
+static uint64_t
+__TscFromCpuid__(void)
+{
+    uint32_t Eax, Ebx, Ecx, Edx;
+
+    __asm__ volatile("cpuid" : "=a"(Eax), "=b"(Ebx), "=c"(Ecx), "=d"(Edx) : "a"(0));
+    if (Eax < 0x15)
+    {
+        return 0;
+    }
+
+    __asm__ volatile("cpuid" : "=a"(Eax), "=b"(Ebx), "=c"(Ecx), "=d"(Edx) : "a"(0x15), "c"(0));
+    if (!Eax || !Ebx || !Ecx)
+    {
+        return 0;
+    }
+
+    return ((uint64_t)Ecx * Ebx) / Eax;
+}
+
+/*Only an invariant TSC ticks at one rate whatever the core's power state*/
+static uint32_t
+__TscInvariant__(void)
+{
+    uint32_t Eax, Ebx, Ecx, Edx;
+
+    __asm__ volatile("cpuid" : "=a"(Eax), "=b"(Ebx), "=c"(Ecx), "=d"(Edx) : "a"(0x80000000));
+    if (Eax < 0x80000007)
+    {
+        return 0;
+    }
+
+    __asm__ volatile("cpuid" : "=a"(Eax), "=b"(Ebx), "=c"(Ecx), "=d"(Edx) : "a"(0x80000007));
+    return (Edx >> 8) & 1;
+}
+
+/*Latched PIT channel 2 count, with the TSC at the middle of the tightest of a few reads*/
+static uint16_t
+__PitRead__(uint64_t* __Stamp__)
+{
+    uint64_t Best  = ~0ULL;
+    uint16_t Count = 0;
+
+    for (uint32_t Try = 0; Try < TscPitReadTries; Try++)
+    {
+        uint64_t Before = ReadTsc();
+        __PortOut__(0x43, 0x80); /*Latch ch2*/
+        uint8_t  Lo    = __PortIn__(0x42);
+        uint8_t  Hi    = __PortIn__(0x42);
+        uint64_t After = ReadTsc();
+
+        if (After - Before < Best)
+        {
+            Best       = After - Before;
+            Count      = (uint16_t)(Lo | (Hi << 8));
+            *__Stamp__ = Before + (After - Before) / 2;
+        }
+    }
+    return Count;
+}
+
+/*
+ * TSC rate over TscCalibrateMs of free-running PIT channel 2. It wraps every
+ * 55 ms, so the counts are summed between back to back reads; each end is
+ * only as uncertain as one port read.
+ */
+static uint64_t
+__TscPitRun__(void)
+{
+    uint64_t Want = (uint64_t)TscPitHz * TscCalibrateMs / 1000;
+    uint64_t Start;
+    uint64_t Now     = 0;
+    uint64_t Elapsed = 0;
+    uint64_t Spins   = 0;
+    uint16_t Last    = __PitRead__(&Start);
+
+    while (Elapsed < Want)
+    {
+        uint16_t Count = __PitRead__(&Now);
+        Elapsed += (uint16_t)(Last - Count); /*Counts down; the 16 bit difference spans a wrap*/
+        Last = Count;
+
+        if (++Spins > 100000000ULL)
+        {
+            return 0;
+        }
+    }
+
+    return (Now - Start) * TscPitHz / Elapsed;
+}
+
+/*Median of several PIT runs; 0 when the runs disagree by more than TscCalibrateSpreadPpm*/
+static uint64_t
+__TscFromPit__(uint64_t* __Median__)
+{
+    uint64_t Runs[TscCalibrateRuns];
+    uint8_t  Gate = __PortIn__(0x61);
+
+    __PortOut__(0x61, (uint8_t)((Gate & ~0x02) | 0x01)); /*Gate on, speaker off*/
+    __PortOut__(0x43, 0xB4);                             /*Ch2, lo/hi, mode 2, free running*/
+    __PortOut__(0x42, 0);                                /*Reload 0 is 65536*/
+    __PortOut__(0x42, 0);
+
+    for (uint32_t Run = 0; Run < TscCalibrateRuns; Run++)
+    {
+        Runs[Run] = __TscPitRun__();
+    }
+    __PortOut__(0x61, Gate);
+
+    /*Insertion sort; there are only a handful*/
+    for (uint32_t Index = 1; Index < TscCalibrateRuns; Index++)
+    {
+        uint64_t Value = Runs[Index];
+        uint32_t Slot  = Index;
+        while (Slot && Runs[Slot - 1] > Value)
+        {
+            Runs[Slot] = Runs[Slot - 1];
+            Slot--;
+        }
+        Runs[Slot] = Value;
+    }
+
+    uint64_t Median = Runs[TscCalibrateRuns / 2];
+    uint64_t Spread = Runs[TscCalibrateRuns - 1] - Runs[0];
+
+    *__Median__ = Median;
+    if (!Runs[0] || Spread * 1000000ULL > Median * TscCalibrateSpreadPpm)
+    {
+        PWarn("TSC: PIT runs %lu..%lu Hz disagree\n", Runs[0], Runs[TscCalibrateRuns - 1]);
+        return 0;
+    }
+
+    PDebug("TSC: PIT runs within %lu ppm\n", Median ? Spread * 1000000ULL / Median : 0);
+    return Median;
+}
+
+void
+InitializeTsc(void)
+{
+    uint64_t Median    = 0;
+    uint64_t Frequency = __TscFromCpuid__();
+    if (!Frequency)
+    {
+        Frequency = __TscFromPit__(&Median);
+    }
+
+    /*Disagreeing runs still beat a guess for accounting, but the clock stays on ticks*/
+    Tsc.Calibrated = Frequency != 0;
+    if (!Frequency)
+    {
+        Frequency = Median ? Median : TscFallbackFreqHz;
+        PWarn("TSC: Calibration failed, assuming %lu Hz\n", Frequency);
+    }
+
+    Tsc.Frequency = Frequency;
+    Tsc.NsMult    = (1000000000ULL << 32) / Frequency;
+    Tsc.Invariant = __TscInvariant__();
+
+    /* Largest shift that keeps Mult in 32 bits, for the most precision the clock can use */
+    uint32_t Shift = 32;
+    uint64_t Mult  = (1000000000ULL << Shift) / Frequency;
+    while (Shift && Mult > 0xFFFFFFFFULL)
+    {
+        Shift--;
+        Mult = (1000000000ULL << Shift) / Frequency;
+    }
+    Tsc.Mult  = (uint32_t)Mult;
+    Tsc.Shift = Shift;
+
+    PSuccess("TSC: %lu.%03lu MHz%s\n",
+             Frequency / 1000000,
+             (Frequency / 1000) % 1000,
+             Tsc.Invariant ? ", invariant" : "");
+}
+
+uint64_t
+TscToNs(uint64_t __Cycles__)
+{
+    return (uint64_t)(((unsigned __int128)__Cycles__ * Tsc.NsMult) >> 32);
+}
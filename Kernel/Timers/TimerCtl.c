@@ -3,21 +3,75 @@
 #include <AxeThreads.h> /* Thread management functions */
 #include <HPETTimer.h>  /* HPET timer constants and functions */
 #include <PerCPUData.h> /* Per-CPU data structures */
+#include <PerCpu.h>     /* Per-CPU interrupt counter */
 #include <SMP.h>        /* Symmetric multiprocessing functions */
+#include <Softirq.h>    /* Timer bottom half */
 #include <SymAP.h>      /* Symmetric Application Processor definitions */
 #include <Timer.h>      /* Timer management structures and definitions */
+#include <Tsc.h>        /* TSC calibration for fine-grained accounting */
 #include <VMM.h>        /* Virtual memory management (for timer mapping) */
+#include <WorkQueue.h>  /* Delayed work deadlines */
 
 TimerManager Timer;
 
-volatile uint32_t TimerInterruptCount = 0;
+static uint64_t LastBalanceTick;
+
+/*Timer bottom half, runs on IRQ exit or in ksoftirqd*/
+static void
+__TimerSoftirq__(uint32_t __CpuId__)
+{
+    WakeupSleepingThreads(__CpuId__);
+    WorkQueueTick(__CpuId__);
+
+    /* One CPU balances for all; softirqs can fold several ticks into one run */
+    uint64_t Now = GetSystemTicks();
+    if (__CpuId__ == Timer.TimekeeperCpu && Now - LastBalanceTick >= LoadBalanceTicks)
+    {
+        LastBalanceTick = Now;
+        LoadBalanceThreads();
+    }
+}
+
+static PerCpuCounter TimerInterrupts;
+
+/*
+ * Pick the clock source and anchor both clocks. Monotonic time starts at 0
+ * here; realtime is the RTC's reading at the same moment. The TSC is only
+ * trusted to keep time on its own when it is calibrated and invariant, as a
+ * TSC that slows down with the core would make time run unevenly.
+ */
+static void
+__InitializeClock__(void)
+{
+    uint64_t Rtc = ReadRtcSeconds();
+
+    AcquireSeqLockWrite(&Timer.Clock);
+    Timer.ClockSource    = (Tsc.Calibrated && Tsc.Invariant) ? ClockSourceTsc : ClockSourceTick;
+    Timer.ClockMult      = Tsc.Mult;
+    Timer.ClockShift     = Tsc.Shift;
+    Timer.BaseNs         = 0;
+    Timer.CycleBase      = ReadTsc();
+    Timer.RealtimeOffset = (int64_t)(Rtc * 1000000000ULL);
+    ReleaseSeqLockWrite(&Timer.Clock);
+
+    PInfo("Clock: %s source, realtime %lu s at boot\n",
+          Timer.ClockSource == ClockSourceTsc ? "TSC" : "tick",
+          Rtc);
+}
 
 void
 InitializeTimer(void)
 {
     Timer.ActiveTimer      = TIMER_TYPE_NONE;
     Timer.SystemTicks      = 0;
+    Timer.TickTsc          = 0;
+    Timer.TimekeeperCpu    = TimekeeperNone;
     Timer.TimerInitialized = 0;
+    InitializeSeqLock(&Timer.Clock, "TimerClock");
+
+    InitializeTsc();
+    __InitializeClock__();
+    RegisterSoftirq(SoftirqTimer, __TimerSoftirq__, "timer");
 
     if (DetectApicTimer() && InitializeApicTimer())
     {
@@ -50,20 +104,80 @@ InitializeTimer(void)
     __asm__ volatile("sti");
 }
 
+/*
+ * Ticks SystemTicks should move by on this CPU's tick, 0 unless it keeps time.
+ * The first CPU to tick keeps time; if it stops ticking, interrupts off or
+ * gone, the next CPU to notice takes over and makes up the ticks it missed.
+ */
+static uint64_t
+__TimekeeperTicks__(uint32_t __CpuId__)
+{
+    uint32_t Keeper = __atomic_load_n(&Timer.TimekeeperCpu, __ATOMIC_RELAXED);
+    if (Keeper == __CpuId__)
+    {
+        return 1;
+    }
+
+    uint64_t TickCycles = Tsc.Frequency / TimerTargetFrequency;
+    uint64_t Last       = __atomic_load_n(&Timer.TickTsc, __ATOMIC_RELAXED);
+    uint64_t Now        = ReadTsc();
+    /* Without a calibrated TSC a stall cannot be told from a slow tick; keep the keeper */
+    if (Keeper != TimekeeperNone &&
+        (!Tsc.Calibrated || Now - Last < TickCycles * TimekeeperStallTicks))
+    {
+        return 0;
+    }
+
+    if (!__atomic_compare_exchange_n(
+            &Timer.TimekeeperCpu, &Keeper, __CpuId__, false, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+    {
+        return 0;
+    }
+
+    return (Keeper == TimekeeperNone || !TickCycles) ? 1 : (Now - Last) / TickCycles;
+}
+
 void
 TimerHandler(InterruptFrame* __Frame__)
 {
     uint32_t    CpuId   = GetCurrentCpuId();
     PerCpuData* CpuData = GetPerCpuData(CpuId);
 
-    __atomic_fetch_add(&CpuData->LocalInterrupts, 1, __ATOMIC_SEQ_CST);
-    __atomic_fetch_add(&CpuData->LocalTicks, 1, __ATOMIC_SEQ_CST);
+    /* ThreadYield came in on this vector: no time passed and there is nothing to EOI */
+    if (CpuData->SoftYield)
+    {
+        CpuData->SoftYield = 0;
+        if (!SoftirqActive(CpuId) && !PreemptDisabled(CpuId))
+        {
+            Schedule(CpuId, __Frame__);
+        }
+        return;
+    }
+
+    /* Only this CPU writes its own line, and only from here */
+    CpuData->LocalInterrupts++;
+    CpuData->LocalTicks++;
+    PerCpuCounterAddOn(&TimerInterrupts, CpuId, 1);
 
-    __atomic_fetch_add(&TimerInterruptCount, 1, __ATOMIC_SEQ_CST);
-    __atomic_fetch_add(&Timer.SystemTicks, 1, __ATOMIC_SEQ_CST);
+    /*Every CPU ticks at TimerTargetFrequency, but only the timekeeper moves the clock*/
+    uint64_t Ticks = __TimekeeperTicks__(CpuId);
+    if (Ticks)
+    {
+        AcquireSeqLockWrite(&Timer.Clock);
+        __atomic_store_n(&Timer.SystemTicks, Timer.SystemTicks + Ticks, __ATOMIC_RELAXED);
+        __atomic_store_n(&Timer.TickTsc, ReadTsc(), __ATOMIC_RELAXED);
+        ReleaseSeqLockWrite(&Timer.Clock);
+    }
 
-    WakeupSleepingThreads(CpuId);
-    Schedule(CpuId, __Frame__);
+    RaiseSoftirq(SoftirqTimer);
+    RcuTick(CpuId);
+    ThreadPoolTick(CpuId);
+
+    /*A softirq batch owns the shared kernel stack; a plain or BH lock holder must not move*/
+    if (!SoftirqActive(CpuId) && !PreemptDisabled(CpuId))
+    {
+        Schedule(CpuId, __Frame__);
+    }
 
     volatile uint32_t* EoiReg = (volatile uint32_t*)(CpuData->ApicBase + TimerApicRegEoi);
     *EoiReg                   = 0;
@@ -75,6 +189,79 @@ GetSystemTicks(void)
     return Timer.SystemTicks;
 }
 
+/*Tick time plus the TSC cycles since that tick, never past the next one*/
+static uint64_t
+__TickTimeNs__(void)
+{
+    uint64_t Ticks;
+    uint64_t Stamp;
+    uint32_t Sequence;
+
+    do
+    {
+        Sequence = ReadSeqLockBegin(&Timer.Clock);
+        Ticks    = __atomic_load_n(&Timer.SystemTicks, __ATOMIC_RELAXED);
+        Stamp    = __atomic_load_n(&Timer.TickTsc, __ATOMIC_RELAXED);
+    } while (ReadSeqLockRetry(&Timer.Clock, Sequence));
+
+    uint64_t TickNs = 1000000000ULL / TimerTargetFrequency;
+    uint64_t Now    = ReadTsc();
+    uint64_t Since  = (Stamp && Now > Stamp) ? TscToNs(Now - Stamp) : 0;
+
+    return Ticks * TickNs + (Since < TickNs ? Since : TickNs - 1);
+}
+
+/*CLOCK_MONOTONIC in ns since the clock was set up*/
+uint64_t
+GetSystemTimeNs(void)
+{
+    if (__atomic_load_n(&Timer.ClockSource, __ATOMIC_RELAXED) != ClockSourceTsc)
+    {
+        return __TickTimeNs__();
+    }
+
+    uint64_t Base;
+    uint64_t Cycles;
+    uint32_t Mult;
+    uint32_t Shift;
+    uint32_t Sequence;
+
+    do
+    {
+        Sequence = ReadSeqLockBegin(&Timer.Clock);
+        Base     = __atomic_load_n(&Timer.BaseNs, __ATOMIC_RELAXED);
+        Cycles   = __atomic_load_n(&Timer.CycleBase, __ATOMIC_RELAXED);
+        Mult     = __atomic_load_n(&Timer.ClockMult, __ATOMIC_RELAXED);
+        Shift    = __atomic_load_n(&Timer.ClockShift, __ATOMIC_RELAXED);
+    } while (ReadSeqLockRetry(&Timer.Clock, Sequence));
+
+    /* A CPU whose TSC trails the one that set the base reads the base, never earlier */
+    uint64_t Now   = ReadTsc();
+    uint64_t Delta = Now > Cycles ? Now - Cycles : 0;
+
+    return Base + (uint64_t)(((unsigned __int128)Delta * Mult) >> Shift);
+}
+
+/*CLOCK_REALTIME in ns since the epoch*/
+uint64_t
+GetRealtimeNs(void)
+{
+    int64_t Offset = __atomic_load_n(&Timer.RealtimeOffset, __ATOMIC_RELAXED);
+    return GetSystemTimeNs() + (uint64_t)Offset;
+}
+
+uint64_t
+GetClockResolutionNs(void)
+{
+    if (__atomic_load_n(&Timer.ClockSource, __ATOMIC_RELAXED) != ClockSourceTsc)
+    {
+        return 1000000000ULL / TimerTargetFrequency;
+    }
+
+    /* One TSC cycle, rounded up to whole nanoseconds */
+    return (1000000000ULL + Tsc.Frequency - 1) / Tsc.Frequency;
+}
+
 void
 Sleep(uint32_t __Milliseconds__)
 {
@@ -95,5 +282,5 @@ Sleep(uint32_t __Milliseconds__)
 uint32_t
 GetTimerInterruptCount(void)
 {
-    return TimerInterruptCount;
+    return (uint32_t)PerCpuCounterSum(&TimerInterrupts);
 }
@@ -23,14 +23,19 @@ static long           __MountCount__ = 0;
 static Vnode*  __RootNode__ = 0;
 static Dentry* __RootDe__   = 0;
 
-static long  __Umask__          = 0;
-static long  __MaxName__        = 256;
-static long  __MaxPath__        = 1024;
-static long  __DirCacheLimit__  = 0;
-static long  __FileCacheLimit__ = 0;
-static long  __IoBlockSize__    = 0;
-static char  __DefaultFs__[64]  = {0};
-static Mutex VfsLock;
+static long __Umask__          = 0;
+static long __MaxName__        = 256;
+static long __MaxPath__        = 1024;
+static long __DirCacheLimit__  = 0;
+static long __FileCacheLimit__ = 0;
+static long __IoBlockSize__    = 0;
+static char __DefaultFs__[64]  = {0};
+
+/*Lookups and open-file I/O share it, mounts and namespace changes take it alone*/
+static RwSemaphore VfsLock;
+
+/*Entry points lock once, then use unlocked helpers like this one rather than each other*/
+static Dentry* __resolve__(const char* __Path__);
 
 static int
 __is_sep__(char c)
@@ -163,8 +168,7 @@ __find_mount__(const char* __Path__)
 int
 VfsInit(void)
 {
-    AcquireMutex(&VfsLock);
-    InitializeMutex(&VfsLock, "vfs-central");
+    InitializeRwSemaphore(&VfsLock, "vfs-central");
     __FsCount__        = 0;
     __MountCount__     = 0;
     __RootNode__       = 0;
@@ -177,14 +181,13 @@ VfsInit(void)
     __IoBlockSize__    = 0;
     __DefaultFs__[0]   = 0;
     PDebug("VFS: Init\n");
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
 int
 VfsShutdown(void)
 {
-    AcquireMutex(&VfsLock);
+    AcquireRwSemaphoreWrite(&VfsLock);
     for (long I = 0; I < __MountCount__; I++)
     {
         Superblock* Sb = __Mounts__[I].Sb;
@@ -204,14 +207,13 @@ VfsShutdown(void)
     __RootNode__   = 0;
     __RootDe__     = 0;
     PDebug("VFS: Shutdown\n");
-    ReleaseMutex(&VfsLock);
+    ReleaseRwSemaphoreWrite(&VfsLock);
     return 0;
 }
 
-int
-VfsRegisterFs(const FsType* __FsType__)
+static int
+__register_fs__(const FsType* __FsType__)
 {
-    AcquireMutex(&VfsLock);
     if (!__FsType__ || !__FsType__->Name || !__FsType__->Mount)
     {
         PError("VFS: RegisterFs invalid\n");
@@ -235,14 +237,21 @@ VfsRegisterFs(const FsType* __FsType__)
 
     __FsReg__[__FsCount__++] = __FsType__;
     PDebug("VFS: FS registered %s\n", __FsType__->Name);
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
 int
-VfsUnregisterFs(const char* __Name__)
+VfsRegisterFs(const FsType* __FsType__)
+{
+    AcquireRwSemaphoreWrite(&VfsLock);
+    int Ret = __register_fs__(__FsType__);
+    ReleaseRwSemaphoreWrite(&VfsLock);
+    return Ret;
+}
+
+static int
+__unregister_fs__(const char* __Name__)
 {
-    AcquireMutex(&VfsLock);
     if (!__Name__)
     {
         PError("VFS: UnregisterFs NULL\n");
@@ -264,12 +273,20 @@ VfsUnregisterFs(const char* __Name__)
     }
 
     PError("VFS: FS not found %s\n", __Name__);
-    ReleaseMutex(&VfsLock);
     return -1;
 }
 
-const FsType*
-VfsFindFs(const char* __Name__)
+int
+VfsUnregisterFs(const char* __Name__)
+{
+    AcquireRwSemaphoreWrite(&VfsLock);
+    int Ret = __unregister_fs__(__Name__);
+    ReleaseRwSemaphoreWrite(&VfsLock);
+    return Ret;
+}
+
+static const FsType*
+__find_fs__(const char* __Name__)
 {
     if (!__Name__)
     {
@@ -287,10 +304,18 @@ VfsFindFs(const char* __Name__)
     return 0;
 }
 
-long
-VfsListFs(const char** __Out__, long __Cap__)
+const FsType*
+VfsFindFs(const char* __Name__)
+{
+    AcquireRwSemaphoreRead(&VfsLock);
+    const FsType* Ret = __find_fs__(__Name__);
+    ReleaseRwSemaphoreRead(&VfsLock);
+    return Ret;
+}
+
+static long
+__list_fs__(const char** __Out__, long __Cap__)
 {
-    AcquireMutex(&VfsLock);
     if (!__Out__ || __Cap__ <= 0)
     {
         return -1;
@@ -302,19 +327,26 @@ VfsListFs(const char** __Out__, long __Cap__)
         __Out__[I] = __FsReg__[I]->Name;
     }
 
-    ReleaseMutex(&VfsLock);
     return N;
 }
 
-Superblock*
-VfsMount(const char* __Dev__,
-         const char* __Path__,
-         const char* __Type__,
-         long        __Flags__,
-         const char* __Opts__)
+long
+VfsListFs(const char** __Out__, long __Cap__)
+{
+    AcquireRwSemaphoreRead(&VfsLock);
+    long Ret = __list_fs__(__Out__, __Cap__);
+    ReleaseRwSemaphoreRead(&VfsLock);
+    return Ret;
+}
+
+static Superblock*
+__mount__(const char* __Dev__,
+          const char* __Path__,
+          const char* __Type__,
+          long        __Flags__,
+          const char* __Opts__)
 {
-    AcquireMutex(&VfsLock);
-    const FsType* Fs = VfsFindFs(__Type__);
+    const FsType* Fs = __find_fs__(__Type__);
     if (!Fs)
     {
         PError("VFS: Mount unknown FS %s\n", __Type__);
@@ -360,14 +392,25 @@ VfsMount(const char* __Dev__,
 
     PDebug("VFS: Mounted %s at %s\n", __Type__, __Path__);
     (void)__Flags__;
-    ReleaseMutex(&VfsLock);
     return Sb;
 }
 
-int
-VfsUnmount(const char* __Path__)
+Superblock*
+VfsMount(const char* __Dev__,
+         const char* __Path__,
+         const char* __Type__,
+         long        __Flags__,
+         const char* __Opts__)
+{
+    AcquireRwSemaphoreWrite(&VfsLock);
+    Superblock* Ret = __mount__(__Dev__, __Path__, __Type__, __Flags__, __Opts__);
+    ReleaseRwSemaphoreWrite(&VfsLock);
+    return Ret;
+}
+
+static int
+__unmount__(const char* __Path__)
 {
-    AcquireMutex(&VfsLock);
     if (!__Path__)
     {
         PError("VFS: Unmount NULL\n");
@@ -405,21 +448,28 @@ VfsUnmount(const char* __Path__)
     }
 
     PError("VFS: Unmount path not found %s\n", __Path__);
-    ReleaseMutex(&VfsLock);
     return -1;
 }
 
 int
-VfsSwitchRoot(const char* __NewRoot__)
+VfsUnmount(const char* __Path__)
+{
+    AcquireRwSemaphoreWrite(&VfsLock);
+    int Ret = __unmount__(__Path__);
+    ReleaseRwSemaphoreWrite(&VfsLock);
+    return Ret;
+}
+
+static int
+__switch_root__(const char* __NewRoot__)
 {
-    AcquireMutex(&VfsLock);
     if (!__NewRoot__)
     {
         PError("VFS: SwitchRoot NULL\n");
         return -1;
     }
 
-    Dentry* De = VfsResolve(__NewRoot__);
+    Dentry* De = __resolve__(__NewRoot__);
     if (!De || !De->Node)
     {
         PError("VFS: SwitchRoot resolve failed %s\n", __NewRoot__);
@@ -429,14 +479,21 @@ VfsSwitchRoot(const char* __NewRoot__)
     __RootNode__ = De->Node;
     __RootDe__   = De;
     PDebug("VFS: Root switched to %s\n", __NewRoot__);
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
 int
-VfsBindMount(const char* __Src__, const char* __Dst__)
+VfsSwitchRoot(const char* __NewRoot__)
+{
+    AcquireRwSemaphoreWrite(&VfsLock);
+    int Ret = __switch_root__(__NewRoot__);
+    ReleaseRwSemaphoreWrite(&VfsLock);
+    return Ret;
+}
+
+static int
+__bind_mount__(const char* __Src__, const char* __Dst__)
 {
-    AcquireMutex(&VfsLock);
     if (!__Src__ || !__Dst__)
     {
         return -1;
@@ -464,14 +521,21 @@ VfsBindMount(const char* __Src__, const char* __Dst__)
     __builtin_memcpy(New->Path, __Dst__, (size_t)(N + 1));
 
     PDebug("VFS: Bind mount %s -> %s\n", __Src__, __Dst__);
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
 int
-VfsMoveMount(const char* __Src__, const char* __Dst__)
+VfsBindMount(const char* __Src__, const char* __Dst__)
+{
+    AcquireRwSemaphoreWrite(&VfsLock);
+    int Ret = __bind_mount__(__Src__, __Dst__);
+    ReleaseRwSemaphoreWrite(&VfsLock);
+    return Ret;
+}
+
+static int
+__move_mount__(const char* __Src__, const char* __Dst__)
 {
-    AcquireMutex(&VfsLock);
     if (!__Src__ || !__Dst__)
     {
         return -1;
@@ -491,14 +555,21 @@ VfsMoveMount(const char* __Src__, const char* __Dst__)
 
     __builtin_memcpy(M->Path, __Dst__, (size_t)(N + 1));
     PDebug("VFS: Move mount %s -> %s\n", __Src__, __Dst__);
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
 int
-VfsRemount(const char* __Path__, long __Flags__, const char* __Opts__)
+VfsMoveMount(const char* __Src__, const char* __Dst__)
+{
+    AcquireRwSemaphoreWrite(&VfsLock);
+    int Ret = __move_mount__(__Src__, __Dst__);
+    ReleaseRwSemaphoreWrite(&VfsLock);
+    return Ret;
+}
+
+static int
+__remount__(const char* __Path__, long __Flags__, const char* __Opts__)
 {
-    AcquireMutex(&VfsLock);
     (void)__Flags__;
     (void)__Opts__;
     __MountEntry__* M = __find_mount__(__Path__);
@@ -506,14 +577,21 @@ VfsRemount(const char* __Path__, long __Flags__, const char* __Opts__)
     {
         return -1;
     }
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
-Dentry*
-VfsResolve(const char* __Path__)
+int
+VfsRemount(const char* __Path__, long __Flags__, const char* __Opts__)
+{
+    AcquireRwSemaphoreWrite(&VfsLock);
+    int Ret = __remount__(__Path__, __Flags__, __Opts__);
+    ReleaseRwSemaphoreWrite(&VfsLock);
+    return Ret;
+}
+
+static Dentry*
+__resolve__(const char* __Path__)
 {
-    AcquireMutex(&VfsLock);
     if (!__Path__)
     {
         return 0;
@@ -563,14 +641,21 @@ VfsResolve(const char* __Path__)
         return De ? De : 0;
     }
 
-    ReleaseMutex(&VfsLock);
     return __walk__(M->Sb->Root, __RootDe__, Tail);
 }
 
 Dentry*
-VfsResolveAt(Dentry* __Base__, const char* __Rel__)
+VfsResolve(const char* __Path__)
+{
+    AcquireRwSemaphoreRead(&VfsLock);
+    Dentry* Ret = __resolve__(__Path__);
+    ReleaseRwSemaphoreRead(&VfsLock);
+    return Ret;
+}
+
+static Dentry*
+__resolve_at__(Dentry* __Base__, const char* __Rel__)
 {
-    AcquireMutex(&VfsLock);
     if (!__Base__ || !__Base__->Node || !__Rel__)
     {
         return 0;
@@ -583,17 +668,24 @@ VfsResolveAt(Dentry* __Base__, const char* __Rel__)
 
     if (__is_sep__(*__Rel__))
     {
-        return VfsResolve(__Rel__);
+        return __resolve__(__Rel__);
     }
 
-    ReleaseMutex(&VfsLock);
     return __walk__(__Base__->Node, __Base__, __Rel__);
 }
 
-Vnode*
-VfsLookup(Dentry* __Base__, const char* __Name__)
+Dentry*
+VfsResolveAt(Dentry* __Base__, const char* __Rel__)
+{
+    AcquireRwSemaphoreRead(&VfsLock);
+    Dentry* Ret = __resolve_at__(__Base__, __Rel__);
+    ReleaseRwSemaphoreRead(&VfsLock);
+    return Ret;
+}
+
+static Vnode*
+__lookup__(Dentry* __Base__, const char* __Name__)
 {
-    AcquireMutex(&VfsLock);
     if (!__Base__ || !__Base__->Node || !__Name__)
     {
         return 0;
@@ -604,14 +696,21 @@ VfsLookup(Dentry* __Base__, const char* __Name__)
         return 0;
     }
 
-    ReleaseMutex(&VfsLock);
     return __Base__->Node->Ops->Lookup(__Base__->Node, __Name__);
 }
 
-int
-VfsMkpath(const char* __Path__, long __Perm__)
+Vnode*
+VfsLookup(Dentry* __Base__, const char* __Name__)
+{
+    AcquireRwSemaphoreRead(&VfsLock);
+    Vnode* Ret = __lookup__(__Base__, __Name__);
+    ReleaseRwSemaphoreRead(&VfsLock);
+    return Ret;
+}
+
+static int
+__mkpath__(const char* __Path__, long __Perm__)
 {
-    AcquireMutex(&VfsLock);
     if (!__Path__)
     {
         return -1;
@@ -662,14 +761,21 @@ VfsMkpath(const char* __Path__, long __Perm__)
         De  = __alloc_dentry__(Dup, De, Next);
         Cur = Next;
     }
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
+int
+VfsMkpath(const char* __Path__, long __Perm__)
+{
+    AcquireRwSemaphoreWrite(&VfsLock);
+    int Ret = __mkpath__(__Path__, __Perm__);
+    ReleaseRwSemaphoreWrite(&VfsLock);
+    return Ret;
+}
+
 int
 VfsRealpath(const char* __Path__, char* __Buf__, long __Len__)
 {
-    AcquireMutex(&VfsLock);
     if (!__Path__ || !__Buf__ || __Len__ <= 0)
     {
         return -1;
@@ -681,15 +787,13 @@ VfsRealpath(const char* __Path__, char* __Buf__, long __Len__)
         return -1;
     }
     __builtin_memcpy(__Buf__, __Path__, (size_t)(L + 1));
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
-File*
-VfsOpen(const char* __Path__, long __Flags__)
+static File*
+__open__(const char* __Path__, long __Flags__)
 {
-    AcquireMutex(&VfsLock);
-    Dentry* De = VfsResolve(__Path__);
+    Dentry* De = __resolve__(__Path__);
     if (!De || !De->Node)
     {
         PError("VFS: Open resolve failed %s\n", __Path__);
@@ -722,15 +826,22 @@ VfsOpen(const char* __Path__, long __Flags__)
     }
 
     PDebug("VFS: Open %s\n", __Path__);
-    ReleaseMutex(&VfsLock);
     return F;
 }
 
 File*
-VfsOpenAt(Dentry* __Base__, const char* __Rel__, long __Flags__)
+VfsOpen(const char* __Path__, long __Flags__)
+{
+    AcquireRwSemaphoreRead(&VfsLock);
+    File* Ret = __open__(__Path__, __Flags__);
+    ReleaseRwSemaphoreRead(&VfsLock);
+    return Ret;
+}
+
+static File*
+__open_at__(Dentry* __Base__, const char* __Rel__, long __Flags__)
 {
-    AcquireMutex(&VfsLock);
-    Dentry* De = VfsResolveAt(__Base__, __Rel__);
+    Dentry* De = __resolve_at__(__Base__, __Rel__);
     if (!De || !De->Node)
     {
         return 0;
@@ -759,14 +870,21 @@ VfsOpenAt(Dentry* __Base__, const char* __Rel__, long __Flags__)
         return 0;
     }
 
-    ReleaseMutex(&VfsLock);
     return F;
 }
 
-int
-VfsClose(File* __File__)
+File*
+VfsOpenAt(Dentry* __Base__, const char* __Rel__, long __Flags__)
+{
+    AcquireRwSemaphoreRead(&VfsLock);
+    File* Ret = __open_at__(__Base__, __Rel__, __Flags__);
+    ReleaseRwSemaphoreRead(&VfsLock);
+    return Ret;
+}
+
+static int
+__close__(File* __File__)
 {
-    AcquireMutex(&VfsLock);
     if (!__File__)
     {
         return -1;
@@ -778,14 +896,21 @@ VfsClose(File* __File__)
     }
 
     KFree(__File__);
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
-long
-VfsRead(File* __File__, void* __Buf__, long __Len__)
+int
+VfsClose(File* __File__)
+{
+    AcquireRwSemaphoreRead(&VfsLock);
+    int Ret = __close__(__File__);
+    ReleaseRwSemaphoreRead(&VfsLock);
+    return Ret;
+}
+
+static long
+__read__(File* __File__, void* __Buf__, long __Len__)
 {
-    AcquireMutex(&VfsLock);
     if (!__File__ || !__Buf__ || __Len__ <= 0)
     {
         return -1;
@@ -801,14 +926,21 @@ VfsRead(File* __File__, void* __Buf__, long __Len__)
     {
         __File__->Offset += Got;
     }
-    ReleaseMutex(&VfsLock);
     return Got;
 }
 
 long
-VfsWrite(File* __File__, const void* __Buf__, long __Len__)
+VfsRead(File* __File__, void* __Buf__, long __Len__)
+{
+    AcquireRwSemaphoreRead(&VfsLock);
+    long Ret = __read__(__File__, __Buf__, __Len__);
+    ReleaseRwSemaphoreRead(&VfsLock);
+    return Ret;
+}
+
+static long
+__write__(File* __File__, const void* __Buf__, long __Len__)
 {
-    AcquireMutex(&VfsLock);
     if (!__File__ || !__Buf__ || __Len__ <= 0)
     {
         return -1;
@@ -824,14 +956,21 @@ VfsWrite(File* __File__, const void* __Buf__, long __Len__)
     {
         __File__->Offset += Put;
     }
-    ReleaseMutex(&VfsLock);
     return Put;
 }
 
 long
-VfsLseek(File* __File__, long __Off__, int __Whence__)
+VfsWrite(File* __File__, const void* __Buf__, long __Len__)
+{
+    AcquireRwSemaphoreRead(&VfsLock);
+    long Ret = __write__(__File__, __Buf__, __Len__);
+    ReleaseRwSemaphoreRead(&VfsLock);
+    return Ret;
+}
+
+static long
+__lseek__(File* __File__, long __Off__, int __Whence__)
 {
-    AcquireMutex(&VfsLock);
     if (!__File__)
     {
         return -1;
@@ -847,14 +986,21 @@ VfsLseek(File* __File__, long __Off__, int __Whence__)
     {
         __File__->Offset = New;
     }
-    ReleaseMutex(&VfsLock);
     return New;
 }
 
+long
+VfsLseek(File* __File__, long __Off__, int __Whence__)
+{
+    AcquireRwSemaphoreRead(&VfsLock);
+    long Ret = __lseek__(__File__, __Off__, __Whence__);
+    ReleaseRwSemaphoreRead(&VfsLock);
+    return Ret;
+}
+
 int
 VfsIoctl(File* __File__, unsigned long __Cmd__, void* __Arg__)
 {
-    AcquireMutex(&VfsLock);
     if (!__File__)
     {
         return -1;
@@ -865,14 +1011,12 @@ VfsIoctl(File* __File__, unsigned long __Cmd__, void* __Arg__)
         return -1;
     }
 
-    ReleaseMutex(&VfsLock);
     return __File__->Node->Ops->Ioctl(__File__, __Cmd__, __Arg__);
 }
 
 int
 VfsFsync(File* __File__)
 {
-    AcquireMutex(&VfsLock);
     if (!__File__ || !__File__->Node || !__File__->Node->Ops)
     {
         return -1;
@@ -883,14 +1027,12 @@ VfsFsync(File* __File__)
         return 0;
     }
 
-    ReleaseMutex(&VfsLock);
     return __File__->Node->Ops->Sync(__File__->Node);
 }
 
 int
 VfsFstats(File* __File__, VfsStat* __Buf__)
 {
-    AcquireMutex(&VfsLock);
     if (!__File__ || !__Buf__)
     {
         return -1;
@@ -901,20 +1043,18 @@ VfsFstats(File* __File__, VfsStat* __Buf__)
         return -1;
     }
 
-    ReleaseMutex(&VfsLock);
     return __File__->Node->Ops->Stat(__File__->Node, __Buf__);
 }
 
-int
-VfsStats(const char* __Path__, VfsStat* __Buf__)
+static int
+__stats__(const char* __Path__, VfsStat* __Buf__)
 {
-    AcquireMutex(&VfsLock);
     if (!__Path__ || !__Buf__)
     {
         return -1;
     }
 
-    Dentry* De = VfsResolve(__Path__);
+    Dentry* De = __resolve__(__Path__);
     if (!De || !De->Node)
     {
         return -1;
@@ -925,20 +1065,27 @@ VfsStats(const char* __Path__, VfsStat* __Buf__)
         return -1;
     }
 
-    ReleaseMutex(&VfsLock);
     return De->Node->Ops->Stat(De->Node, __Buf__);
 }
 
-long
-VfsReaddir(const char* __Path__, void* __Buf__, long __BufLen__)
+int
+VfsStats(const char* __Path__, VfsStat* __Buf__)
+{
+    AcquireRwSemaphoreRead(&VfsLock);
+    int Ret = __stats__(__Path__, __Buf__);
+    ReleaseRwSemaphoreRead(&VfsLock);
+    return Ret;
+}
+
+static long
+__readdir__(const char* __Path__, void* __Buf__, long __BufLen__)
 {
-    AcquireMutex(&VfsLock);
     if (!__Path__ || !__Buf__ || __BufLen__ <= 0)
     {
         return -1;
     }
 
-    Dentry* De = VfsResolve(__Path__);
+    Dentry* De = __resolve__(__Path__);
     if (!De || !De->Node)
     {
         return -1;
@@ -949,14 +1096,21 @@ VfsReaddir(const char* __Path__, void* __Buf__, long __BufLen__)
         return -1;
     }
 
-    ReleaseMutex(&VfsLock);
     return De->Node->Ops->Readdir(De->Node, __Buf__, __BufLen__);
 }
 
+long
+VfsReaddir(const char* __Path__, void* __Buf__, long __BufLen__)
+{
+    AcquireRwSemaphoreRead(&VfsLock);
+    long Ret = __readdir__(__Path__, __Buf__, __BufLen__);
+    ReleaseRwSemaphoreRead(&VfsLock);
+    return Ret;
+}
+
 long
 VfsReaddirF(File* __Dir__, void* __Buf__, long __BufLen__)
 {
-    AcquireMutex(&VfsLock);
     if (!__Dir__ || !__Buf__ || __BufLen__ <= 0)
     {
         return -1;
@@ -967,14 +1121,12 @@ VfsReaddirF(File* __Dir__, void* __Buf__, long __BufLen__)
         return -1;
     }
 
-    ReleaseMutex(&VfsLock);
     return __Dir__->Node->Ops->Readdir(__Dir__->Node, __Buf__, __BufLen__);
 }
 
-int
-VfsCreate(const char* __Path__, long __Flags__, VfsPerm __Perm__)
+static int
+__create__(const char* __Path__, long __Flags__, VfsPerm __Perm__)
 {
-    AcquireMutex(&VfsLock);
     Dentry* Parent = 0;
     char    Name[256];
     if (!__Path__)
@@ -1031,14 +1183,21 @@ VfsCreate(const char* __Path__, long __Flags__, VfsPerm __Perm__)
     {
         return -1;
     }
-    ReleaseMutex(&VfsLock);
     return Parent->Node->Ops->Create(Parent->Node, Name, __Flags__, __Perm__);
 }
 
 int
-VfsUnlink(const char* __Path__)
+VfsCreate(const char* __Path__, long __Flags__, VfsPerm __Perm__)
+{
+    AcquireRwSemaphoreWrite(&VfsLock);
+    int Ret = __create__(__Path__, __Flags__, __Perm__);
+    ReleaseRwSemaphoreWrite(&VfsLock);
+    return Ret;
+}
+
+static int
+__unlink__(const char* __Path__)
 {
-    AcquireMutex(&VfsLock);
     Dentry* Base = 0;
     char    Name[256];
     if (!__Path__)
@@ -1095,19 +1254,25 @@ VfsUnlink(const char* __Path__)
     {
         return -1;
     }
-    ReleaseMutex(&VfsLock);
     return Base->Node->Ops->Unlink(Base->Node, Name);
 }
 
 int
-VfsMkdir(const char* __Path__, VfsPerm __Perm__)
+VfsUnlink(const char* __Path__)
+{
+    AcquireRwSemaphoreWrite(&VfsLock);
+    int Ret = __unlink__(__Path__);
+    ReleaseRwSemaphoreWrite(&VfsLock);
+    return Ret;
+}
+
+static int
+__mkdir__(const char* __Path__, VfsPerm __Perm__)
 {
-    AcquireMutex(&VfsLock);
     Dentry* Base = 0;
     char    Name[256];
     if (!__Path__)
     {
-        ReleaseMutex(&VfsLock);
         return -1;
     }
     const char* __PathCur = __Path__;
@@ -1136,43 +1301,45 @@ VfsMkdir(const char* __Path__, VfsPerm __Perm__)
         }
         if (!Cur || !Cur->Ops || !Cur->Ops->Lookup)
         {
-            ReleaseMutex(&VfsLock);
             return -1;
         }
         Vnode* Next = Cur->Ops->Lookup(Cur, Name);
         if (!Next)
         {
-            ReleaseMutex(&VfsLock);
             return -1;
         }
         char* Dup = (char*)KMalloc((size_t)(N + 1));
         if (!Dup)
         {
-            ReleaseMutex(&VfsLock);
             return -1;
         }
         __builtin_memcpy(Dup, Name, (size_t)(N + 1));
         De = __alloc_dentry__(Dup, De, Next);
         if (!De)
         {
-            ReleaseMutex(&VfsLock);
             return -1;
         }
         Cur = Next;
     }
     if (!Base || !Base->Node || !Base->Node->Ops || !Base->Node->Ops->Mkdir)
     {
-        ReleaseMutex(&VfsLock);
         return -1;
     }
-    ReleaseMutex(&VfsLock);
     return Base->Node->Ops->Mkdir(Base->Node, Name, __Perm__);
 }
 
 int
-VfsRmdir(const char* __Path__)
+VfsMkdir(const char* __Path__, VfsPerm __Perm__)
+{
+    AcquireRwSemaphoreWrite(&VfsLock);
+    int Ret = __mkdir__(__Path__, __Perm__);
+    ReleaseRwSemaphoreWrite(&VfsLock);
+    return Ret;
+}
+
+static int
+__rmdir__(const char* __Path__)
 {
-    AcquireMutex(&VfsLock);
     Dentry* Base = 0;
     char    Name[256];
     if (!__Path__)
@@ -1221,14 +1388,21 @@ VfsRmdir(const char* __Path__)
     {
         return -1;
     }
-    ReleaseMutex(&VfsLock);
     return Base->Node->Ops->Rmdir(Base->Node, Name);
 }
 
 int
-VfsSymlink(const char* __Target__, const char* __LinkPath__, VfsPerm __Perm__)
+VfsRmdir(const char* __Path__)
+{
+    AcquireRwSemaphoreWrite(&VfsLock);
+    int Ret = __rmdir__(__Path__);
+    ReleaseRwSemaphoreWrite(&VfsLock);
+    return Ret;
+}
+
+static int
+__symlink__(const char* __Target__, const char* __LinkPath__, VfsPerm __Perm__)
 {
-    AcquireMutex(&VfsLock);
     Dentry* Base = 0;
     char    Name[256];
     if (!__LinkPath__ || !__Target__)
@@ -1285,20 +1459,27 @@ VfsSymlink(const char* __Target__, const char* __LinkPath__, VfsPerm __Perm__)
     {
         return -1;
     }
-    ReleaseMutex(&VfsLock);
     return Base->Node->Ops->Symlink(Base->Node, Name, __Target__, __Perm__);
 }
 
 int
-VfsReadlink(const char* __Path__, char* __Buf__, long __Len__)
+VfsSymlink(const char* __Target__, const char* __LinkPath__, VfsPerm __Perm__)
+{
+    AcquireRwSemaphoreWrite(&VfsLock);
+    int Ret = __symlink__(__Target__, __LinkPath__, __Perm__);
+    ReleaseRwSemaphoreWrite(&VfsLock);
+    return Ret;
+}
+
+static int
+__readlink__(const char* __Path__, char* __Buf__, long __Len__)
 {
-    AcquireMutex(&VfsLock);
     if (!__Path__ || !__Buf__ || __Len__ <= 0)
     {
         return -1;
     }
 
-    Dentry* De = VfsResolve(__Path__);
+    Dentry* De = __resolve__(__Path__);
     if (!De || !De->Node)
     {
         return -1;
@@ -1311,20 +1492,27 @@ VfsReadlink(const char* __Path__, char* __Buf__, long __Len__)
     VfsNameBuf NB;
     NB.Buf = __Buf__;
     NB.Len = __Len__;
-    ReleaseMutex(&VfsLock);
     return De->Node->Ops->Readlink(De->Node, &NB);
 }
 
 int
-VfsLink(const char* __OldPath__, const char* __NewPath__)
+VfsReadlink(const char* __Path__, char* __Buf__, long __Len__)
+{
+    AcquireRwSemaphoreRead(&VfsLock);
+    int Ret = __readlink__(__Path__, __Buf__, __Len__);
+    ReleaseRwSemaphoreRead(&VfsLock);
+    return Ret;
+}
+
+static int
+__link__(const char* __OldPath__, const char* __NewPath__)
 {
-    AcquireMutex(&VfsLock);
     if (!__OldPath__ || !__NewPath__)
     {
         return -1;
     }
 
-    Dentry* OldDe   = VfsResolve(__OldPath__);
+    Dentry* OldDe   = __resolve__(__OldPath__);
     Dentry* NewBase = 0;
     char    Name[256];
 
@@ -1384,14 +1572,21 @@ VfsLink(const char* __OldPath__, const char* __NewPath__)
     {
         return -1;
     }
-    ReleaseMutex(&VfsLock);
     return NewBase->Node->Ops->Link(NewBase->Node, OldDe->Node, Name);
 }
 
 int
-VfsRename(const char* __OldPath__, const char* __NewPath__, long __Flags__)
+VfsLink(const char* __OldPath__, const char* __NewPath__)
+{
+    AcquireRwSemaphoreWrite(&VfsLock);
+    int Ret = __link__(__OldPath__, __NewPath__);
+    ReleaseRwSemaphoreWrite(&VfsLock);
+    return Ret;
+}
+
+static int
+__rename__(const char* __OldPath__, const char* __NewPath__, long __Flags__)
 {
-    AcquireMutex(&VfsLock);
     Dentry* OldBase = 0;
     Dentry* NewBase = 0;
     char    OldName[256];
@@ -1508,15 +1703,22 @@ VfsRename(const char* __OldPath__, const char* __NewPath__, long __Flags__)
     {
         return -1;
     }
-    ReleaseMutex(&VfsLock);
     return OldBase->Node->Ops->Rename(OldBase->Node, OldName, NewBase->Node, NewName, __Flags__);
 }
 
 int
-VfsChmod(const char* __Path__, long __Mode__)
+VfsRename(const char* __OldPath__, const char* __NewPath__, long __Flags__)
 {
-    AcquireMutex(&VfsLock);
-    Dentry* De = VfsResolve(__Path__);
+    AcquireRwSemaphoreWrite(&VfsLock);
+    int Ret = __rename__(__OldPath__, __NewPath__, __Flags__);
+    ReleaseRwSemaphoreWrite(&VfsLock);
+    return Ret;
+}
+
+static int
+__chmod__(const char* __Path__, long __Mode__)
+{
+    Dentry* De = __resolve__(__Path__);
     if (!De || !De->Node)
     {
         return -1;
@@ -1525,15 +1727,22 @@ VfsChmod(const char* __Path__, long __Mode__)
     {
         return -1;
     }
-    ReleaseMutex(&VfsLock);
     return De->Node->Ops->Chmod(De->Node, __Mode__);
 }
 
 int
-VfsChown(const char* __Path__, long __Uid__, long __Gid__)
+VfsChmod(const char* __Path__, long __Mode__)
 {
-    AcquireMutex(&VfsLock);
-    Dentry* De = VfsResolve(__Path__);
+    AcquireRwSemaphoreWrite(&VfsLock);
+    int Ret = __chmod__(__Path__, __Mode__);
+    ReleaseRwSemaphoreWrite(&VfsLock);
+    return Ret;
+}
+
+static int
+__chown__(const char* __Path__, long __Uid__, long __Gid__)
+{
+    Dentry* De = __resolve__(__Path__);
     if (!De || !De->Node)
     {
         return -1;
@@ -1542,15 +1751,22 @@ VfsChown(const char* __Path__, long __Uid__, long __Gid__)
     {
         return -1;
     }
-    ReleaseMutex(&VfsLock);
     return De->Node->Ops->Chown(De->Node, __Uid__, __Gid__);
 }
 
 int
-VfsTruncate(const char* __Path__, long __Len__)
+VfsChown(const char* __Path__, long __Uid__, long __Gid__)
 {
-    AcquireMutex(&VfsLock);
-    Dentry* De = VfsResolve(__Path__);
+    AcquireRwSemaphoreWrite(&VfsLock);
+    int Ret = __chown__(__Path__, __Uid__, __Gid__);
+    ReleaseRwSemaphoreWrite(&VfsLock);
+    return Ret;
+}
+
+static int
+__truncate__(const char* __Path__, long __Len__)
+{
+    Dentry* De = __resolve__(__Path__);
     if (!De || !De->Node)
     {
         return -1;
@@ -1559,43 +1775,50 @@ VfsTruncate(const char* __Path__, long __Len__)
     {
         return -1;
     }
-    ReleaseMutex(&VfsLock);
     return De->Node->Ops->Truncate(De->Node, __Len__);
 }
 
+int
+VfsTruncate(const char* __Path__, long __Len__)
+{
+    AcquireRwSemaphoreWrite(&VfsLock);
+    int Ret = __truncate__(__Path__, __Len__);
+    ReleaseRwSemaphoreWrite(&VfsLock);
+    return Ret;
+}
+
 int
 VnodeRefInc(Vnode* __Node__)
 {
-    AcquireMutex(&VfsLock);
     if (!__Node__)
     {
         return -1;
     }
-    __Node__->Refcnt++;
-    ReleaseMutex(&VfsLock);
-    return (int)__Node__->Refcnt;
+    return (int)__atomic_add_fetch(&__Node__->Refcnt, 1, __ATOMIC_ACQ_REL);
 }
 
 int
 VnodeRefDec(Vnode* __Node__)
 {
-    AcquireMutex(&VfsLock);
     if (!__Node__)
     {
         return -1;
     }
-    if (__Node__->Refcnt > 0)
+    long Refs = __atomic_load_n(&__Node__->Refcnt, __ATOMIC_RELAXED);
+    while (Refs > 0 && !__atomic_compare_exchange_n(&__Node__->Refcnt,
+                                                    &Refs,
+                                                    Refs - 1,
+                                                    false,
+                                                    __ATOMIC_ACQ_REL,
+                                                    __ATOMIC_RELAXED))
     {
-        __Node__->Refcnt--;
     }
-    ReleaseMutex(&VfsLock);
-    return (int)__Node__->Refcnt;
+    return (int)(Refs > 0 ? Refs - 1 : Refs);
 }
 
 int
 VnodeGetAttr(Vnode* __Node__, VfsStat* __Buf__)
 {
-    AcquireMutex(&VfsLock);
     if (!__Node__ || !__Buf__)
     {
         return -1;
@@ -1604,76 +1827,100 @@ VnodeGetAttr(Vnode* __Node__, VfsStat* __Buf__)
     {
         return -1;
     }
-    ReleaseMutex(&VfsLock);
     return __Node__->Ops->Stat(__Node__, __Buf__);
 }
 
 int
 VnodeSetAttr(Vnode* __Node__, const VfsStat* __Buf__)
 {
-    AcquireMutex(&VfsLock);
     (void)__Node__;
     (void)__Buf__;
-    ReleaseMutex(&VfsLock);
     return -1;
 }
 
-int
-DentryInvalidate(Dentry* __De__)
+static int
+__dentry_invalidate__(Dentry* __De__)
 {
-    AcquireMutex(&VfsLock);
     if (!__De__)
     {
         return -1;
     }
     __De__->Flags |= 1;
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
 int
-DentryRevalidate(Dentry* __De__)
+DentryInvalidate(Dentry* __De__)
+{
+    AcquireRwSemaphoreWrite(&VfsLock);
+    int Ret = __dentry_invalidate__(__De__);
+    ReleaseRwSemaphoreWrite(&VfsLock);
+    return Ret;
+}
+
+static int
+__dentry_revalidate__(Dentry* __De__)
 {
-    AcquireMutex(&VfsLock);
     if (!__De__)
     {
         return -1;
     }
     __De__->Flags &= ~1;
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
 int
-DentryAttach(Dentry* __De__, Vnode* __Node__)
+DentryRevalidate(Dentry* __De__)
+{
+    AcquireRwSemaphoreWrite(&VfsLock);
+    int Ret = __dentry_revalidate__(__De__);
+    ReleaseRwSemaphoreWrite(&VfsLock);
+    return Ret;
+}
+
+static int
+__dentry_attach__(Dentry* __De__, Vnode* __Node__)
 {
-    AcquireMutex(&VfsLock);
     if (!__De__ || !__Node__)
     {
         return -1;
     }
     __De__->Node = __Node__;
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
 int
-DentryDetach(Dentry* __De__)
+DentryAttach(Dentry* __De__, Vnode* __Node__)
+{
+    AcquireRwSemaphoreWrite(&VfsLock);
+    int Ret = __dentry_attach__(__De__, __Node__);
+    ReleaseRwSemaphoreWrite(&VfsLock);
+    return Ret;
+}
+
+static int
+__dentry_detach__(Dentry* __De__)
 {
-    AcquireMutex(&VfsLock);
     if (!__De__)
     {
         return -1;
     }
     __De__->Node = 0;
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
+int
+DentryDetach(Dentry* __De__)
+{
+    AcquireRwSemaphoreWrite(&VfsLock);
+    int Ret = __dentry_detach__(__De__);
+    ReleaseRwSemaphoreWrite(&VfsLock);
+    return Ret;
+}
+
 int
 DentryName(Dentry* __De__, char* __Buf__, long __Len__)
 {
-    AcquireMutex(&VfsLock);
     if (!__De__ || !__Buf__ || __Len__ <= 0)
     {
         return -1;
@@ -1684,23 +1931,19 @@ DentryName(Dentry* __De__, char* __Buf__, long __Len__)
         return -1;
     }
     __builtin_memcpy(__Buf__, __De__->Name, (size_t)(N + 1));
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
 int
 VfsSetCwd(const char* __Path__)
 {
-    AcquireMutex(&VfsLock);
     (void)__Path__;
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
 int
 VfsGetCwd(char* __Buf__, long __Len__)
 {
-    AcquireMutex(&VfsLock);
     if (!__Buf__ || __Len__ <= 0)
     {
         return -1;
@@ -1712,22 +1955,18 @@ VfsGetCwd(char* __Buf__, long __Len__)
         return -1;
     }
     __builtin_memcpy(__Buf__, __Path, (size_t)(N + 1));
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
 int
 VfsSetRoot(const char* __Path__)
 {
-    AcquireMutex(&VfsLock);
-    ReleaseMutex(&VfsLock);
     return VfsSwitchRoot(__Path__);
 }
 
 int
 VfsGetRoot(char* __Buf__, long __Len__)
 {
-    AcquireMutex(&VfsLock);
     if (!__Buf__ || __Len__ <= 0)
     {
         return -1;
@@ -1739,110 +1978,90 @@ VfsGetRoot(char* __Buf__, long __Len__)
         return -1;
     }
     __builtin_memcpy(__Buf__, __Path, (size_t)(N + 1));
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
 int
 VfsSetUmask(long __Mode__)
 {
-    AcquireMutex(&VfsLock);
+    AcquireRwSemaphoreWrite(&VfsLock);
     __Umask__ = __Mode__;
-    ReleaseMutex(&VfsLock);
+    ReleaseRwSemaphoreWrite(&VfsLock);
     return 0;
 }
 
 long
 VfsGetUmask(void)
 {
-    AcquireMutex(&VfsLock);
-    ReleaseMutex(&VfsLock);
     return __Umask__;
 }
 
 int
 VfsNotifySubscribe(const char* __Path__, long __Mask__)
 {
-    AcquireMutex(&VfsLock);
     (void)__Path__;
     (void)__Mask__;
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
 int
 VfsNotifyUnsubscribe(const char* __Path__)
 {
-    AcquireMutex(&VfsLock);
     (void)__Path__;
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
 int
 VfsNotifyPoll(const char* __Path__, long* __OutMask__)
 {
-    AcquireMutex(&VfsLock);
     (void)__Path__;
     if (!__OutMask__)
     {
         return -1;
     }
     *__OutMask__ = 0;
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
 int
 VfsAccess(const char* __Path__, long __Mode__)
 {
-    AcquireMutex(&VfsLock);
     (void)__Mode__;
     Dentry* De = VfsResolve(__Path__);
-    ReleaseMutex(&VfsLock);
     return De ? 0 : -1;
 }
 
 int
 VfsExists(const char* __Path__)
 {
-    AcquireMutex(&VfsLock);
     Dentry* De = VfsResolve(__Path__);
-    ReleaseMutex(&VfsLock);
     return De ? 1 : 0;
 }
 
 int
 VfsIsDir(const char* __Path__)
 {
-    AcquireMutex(&VfsLock);
     Dentry* De = VfsResolve(__Path__);
-    ReleaseMutex(&VfsLock);
     return (De && De->Node && De->Node->Type == VNodeDIR) ? 1 : 0;
 }
 
 int
 VfsIsFile(const char* __Path__)
 {
-    AcquireMutex(&VfsLock);
     Dentry* De = VfsResolve(__Path__);
-    ReleaseMutex(&VfsLock);
     return (De && De->Node && De->Node->Type == VNodeFILE) ? 1 : 0;
 }
 
 int
 VfsIsSymlink(const char* __Path__)
 {
-    AcquireMutex(&VfsLock);
     Dentry* De = VfsResolve(__Path__);
-    ReleaseMutex(&VfsLock);
     return (De && De->Node && De->Node->Type == VNodeSYM) ? 1 : 0;
 }
 
 int
 VfsCopy(const char* __Src__, const char* __Dst__, long __Flags__)
 {
-    AcquireMutex(&VfsLock);
     (void)__Flags__;
     File* S = VfsOpen(__Src__, VFlgRDONLY);
     if (!S)
@@ -1881,14 +2100,12 @@ VfsCopy(const char* __Src__, const char* __Dst__, long __Flags__)
 
     VfsClose(S);
     VfsClose(D);
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
 int
 VfsMove(const char* __Src__, const char* __Dst__, long __Flags__)
 {
-    AcquireMutex(&VfsLock);
     int rc = VfsRename(__Src__, __Dst__, __Flags__);
     if (rc == 0)
     {
@@ -1899,14 +2116,12 @@ VfsMove(const char* __Src__, const char* __Dst__, long __Flags__)
     {
         return -1;
     }
-    ReleaseMutex(&VfsLock);
     return VfsUnlink(__Src__);
 }
 
 int
 VfsReadAll(const char* __Path__, void* __Buf__, long __BufLen__, long* __OutLen__)
 {
-    AcquireMutex(&VfsLock);
     File* F = VfsOpen(__Path__, VFlgRDONLY);
     if (!F)
     {
@@ -1932,14 +2147,12 @@ VfsReadAll(const char* __Path__, void* __Buf__, long __BufLen__, long* __OutLen_
         *__OutLen__ = total;
     }
     VfsClose(F);
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
 int
 VfsWriteAll(const char* __Path__, const void* __Buf__, long __Len__)
 {
-    AcquireMutex(&VfsLock);
     File* F = VfsOpen(__Path__, VFlgCREATE | VFlgWRONLY | VFlgTRUNC);
     if (!F)
     {
@@ -1957,14 +2170,12 @@ VfsWriteAll(const char* __Path__, const void* __Buf__, long __Len__)
         total += w;
     }
     VfsClose(F);
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
-int
-VfsMountTableEnumerate(char* __Buf__, long __Len__)
+static int
+__mount_table_enumerate__(char* __Buf__, long __Len__)
 {
-    AcquireMutex(&VfsLock);
     if (!__Buf__ || __Len__ <= 0)
     {
         return -1;
@@ -1986,14 +2197,21 @@ VfsMountTableEnumerate(char* __Buf__, long __Len__)
     {
         __Buf__[off] = 0;
     }
-    ReleaseMutex(&VfsLock);
     return (int)off;
 }
 
 int
-VfsMountTableFind(const char* __Path__, char* __Buf__, long __Len__)
+VfsMountTableEnumerate(char* __Buf__, long __Len__)
+{
+    AcquireRwSemaphoreRead(&VfsLock);
+    int Ret = __mount_table_enumerate__(__Buf__, __Len__);
+    ReleaseRwSemaphoreRead(&VfsLock);
+    return Ret;
+}
+
+static int
+__mount_table_find__(const char* __Path__, char* __Buf__, long __Len__)
 {
-    AcquireMutex(&VfsLock);
     if (!__Path__ || !__Buf__ || __Len__ <= 0)
     {
         return -1;
@@ -2011,14 +2229,21 @@ VfsMountTableFind(const char* __Path__, char* __Buf__, long __Len__)
             return 0;
         }
     }
-    ReleaseMutex(&VfsLock);
     return -1;
 }
 
+int
+VfsMountTableFind(const char* __Path__, char* __Buf__, long __Len__)
+{
+    AcquireRwSemaphoreRead(&VfsLock);
+    int Ret = __mount_table_find__(__Path__, __Buf__, __Len__);
+    ReleaseRwSemaphoreRead(&VfsLock);
+    return Ret;
+}
+
 int
 VfsNodePath(Vnode* __Node__, char* __Buf__, long __Len__)
 {
-    AcquireMutex(&VfsLock);
     (void)__Node__;
     if (!__Buf__ || __Len__ <= 0)
     {
@@ -2031,14 +2256,12 @@ VfsNodePath(Vnode* __Node__, char* __Buf__, long __Len__)
         return -1;
     }
     __builtin_memcpy(__Buf__, __Path, (size_t)(N + 1));
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
 int
 VfsNodeName(Vnode* __Node__, char* __Buf__, long __Len__)
 {
-    AcquireMutex(&VfsLock);
     (void)__Node__;
     if (!__Buf__ || __Len__ <= 0)
     {
@@ -2051,40 +2274,34 @@ VfsNodeName(Vnode* __Node__, char* __Buf__, long __Len__)
         return -1;
     }
     __builtin_memcpy(__Buf__, __Path, (size_t)(N + 1));
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
 int
 VfsAllocName(char** __Out__, long __Len__)
 {
-    AcquireMutex(&VfsLock);
     if (!__Out__ || __Len__ <= 0)
     {
         return -1;
     }
     *__Out__ = (char*)KMalloc((size_t)__Len__);
-    ReleaseMutex(&VfsLock);
     return *__Out__ ? 0 : -1;
 }
 
 int
 VfsFreeName(char* __Name__)
 {
-    AcquireMutex(&VfsLock);
     if (!__Name__)
     {
         return -1;
     }
     KFree(__Name__);
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
 int
 VfsJoinPath(const char* __A__, const char* __B__, char* __Out__, long __Len__)
 {
-    AcquireMutex(&VfsLock);
     if (!__A__ || !__B__ || !__Out__ || __Len__ <= 0)
     {
         return -1;
@@ -2100,43 +2317,36 @@ VfsJoinPath(const char* __A__, const char* __B__, char* __Out__, long __Len__)
     __Out__[la] = '/';
     __builtin_memcpy(__Out__ + la + 1, __B__, (size_t)lb);
     __Out__[la + 1 + lb] = 0;
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
 int
 VfsSetFlag(const char* __Path__, long __Flag__)
 {
-    AcquireMutex(&VfsLock);
     (void)__Path__;
     (void)__Flag__;
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
 int
 VfsClearFlag(const char* __Path__, long __Flag__)
 {
-    AcquireMutex(&VfsLock);
     (void)__Path__;
     (void)__Flag__;
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
 long
 VfsGetFlags(const char* __Path__)
 {
-    AcquireMutex(&VfsLock);
     (void)__Path__;
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
 int
 VfsSyncAll(void)
 {
-    AcquireMutex(&VfsLock);
+    AcquireRwSemaphoreRead(&VfsLock);
     for (long I = 0; I < __MountCount__; I++)
     {
         Superblock* Sb = __Mounts__[I].Sb;
@@ -2145,22 +2355,19 @@ VfsSyncAll(void)
             Sb->Ops->Sync(Sb);
         }
     }
-    ReleaseMutex(&VfsLock);
+    ReleaseRwSemaphoreRead(&VfsLock);
     return 0;
 }
 
 int
 VfsPruneCaches(void)
 {
-    AcquireMutex(&VfsLock);
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
-int
-VfsRegisterDevNode(const char* __Path__, void* __Priv__, long __Flags__)
+static int
+__register_dev_node__(const char* __Path__, void* __Priv__, long __Flags__)
 {
-    AcquireMutex(&VfsLock);
     if (!__Path__ || !__Priv__)
     {
         return -1;
@@ -2180,7 +2387,7 @@ VfsRegisterDevNode(const char* __Path__, void* __Priv__, long __Flags__)
     long plen = (long)(Name - Buf);
     __builtin_memcpy(Parent, Buf, plen);
     Parent[plen] = 0;
-    VfsMkpath(Parent, 0);
+    __mkpath__(Parent, 0);
 
     /* Create vnode for device */
     Vnode* Node = (Vnode*)KMalloc(sizeof(Vnode));
@@ -2204,23 +2411,28 @@ VfsRegisterDevNode(const char* __Path__, void* __Priv__, long __Flags__)
     }
 
     PDebug("VFS: Registered devnode %s\n", __Path__);
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
+int
+VfsRegisterDevNode(const char* __Path__, void* __Priv__, long __Flags__)
+{
+    AcquireRwSemaphoreWrite(&VfsLock);
+    int Ret = __register_dev_node__(__Path__, __Priv__, __Flags__);
+    ReleaseRwSemaphoreWrite(&VfsLock);
+    return Ret;
+}
+
 int
 VfsUnregisterDevNode(const char* __Path__)
 {
-    AcquireMutex(&VfsLock);
     (void)__Path__;
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
-int
-VfsRegisterPseudoFs(const char* __Path__, Superblock* __Sb__)
+static int
+__register_pseudo_fs__(const char* __Path__, Superblock* __Sb__)
 {
-    AcquireMutex(&VfsLock);
     if (!__Path__ || !__Sb__)
     {
         return -1;
@@ -2233,22 +2445,27 @@ VfsRegisterPseudoFs(const char* __Path__, Superblock* __Sb__)
     __MountEntry__* M = &__Mounts__[__MountCount__++];
     M->Sb             = __Sb__;
     __builtin_memcpy(M->Path, __Path__, (size_t)(N + 1));
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
+int
+VfsRegisterPseudoFs(const char* __Path__, Superblock* __Sb__)
+{
+    AcquireRwSemaphoreWrite(&VfsLock);
+    int Ret = __register_pseudo_fs__(__Path__, __Sb__);
+    ReleaseRwSemaphoreWrite(&VfsLock);
+    return Ret;
+}
+
 int
 VfsUnregisterPseudoFs(const char* __Path__)
 {
-    AcquireMutex(&VfsLock);
-    ReleaseMutex(&VfsLock);
     return VfsUnmount(__Path__);
 }
 
-int
-VfsSetDefaultFs(const char* __Name__)
+static int
+__set_default_fs__(const char* __Name__)
 {
-    AcquireMutex(&VfsLock);
     if (!__Name__)
     {
         return -1;
@@ -2259,105 +2476,117 @@ VfsSetDefaultFs(const char* __Name__)
         return -1;
     }
     __builtin_memcpy(__DefaultFs__, __Name__, (size_t)(N + 1));
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
+int
+VfsSetDefaultFs(const char* __Name__)
+{
+    AcquireRwSemaphoreWrite(&VfsLock);
+    int Ret = __set_default_fs__(__Name__);
+    ReleaseRwSemaphoreWrite(&VfsLock);
+    return Ret;
+}
+
 const char*
 VfsGetDefaultFs(void)
 {
     return __DefaultFs__;
 }
 
-int
-VfsSetMaxName(long __Len__)
+static int
+__set_max_name__(long __Len__)
 {
-    AcquireMutex(&VfsLock);
     if (__Len__ < 1)
     {
         return -1;
     }
     __MaxName__ = __Len__;
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
+int
+VfsSetMaxName(long __Len__)
+{
+    AcquireRwSemaphoreWrite(&VfsLock);
+    int Ret = __set_max_name__(__Len__);
+    ReleaseRwSemaphoreWrite(&VfsLock);
+    return Ret;
+}
+
 long
 VfsGetMaxName(void)
 {
-    AcquireMutex(&VfsLock);
-    ReleaseMutex(&VfsLock);
     return __MaxName__;
 }
 
-int
-VfsSetMaxPath(long __Len__)
+static int
+__set_max_path__(long __Len__)
 {
-    AcquireMutex(&VfsLock);
     if (__Len__ < 1)
     {
         return -1;
     }
     __MaxPath__ = __Len__;
-    ReleaseMutex(&VfsLock);
     return 0;
 }
 
+int
+VfsSetMaxPath(long __Len__)
+{
+    AcquireRwSemaphoreWrite(&VfsLock);
+    int Ret = __set_max_path__(__Len__);
+    ReleaseRwSemaphoreWrite(&VfsLock);
+    return Ret;
+}
+
 long
 VfsGetMaxPath(void)
 {
-    AcquireMutex(&VfsLock);
-    ReleaseMutex(&VfsLock);
     return __MaxPath__;
 }
 
 int
 VfsSetDirCacheLimit(long __Val__)
 {
-    AcquireMutex(&VfsLock);
+    AcquireRwSemaphoreWrite(&VfsLock);
     __DirCacheLimit__ = __Val__;
-    ReleaseMutex(&VfsLock);
+    ReleaseRwSemaphoreWrite(&VfsLock);
     return 0;
 }
 
 long
 VfsGetDirCacheLimit(void)
 {
-    AcquireMutex(&VfsLock);
-    ReleaseMutex(&VfsLock);
     return __DirCacheLimit__;
 }
 
 int
 VfsSetFileCacheLimit(long __Val__)
 {
-    AcquireMutex(&VfsLock);
+    AcquireRwSemaphoreWrite(&VfsLock);
     __FileCacheLimit__ = __Val__;
-    ReleaseMutex(&VfsLock);
+    ReleaseRwSemaphoreWrite(&VfsLock);
     return 0;
 }
 
 long
 VfsGetFileCacheLimit(void)
 {
-    AcquireMutex(&VfsLock);
-    ReleaseMutex(&VfsLock);
     return __FileCacheLimit__;
 }
 
 int
 VfsSetIoBlockSize(long __Val__)
 {
-    AcquireMutex(&VfsLock);
+    AcquireRwSemaphoreWrite(&VfsLock);
     __IoBlockSize__ = __Val__;
-    ReleaseMutex(&VfsLock);
+    ReleaseRwSemaphoreWrite(&VfsLock);
     return 0;
 }
 
 long
 VfsGetIoBlockSize(void)
 {
-    AcquireMutex(&VfsLock);
-    ReleaseMutex(&VfsLock);
     return __IoBlockSize__;
 }
\ No newline at end of file
@@ -64,7 +64,7 @@ RamFsMountImpl(const char* __Dev__, const char* __Opts__)
         return 0;
     }
 
-    Superblock* Sb = (Superblock*)KMalloc(sizeof(Superblock));
+    Superblock* Sb = (Superblock*)KZalloc(sizeof(Superblock));
     if (!Sb)
     {
         PError("RamFS: Sb alloc failed\n");
@@ -26,6 +26,8 @@ GetPageTable(uint64_t* __Pml4__, uint64_t __VirtAddr__, int __Level__, int __Cre
                 return NULL;
             }
 
+            PmmSetFrameOwner(NewTablePhys, 1, PageOwnerPageTable);
+
             uint64_t* NewTable = (uint64_t*)PhysToVirt(NewTablePhys);
 
             for (uint32_t Index = 0; Index < PageTableEntries; Index++)
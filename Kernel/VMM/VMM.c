@@ -63,6 +63,8 @@ CreateVirtualSpace(void)
         return 0;
     }
 
+    PmmSetFrameOwner(Pml4Phys, 1, PageOwnerPageTable);
+
     Space->PhysicalBase = Pml4Phys;
     Space->Pml4         = (uint64_t*)PhysToVirt(Pml4Phys);
     Space->RefCount     = 1;
@@ -267,6 +269,65 @@ GetPhysicalAddress(VirtualMemorySpace* __Space__, uint64_t __VirtAddr__)
     return PhysBase + Offset;
 }
 
+uint64_t
+VmmCountUserPages(VirtualMemorySpace* __Space__)
+{
+    if (!__Space__ || !__Space__->Pml4)
+    {
+        return 0;
+    }
+
+    uint64_t Pages = 0;
+
+    /* Lower half only; the upper half is the shared kernel mapping */
+    for (uint64_t Pml4Index = 0; Pml4Index < 256; Pml4Index++)
+    {
+        if (!(__Space__->Pml4[Pml4Index] & PTEPRESENT))
+        {
+            continue;
+        }
+
+        uint64_t* Pdpt = (uint64_t*)PhysToVirt(__Space__->Pml4[Pml4Index] & 0x000FFFFFFFFFF000ULL);
+        for (uint64_t PdptIndex = 0; PdptIndex < PageTableEntries; PdptIndex++)
+        {
+            if (!(Pdpt[PdptIndex] & PTEPRESENT))
+            {
+                continue;
+            }
+            if (Pdpt[PdptIndex] & PTEHUGEPAGE)
+            {
+                Pages += PageTableEntries * PageTableEntries;
+                continue;
+            }
+
+            uint64_t* Pd = (uint64_t*)PhysToVirt(Pdpt[PdptIndex] & 0x000FFFFFFFFFF000ULL);
+            for (uint64_t PdIndex = 0; PdIndex < PageTableEntries; PdIndex++)
+            {
+                if (!(Pd[PdIndex] & PTEPRESENT))
+                {
+                    continue;
+                }
+                if (Pd[PdIndex] & PTEHUGEPAGE)
+                {
+                    Pages += PageTableEntries;
+                    continue;
+                }
+
+                uint64_t* Pt = (uint64_t*)PhysToVirt(Pd[PdIndex] & 0x000FFFFFFFFFF000ULL);
+                for (uint64_t PtIndex = 0; PtIndex < PageTableEntries; PtIndex++)
+                {
+                    if ((Pt[PtIndex] & (PTEPRESENT | PTEUSER)) == (PTEPRESENT | PTEUSER))
+                    {
+                        Pages++;
+                    }
+                }
+            }
+        }
+    }
+
+    return Pages;
+}
+
 void
 SwitchVirtualSpace(VirtualMemorySpace* __Space__)
 {
@@ -0,0 +1,71 @@
+#include "LockFreeTest.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <unistd.h>
+
+TestConfig TestCfg = {
+    .Iterations = 1000000,
+    .Threads    = TestThreads,
+    .Verbose    = 0,
+};
+
+static void
+__Usage__(const char* __Prog__)
+{
+    printf("usage: %s [-i iterations] [-p threads] [-v]\n"
+           "  -i  operations per thread (default 1000000)\n"
+           "  -p  producer, stack and counter threads (default %u)\n"
+           "  -v  print sums even when they match\n",
+           __Prog__,
+           TestThreads);
+}
+
+int
+main(int __Argc__, char** __Argv__)
+{
+    int Opt;
+    while ((Opt = getopt(__Argc__, __Argv__, "i:p:vh")) != -1)
+    {
+        switch (Opt)
+        {
+            case 'i':
+                TestCfg.Iterations = strtoull(optarg, NULL, 0);
+                break;
+            case 'p':
+                TestCfg.Threads = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'v':
+                TestCfg.Verbose = 1;
+                break;
+            default:
+                __Usage__(__Argv__[0]);
+                return Opt == 'h' ? 0 : 2;
+        }
+    }
+
+    /*MPSC producers take CPUs 1..Threads, the consumer CPU 0*/
+    if (!TestCfg.Iterations || !TestCfg.Threads || TestCfg.Threads >= MaxCPUs)
+    {
+        __Usage__(__Argv__[0]);
+        return 2;
+    }
+
+    struct timespec Start;
+    struct timespec End;
+    clock_gettime(CLOCK_MONOTONIC, &Start);
+
+    int Failed = 0;
+    Failed |= TestSpscRing();
+    Failed |= TestMpscRing();
+    Failed |= TestLfStack();
+    Failed |= TestPerCpuCounter();
+
+    clock_gettime(CLOCK_MONOTONIC, &End);
+    printf("%s, %u threads, host time %.1f ms\n",
+           Failed ? "FAILED" : "all passed",
+           TestCfg.Threads,
+           (End.tv_sec - Start.tv_sec) * 1e3 + (End.tv_nsec - Start.tv_nsec) / 1e6);
+    return Failed ? 1 : 0;
+}
@@ -0,0 +1,28 @@
+#pragma once
+
+#include <LockFree.h>
+#include <PerCpu.h>
+
+/*
+ * Host stress tests for the lock-free primitives. The real LockFree.c and
+ * PerCpu.c are linked against TestHost.c; every pthread plays one CPU, and
+ * TestCpu is the id GetCurrentCpuId hands back to it.
+ */
+
+#define TestThreads 4 /*Producers, stack users and counter CPUs per test*/
+
+typedef struct
+{
+    uint64_t Iterations; /*Operations per thread*/
+    uint32_t Threads;
+    uint32_t Verbose;
+
+} TestConfig;
+
+extern TestConfig             TestCfg;
+extern _Thread_local uint32_t TestCpu;
+
+int TestSpscRing(void);
+int TestMpscRing(void);
+int TestLfStack(void);
+int TestPerCpuCounter(void);
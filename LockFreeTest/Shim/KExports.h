@@ -0,0 +1,8 @@
+#pragma once
+
+/*
+ * Host build of KExports.h. Nothing loads modules here, and the real macro
+ * would reference every exported kernel symbol the tests do not link.
+ */
+
+#define KEXPORT(__SYM__)
@@ -0,0 +1,14 @@
+#include "LockFreeTest.h"
+
+/*
+ * Stand-ins for the kernel services LockFree.c and PerCpu.c link against.
+ * A host thread stays on the CPU it was given, so there is nothing to pin.
+ */
+
+_Thread_local uint32_t TestCpu;
+
+uint32_t
+GetCurrentCpuId(void)
+{
+    return TestCpu;
+}
@@ -0,0 +1,364 @@
+#include "LockFreeTest.h"
+
+#include <pthread.h>
+#include <sched.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+#define SpscSlots     64  /*Small, so the producer keeps running into a full ring*/
+#define MpscSlots     256
+#define StackNodes    8 /*Fewer nodes than threads makes the same node come back often*/
+#define NodeFree      0
+#define CounterShared 0 /*Slot every counter thread also adds to with PerCpuCounterAddOn*/
+
+/*Ring items carry their producer in the top 16 bits and a sequence number below*/
+#define ItemEncode(__Producer__, __Seq__)                                                          \
+    ((void*)(uintptr_t)(((uint64_t)(__Producer__) << 48) | (__Seq__)))
+#define ItemProducer(__Item__) ((uint32_t)((uintptr_t)(__Item__) >> 48))
+#define ItemSeq(__Item__)      ((uint64_t)(uintptr_t)(__Item__) & 0xFFFFFFFFFFFFULL)
+
+typedef struct
+{
+    uint32_t Cpu;
+    void*    Shared;
+    uint64_t Failures;
+
+} TestWorker;
+
+static void
+__Spawn__(pthread_t* __Ids__, TestWorker* __Workers__, uint32_t __Count__, void* (*__Fn__)(void*))
+{
+    for (uint32_t Index = 0; Index < __Count__; Index++)
+    {
+        if (pthread_create(&__Ids__[Index], NULL, __Fn__, &__Workers__[Index]) != 0)
+        {
+            fprintf(stderr, "pthread_create failed\n");
+            exit(2);
+        }
+    }
+}
+
+static void
+__Join__(pthread_t* __Ids__, uint32_t __Count__)
+{
+    for (uint32_t Index = 0; Index < __Count__; Index++)
+    {
+        pthread_join(__Ids__[Index], NULL);
+    }
+}
+
+/*Ring full or empty: on a host with few cores the other side needs the CPU to move*/
+static void
+__Backoff__(void)
+{
+    sched_yield();
+}
+
+static int
+__Report__(const char* __Name__, uint64_t __Failures__, uint64_t __Ops__)
+{
+    printf("%-16s %s  (%llu ops, %llu failures)\n",
+           __Name__,
+           __Failures__ ? "FAIL" : "ok",
+           (unsigned long long)__Ops__,
+           (unsigned long long)__Failures__);
+    return __Failures__ ? -1 : 0;
+}
+
+/*SPSC: one producer, one consumer; every item must come out once and in order*/
+
+static SpscRing SpscTestRing;
+static void*    SpscTestSlots[SpscSlots];
+
+static void*
+__SpscProducer__(void* __Arg__)
+{
+    TestWorker* Self = (TestWorker*)__Arg__;
+    TestCpu          = Self->Cpu;
+
+    for (uint64_t Seq = 1; Seq <= TestCfg.Iterations; Seq++)
+    {
+        while (SpscRingPush(&SpscTestRing, ItemEncode(0, Seq)) != 0)
+        {
+            __Backoff__();
+        }
+    }
+    return NULL;
+}
+
+static void*
+__SpscConsumer__(void* __Arg__)
+{
+    TestWorker* Self = (TestWorker*)__Arg__;
+    TestCpu          = Self->Cpu;
+
+    for (uint64_t Want = 1; Want <= TestCfg.Iterations; Want++)
+    {
+        void* Item;
+        while (SpscRingPop(&SpscTestRing, &Item) != 0)
+        {
+            __Backoff__();
+        }
+        if (ItemSeq(Item) != Want)
+        {
+            Self->Failures++;
+            Want = ItemSeq(Item); /*Resynchronise so one loss is one failure*/
+        }
+    }
+    return NULL;
+}
+
+int
+TestSpscRing(void)
+{
+    pthread_t  Ids[2];
+    TestWorker Workers[2] = {{.Cpu = 0}, {.Cpu = 1}};
+
+    /*Sizes must be powers of two*/
+    if (InitializeSpscRing(&SpscTestRing, SpscTestSlots, SpscSlots - 1) == 0 ||
+        InitializeSpscRing(&SpscTestRing, SpscTestSlots, SpscSlots) != 0)
+    {
+        return __Report__("SpscRing", 1, 0);
+    }
+
+    pthread_create(&Ids[0], NULL, __SpscProducer__, &Workers[0]);
+    pthread_create(&Ids[1], NULL, __SpscConsumer__, &Workers[1]);
+    __Join__(Ids, 2);
+
+    void*    Item;
+    uint64_t Failures = Workers[1].Failures + (SpscRingPop(&SpscTestRing, &Item) == 0);
+    return __Report__("SpscRing", Failures, TestCfg.Iterations);
+}
+
+/*MPSC: each producer's items must arrive in its own order, none lost or doubled*/
+
+static MpscRing MpscTestRing;
+static MpscSlot MpscTestSlots[MpscSlots];
+
+static void*
+__MpscProducer__(void* __Arg__)
+{
+    TestWorker* Self = (TestWorker*)__Arg__;
+    TestCpu          = Self->Cpu;
+
+    for (uint64_t Seq = 1; Seq <= TestCfg.Iterations; Seq++)
+    {
+        while (MpscRingPush(&MpscTestRing, ItemEncode(Self->Cpu, Seq)) != 0)
+        {
+            __Backoff__();
+        }
+    }
+    return NULL;
+}
+
+int
+TestMpscRing(void)
+{
+    pthread_t  Ids[MaxCPUs];
+    TestWorker Workers[MaxCPUs] = {{0}};
+    uint64_t   Next[MaxCPUs];
+    uint64_t   Failures = 0;
+
+    InitializeMpscRing(&MpscTestRing, MpscTestSlots, MpscSlots);
+    for (uint32_t Index = 0; Index < TestCfg.Threads; Index++)
+    {
+        Workers[Index].Cpu = Index + 1; /*The consumer is CPU 0*/
+        Next[Index + 1]    = 1;
+    }
+    __Spawn__(Ids, Workers, TestCfg.Threads, __MpscProducer__);
+
+    uint64_t Total = TestCfg.Iterations * TestCfg.Threads;
+    for (uint64_t Got = 0; Got < Total; Got++)
+    {
+        void* Item;
+        while (MpscRingPop(&MpscTestRing, &Item) != 0)
+        {
+            __Backoff__();
+        }
+
+        uint32_t Producer = ItemProducer(Item);
+        if (Producer < 1 || Producer > TestCfg.Threads || ItemSeq(Item) != Next[Producer])
+        {
+            Failures++;
+            continue;
+        }
+        Next[Producer]++;
+    }
+    __Join__(Ids, TestCfg.Threads);
+
+    void* Item;
+    Failures += (MpscRingPop(&MpscTestRing, &Item) == 0);
+    return __Report__("MpscRing", Failures, Total);
+}
+
+/*
+ * LfStack: a handful of nodes cycle through many threads, so a node is often
+ * popped and pushed back between another pop's read and its CAS. Without the
+ * tag that CAS would install a stale Next and hand one node to two threads;
+ * Owner catches exactly that.
+ */
+
+typedef struct
+{
+    LfStackNode Link;
+    uint32_t    Owner;
+
+} TestNode;
+
+static LfStack  StackTest;
+static TestNode StackTestNodes[StackNodes];
+
+static void*
+__StackWorker__(void* __Arg__)
+{
+    TestWorker* Self = (TestWorker*)__Arg__;
+    TestCpu          = Self->Cpu;
+
+    for (uint64_t Round = 0; Round < TestCfg.Iterations; Round++)
+    {
+        LfStackNode* Link;
+        if (LfStackPop(&StackTest, &Link) != 0)
+        {
+            continue;
+        }
+
+        TestNode* Node = (TestNode*)Link;
+        uint32_t  Free = NodeFree;
+        if (!__atomic_compare_exchange_n(
+                &Node->Owner, &Free, Self->Cpu + 1, 0, __ATOMIC_ACQ_REL, __ATOMIC_RELAXED))
+        {
+            Self->Failures++;
+            continue; /*Someone else holds it; leave it to them*/
+        }
+
+        __atomic_store_n(&Node->Owner, NodeFree, __ATOMIC_RELEASE);
+        LfStackPush(&StackTest, Link);
+    }
+    return NULL;
+}
+
+int
+TestLfStack(void)
+{
+    pthread_t  Ids[MaxCPUs];
+    TestWorker Workers[MaxCPUs] = {{0}};
+    uint64_t   Failures         = 0;
+
+    InitializeLfStack(&StackTest);
+    for (uint32_t Index = 0; Index < StackNodes; Index++)
+    {
+        StackTestNodes[Index].Owner = NodeFree;
+        LfStackPush(&StackTest, &StackTestNodes[Index].Link);
+    }
+
+    /*The same Top popped and pushed back must not look unchanged to a racing pop*/
+    LfStackNode* Top = StackTest.Top;
+    uint64_t     Tag = StackTest.Tag;
+    LfStackNode* Link;
+    LfStackPop(&StackTest, &Link);
+    LfStackPush(&StackTest, Link);
+    Failures += StackTest.Top != Top || StackTest.Tag == Tag;
+
+    for (uint32_t Index = 0; Index < TestCfg.Threads; Index++)
+    {
+        Workers[Index].Cpu = Index;
+    }
+    __Spawn__(Ids, Workers, TestCfg.Threads, __StackWorker__);
+    __Join__(Ids, TestCfg.Threads);
+
+    for (uint32_t Index = 0; Index < TestCfg.Threads; Index++)
+    {
+        Failures += Workers[Index].Failures;
+    }
+
+    /*Every node must be back on the stack exactly once*/
+    uint32_t Seen[StackNodes] = {0};
+    uint32_t Count            = 0;
+    while (LfStackPop(&StackTest, &Link) == 0)
+    {
+        TestNode* Node = (TestNode*)Link;
+        if (Node < &StackTestNodes[0] || Node >= &StackTestNodes[StackNodes] ||
+            Seen[Node - StackTestNodes]++ || ++Count > StackNodes)
+        {
+            Failures++;
+            break;
+        }
+    }
+    Failures += Count != StackNodes;
+
+    return __Report__("LfStack", Failures, TestCfg.Iterations * TestCfg.Threads);
+}
+
+/*PerCpuCounter: concurrent adds to own and shared slots must all be in the final sum*/
+
+static PerCpuCounter CounterTest;
+static volatile int  CounterDone;
+
+static void*
+__CounterWorker__(void* __Arg__)
+{
+    TestWorker* Self = (TestWorker*)__Arg__;
+    TestCpu          = Self->Cpu;
+
+    for (uint64_t Round = 0; Round < TestCfg.Iterations; Round++)
+    {
+        PerCpuCounterAdd(&CounterTest, 2);
+        PerCpuCounterAddOn(&CounterTest, CounterShared, 1);
+        PerCpuCounterAdd(&CounterTest, -1);
+    }
+    return NULL;
+}
+
+/*Every slot only grows overall, so a reader's sums must never go backwards*/
+static void*
+__CounterReader__(void* __Arg__)
+{
+    TestWorker* Self = (TestWorker*)__Arg__;
+    int64_t     Last = 0;
+
+    while (!__atomic_load_n(&CounterDone, __ATOMIC_ACQUIRE))
+    {
+        int64_t Sum = PerCpuCounterSum(&CounterTest);
+        if (Sum + (int64_t)TestCfg.Threads < Last)
+        {
+            Self->Failures++;
+        }
+        Last = Sum;
+    }
+    return NULL;
+}
+
+int
+TestPerCpuCounter(void)
+{
+    pthread_t  Ids[MaxCPUs];
+    pthread_t  ReaderId;
+    TestWorker Workers[MaxCPUs] = {{0}};
+    TestWorker Reader           = {0};
+
+    PerCpuCounterReset(&CounterTest);
+    CounterDone = 0;
+    for (uint32_t Index = 0; Index < TestCfg.Threads; Index++)
+    {
+        Workers[Index].Cpu = Index;
+    }
+
+    pthread_create(&ReaderId, NULL, __CounterReader__, &Reader);
+    __Spawn__(Ids, Workers, TestCfg.Threads, __CounterWorker__);
+    __Join__(Ids, TestCfg.Threads);
+    __atomic_store_n(&CounterDone, 1, __ATOMIC_RELEASE);
+    pthread_join(ReaderId, NULL);
+
+    int64_t  Want     = (int64_t)(TestCfg.Iterations * TestCfg.Threads * 2);
+    int64_t  Sum      = PerCpuCounterSum(&CounterTest);
+    uint64_t Failures = Reader.Failures + (Sum != Want);
+
+    if (Sum != Want || TestCfg.Verbose)
+    {
+        printf("PerCpuCounter: sum %lld, want %lld\n", (long long)Sum, (long long)Want);
+    }
+
+    PerCpuCounterReset(&CounterTest);
+    Failures += PerCpuCounterSum(&CounterTest) != 0;
+    return __Report__("PerCpuCounter", Failures, TestCfg.Iterations * TestCfg.Threads * 3);
+}
@@ -0,0 +1,297 @@
+#include "SchedSim.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#include <unistd.h>
+
+SimConfig SimCfg = {
+    .CpuCount     = 4,
+    .SmtWidth     = 1,
+    .LlcWidth     = 0, /*All CPUs on one LLC unless -l says otherwise*/
+    .Ticks        = 10000,
+    .Seed         = 1,
+    .BalanceEvery = LoadBalanceTicks, /*As often as the kernel's timer softirq does*/
+    .Scale        = 1,
+    .Verbose      = 0,
+};
+
+static InterruptFrame SimFrames[MaxCPUs];
+static Thread*        SimRunning[MaxCPUs];
+static uint64_t       SimBusyTicks[MaxCPUs];
+
+static void
+__Usage__(const char* __Prog__)
+{
+    printf("usage: %s [-c cpus] [-t smt] [-l llc] [-w workload] [-d ticks] [-s seed]\n"
+           "       [-b balance] [-n scale] [-v]\n"
+           "  -c  virtual CPUs (default 4)\n"
+           "  -t  hardware threads per core (default 1)\n"
+           "  -l  CPUs per last level cache (default all)\n"
+           "  -d  ticks to simulate, 1 ms each (default 10000)\n"
+           "  -s  random seed (default 1)\n"
+           "  -b  call LoadBalanceThreads every N ticks, 0 never (default 100)\n"
+           "  -n  multiply the workload's tasks per CPU (default 1)\n"
+           "  -v  show kernel log output\n"
+           "workloads:\n",
+           __Prog__);
+    SimListWorkloads();
+}
+
+static void
+__Record__(SimLatency* __Lat__, uint64_t __Ticks__)
+{
+    __Lat__->Buckets[__Ticks__ < SimLatencyBuckets ? __Ticks__ : SimLatencyBuckets - 1]++;
+    __Lat__->Samples++;
+    __Lat__->Sum += __Ticks__;
+    if (__Ticks__ > __Lat__->Max)
+    {
+        __Lat__->Max = __Ticks__;
+    }
+}
+
+static uint64_t
+__Percentile__(const SimLatency* __Lat__, uint32_t __Pct__)
+{
+    uint64_t Want = (__Lat__->Samples * __Pct__ + 99) / 100;
+    uint64_t Seen = 0;
+
+    for (uint32_t Bucket = 0; Bucket < SimLatencyBuckets; Bucket++)
+    {
+        Seen += __Lat__->Buckets[Bucket];
+        if (Want && Seen >= Want)
+        {
+            return Bucket;
+        }
+    }
+    return __Lat__->Max;
+}
+
+/*What the CPU picked this tick: wake-to-run latency and migrations are counted here*/
+static void
+__Dispatched__(uint32_t __Cpu__)
+{
+    Thread* Th = CpuSchedulers[__Cpu__].CurrentThread;
+    if (Th == SimRunning[__Cpu__])
+    {
+        return;
+    }
+
+    SimRunning[__Cpu__] = Th;
+    if (!Th || SimTaskOf(Th)->Class == SimClassKernel)
+    {
+        return;
+    }
+
+    SimTask*       Task  = SimTaskOf(Th);
+    SimClassStats* Stats = &SimStats[Task->Class];
+    Stats->Dispatches++;
+
+    if (Task->WokenAt != SimNoStamp && SimNow >= Task->WokenAt)
+    {
+        __Record__(&Stats->Wakeup, SimNow - Task->WokenAt);
+        Task->WokenAt = SimNoStamp;
+    }
+
+    if (Task->LastRanCpu < SimCfg.CpuCount && Task->LastRanCpu != __Cpu__)
+    {
+        Stats->Migrations++;
+        if (!CpusShareLlc(Task->LastRanCpu, __Cpu__))
+        {
+            Stats->FarMigrations++;
+        }
+    }
+    Task->LastRanCpu = __Cpu__;
+}
+
+/*
+ * One timer interrupt on every CPU. The running task is charged for the tick
+ * that just ended, device completions arrive, then each CPU goes through
+ * TimerHandler's order: Schedule, then the timer softirq waking sleepers.
+ */
+static void
+__Tick__(void)
+{
+    for (uint32_t CpuIndex = 0; CpuIndex < SimCfg.CpuCount; CpuIndex++)
+    {
+        Thread* Th = CpuSchedulers[CpuIndex].CurrentThread;
+        if (Th && !(Th->Flags & ThreadFlagIdle) && SimTaskOf(Th)->Class != SimClassKernel)
+        {
+            SimBusyTicks[CpuIndex]++;
+            SimRunTick(SimTaskOf(Th), CpuIndex);
+        }
+    }
+
+    SimDeliverEvents();
+
+    for (uint32_t CpuIndex = 0; CpuIndex < SimCfg.CpuCount; CpuIndex++)
+    {
+        SimCpu = CpuIndex;
+        Schedule(CpuIndex, &SimFrames[CpuIndex]);
+        WakeupSleepingThreads(CpuIndex);
+        __Dispatched__(CpuIndex);
+    }
+
+    if (SimCfg.BalanceEvery && SimNow % SimCfg.BalanceEvery == 0)
+    {
+        SimCpu = 0;
+        LoadBalanceThreads();
+    }
+}
+
+static void
+__Report__(const char* __Workload__, double __HostMs__)
+{
+    printf("SchedSim: %u CPUs (SMT %u, LLC %u), workload %s, %lu ticks, seed %lu\n\n",
+           SimCfg.CpuCount,
+           SimCfg.SmtWidth,
+           SimCfg.LlcWidth,
+           __Workload__,
+           (unsigned long)SimCfg.Ticks,
+           (unsigned long)SimCfg.Seed);
+
+    printf("%-6s %8s %8s %10s %10s %8s %8s %6s %6s %6s %6s\n",
+           "class",
+           "spawned",
+           "exited",
+           "run",
+           "dispatch",
+           "migr",
+           "far",
+           "p50",
+           "p90",
+           "p99",
+           "max");
+
+    for (uint32_t Class = SimClassKernel + 1; Class < SimClasses; Class++)
+    {
+        SimClassStats* Stats = &SimStats[Class];
+        if (!Stats->Spawned)
+        {
+            continue;
+        }
+
+        printf("%-6s %8lu %8lu %10lu %10lu %8lu %8lu %6lu %6lu %6lu %6lu\n",
+               SimProfiles[Class].Name,
+               (unsigned long)Stats->Spawned,
+               (unsigned long)Stats->Exited,
+               (unsigned long)Stats->RunTicks,
+               (unsigned long)Stats->Dispatches,
+               (unsigned long)Stats->Migrations,
+               (unsigned long)Stats->FarMigrations,
+               (unsigned long)__Percentile__(&Stats->Wakeup, 50),
+               (unsigned long)__Percentile__(&Stats->Wakeup, 90),
+               (unsigned long)__Percentile__(&Stats->Wakeup, 99),
+               (unsigned long)Stats->Wakeup.Max);
+    }
+
+    uint64_t Switches = 0;
+    uint64_t Busy     = 0;
+    for (uint32_t CpuIndex = 0; CpuIndex < SimCfg.CpuCount; CpuIndex++)
+    {
+        Switches += CpuSchedulers[CpuIndex].ContextSwitches;
+        Busy += SimBusyTicks[CpuIndex];
+    }
+
+    printf("\nwake-to-run latency in ticks; run, migr and far summed over each class\n");
+    printf("fairness (Jain, cpu class): %.4f\n", SimFairness());
+    printf("utilization: %.1f%%, context switches: %lu, live tasks at end: %u\n",
+           100.0 * (double)Busy / (double)(SimCfg.Ticks * SimCfg.CpuCount),
+           (unsigned long)Switches,
+           SimLive);
+
+    if (SimCfg.Verbose)
+    {
+        for (uint32_t CpuIndex = 0; CpuIndex < SimCfg.CpuCount; CpuIndex++)
+        {
+            printf("  cpu %2u: busy %lu, ready %u\n",
+                   CpuIndex,
+                   (unsigned long)SimBusyTicks[CpuIndex],
+                   GetCpuReadyCount(CpuIndex));
+        }
+    }
+
+    printf("host time: %.1f ms (%.0f ticks/s)\n",
+           __HostMs__,
+           __HostMs__ > 0 ? (double)SimCfg.Ticks * 1000.0 / __HostMs__ : 0.0);
+}
+
+int
+main(int __Argc__, char** __Argv__)
+{
+    const char* Workload = "mixed";
+    int         Opt;
+
+    while ((Opt = getopt(__Argc__, __Argv__, "c:t:l:w:d:s:b:n:vh")) != -1)
+    {
+        switch (Opt)
+        {
+            case 'c':
+                SimCfg.CpuCount = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 't':
+                SimCfg.SmtWidth = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'l':
+                SimCfg.LlcWidth = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'w':
+                Workload = optarg;
+                break;
+            case 'd':
+                SimCfg.Ticks = strtoull(optarg, NULL, 0);
+                break;
+            case 's':
+                SimCfg.Seed = strtoull(optarg, NULL, 0);
+                break;
+            case 'b':
+                SimCfg.BalanceEvery = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'n':
+                SimCfg.Scale = (uint32_t)strtoul(optarg, NULL, 0);
+                break;
+            case 'v':
+                SimCfg.Verbose = 1;
+                break;
+            default:
+                __Usage__(__Argv__[0]);
+                return Opt == 'h' ? 0 : 2;
+        }
+    }
+
+    if (!SimCfg.LlcWidth)
+    {
+        SimCfg.LlcWidth = SimCfg.CpuCount;
+    }
+
+    if (!SimCfg.CpuCount || SimCfg.CpuCount > MaxCPUs || !SimCfg.SmtWidth ||
+        SimCfg.SmtWidth > TopoMaxSiblings + 1 || SimCfg.LlcWidth < SimCfg.SmtWidth ||
+        SimCfg.LlcWidth % SimCfg.SmtWidth || !SimCfg.Scale)
+    {
+        fprintf(stderr, "SchedSim: bad topology, need 1..%u CPUs and whole cores per LLC\n", MaxCPUs);
+        return 2;
+    }
+
+    SimHostInitialize();
+    if (SimLoadWorkload(Workload))
+    {
+        fprintf(stderr, "SchedSim: cannot load workload '%s'\n", Workload);
+        __Usage__(__Argv__[0]);
+        return 2;
+    }
+
+    struct timespec Start, End;
+    clock_gettime(CLOCK_MONOTONIC, &Start);
+    for (SimNow = 1; SimNow <= SimCfg.Ticks; SimNow++)
+    {
+        __Tick__();
+    }
+    SimNow = SimCfg.Ticks;
+    clock_gettime(CLOCK_MONOTONIC, &End);
+
+    double HostMs = (double)(End.tv_sec - Start.tv_sec) * 1000.0 +
+                    (double)(End.tv_nsec - Start.tv_nsec) / 1000000.0;
+    __Report__(Workload, HostMs);
+    return 0;
+}
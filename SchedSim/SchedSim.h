@@ -0,0 +1,123 @@
+#pragma once
+
+#include <AxeSchd.h>
+#include <SymAP.h>
+
+/*
+ * Host-side scheduler simulator. The real Scheduler.c, SchedGroup.c,
+ * ThreadAcct.c and Placement.c are linked against the stand-ins in SimHost.c;
+ * one simulated tick is one timer interrupt (1 ms) on every virtual CPU.
+ */
+
+#define SimNoStamp        (~0ULL)
+#define SimLatencyBuckets 4096 /*Ticks; slower wakeups land in the last bucket*/
+#define SimMaxLive        4096 /*Cap on live tasks so fork bombs stay bounded*/
+#define SimMaxEvents      (SimMaxLive * 2)
+
+typedef enum
+{
+    SimClassKernel, /*Threads the scheduler creates for itself, e.g. group idle*/
+    SimClassCpu,
+    SimClassIo,
+    SimClassStorm,
+    SimClassFork,  /*Spawns SimClassChild*/
+    SimClassChild, /*Short lived, exits after a few bursts*/
+    SimClasses
+
+} SimClass;
+
+typedef enum
+{
+    SimActionNone, /*Keep running, a new burst starts at once*/
+    SimActionIo,
+    SimActionSleep,
+    SimActionFork
+
+} SimAction;
+
+typedef struct
+{
+    const char* Name;
+    uint32_t    BurstMin; /*CPU ticks before the next action*/
+    uint32_t    BurstMax;
+    SimAction   Action;
+    uint32_t    WaitMin; /*Ticks blocked on I/O or asleep*/
+    uint32_t    WaitMax;
+    uint32_t    Bursts;     /*Bursts before exit, 0 runs forever*/
+    SimClass    ChildClass; /*What SimActionFork spawns*/
+
+} SimProfile;
+
+typedef struct __attribute__((aligned(64))) SimTask
+{
+    Thread   Th; /*First, so the scheduler's Thread* converts back*/
+    SimClass Class;
+    uint32_t BurstLeft;
+    uint32_t BurstsLeft;
+    uint32_t LastRanCpu;
+    uint64_t WokenAt; /*Tick it became runnable after a wait, SimNoStamp otherwise*/
+    uint64_t BornTick;
+    uint64_t RunTicks;
+
+} SimTask;
+
+typedef struct
+{
+    uint64_t Buckets[SimLatencyBuckets];
+    uint64_t Samples;
+    uint64_t Sum;
+    uint64_t Max;
+
+} SimLatency;
+
+typedef struct
+{
+    uint64_t   Spawned;
+    uint64_t   Exited;
+    uint64_t   RunTicks;
+    uint64_t   Dispatches;
+    uint64_t   Migrations;
+    uint64_t   FarMigrations; /*Across last level caches*/
+    SimLatency Wakeup;
+
+} SimClassStats;
+
+typedef struct
+{
+    uint32_t CpuCount;
+    uint32_t SmtWidth; /*Hardware threads per core*/
+    uint32_t LlcWidth; /*CPUs per last level cache*/
+    uint64_t Ticks;
+    uint64_t Seed;
+    uint32_t BalanceEvery; /*Ticks between LoadBalanceThreads calls, 0 disables*/
+    uint32_t Scale;        /*Tasks per CPU for each workload class*/
+    int      Verbose;
+
+} SimConfig;
+
+extern SimConfig     SimCfg;
+extern uint64_t      SimNow;
+extern uint32_t      SimCpu;
+extern SimClassStats SimStats[SimClasses];
+extern SimProfile    SimProfiles[SimClasses];
+extern uint32_t      SimLive;
+
+/*SimHost.c*/
+void     SimHostInitialize(void);
+uint64_t SimRandom(void);
+uint32_t SimRandomRange(uint32_t __Min__, uint32_t __Max__);
+void     SimReleaseTask(SimTask* __Task__);
+
+/*Workloads.c*/
+int      SimLoadWorkload(const char* __Name__);
+void     SimListWorkloads(void);
+SimTask* SimSpawn(SimClass __Class__, uint32_t __Cpu__);
+void     SimRunTick(SimTask* __Task__, uint32_t __Cpu__);
+void     SimDeliverEvents(void);
+double   SimFairness(void);
+
+static inline SimTask*
+SimTaskOf(Thread* __ThreadPtr__)
+{
+    return (SimTask*)__ThreadPtr__;
+}
@@ -0,0 +1,333 @@
+#include "SchedSim.h"
+
+#include <stdarg.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+/*
+ * Stand-ins for the kernel services the scheduler core links against. There is
+ * one host thread, so a spinlock only has to catch recursive acquisition, which
+ * would deadlock a real CPU.
+ */
+
+SmpManager Smp;
+SpinLock   ThreadListLock;
+uint64_t   SimNow;
+uint32_t   SimCpu;
+uint32_t   SimLive;
+
+static PerCpuData SimPerCpu[MaxCPUs];
+static Thread*    SimCurrent[MaxCPUs];
+static uint32_t   SimNextThreadId = 1;
+static uint64_t   SimRngState;
+
+uint32_t
+GetCurrentCpuId(void)
+{
+    return SimCpu;
+}
+
+PerCpuData*
+GetPerCpuData(uint32_t __CpuNumber__)
+{
+    return __CpuNumber__ < MaxCPUs ? &SimPerCpu[__CpuNumber__] : NULL;
+}
+
+uint64_t
+GetSystemTicks(void)
+{
+    return SimNow;
+}
+
+/*ThreadAcct reads the host TSC; the simulator reports ticks, so cycles pass through*/
+uint64_t
+TscToNs(uint64_t __Cycles__)
+{
+    return __Cycles__;
+}
+
+void
+InitializeSpinLock(SpinLock* __Lock__, const char* __Name__)
+{
+    __Lock__->Lock  = 0;
+    __Lock__->CpuId = 0xFFFFFFFF;
+    __Lock__->Name  = __Name__;
+}
+
+void
+AcquireSpinLock(SpinLock* __Lock__)
+{
+    if (__Lock__->Lock)
+    {
+        fprintf(stderr,
+                "SchedSim: CPU %u re-acquired %s held by CPU %u\n",
+                SimCpu,
+                __Lock__->Name ? __Lock__->Name : "?",
+                __Lock__->CpuId);
+        abort();
+    }
+
+    __Lock__->Lock  = 1;
+    __Lock__->CpuId = SimCpu;
+}
+
+void
+ReleaseSpinLock(SpinLock* __Lock__)
+{
+    __Lock__->Lock  = 0;
+    __Lock__->CpuId = 0xFFFFFFFF;
+}
+
+static McsNode SimMcsNodes[MaxCPUs];
+
+void
+InitializeMcsLock(McsLock* __Lock__, const char* __Name__)
+{
+    __Lock__->Tail   = NULL;
+    __Lock__->Holder = NULL;
+    __Lock__->CpuId  = 0xFFFFFFFF;
+    __Lock__->Name   = __Name__;
+}
+
+void
+AcquireMcsLock(McsLock* __Lock__)
+{
+    if (__Lock__->Tail)
+    {
+        fprintf(stderr,
+                "SchedSim: CPU %u re-acquired %s held by CPU %u\n",
+                SimCpu,
+                __Lock__->Name ? __Lock__->Name : "?",
+                __Lock__->CpuId);
+        abort();
+    }
+
+    __Lock__->Tail   = &SimMcsNodes[SimCpu];
+    __Lock__->Holder = __Lock__->Tail;
+    __Lock__->CpuId  = SimCpu;
+}
+
+void
+ReleaseMcsLock(McsLock* __Lock__)
+{
+    __Lock__->Tail   = NULL;
+    __Lock__->Holder = NULL;
+    __Lock__->CpuId  = 0xFFFFFFFF;
+}
+
+/*No RCU readers on the host*/
+void
+RcuQuiescentState(uint32_t __CpuId__)
+{
+    (void)__CpuId__;
+}
+
+static void
+__Log__(const char* __Tag__, int __Always__, const char* __Format__, va_list __Args__)
+{
+    if (!__Always__ && !SimCfg.Verbose)
+    {
+        return;
+    }
+
+    fprintf(stderr, "[%8lu] %s", (unsigned long)SimNow, __Tag__);
+    vfprintf(stderr, __Format__, __Args__);
+}
+
+void
+PError(const char* __Format__, ...)
+{
+    va_list Args;
+    va_start(Args, __Format__);
+    __Log__("error: ", 1, __Format__, Args);
+    va_end(Args);
+}
+
+void
+PWarn(const char* __Format__, ...)
+{
+    va_list Args;
+    va_start(Args, __Format__);
+    __Log__("warn: ", 0, __Format__, Args);
+    va_end(Args);
+}
+
+void
+PInfo(const char* __Format__, ...)
+{
+    va_list Args;
+    va_start(Args, __Format__);
+    __Log__("", 0, __Format__, Args);
+    va_end(Args);
+}
+
+void
+PSuccess(const char* __Format__, ...)
+{
+    va_list Args;
+    va_start(Args, __Format__);
+    __Log__("", 0, __Format__, Args);
+    va_end(Args);
+}
+
+void
+StringCopy(char* __Dest__, const char* __Src__, uint32_t __MaxLen__)
+{
+    snprintf(__Dest__, __MaxLen__, "%s", __Src__);
+}
+
+void
+SetCurrentThread(uint32_t __CpuId__, Thread* __ThreadPtr__)
+{
+    if (__CpuId__ < MaxCPUs)
+    {
+        SimCurrent[__CpuId__] = __ThreadPtr__;
+    }
+}
+
+/*Mirrors the defaults ThreadMGR.c gives a new thread; nothing ever executes the entry point*/
+Thread*
+CreateThread(ThreadType     __Type__,
+             void*          __EntryPoint__,
+             void*          __Argument__,
+             ThreadPriority __Priority__)
+{
+    if (SimLive >= SimMaxLive)
+    {
+        return NULL;
+    }
+
+    SimTask* Task = aligned_alloc(64, sizeof(SimTask));
+    if (!Task)
+    {
+        return NULL;
+    }
+    memset(Task, 0, sizeof(SimTask));
+
+    Thread* Th       = &Task->Th;
+    Th->ThreadId     = SimNextThreadId++;
+    Th->ProcessId    = 1;
+    Th->State        = ThreadStateReady;
+    Th->Type         = __Type__;
+    Th->Priority     = __Priority__;
+    Th->BasePriority = __Priority__;
+    Th->CpuAffinity  = 0xFFFFFFFF;
+    Th->LastCpu      = 0xFFFFFFFF;
+    Th->TimeSlice    = 10;
+    Th->StartTime    = SimNow;
+    Th->CreationTick = SimNow;
+    Th->WaitReason   = WaitReasonNone;
+    Th->Context.Rip  = (uint64_t)__EntryPoint__;
+    Th->Context.Rdi  = (uint64_t)__Argument__;
+    SchedGroupInherit(Th);
+
+    /*Schedule() fxrstors this on switch-in, so it must hold a state the host accepts*/
+    __asm__ volatile("fxsave %0" : "=m"(*(char (*)[512])Th->Context.FpuState));
+
+    Task->Class      = SimClassKernel;
+    Task->LastRanCpu = 0xFFFFFFFF;
+    Task->WokenAt    = SimNoStamp;
+    Task->BornTick   = SimNow;
+    SimLive++;
+    return Th;
+}
+
+void
+SimReleaseTask(SimTask* __Task__)
+{
+    SimStats[__Task__->Class].Exited++;
+    SimLive--;
+    free(__Task__);
+}
+
+/*Schedule() hands chains of switched-out dead threads here, as it does to kreaper*/
+void
+ReapThreads(Thread* __Chain__)
+{
+    while (__Chain__)
+    {
+        Thread* Next = __Chain__->ReapNext;
+        SimReleaseTask(SimTaskOf(__Chain__));
+        __Chain__ = Next;
+    }
+}
+
+int
+CpusShareLlc(uint32_t __CpuA__, uint32_t __CpuB__)
+{
+    if (__CpuA__ >= MaxCPUs || __CpuB__ >= MaxCPUs)
+    {
+        return 0;
+    }
+    return SimPerCpu[__CpuA__].Topo.LlcId == SimPerCpu[__CpuB__].Topo.LlcId;
+}
+
+uint64_t
+SimRandom(void)
+{
+    /*xorshift64*, plenty for workload shaping and reproducible per seed*/
+    SimRngState ^= SimRngState >> 12;
+    SimRngState ^= SimRngState << 25;
+    SimRngState ^= SimRngState >> 27;
+    return SimRngState * 0x2545F4914F6CDD1DULL;
+}
+
+uint32_t
+SimRandomRange(uint32_t __Min__, uint32_t __Max__)
+{
+    if (__Max__ <= __Min__)
+    {
+        return __Min__;
+    }
+    return __Min__ + (uint32_t)(SimRandom() % (__Max__ - __Min__ + 1));
+}
+
+/*A regular grid: SmtWidth threads per core, LlcWidth CPUs per last level cache*/
+static void
+__BuildTopology__(void)
+{
+    for (uint32_t CpuIndex = 0; CpuIndex < SimCfg.CpuCount; CpuIndex++)
+    {
+        CpuTopology* Topo = &SimPerCpu[CpuIndex].Topo;
+        Topo->ApicId      = CpuIndex;
+        Topo->SmtId       = CpuIndex % SimCfg.SmtWidth;
+        Topo->CoreId      = CpuIndex / SimCfg.SmtWidth;
+        Topo->L2Id        = Topo->CoreId;
+        Topo->LlcId       = CpuIndex / SimCfg.LlcWidth;
+        Topo->PackageId   = Topo->LlcId;
+        Topo->NumaNode    = TopoNoNode;
+        Topo->Valid       = 1;
+
+        for (uint32_t Other = Topo->CoreId * SimCfg.SmtWidth;
+             Other < (Topo->CoreId + 1) * SimCfg.SmtWidth && Other < SimCfg.CpuCount;
+             Other++)
+        {
+            if (Other != CpuIndex && Topo->SiblingCount < TopoMaxSiblings)
+            {
+                Topo->Siblings[Topo->SiblingCount++] = Other;
+            }
+        }
+    }
+}
+
+void
+SimHostInitialize(void)
+{
+    SimRngState = SimCfg.Seed ? SimCfg.Seed : 0x9E3779B97F4A7C15ULL;
+    InitializeSpinLock(&ThreadListLock, "ThreadList");
+
+    Smp.CpuCount   = SimCfg.CpuCount;
+    Smp.OnlineCpus = SimCfg.CpuCount;
+    for (uint32_t CpuIndex = 0; CpuIndex < SimCfg.CpuCount; CpuIndex++)
+    {
+        Smp.Cpus[CpuIndex].ApicId    = CpuIndex;
+        Smp.Cpus[CpuIndex].CpuNumber = CpuIndex;
+        Smp.Cpus[CpuIndex].Status    = CPU_STATUS_ONLINE;
+        Smp.Cpus[CpuIndex].Started   = 1;
+    }
+
+    __BuildTopology__();
+    InitializeScheduler();
+    InitializeSchedGroups();
+}
@@ -0,0 +1,250 @@
+#include "SchedSim.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*Burst and wait lengths are in ticks; one tick is 1 ms of kernel time*/
+SimProfile SimProfiles[SimClasses] = {
+    [SimClassKernel] = {"kernel", 0, 0, SimActionNone, 0, 0, 0, SimClassKernel},
+    [SimClassCpu]    = {"cpu", 50, 200, SimActionNone, 0, 0, 0, SimClassKernel},
+    [SimClassIo]     = {"io", 1, 3, SimActionIo, 2, 20, 0, SimClassKernel},
+    [SimClassStorm]  = {"storm", 1, 1, SimActionSleep, 1, 4, 0, SimClassKernel},
+    [SimClassFork]   = {"fork", 1, 2, SimActionFork, 0, 0, 0, SimClassChild},
+    [SimClassChild]  = {"child", 1, 8, SimActionSleep, 1, 3, 4, SimClassKernel},
+};
+
+SimClassStats SimStats[SimClasses];
+
+typedef struct
+{
+    const char* Name;
+    const char* Description;
+    uint32_t    PerCpu[SimClasses]; /*Tasks started per virtual CPU*/
+
+} SimWorkload;
+
+static const SimWorkload SimWorkloads[] = {
+    {"cpu", "CPU-bound tasks that never block", {[SimClassCpu] = 2}},
+    {"io", "Short bursts between I/O waits", {[SimClassIo] = 4}},
+    {"storm", "1-tick bursts between short sleeps", {[SimClassStorm] = 8}},
+    {"fork", "Forkers spawning short lived children", {[SimClassFork] = 1}},
+    {"mixed",
+     "All of the above at once",
+     {[SimClassCpu] = 1, [SimClassIo] = 2, [SimClassStorm] = 2, [SimClassFork] = 1}},
+};
+
+#define SimWorkloadCount (sizeof(SimWorkloads) / sizeof(SimWorkloads[0]))
+
+typedef struct
+{
+    uint64_t Due;
+    SimTask* Task;
+
+} SimEvent;
+
+/*Min-heap of pending I/O completions, ordered by Due*/
+static SimEvent SimEvents[SimMaxEvents];
+static uint32_t SimEventCount;
+
+/*CPU-bound tasks live for the whole run, so their shares are comparable*/
+static SimTask* SimFairSet[SimMaxLive];
+static uint32_t SimFairCount;
+
+static void
+__PushEvent__(uint64_t __Due__, SimTask* __Task__)
+{
+    if (SimEventCount >= SimMaxEvents)
+    {
+        PError("SchedSim: event queue full, task %u never wakes\n", __Task__->Th.ThreadId);
+        return;
+    }
+
+    uint32_t Index = SimEventCount++;
+    while (Index && SimEvents[(Index - 1) / 2].Due > __Due__)
+    {
+        SimEvents[Index] = SimEvents[(Index - 1) / 2];
+        Index            = (Index - 1) / 2;
+    }
+    SimEvents[Index].Due  = __Due__;
+    SimEvents[Index].Task = __Task__;
+}
+
+static SimEvent
+__PopEvent__(void)
+{
+    SimEvent Top   = SimEvents[0];
+    SimEvent Last  = SimEvents[--SimEventCount];
+    uint32_t Index = 0;
+
+    for (;;)
+    {
+        uint32_t Child = Index * 2 + 1;
+        if (Child >= SimEventCount)
+        {
+            break;
+        }
+        if (Child + 1 < SimEventCount && SimEvents[Child + 1].Due < SimEvents[Child].Due)
+        {
+            Child++;
+        }
+        if (SimEvents[Child].Due >= Last.Due)
+        {
+            break;
+        }
+        SimEvents[Index] = SimEvents[Child];
+        Index            = Child;
+    }
+
+    SimEvents[Index] = Last;
+    return Top;
+}
+
+static uint32_t
+__NewBurst__(SimClass __Class__)
+{
+    return SimRandomRange(SimProfiles[__Class__].BurstMin, SimProfiles[__Class__].BurstMax);
+}
+
+SimTask*
+SimSpawn(SimClass __Class__, uint32_t __Cpu__)
+{
+    SimCpu     = __Cpu__;
+    Thread* Th = CreateThread(ThreadTypeUser, NULL, NULL, ThreadPriorityNormal);
+    if (!Th)
+    {
+        return NULL;
+    }
+
+    SimTask* Task    = SimTaskOf(Th);
+    Task->Class      = __Class__;
+    Task->BurstLeft  = __NewBurst__(__Class__);
+    Task->BurstsLeft = SimProfiles[__Class__].Bursts;
+    Task->WokenAt    = SimNow;
+    SimStats[__Class__].Spawned++;
+
+    if (__Class__ == SimClassCpu && SimFairCount < SimMaxLive)
+    {
+        SimFairSet[SimFairCount++] = Task;
+    }
+
+    ThreadExecute(Th);
+    return Task;
+}
+
+/*One tick of CPU for a running task, then whatever its profile does at the end of a burst*/
+void
+SimRunTick(SimTask* __Task__, uint32_t __Cpu__)
+{
+    const SimProfile* Profile = &SimProfiles[__Task__->Class];
+    Thread*           Th      = &__Task__->Th;
+
+    __Task__->RunTicks++;
+    SimStats[__Task__->Class].RunTicks++;
+
+    if (__Task__->BurstLeft > 1)
+    {
+        __Task__->BurstLeft--;
+        return;
+    }
+
+    if (Profile->Bursts && --__Task__->BurstsLeft == 0)
+    {
+        Th->State = ThreadStateTerminated;
+        return;
+    }
+
+    __Task__->BurstLeft = __NewBurst__(__Task__->Class);
+    switch (Profile->Action)
+    {
+        case SimActionIo:
+            Th->WaitReason = WaitReasonIo;
+            Th->State      = ThreadStateBlocked;
+            __PushEvent__(SimNow + SimRandomRange(Profile->WaitMin, Profile->WaitMax), __Task__);
+            break;
+
+        case SimActionSleep:
+            /*What ThreadSleep() does, minus the int $0x20; Schedule runs this tick anyway*/
+            Th->WaitReason    = WaitReasonSleep;
+            Th->WakeupTime    = SimNow + SimRandomRange(Profile->WaitMin, Profile->WaitMax);
+            Th->State         = ThreadStateSleeping;
+            __Task__->WokenAt = Th->WakeupTime;
+            break;
+
+        case SimActionFork:
+            SimSpawn(Profile->ChildClass, __Cpu__);
+            break;
+
+        default:
+            break;
+    }
+}
+
+/*Completion interrupts land on the CPU the task last ran on, as WakeupThread expects*/
+void
+SimDeliverEvents(void)
+{
+    while (SimEventCount && SimEvents[0].Due <= SimNow)
+    {
+        SimEvent Event      = __PopEvent__();
+        uint32_t LastCpu    = Event.Task->Th.LastCpu;
+        SimCpu              = LastCpu < SimCfg.CpuCount ? LastCpu : 0;
+        Event.Task->WokenAt = SimNow;
+        WakeupThread(&Event.Task->Th);
+    }
+}
+
+/*Jain's index over CPU-bound shares: 1.0 is perfectly even, 1/n is one task taking all*/
+double
+SimFairness(void)
+{
+    double Sum   = 0;
+    double SumSq = 0;
+
+    for (uint32_t Index = 0; Index < SimFairCount; Index++)
+    {
+        double Share = (double)SimFairSet[Index]->RunTicks;
+        Sum += Share;
+        SumSq += Share * Share;
+    }
+
+    return SumSq > 0 ? (Sum * Sum) / (SimFairCount * SumSq) : 1.0;
+}
+
+int
+SimLoadWorkload(const char* __Name__)
+{
+    for (uint32_t Index = 0; Index < SimWorkloadCount; Index++)
+    {
+        const SimWorkload* Load = &SimWorkloads[Index];
+        if (strcmp(Load->Name, __Name__))
+        {
+            continue;
+        }
+
+        /*Everything starts from CPU 0, the way boot-time threads do*/
+        for (uint32_t Class = 0; Class < SimClasses; Class++)
+        {
+            uint32_t Count = Load->PerCpu[Class] * SimCfg.Scale * SimCfg.CpuCount;
+            for (uint32_t Spawned = 0; Spawned < Count; Spawned++)
+            {
+                if (!SimSpawn((SimClass)Class, 0))
+                {
+                    PError("SchedSim: task limit reached while loading %s\n", __Name__);
+                    return -1;
+                }
+            }
+        }
+        return 0;
+    }
+
+    return -1;
+}
+
+void
+SimListWorkloads(void)
+{
+    for (uint32_t Index = 0; Index < SimWorkloadCount; Index++)
+    {
+        printf("  %-6s %s\n", SimWorkloads[Index].Name, SimWorkloads[Index].Description);
+    }
+}